@@ -0,0 +1,323 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#include "asset-archive.hpp"
+
+#include <cstring>
+#include <algorithm>
+
+namespace qpl {
+
+QPL_INLINE static uint64_t AlignUp(uint64_t value, uint64_t alignment) {
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+//
+// ---- Asset Archive ---------------------------------
+//
+
+bool AssetArchive::Open(const std::filesystem::path& path) {
+  Close();
+
+  if (!mFile.Open(path)) {
+    LogWarning("Assets - Failed to open archive: {}", path.string());
+    return false;
+  }
+
+  if (!Validate(path)) {
+    Close();
+    return false;
+  }
+
+  LogInfo("Assets - Opened archive {} ({} entries, {} bytes)", path.string(), mEntries.size(), mFile.GetSize());
+  return true;
+}
+
+void AssetArchive::Close() {
+  mFile.Close();
+  mEntries = {};
+  mNames = {};
+}
+
+bool AssetArchive::Validate(const std::filesystem::path& path) {
+  std::span<const std::byte> data = mFile.GetData();
+
+  if (data.size() < sizeof(ArchiveHeader)) {
+    LogWarning("Assets - Archive is truncated: {}", path.string());
+    return false;
+  }
+
+  ArchiveHeader header;
+  std::memcpy(&header, data.data(), sizeof(header));
+
+  if (header.magic != ArchiveMagic || header.version != ArchiveVersion) {
+    LogWarning("Assets - Archive has a mismatching header: {}", path.string());
+    return false;
+  }
+
+  uint64_t tableSize = (uint64_t)header.entryCount * sizeof(ArchiveEntry);
+
+  // The entry table is read in place, so it has to be aligned within the (page aligned) mapping.
+  if (header.alignment == 0 || (header.alignment & (header.alignment - 1)) != 0
+      || header.tocOffset % alignof(ArchiveEntry) != 0 || header.tocOffset > data.size()
+      || header.tocSize > data.size() - header.tocOffset || tableSize > header.tocSize) {
+    LogWarning("Assets - Archive has a malformed table of contents: {}", path.string());
+    return false;
+  }
+
+  const std::byte* toc = data.data() + header.tocOffset;
+
+  if (HashBytes(toc, header.tocSize) != header.tocHash) {
+    LogWarning("Assets - Archive table of contents is corrupt: {}", path.string());
+    return false;
+  }
+
+  mEntries = {reinterpret_cast<const ArchiveEntry*>(toc), header.entryCount};
+  mNames = {reinterpret_cast<const char*>(toc + tableSize), header.tocSize - tableSize};
+
+  for (const ArchiveEntry& entry : mEntries) {
+    bool valid = entry.offset <= header.tocOffset && entry.storedSize <= header.tocOffset - entry.offset
+      && (uint64_t)entry.nameOffset + entry.nameLength <= mNames.size();
+
+    if (entry.compression == AssetCompression::None) {
+      valid = valid && entry.storedSize == entry.size;
+    }
+    else {
+      valid = valid && entry.compression == AssetCompression::Lz4;
+    }
+
+    if (!valid) {
+      LogWarning("Assets - Archive has a malformed entry: {}", path.string());
+      return false;
+    }
+  }
+
+  return true;
+}
+
+const ArchiveEntry* AssetArchive::Find(std::string_view name) const {
+  uint64_t nameHash = HashString(name);
+
+  auto it = std::lower_bound(mEntries.begin(), mEntries.end(), nameHash, [](const ArchiveEntry& entry, uint64_t hash) {
+    return entry.nameHash < hash;
+  });
+
+  for (; it != mEntries.end() && it->nameHash == nameHash; ++it) {
+    if (GetName(*it) == name) {
+      return &*it;
+    }
+  }
+
+  return nullptr;
+}
+
+std::string_view AssetArchive::GetName(const ArchiveEntry& entry) const {
+  return mNames.substr(entry.nameOffset, entry.nameLength);
+}
+
+std::span<const std::byte> AssetArchive::GetStoredData(const ArchiveEntry& entry) const {
+  return mFile.GetData().subspan(entry.offset, entry.storedSize);
+}
+
+bool AssetArchive::Read(const ArchiveEntry& entry, std::span<std::byte> dst, bool verify) const {
+  QPL_CORE_ASSERT(dst.size() == entry.size && "destination does not match the asset size");
+
+  std::span<const std::byte> stored = GetStoredData(entry);
+
+  if (entry.compression == AssetCompression::None) {
+    std::memcpy(dst.data(), stored.data(), stored.size());
+  }
+  else if (!Lz4Decompress(stored, dst)) {
+    LogError("Assets - Failed to decompress {}", GetName(entry));
+    return false;
+  }
+
+  if (verify && HashBytes(dst.data(), dst.size()) != entry.contentHash) {
+    LogError("Assets - Content hash mismatch in {}", GetName(entry));
+    return false;
+  }
+
+  return true;
+}
+
+//
+// ---- Asset Archive Writer ---------------------------------
+//
+
+bool AssetArchiveWriter::Open(const std::filesystem::path& path, uint32_t alignment) {
+  QPL_CORE_ASSERT(alignment != 0 && (alignment & (alignment - 1)) == 0 && "alignment must be a power of two");
+
+  mPath = path;
+  mTempPath = path;
+  mTempPath += ".tmp";
+  mAlignment = std::max<uint32_t>(alignment, alignof(ArchiveEntry));
+  mEntries.clear();
+  mNames.clear();
+  mBlobs.clear();
+
+  std::error_code ec;
+  std::filesystem::create_directories(mPath.parent_path(), ec);
+
+  mFile.open(mTempPath, std::ios::binary | std::ios::trunc);
+  if (!mFile.is_open()) {
+    LogError("Assets - Failed to open archive for writing: {}", mTempPath.string());
+    return false;
+  }
+
+  // Rewritten by Finish() once the table of contents is known.
+  ArchiveHeader header{};
+  mFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  mOffset = sizeof(header);
+  return mFile.good();
+}
+
+bool AssetArchiveWriter::Add(std::string_view name, std::span<const std::byte> data, AssetCompression compression) {
+  ArchiveEntry entry{};
+  entry.nameHash = HashString(name);
+  entry.contentHash = HashBytes(data.data(), data.size());
+  entry.size = data.size();
+  entry.nameOffset = static_cast<uint32_t>(mNames.size());
+  entry.nameLength = static_cast<uint32_t>(name.size());
+  mNames += name;
+
+  for (auto [it, end] = mBlobs.equal_range(entry.contentHash); it != end; ++it) {
+    const ArchiveEntry& blob = mEntries[it->second];
+
+    if (!MatchesBlob(blob, data)) {
+      continue;
+    }
+
+    entry.offset = blob.offset;
+    entry.storedSize = blob.storedSize;
+    entry.compression = blob.compression;
+    mEntries.push_back(entry);
+    return true;
+  }
+
+  std::span<const std::byte> stored = data;
+  entry.compression = AssetCompression::None;
+
+  if (compression == AssetCompression::Lz4) {
+    mScratch.resize(Lz4CompressBound(data.size()));
+    size_t compressedSize = Lz4Compress(data, mScratch);
+
+    if (compressedSize != 0 && compressedSize < data.size()) {
+      stored = std::span<const std::byte>(mScratch).first(compressedSize);
+      entry.compression = AssetCompression::Lz4;
+    }
+  }
+
+  entry.offset = AlignUp(mOffset, mAlignment);
+  entry.storedSize = stored.size();
+
+  if (!WriteAligned(stored)) {
+    LogError("Assets - Failed to write {} to {}", name, mTempPath.string());
+    return false;
+  }
+
+  mBlobs.emplace(entry.contentHash, mEntries.size());
+  mEntries.push_back(entry);
+  return true;
+}
+
+bool AssetArchiveWriter::Finish() {
+  std::sort(mEntries.begin(), mEntries.end(), [](const ArchiveEntry& a, const ArchiveEntry& b) {
+    return a.nameHash < b.nameHash;
+  });
+
+  for (size_t i = 1; i < mEntries.size(); i++) {
+    const ArchiveEntry& a = mEntries[i - 1];
+    const ArchiveEntry& b = mEntries[i];
+
+    if (a.nameHash == b.nameHash
+        && mNames.compare(a.nameOffset, a.nameLength, mNames, b.nameOffset, b.nameLength) == 0) {
+      LogError("Assets - Archive has two entries named {}", mNames.substr(a.nameOffset, a.nameLength));
+      mFile.close();
+      return false;
+    }
+  }
+
+  std::vector<std::byte> toc(mEntries.size() * sizeof(ArchiveEntry) + mNames.size());
+  std::memcpy(toc.data(), mEntries.data(), mEntries.size() * sizeof(ArchiveEntry));
+  std::memcpy(toc.data() + mEntries.size() * sizeof(ArchiveEntry), mNames.data(), mNames.size());
+
+  ArchiveHeader header{};
+  header.magic = ArchiveMagic;
+  header.version = ArchiveVersion;
+  header.entryCount = static_cast<uint32_t>(mEntries.size());
+  header.alignment = mAlignment;
+  header.tocOffset = AlignUp(mOffset, mAlignment);
+  header.tocSize = toc.size();
+  header.tocHash = HashBytes(toc.data(), toc.size());
+
+  WriteAligned(toc);
+  mFile.seekp(0);
+  mFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  mFile.close();
+
+  if (!mFile.good()) {
+    LogError("Assets - Failed to write archive: {}", mTempPath.string());
+    return false;
+  }
+
+  std::error_code ec;
+  std::filesystem::rename(mTempPath, mPath, ec);
+  if (ec) {
+    LogError("Assets - Failed to replace archive: {}", ec.message());
+    return false;
+  }
+
+  LogInfo("Assets - Wrote archive {} ({} entries, {} bytes)", mPath.string(), mEntries.size(), mOffset);
+  return true;
+}
+
+bool AssetArchiveWriter::WriteAligned(std::span<const std::byte> data) {
+  static constexpr char Zeros[256] = {};
+
+  for (uint64_t padding = AlignUp(mOffset, mAlignment) - mOffset; padding > 0;) {
+    uint64_t chunk = std::min<uint64_t>(padding, sizeof(Zeros));
+    mFile.write(Zeros, static_cast<std::streamsize>(chunk));
+    padding -= chunk;
+    mOffset += chunk;
+  }
+
+  mFile.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+  mOffset += data.size();
+  return mFile.good();
+}
+
+// Reads `blob` back from the temporary file and compares it with `data`.
+bool AssetArchiveWriter::MatchesBlob(const ArchiveEntry& blob, std::span<const std::byte> data) {
+  if (blob.size != data.size()) {
+    return false;
+  }
+
+  mFile.flush();
+
+  std::ifstream file(mTempPath, std::ios::binary);
+  mStoredBlob.resize(blob.storedSize);
+  file.seekg(static_cast<std::streamoff>(blob.offset));
+  file.read(reinterpret_cast<char*>(mStoredBlob.data()), static_cast<std::streamsize>(mStoredBlob.size()));
+
+  if (!file.good()) {
+    LogWarning("Assets - Failed to read back a blob of {}, storing a duplicate", mTempPath.string());
+    return false;
+  }
+
+  std::span<const std::byte> content = mStoredBlob;
+
+  if (blob.compression == AssetCompression::Lz4) {
+    mBlobData.resize(blob.size);
+
+    if (!Lz4Decompress(mStoredBlob, mBlobData)) {
+      return false;
+    }
+
+    content = mBlobData;
+  }
+
+  return data.empty() || std::memcmp(content.data(), data.data(), data.size()) == 0;
+}
+
+} // namespace qpl
@@ -0,0 +1,157 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#ifndef QPL_ASSET_ARCHIVE_HPP
+#define QPL_ASSET_ARCHIVE_HPP
+
+#include <span>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <fstream>
+#include <filesystem>
+#include <string_view>
+#include <unordered_map>
+
+#include <core/core.hpp>
+#include "asset-compression.hpp"
+
+namespace qpl {
+
+//
+// ---- Archive Format ---------------------------------
+//
+// An archive is a header, the entry blobs, and a table of contents followed by the entry names:
+//
+//   ArchiveHeader | blob | pad | blob | pad | ... | ArchiveEntry[entryCount] | names
+//
+// Every blob starts at a multiple of the header's alignment, so uncompressed GPU data can be copied straight out of
+// the mapping with the alignment copies expect. Entries are sorted by name hash for lookup. Entries with the same
+// content share one blob. All values are little endian.
+//
+struct ArchiveHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t entryCount;
+  uint32_t alignment;
+  uint64_t tocOffset;
+  // Size of the entry table and the names after it.
+  uint64_t tocSize;
+  uint64_t tocHash;
+};
+
+struct ArchiveEntry {
+  uint64_t nameHash;
+  // Hash of the uncompressed content.
+  uint64_t contentHash;
+  uint64_t offset;
+  uint64_t storedSize;
+  uint64_t size;
+  // Relative to the end of the entry table.
+  uint32_t nameOffset;
+  uint32_t nameLength;
+  AssetCompression compression;
+  uint8_t reserved[7];
+};
+
+static_assert(sizeof(ArchiveHeader) == 40);
+static_assert(sizeof(ArchiveEntry) == 56);
+
+QPL_INLINE_CONSTEXPR uint32_t ArchiveMagic = 0x4B415051; // "QPAK"
+QPL_INLINE_CONSTEXPR uint32_t ArchiveVersion = 1;
+
+// Covers UploadRing::CopyAlignment and the non-coherent atom size of every common device.
+QPL_INLINE_CONSTEXPR uint32_t ArchiveDefaultAlignment = 256;
+
+//
+// ---- Asset Archive ---------------------------------
+//
+// Read-only view of an archive. The file is memory mapped, so opening it only reads the table of contents, and an
+// entry's pages are read from disk when it is first accessed. Uncompressed entries are returned as spans straight
+// into the mapping, to be copied into staging memory without an intermediate buffer.
+//
+// Every method is const and safe to call from any thread once Open() has returned.
+//
+class AssetArchive final {
+public:
+  // Maps `path` and validates its header and table of contents. Returns false, leaving the archive closed, if the
+  // file is missing or malformed.
+  bool Open(const std::filesystem::path& path);
+  void Close();
+
+  // `name` uses '/' as separator and is relative to the directory that was packed. nullptr if there is no such entry.
+  const ArchiveEntry* Find(std::string_view name) const;
+
+  std::string_view GetName(const ArchiveEntry& entry) const;
+
+  // The bytes as stored in the archive. For entries without compression this is the asset itself.
+  std::span<const std::byte> GetStoredData(const ArchiveEntry& entry) const;
+
+  // Writes the asset into `dst`, which must be exactly entry.size bytes: a copy from the mapping, or decompression.
+  // With `verify` the result is also checked against the content hash. Returns false if the entry is corrupt.
+  bool Read(const ArchiveEntry& entry, std::span<std::byte> dst, bool verify = false) const;
+
+  QPL_INLINE std::span<const ArchiveEntry> GetEntries() const {
+    return mEntries;
+  }
+
+  QPL_INLINE bool IsOpen() const {
+    return mFile.IsOpen();
+  }
+
+private:
+  bool Validate(const std::filesystem::path& path);
+
+private:
+  MappedFile mFile;
+  std::span<const ArchiveEntry> mEntries;
+  std::string_view mNames;
+};
+
+//
+// ---- Asset Archive Writer ---------------------------------
+//
+// Builds an archive one entry at a time. Blobs are streamed to a temporary file as they are added; Finish() appends
+// the table of contents and renames the file over `path`, so a failed or interrupted pack never leaves a torn archive
+// behind and processes that still map the old one keep a valid view.
+//
+class AssetArchiveWriter final {
+public:
+  bool Open(const std::filesystem::path& path, uint32_t alignment = ArchiveDefaultAlignment);
+
+  // Adds `data` under `name`. Compressed entries fall back to being stored as-is when compression does not make them
+  // smaller. Entries with the same content as an earlier one point at its blob instead of storing another copy; a
+  // blob with a matching hash is read back and compared first, so a hash collision never aliases two entries.
+  bool Add(std::string_view name, std::span<const std::byte> data, AssetCompression compression);
+
+  bool Finish();
+
+  QPL_INLINE uint64_t GetSize() const {
+    return mOffset;
+  }
+
+private:
+  bool WriteAligned(std::span<const std::byte> data);
+  bool MatchesBlob(const ArchiveEntry& blob, std::span<const std::byte> data);
+
+private:
+  std::filesystem::path mPath;
+  std::filesystem::path mTempPath;
+  std::ofstream mFile;
+  uint32_t mAlignment = ArchiveDefaultAlignment;
+  uint64_t mOffset = 0;
+
+  std::vector<ArchiveEntry> mEntries;
+  std::string mNames;
+  // Content hash -> index of the first entry with that content. Colliding contents each get an entry of their own.
+  std::unordered_multimap<uint64_t, size_t> mBlobs;
+  std::vector<std::byte> mScratch;
+  // Blobs read back by MatchesBlob(), as stored and decompressed.
+  std::vector<std::byte> mStoredBlob;
+  std::vector<std::byte> mBlobData;
+};
+
+} // namespace qpl
+
+#endif
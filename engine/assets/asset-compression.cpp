@@ -0,0 +1,239 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#include "asset-compression.hpp"
+
+#include <array>
+#include <algorithm>
+#include <limits>
+#include <cstring>
+
+namespace qpl {
+
+// Limits of the block format. The last five bytes are always literals, and no match may start within the last twelve.
+static constexpr size_t MinMatch = 4;
+static constexpr size_t LastLiterals = 5;
+static constexpr size_t MatchFindLimit = 12;
+static constexpr size_t MaxOffset = 65535;
+
+static constexpr uint32_t HashBits = 12;
+
+// Short copies are done as one fixed-size copy when both buffers have room for it, which compiles to a couple of
+// vector moves instead of a call.
+static constexpr size_t WildCopySize = 16;
+
+static uint32_t Read32(const std::byte* data) {
+  uint32_t value;
+  std::memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+static uint32_t HashSequence(uint32_t sequence) {
+  return (sequence * 2654435761u) >> (32 - HashBits);
+}
+
+// Lengths of 15 and up continue in extra bytes, 255 at a time.
+static void WriteLength(std::byte*& out, size_t length) {
+  for (length -= 15; length >= 255; length -= 255) {
+    *out++ = std::byte{255};
+  }
+
+  *out++ = static_cast<std::byte>(length);
+}
+
+static bool ReadLength(const std::byte*& in, const std::byte* inEnd, size_t& length) {
+  if (length != 15) {
+    return true;
+  }
+
+  uint8_t byte;
+
+  do {
+    if (in == inEnd) {
+      return false;
+    }
+
+    byte = static_cast<uint8_t>(*in++);
+    length += byte;
+  } while (byte == 255);
+
+  return true;
+}
+
+// Writes one sequence: `literalCount` literals followed by a match, or just the literals if `matchLength` is 0.
+static bool WriteSequence(
+  std::byte*& out,
+  const std::byte* outEnd,
+  const std::byte* literals,
+  size_t literalCount,
+  size_t offset,
+  size_t matchLength
+) {
+  size_t worstCase = 1 + literalCount / 255 + 1 + literalCount + 2 + matchLength / 255 + 1;
+
+  if ((size_t)(outEnd - out) < worstCase) {
+    return false;
+  }
+
+  uint8_t token = static_cast<uint8_t>(std::min<size_t>(literalCount, 15) << 4);
+
+  if (matchLength != 0) {
+    token |= static_cast<uint8_t>(std::min<size_t>(matchLength - MinMatch, 15));
+  }
+
+  *out++ = static_cast<std::byte>(token);
+
+  if (literalCount >= 15) {
+    WriteLength(out, literalCount);
+  }
+
+  if (literalCount != 0) {
+    std::memcpy(out, literals, literalCount);
+    out += literalCount;
+  }
+
+  if (matchLength == 0) {
+    return true;
+  }
+
+  *out++ = static_cast<std::byte>(offset & 0xFF);
+  *out++ = static_cast<std::byte>(offset >> 8);
+
+  if (matchLength - MinMatch >= 15) {
+    WriteLength(out, matchLength - MinMatch);
+  }
+
+  return true;
+}
+
+size_t Lz4Compress(std::span<const std::byte> src, std::span<std::byte> dst) {
+  if (src.size() >= std::numeric_limits<uint32_t>::max()) {
+    return 0;
+  }
+
+  const std::byte* in = src.data();
+  std::byte* out = dst.data();
+  const std::byte* outEnd = out + dst.size();
+
+  // Position + 1 of the last sequence with each hash; 0 is empty.
+  std::array<uint32_t, 1u << HashBits> table{};
+
+  size_t anchor = 0;
+  size_t pos = 0;
+
+  // Inputs too short to hold a match past the end-of-block rules are stored as literals only.
+  if (src.size() > MatchFindLimit) {
+    size_t matchLimit = src.size() - LastLiterals;
+
+    while (pos + MatchFindLimit <= src.size()) {
+      uint32_t sequence = Read32(in + pos);
+      uint32_t& slot = table[HashSequence(sequence)];
+      size_t candidate = slot;
+      slot = static_cast<uint32_t>(pos + 1);
+
+      if (candidate == 0 || pos - (candidate - 1) > MaxOffset || Read32(in + candidate - 1) != sequence) {
+        pos++;
+        continue;
+      }
+
+      size_t matchPos = candidate - 1;
+      size_t length = MinMatch;
+
+      while (pos + length < matchLimit && in[pos + length] == in[matchPos + length]) {
+        length++;
+      }
+
+      if (!WriteSequence(out, outEnd, in + anchor, pos - anchor, pos - matchPos, length)) {
+        return 0;
+      }
+
+      pos += length;
+      anchor = pos;
+    }
+  }
+
+  if (!WriteSequence(out, outEnd, in + anchor, src.size() - anchor, 0, 0)) {
+    return 0;
+  }
+
+  return static_cast<size_t>(out - dst.data());
+}
+
+bool Lz4Decompress(std::span<const std::byte> src, std::span<std::byte> dst) {
+  const std::byte* in = src.data();
+  const std::byte* inEnd = in + src.size();
+  std::byte* out = dst.data();
+  std::byte* outEnd = out + dst.size();
+
+  while (true) {
+    if (in == inEnd) {
+      return false;
+    }
+
+    uint8_t token = static_cast<uint8_t>(*in++);
+    size_t literalCount = token >> 4;
+
+    if (!ReadLength(in, inEnd, literalCount) || literalCount > (size_t)(inEnd - in)
+        || literalCount > (size_t)(outEnd - out)) {
+      return false;
+    }
+
+    if (literalCount <= WildCopySize && (size_t)(inEnd - in) >= WildCopySize
+        && (size_t)(outEnd - out) >= WildCopySize) {
+      std::memcpy(out, in, WildCopySize);
+    }
+    else {
+      std::memcpy(out, in, literalCount);
+    }
+
+    in += literalCount;
+    out += literalCount;
+
+    // The last sequence has no match.
+    if (in == inEnd) {
+      return out == outEnd;
+    }
+
+    if (inEnd - in < 2) {
+      return false;
+    }
+
+    size_t offset = static_cast<size_t>(in[0]) | (static_cast<size_t>(in[1]) << 8);
+    in += 2;
+
+    size_t matchLength = token & 0xF;
+
+    if (offset == 0 || offset > (size_t)(out - dst.data()) || !ReadLength(in, inEnd, matchLength)) {
+      return false;
+    }
+
+    matchLength += MinMatch;
+
+    if (matchLength > (size_t)(outEnd - out)) {
+      return false;
+    }
+
+    const std::byte* match = out - offset;
+
+    if (offset >= WildCopySize && (size_t)(outEnd - out) >= matchLength + WildCopySize) {
+      for (size_t i = 0; i < matchLength; i += WildCopySize) {
+        std::memcpy(out + i, match + i, WildCopySize);
+      }
+
+      out += matchLength;
+      continue;
+    }
+
+    // Overlapping matches repeat the last `offset` bytes. Everything from `match` on already has that period, so each
+    // copy can take all of it, doubling the distance every time.
+    while (matchLength > 0) {
+      size_t chunk = std::min<size_t>(out - match, matchLength);
+      std::memcpy(out, match, chunk);
+      out += chunk;
+      matchLength -= chunk;
+    }
+  }
+}
+
+} // namespace qpl
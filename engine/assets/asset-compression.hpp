@@ -0,0 +1,45 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#ifndef QPL_ASSET_COMPRESSION_HPP
+#define QPL_ASSET_COMPRESSION_HPP
+
+#include <span>
+#include <cstddef>
+#include <cstdint>
+
+#include <core/core.hpp>
+
+namespace qpl {
+
+enum class AssetCompression : uint8_t {
+  None,
+  // LZ4 block format, without the frame around it: the stored and uncompressed sizes live in the archive.
+  Lz4,
+};
+
+//
+// ---- LZ4 ---------------------------------
+//
+// A small, self-contained codec for the LZ4 block format, so blocks written by the packer can also be produced or
+// read by the reference implementation. The compressor is the single-pass greedy one; it trades some ratio for
+// speed, which is the point of LZ4 in an archive that is decompressed at load time.
+//
+
+// Worst-case compressed size of `size` bytes.
+QPL_INLINE_CONSTEXPR size_t Lz4CompressBound(size_t size) {
+  return size + size / 255 + 16;
+}
+
+// Compresses `src` into `dst` and returns the compressed size, or 0 if it does not fit into `dst`. Inputs of 4 GiB or
+// more are not supported and also return 0.
+size_t Lz4Compress(std::span<const std::byte> src, std::span<std::byte> dst);
+
+// Decompresses `src` into `dst`, which must be exactly the uncompressed size. Returns false on malformed input; never
+// reads or writes outside either span.
+bool Lz4Decompress(std::span<const std::byte> src, std::span<std::byte> dst);
+
+} // namespace qpl
+
+#endif
@@ -0,0 +1,376 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#include "asset-io.hpp"
+
+#include <atomic>
+#include <algorithm>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+
+namespace qpl {
+
+// Largest single read; both read(2) and ReadFile() take sizes that may not fit bigger ones.
+static constexpr uint64_t MaxReadSize = 1ull << 30;
+
+void AsyncReader::Init(uint32_t queueDepth, uint32_t threadCount, bool allowIoUring) {
+  mQueueDepth = std::max(queueDepth, 1u);
+
+#ifdef __linux__
+  if (allowIoUring && InitRing(mQueueDepth)) {
+    LogInfo("Assets - Reading through io_uring (queue depth {})", mQueueDepth);
+    return;
+  }
+
+  if (allowIoUring) {
+    LogWarning("Assets - io_uring is unavailable, falling back to read threads");
+  }
+#else
+  (void)allowIoUring;
+#endif
+
+  threadCount = std::max(threadCount, 1u);
+
+  for (uint32_t i = 0; i < threadCount; i++) {
+    mThreads.emplace_back([this](std::stop_token stopToken) { ThreadMain(stopToken); });
+  }
+
+  LogInfo("Assets - Reading on {} thread(s)", threadCount);
+}
+
+void AsyncReader::Destroy() {
+  {
+    std::unique_lock lock(mMutex);
+    mSlotFreed.wait(lock, [this] { return mInFlight == 0; });
+  }
+
+  // Joining also waits for the callbacks of the last reads to return.
+#ifdef __linux__
+  if (IsUsingIoUring()) {
+    SubmitToRing(nullptr);
+    mRingThread.join();
+    DestroyRing();
+  }
+#endif
+
+  mThreads.clear();
+
+  for (NativeFile file : mFiles) {
+#ifdef _WIN32
+    CloseHandle(file);
+#else
+    close(file);
+#endif
+  }
+
+  mFiles.clear();
+}
+
+uint32_t AsyncReader::OpenFile(const std::filesystem::path& path) {
+#ifdef _WIN32
+  NativeFile file = CreateFileW(
+    path.c_str(),
+    GENERIC_READ,
+    FILE_SHARE_READ | FILE_SHARE_DELETE,
+    nullptr,
+    OPEN_EXISTING,
+    FILE_ATTRIBUTE_NORMAL,
+    nullptr
+  );
+
+  if (file == INVALID_HANDLE_VALUE) {
+    return InvalidFile;
+  }
+#else
+  NativeFile file = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+  if (file < 0) {
+    return InvalidFile;
+  }
+#endif
+
+  std::lock_guard lock(mFileMutex);
+  mFiles.push_back(file);
+  return static_cast<uint32_t>(mFiles.size() - 1);
+}
+
+void AsyncReader::Submit(const AsyncRead& read) {
+  // A zero-length read would look like the end of the file to io_uring.
+  if (read.dst.empty()) {
+    read.callback(read.userData, true);
+    return;
+  }
+
+  PendingRead* pending;
+
+  {
+    std::lock_guard lock(mFileMutex);
+    QPL_CORE_ASSERT(read.file < mFiles.size() && "invalid file index");
+    pending = new PendingRead{read, mFiles[read.file]};
+  }
+
+  {
+    std::unique_lock lock(mMutex);
+    mSlotFreed.wait(lock, [this] { return mInFlight < mQueueDepth; });
+    mInFlight++;
+
+    if (!IsUsingIoUring()) {
+      mQueue.push_back(pending);
+      mReadQueued.notify_one();
+      return;
+    }
+  }
+
+#ifdef __linux__
+  SubmitToRing(pending);
+#endif
+}
+
+bool AsyncReader::ReadAt(NativeFile file, uint64_t offset, std::span<std::byte> dst) {
+  while (!dst.empty()) {
+    size_t size = static_cast<size_t>(std::min<uint64_t>(dst.size(), MaxReadSize));
+
+#ifdef _WIN32
+    OVERLAPPED overlapped{};
+    overlapped.Offset = static_cast<DWORD>(offset);
+    overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+
+    DWORD read = 0;
+
+    if (!ReadFile(file, dst.data(), static_cast<DWORD>(size), &read, &overlapped) || read == 0) {
+      return false;
+    }
+#else
+    ssize_t read = pread(file, dst.data(), size, static_cast<off_t>(offset));
+
+    if (read < 0 && errno == EINTR) {
+      continue;
+    }
+
+    if (read <= 0) {
+      return false;
+    }
+#endif
+
+    dst = dst.subspan(static_cast<size_t>(read));
+    offset += static_cast<uint64_t>(read);
+  }
+
+  return true;
+}
+
+void AsyncReader::Complete(PendingRead* pending, bool success) {
+  {
+    std::lock_guard lock(mMutex);
+    mInFlight--;
+  }
+
+  // Freed before the callback runs, so a callback that submits a follow-up read never waits on its own slot.
+  mSlotFreed.notify_all();
+
+  pending->read.callback(pending->read.userData, success);
+  delete pending;
+}
+
+void AsyncReader::ThreadMain(std::stop_token stopToken) {
+  while (true) {
+    PendingRead* pending;
+
+    {
+      std::unique_lock lock(mMutex);
+
+      if (!mReadQueued.wait(lock, stopToken, [this] { return !mQueue.empty(); })) {
+        return;
+      }
+
+      pending = mQueue.front();
+      mQueue.pop_front();
+    }
+
+    Complete(pending, ReadAt(pending->file, pending->read.offset, pending->read.dst));
+  }
+}
+
+#ifdef __linux__
+
+//
+// ---- io_uring ---------------------------------
+//
+// Driven through the raw system calls rather than liburing, which the engine does not vendor. The submission and
+// completion rings are shared with the kernel: we write submission entries and advance the submission tail, the
+// kernel advances the completion tail, and each side publishes its index with release semantics.
+//
+
+static uint32_t* RingField(void* ring, uint32_t offset) {
+  return reinterpret_cast<uint32_t*>(static_cast<char*>(ring) + offset);
+}
+
+// IORING_OP_READ only exists since Linux 5.6, while rings themselves go back to 5.1. Probing needs 5.6 as well, so a
+// kernel that cannot be probed cannot read either.
+static bool SupportsRead(int ringFd) {
+  std::vector<std::byte> storage(sizeof(io_uring_probe) + IORING_OP_LAST * sizeof(io_uring_probe_op));
+  io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(storage.data());
+
+  if (syscall(__NR_io_uring_register, ringFd, IORING_REGISTER_PROBE, probe, IORING_OP_LAST) < 0) {
+    return false;
+  }
+
+  return IORING_OP_READ <= probe->last_op && (probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED) != 0;
+}
+
+bool AsyncReader::InitRing(uint32_t queueDepth) {
+  io_uring_params params{};
+  int ringFd = static_cast<int>(syscall(__NR_io_uring_setup, queueDepth, &params));
+
+  if (ringFd < 0) {
+    return false;
+  }
+
+  if (!SupportsRead(ringFd)) {
+    close(ringFd);
+    return false;
+  }
+
+  mRingFd = ringFd;
+  mSqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+  mCqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  mSqesSize = params.sq_entries * sizeof(io_uring_sqe);
+
+  // Newer kernels map both rings with one call.
+  bool singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+
+  if (singleMmap) {
+    mSqRingSize = mCqRingSize = std::max(mSqRingSize, mCqRingSize);
+  }
+
+  auto map = [ringFd](size_t size, off_t offset) -> void* {
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, offset);
+    return data == MAP_FAILED ? nullptr : data;
+  };
+
+  mSqRing = map(mSqRingSize, IORING_OFF_SQ_RING);
+  mCqRing = singleMmap ? mSqRing : map(mCqRingSize, IORING_OFF_CQ_RING);
+  mSqes = map(mSqesSize, IORING_OFF_SQES);
+
+  if (mSqRing == nullptr || mCqRing == nullptr || mSqes == nullptr) {
+    DestroyRing();
+    return false;
+  }
+
+  mSqHead = RingField(mSqRing, params.sq_off.head);
+  mSqTail = RingField(mSqRing, params.sq_off.tail);
+  mSqMask = RingField(mSqRing, params.sq_off.ring_mask);
+  mSqArray = RingField(mSqRing, params.sq_off.array);
+  mCqHead = RingField(mCqRing, params.cq_off.head);
+  mCqTail = RingField(mCqRing, params.cq_off.tail);
+  mCqMask = RingField(mCqRing, params.cq_off.ring_mask);
+  mCqes = static_cast<char*>(mCqRing) + params.cq_off.cqes;
+
+  mRingThread = std::jthread([this] { RingMain(); });
+  return true;
+}
+
+void AsyncReader::DestroyRing() {
+  if (mSqes != nullptr) {
+    munmap(mSqes, mSqesSize);
+  }
+
+  if (mCqRing != nullptr && mCqRing != mSqRing) {
+    munmap(mCqRing, mCqRingSize);
+  }
+
+  if (mSqRing != nullptr) {
+    munmap(mSqRing, mSqRingSize);
+  }
+
+  close(mRingFd);
+  mRingFd = -1;
+  mSqRing = mCqRing = mSqes = nullptr;
+}
+
+// Queues the rest of `pending`'s read, or with nullptr a no-op that tells the ring thread to exit.
+void AsyncReader::SubmitToRing(PendingRead* pending) {
+  std::lock_guard lock(mSubmitMutex);
+
+  // The queue depth keeps the reads in flight below the ring size, so there is always a free entry.
+  uint32_t tail = *mSqTail;
+  uint32_t index = tail & *mSqMask;
+
+  io_uring_sqe& sqe = static_cast<io_uring_sqe*>(mSqes)[index];
+  sqe = {};
+
+  if (pending == nullptr) {
+    sqe.opcode = IORING_OP_NOP;
+  }
+  else {
+    std::span<std::byte> rest = pending->read.dst.subspan(pending->done);
+
+    sqe.opcode = IORING_OP_READ;
+    sqe.fd = pending->file;
+    sqe.off = pending->read.offset + pending->done;
+    sqe.addr = reinterpret_cast<uint64_t>(rest.data());
+    sqe.len = static_cast<uint32_t>(std::min<uint64_t>(rest.size(), MaxReadSize));
+    sqe.user_data = reinterpret_cast<uint64_t>(pending);
+  }
+
+  mSqArray[index] = index;
+  std::atomic_ref(*mSqTail).store(tail + 1, std::memory_order_release);
+
+  while (syscall(__NR_io_uring_enter, mRingFd, 1, 0, 0, nullptr, 0) < 0) {
+    if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+      QPL_CORE_ASSERT(false && "failed to submit to io_uring!");
+    }
+  }
+}
+
+void AsyncReader::RingMain() {
+  bool stopping = false;
+
+  while (!stopping) {
+    if (syscall(__NR_io_uring_enter, mRingFd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 && errno != EINTR) {
+      QPL_CORE_ASSERT(false && "failed to wait on io_uring!");
+    }
+
+    uint32_t head = *mCqHead;
+    uint32_t tail = std::atomic_ref(*mCqTail).load(std::memory_order_acquire);
+
+    for (; head != tail; head++) {
+      // Released before it is handled, so completions of reads the callbacks submit always find room.
+      io_uring_cqe cqe = static_cast<io_uring_cqe*>(mCqes)[head & *mCqMask];
+      std::atomic_ref(*mCqHead).store(head + 1, std::memory_order_release);
+
+      PendingRead* pending = reinterpret_cast<PendingRead*>(cqe.user_data);
+
+      if (pending == nullptr) {
+        stopping = true;
+      }
+      else if (cqe.res <= 0) {
+        Complete(pending, false);
+      }
+      else if ((pending->done += static_cast<uint64_t>(cqe.res)) < pending->read.dst.size()) {
+        SubmitToRing(pending);
+      }
+      else {
+        Complete(pending, true);
+      }
+    }
+  }
+}
+
+#endif
+
+} // namespace qpl
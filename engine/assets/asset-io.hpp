@@ -0,0 +1,122 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#ifndef QPL_ASSET_IO_HPP
+#define QPL_ASSET_IO_HPP
+
+#include <span>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <filesystem>
+#include <condition_variable>
+
+#include <core/core.hpp>
+
+namespace qpl {
+
+// Called on an I/O thread once a read has finished; `success` is false if it failed or hit the end of the file.
+using AsyncReadCallback = void (*)(void* userData, bool success);
+
+struct AsyncRead {
+  uint32_t file = 0;
+  uint64_t offset = 0;
+  std::span<std::byte> dst;
+  AsyncReadCallback callback = nullptr;
+  void* userData = nullptr;
+};
+
+//
+// ---- Async Reader ---------------------------------
+//
+// Reads file ranges without blocking the caller. On Linux reads go through an io_uring: the submitting thread queues
+// them with one syscall and a single completion thread reaps them, so any number of reads can be in flight on one
+// thread. Elsewhere, or if the kernel refuses to set up a ring, a few threads run blocking reads instead.
+//
+// Reads are not prioritized here; callers that care keep the queue short and submit the most important reads first.
+//
+class AsyncReader final {
+public:
+  static constexpr uint32_t InvalidFile = UINT32_MAX;
+
+  // `queueDepth` caps the reads in flight; Submit() blocks while it is reached. `threadCount` sizes the fallback.
+  void Init(uint32_t queueDepth, uint32_t threadCount, bool allowIoUring);
+
+  // Waits for every submitted read to finish, then closes the files.
+  void Destroy();
+
+  // Opens `path` for reading and returns the file index to pass in AsyncRead, or InvalidFile.
+  uint32_t OpenFile(const std::filesystem::path& path);
+
+  // May be called from any thread, including from a callback. Empty reads call back right away, on the caller.
+  void Submit(const AsyncRead& read);
+
+  QPL_INLINE bool IsUsingIoUring() const {
+    return mRingFd >= 0;
+  }
+
+private:
+#ifdef _WIN32
+  using NativeFile = void*;
+#else
+  using NativeFile = int;
+#endif
+
+  struct PendingRead {
+    AsyncRead read;
+    NativeFile file;
+    // Bytes read so far; reads can come back short and are resubmitted for the rest.
+    uint64_t done = 0;
+  };
+
+  static bool ReadAt(NativeFile file, uint64_t offset, std::span<std::byte> dst);
+
+  void Complete(PendingRead* pending, bool success);
+  void ThreadMain(std::stop_token stopToken);
+
+#ifdef __linux__
+  bool InitRing(uint32_t queueDepth);
+  void DestroyRing();
+  void SubmitToRing(PendingRead* pending);
+  void RingMain();
+#endif
+
+private:
+  uint32_t mQueueDepth = 0;
+
+  std::mutex mFileMutex;
+  std::vector<NativeFile> mFiles;
+
+  std::mutex mMutex;
+  std::condition_variable mSlotFreed;
+  std::condition_variable_any mReadQueued;
+  std::deque<PendingRead*> mQueue;
+  uint32_t mInFlight = 0;
+  std::vector<std::jthread> mThreads;
+
+  // io_uring state, see InitRing(). Submissions are serialized by mSubmitMutex; only the ring thread reaps.
+  int mRingFd = -1;
+  std::mutex mSubmitMutex;
+  void* mSqRing = nullptr;
+  void* mCqRing = nullptr;
+  void* mSqes = nullptr;
+  size_t mSqRingSize = 0;
+  size_t mCqRingSize = 0;
+  size_t mSqesSize = 0;
+  uint32_t* mSqHead = nullptr;
+  uint32_t* mSqTail = nullptr;
+  uint32_t* mSqMask = nullptr;
+  uint32_t* mSqArray = nullptr;
+  uint32_t* mCqHead = nullptr;
+  uint32_t* mCqTail = nullptr;
+  uint32_t* mCqMask = nullptr;
+  void* mCqes = nullptr;
+  std::jthread mRingThread;
+};
+
+} // namespace qpl
+
+#endif
@@ -0,0 +1,352 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#include "asset-streamer.hpp"
+
+#include <algorithm>
+
+namespace qpl {
+
+// Memory a request holds between starting its read and handing its data off.
+QPL_INLINE static uint64_t GetInFlightBytes(const ArchiveEntry& entry) {
+  return entry.storedSize + (entry.compression != AssetCompression::None ? entry.size : 0);
+}
+
+void AssetStreamer::Init(JobSystem& jobSystem, UploadRing* uploadRing, const StreamerConfig& config) {
+  mJobSystem = &jobSystem;
+  mUploadRing = uploadRing;
+  mConfig = config;
+  mConfig.maxInFlightReads = std::max(mConfig.maxInFlightReads, 1u);
+
+  mReader.Init(mConfig.maxInFlightReads, mConfig.ioThreads, mConfig.useIoUring);
+}
+
+void AssetStreamer::Destroy() {
+  if (mJobSystem == nullptr) {
+    return;
+  }
+
+  {
+    std::unique_lock lock(mMutex);
+    mQueue.clear();
+    mUploading.clear();
+
+    for (auto& [handle, stream] : mStreams) {
+      stream->released = true;
+      mReleased.push_back(std::move(stream));
+    }
+
+    mStreams.clear();
+
+    // With the queue empty nothing new starts; wait for the reads that already have. Decompression jobs are waited
+    // on below, and the reader joins its threads, so no callback is left running on a freed stream.
+    mStateChanged.wait(lock, [this] {
+      return std::none_of(mReleased.begin(), mReleased.end(), [](const std::unique_ptr<Stream>& stream) {
+        return stream->state == StreamState::Reading;
+      });
+    });
+  }
+
+  for (std::unique_ptr<Stream>& stream : mReleased) {
+    mJobSystem->Wait(stream->decompressCounter);
+  }
+
+  mReleased.clear();
+  mReader.Destroy();
+  mArchives.clear();
+  mJobSystem = nullptr;
+}
+
+bool AssetStreamer::Mount(const std::filesystem::path& path) {
+  auto mounted = std::make_unique<MountedArchive>();
+
+  if (!mounted->archive.Open(path)) {
+    return false;
+  }
+
+  mounted->file = mReader.OpenFile(path);
+
+  if (mounted->file == AsyncReader::InvalidFile) {
+    LogWarning("Assets - Failed to open archive for streaming: {}", path.string());
+    return false;
+  }
+
+  std::lock_guard lock(mMutex);
+  mArchives.push_back(std::move(mounted));
+  return true;
+}
+
+StreamHandle AssetStreamer::Request(const StreamRequest& request) {
+  QPL_CORE_ASSERT(
+    (request.buffer == VK_NULL_HANDLE || mUploadRing != nullptr) && "streaming into a buffer needs an upload ring"
+  );
+
+  auto stream = std::make_unique<Stream>();
+  stream->streamer = this;
+  stream->priority = request.priority;
+  stream->buffer = request.buffer;
+  stream->bufferOffset = request.bufferOffset;
+  stream->decompressJob = {DecompressJob, stream.get()};
+
+  StreamHandle handle;
+
+  {
+    std::lock_guard lock(mMutex);
+
+    for (auto it = mArchives.rbegin(); it != mArchives.rend() && stream->entry == nullptr; ++it) {
+      stream->archive = it->get();
+      stream->entry = (*it)->archive.Find(request.name);
+    }
+
+    if (stream->entry == nullptr) {
+      LogWarning("Assets - No mounted archive contains {}", request.name);
+      return InvalidStreamHandle;
+    }
+
+    handle = stream->handle = mNextHandle++;
+    mQueue.insert({stream->priority, handle});
+    mStreams.emplace(handle, std::move(stream));
+  }
+
+  Dispatch();
+  return handle;
+}
+
+void AssetStreamer::SetPriority(StreamHandle handle, float priority) {
+  std::lock_guard lock(mMutex);
+
+  auto it = mStreams.find(handle);
+  if (it == mStreams.end() || it->second->state != StreamState::Queued) {
+    return;
+  }
+
+  Stream& stream = *it->second;
+  mQueue.erase({stream.priority, handle});
+  stream.priority = priority;
+  mQueue.insert({stream.priority, handle});
+}
+
+void AssetStreamer::Release(StreamHandle handle) {
+  std::lock_guard lock(mMutex);
+
+  auto it = mStreams.find(handle);
+  if (it == mStreams.end()) {
+    return;
+  }
+
+  std::unique_ptr<Stream> stream = std::move(it->second);
+  mStreams.erase(it);
+
+  if (stream->state == StreamState::Queued) {
+    mQueue.erase({stream->priority, handle});
+  }
+
+  // Uploads need no waiting for: the ring copied the data when the upload was issued.
+  if (!IsIdle(*stream)) {
+    stream->released = true;
+    mReleased.push_back(std::move(stream));
+  }
+}
+
+StreamState AssetStreamer::GetState(StreamHandle handle) const {
+  std::lock_guard lock(mMutex);
+
+  auto it = mStreams.find(handle);
+  return it != mStreams.end() ? it->second->state : StreamState::Failed;
+}
+
+StreamState AssetStreamer::Wait(StreamHandle handle) {
+  std::unique_lock lock(mMutex);
+  StreamState state = StreamState::Failed;
+
+  mStateChanged.wait(lock, [&] {
+    auto it = mStreams.find(handle);
+    state = it != mStreams.end() ? it->second->state : StreamState::Failed;
+    return state == StreamState::Complete || state == StreamState::Failed;
+  });
+
+  return state;
+}
+
+std::span<const std::byte> AssetStreamer::GetData(StreamHandle handle) const {
+  std::lock_guard lock(mMutex);
+
+  auto it = mStreams.find(handle);
+  if (it == mStreams.end() || it->second->state != StreamState::Complete) {
+    return {};
+  }
+
+  return it->second->data;
+}
+
+void AssetStreamer::Update() {
+  bool completed = false;
+
+  {
+    std::lock_guard lock(mMutex);
+
+    std::erase_if(mUploading, [&](StreamHandle handle) {
+      auto it = mStreams.find(handle);
+
+      if (it == mStreams.end()) {
+        return true;
+      }
+
+      if (!mUploadRing->IsComplete(it->second->ticket)) {
+        return false;
+      }
+
+      it->second->state = StreamState::Complete;
+      completed = true;
+      return true;
+    });
+
+    std::erase_if(mReleased, [&](const std::unique_ptr<Stream>& stream) { return IsIdle(*stream); });
+  }
+
+  if (completed) {
+    mStateChanged.notify_all();
+  }
+}
+
+void AssetStreamer::Dispatch() {
+  std::vector<Stream*> started;
+
+  {
+    std::lock_guard lock(mMutex);
+
+    while (!mQueue.empty() && mInFlightReads < mConfig.maxInFlightReads) {
+      Stream* stream = mStreams.at(mQueue.begin()->handle).get();
+      uint64_t bytes = GetInFlightBytes(*stream->entry);
+
+      if (mInFlightBytes != 0 && mInFlightBytes + bytes > mConfig.maxInFlightBytes) {
+        break;
+      }
+
+      mQueue.erase(mQueue.begin());
+      stream->state = StreamState::Reading;
+      mInFlightReads++;
+      mInFlightBytes += bytes;
+      started.push_back(stream);
+    }
+  }
+
+  // Nothing else touches a stream's buffers while it is reading, so they are allocated outside the lock.
+  for (Stream* stream : started) {
+    stream->stored.resize(stream->entry->storedSize);
+
+    AsyncRead read;
+    read.file = stream->archive->file;
+    read.offset = stream->entry->offset;
+    read.dst = stream->stored;
+    read.callback = OnRead;
+    read.userData = stream;
+    mReader.Submit(read);
+  }
+}
+
+void AssetStreamer::OnRead(void* data, bool success) {
+  Stream* stream = static_cast<Stream*>(data);
+  AssetStreamer& streamer = *stream->streamer;
+  bool released;
+
+  {
+    std::lock_guard lock(streamer.mMutex);
+    streamer.mInFlightReads--;
+    released = stream->released;
+
+    if (success && !released && stream->entry->compression != AssetCompression::None) {
+      stream->state = StreamState::Decompressing;
+    }
+  }
+
+  streamer.mStateChanged.notify_all();
+
+  if (!success || released) {
+    if (!success) {
+      LogError("Assets - Failed to read {}", stream->archive->archive.GetName(*stream->entry));
+    }
+
+    streamer.Fail(stream);
+  }
+  else if (stream->entry->compression != AssetCompression::None) {
+    streamer.mJobSystem->Run(stream->decompressJob, stream->decompressCounter);
+    streamer.Dispatch();
+  }
+  else {
+    stream->data = std::move(stream->stored);
+    streamer.Deliver(stream);
+  }
+}
+
+void AssetStreamer::DecompressJob(void* data) {
+  Stream* stream = static_cast<Stream*>(data);
+  AssetStreamer& streamer = *stream->streamer;
+
+  stream->data.resize(stream->entry->size);
+
+  if (!Lz4Decompress(stream->stored, stream->data)) {
+    LogError("Assets - Failed to decompress {}", stream->archive->archive.GetName(*stream->entry));
+    streamer.Fail(stream);
+    return;
+  }
+
+  stream->stored = {};
+  streamer.Deliver(stream);
+}
+
+void AssetStreamer::Deliver(Stream* stream) {
+  if (mConfig.verifyContent && HashBytes(stream->data.data(), stream->data.size()) != stream->entry->contentHash) {
+    LogError("Assets - Content hash mismatch in {}", stream->archive->archive.GetName(*stream->entry));
+    Fail(stream);
+    return;
+  }
+
+  bool released;
+
+  {
+    std::lock_guard lock(mMutex);
+    released = stream->released;
+  }
+
+  UploadTicket ticket = 0;
+
+  if (stream->buffer != VK_NULL_HANDLE && !released && !stream->data.empty()) {
+    ticket = mUploadRing->UploadBuffer(stream->buffer, stream->bufferOffset, stream->data);
+    stream->data = {};
+  }
+
+  {
+    std::lock_guard lock(mMutex);
+    mInFlightBytes -= GetInFlightBytes(*stream->entry);
+
+    if (ticket != 0) {
+      stream->ticket = ticket;
+      stream->state = StreamState::Uploading;
+      mUploading.push_back(stream->handle);
+    }
+    else {
+      stream->state = released ? StreamState::Failed : StreamState::Complete;
+    }
+  }
+
+  mStateChanged.notify_all();
+  Dispatch();
+}
+
+void AssetStreamer::Fail(Stream* stream) {
+  stream->stored = {};
+  stream->data = {};
+
+  {
+    std::lock_guard lock(mMutex);
+    mInFlightBytes -= GetInFlightBytes(*stream->entry);
+    stream->state = StreamState::Failed;
+  }
+
+  mStateChanged.notify_all();
+  Dispatch();
+}
+
+} // namespace qpl
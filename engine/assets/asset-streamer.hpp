@@ -0,0 +1,195 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#ifndef QPL_ASSET_STREAMER_HPP
+#define QPL_ASSET_STREAMER_HPP
+
+#include <set>
+#include <span>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+#include <unordered_map>
+#include <condition_variable>
+
+#include <vulkan/vulkan.h>
+#include <core/core.hpp>
+#include <rendering/upload-ring.hpp>
+#include "asset-archive.hpp"
+#include "asset-io.hpp"
+
+namespace qpl {
+
+// Identifies a request made through AssetStreamer::Request(). Increases monotonically; 0 is never issued.
+using StreamHandle = uint64_t;
+
+QPL_INLINE_CONSTEXPR StreamHandle InvalidStreamHandle = 0;
+
+enum class StreamState : uint8_t {
+  Queued,
+  Reading,
+  Decompressing,
+  Uploading,
+  Complete,
+  Failed,
+};
+
+struct StreamRequest {
+  // Entry name in one of the mounted archives.
+  std::string_view name;
+  // Higher runs first. Callers derive it from whatever matters to them - distance, visibility, screen size - and
+  // update it with SetPriority() while the request waits.
+  float priority = 0.0f;
+
+  // Optional destination. Without one the data stays on the CPU for GetData(); with one it is copied into `buffer`
+  // at `bufferOffset` through the upload ring and the CPU copy is dropped.
+  VkBuffer buffer = VK_NULL_HANDLE;
+  VkDeviceSize bufferOffset = 0;
+};
+
+struct StreamerConfig {
+  // Reads in flight at once. Deeper queues let the device reorder more, but a new urgent request waits behind them.
+  uint32_t maxInFlightReads = 32;
+  // Bytes read or decompressed but not yet handed off, which bounds the memory streaming takes. A single larger
+  // request still runs, alone.
+  uint64_t maxInFlightBytes = 64ull * 1024 * 1024;
+  // Read threads for platforms or kernels without io_uring.
+  uint32_t ioThreads = 2;
+  bool useIoUring = true;
+  // Checks every asset against its content hash after decompression.
+  bool verifyContent = false;
+};
+
+//
+// ---- Asset Streamer ---------------------------------
+//
+// Loads archive entries asynchronously. A request moves through three stages, each on its own threads:
+//
+//   read         the stored bytes, on the AsyncReader (io_uring, or read threads)
+//   decompress   on the job system, for compressed entries only
+//   upload       through the upload ring, for requests with a GPU destination
+//
+// Queued requests are started highest priority first, as read slots and the in-flight byte budget allow, so a level
+// load or a streaming camera can queue far more than it needs right away without delaying what it needs first.
+//
+// Everything but Update() and Destroy() may be called from any thread. Update() belongs to the render thread, between
+// frames, since it is what notices finished uploads; Wait() on a request with a GPU destination must therefore not be
+// called from the render thread.
+//
+class AssetStreamer final {
+public:
+  void Init(JobSystem& jobSystem, UploadRing* uploadRing, const StreamerConfig& config);
+  void Destroy();
+
+  // Makes the entries of the archive at `path` available. Archives mounted later take precedence over earlier ones
+  // for names they share, so patches can be mounted over a base archive.
+  bool Mount(const std::filesystem::path& path);
+
+  // Queues a request. Returns InvalidStreamHandle if no mounted archive has the name.
+  StreamHandle Request(const StreamRequest& request);
+
+  // Reorders a request that has not started reading yet; does nothing otherwise.
+  void SetPriority(StreamHandle handle, float priority);
+
+  // Cancels the request if it has not finished, and frees its data. The handle is invalid afterwards. A request
+  // already uploading still writes its destination buffer.
+  void Release(StreamHandle handle);
+
+  StreamState GetState(StreamHandle handle) const;
+
+  // Blocks until the request completes or fails, and returns which.
+  StreamState Wait(StreamHandle handle);
+
+  // The loaded bytes of a complete request without a GPU destination. Valid until Release().
+  std::span<const std::byte> GetData(StreamHandle handle) const;
+
+  // Completes the requests whose uploads have finished, and frees released requests once no stage uses them.
+  void Update();
+
+  QPL_INLINE const AsyncReader& GetReader() const {
+    return mReader;
+  }
+
+private:
+  struct MountedArchive {
+    AssetArchive archive;
+    uint32_t file = AsyncReader::InvalidFile;
+  };
+
+  struct Stream {
+    AssetStreamer* streamer = nullptr;
+    StreamHandle handle = InvalidStreamHandle;
+    StreamState state = StreamState::Queued;
+    float priority = 0.0f;
+    bool released = false;
+
+    const MountedArchive* archive = nullptr;
+    const ArchiveEntry* entry = nullptr;
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VkDeviceSize bufferOffset = 0;
+
+    // What was read, then what it decompressed to.
+    std::vector<std::byte> stored;
+    std::vector<std::byte> data;
+    UploadTicket ticket = 0;
+
+    // Lives as long as the stream, which outlives the job; the job system touches both after the job returns.
+    Job decompressJob;
+    JobCounter decompressCounter;
+  };
+
+  // Ordered highest priority first, then oldest first.
+  struct QueuedStream {
+    float priority;
+    StreamHandle handle;
+
+    QPL_INLINE bool operator<(const QueuedStream& other) const {
+      return priority != other.priority ? priority > other.priority : handle < other.handle;
+    }
+  };
+
+  // Starts as many queued reads as the limits allow. Locks mMutex.
+  void Dispatch();
+
+  static void OnRead(void* data, bool success);
+  static void DecompressJob(void* data);
+
+  // Hands decompressed data on to the upload ring, or completes the request.
+  void Deliver(Stream* stream);
+  void Fail(Stream* stream);
+
+  // Streams no stage holds anymore. Expects mMutex to be held.
+  QPL_INLINE bool IsIdle(const Stream& stream) const {
+    return stream.state != StreamState::Reading && stream.state != StreamState::Decompressing
+      && stream.decompressCounter.IsDone();
+  }
+
+private:
+  JobSystem* mJobSystem = nullptr;
+  UploadRing* mUploadRing = nullptr;
+  StreamerConfig mConfig;
+  AsyncReader mReader;
+
+  std::vector<std::unique_ptr<MountedArchive>> mArchives;
+
+  mutable std::mutex mMutex;
+  std::condition_variable mStateChanged;
+  std::unordered_map<StreamHandle, std::unique_ptr<Stream>> mStreams;
+  std::set<QueuedStream> mQueue;
+  // Requests waiting on their upload ticket.
+  std::vector<StreamHandle> mUploading;
+  // Released while a stage still held them; freed by Update() once it lets go.
+  std::vector<std::unique_ptr<Stream>> mReleased;
+  StreamHandle mNextHandle = 1;
+
+  uint32_t mInFlightReads = 0;
+  uint64_t mInFlightBytes = 0;
+};
+
+} // namespace qpl
+
+#endif
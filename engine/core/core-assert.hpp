@@ -80,9 +80,21 @@ QPL_INLINE void AssertPrintBacktrace(std::ostream& os = std::cerr, size_t skip =
 }
 
 QPL_INLINE void AssertFail(const char* exprStr, const src_loc& loc) {
-  LogError(std::format("Runtime assertion '{}' failed:", exprStr));
-  std::cerr << " at " << loc.file_name() << ':' << loc.line() << ':' << loc.column() << ' ' << loc.function_name()
-            << "\n";
+  // Written straight through LogWrite so the report survives any QPL_LOG_LEVEL, then flushed, since the logging
+  // thread will not get another chance once the process aborts.
+  LogWrite(
+    LogLevel::Error,
+    std::format(
+      "Runtime assertion '{}' failed:\n at {}:{}:{} {}",
+      exprStr,
+      loc.file_name(),
+      loc.line(),
+      loc.column(),
+      loc.function_name()
+    )
+  );
+  LogFlush();
+
   std::cerr << " stacktrace:\n";
   AssertPrintBacktrace();
   std::abort();
@@ -0,0 +1,42 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#ifndef QPL_CORE_HASH_HPP
+#define QPL_CORE_HASH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include "core-config.hpp"
+
+namespace qpl {
+
+QPL_INLINE_CONSTEXPR uint64_t Fnv1aOffsetBasis = 0xcbf29ce484222325ull;
+QPL_INLINE_CONSTEXPR uint64_t Fnv1aPrime = 0x100000001b3ull;
+
+// 64-bit FNV-1a over a byte range. Not cryptographic; meant for content keys and integrity checks.
+QPL_INLINE uint64_t HashBytes(const void* data, size_t size, uint64_t seed = Fnv1aOffsetBasis) {
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  uint64_t hash = seed;
+
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= bytes[i];
+    hash *= Fnv1aPrime;
+  }
+
+  return hash;
+}
+
+QPL_INLINE uint64_t HashString(std::string_view str, uint64_t seed = Fnv1aOffsetBasis) {
+  return HashBytes(str.data(), str.size(), seed);
+}
+
+// Mixes `value` into `seed`, boost::hash_combine style.
+QPL_INLINE_CONSTEXPR uint64_t HashCombine(uint64_t seed, uint64_t value) {
+  return seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+}
+
+} // namespace qpl
+
+#endif
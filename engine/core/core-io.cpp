@@ -0,0 +1,357 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#include "core-io.hpp"
+
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+namespace qpl {
+
+namespace {
+
+//
+// ---- Async Logger ---------------------------------
+//
+// Bounded multi-producer single-consumer ring (Vyukov's sequence-per-slot scheme). A producer claims a slot by
+// advancing the enqueue position, fills it, and publishes it by bumping the slot's sequence; the logging thread
+// consumes slots strictly in order. Slot strings keep their capacity, so steady-state logging does not allocate.
+//
+class AsyncLogger final {
+public:
+  static constexpr uint64_t Capacity = 1024;
+  static constexpr size_t SlotReserve = 256;
+
+  AsyncLogger() {
+    mSlots = std::make_unique<Slot[]>(Capacity);
+
+    for (uint64_t i = 0; i < Capacity; i++) {
+      mSlots[i].sequence.store(i, std::memory_order_relaxed);
+      mSlots[i].text.reserve(SlotReserve);
+    }
+
+    mThread = std::thread([this] { ThreadMain(); });
+  }
+
+  void Push(LogLevel level, std::string_view message) {
+    auto time = std::chrono::system_clock::now();
+
+    // Announced before checking mStopped, so Stop() either sees this push in flight and waits for it to land in the
+    // ring, or this push sees mStopped and writes synchronously. Both sides are seq_cst for that reason.
+    mActiveProducers.fetch_add(1, std::memory_order_seq_cst);
+
+    // Once the logging thread is stopping (at exit), fall back to writing synchronously.
+    if (QPL_UNLIKELY(mStopped.load(std::memory_order_seq_cst))) {
+      mActiveProducers.fetch_sub(1, std::memory_order_release);
+
+      std::lock_guard lock(mSinkMutex);
+      WriteRecord(level, time, message);
+      FlushSinks();
+      return;
+    }
+
+    uint64_t position = mEnqueuePosition.load(std::memory_order_relaxed);
+    Slot* slot = nullptr;
+
+    while (true) {
+      slot = &mSlots[position % Capacity];
+      uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+      int64_t difference = (int64_t)sequence - (int64_t)position;
+
+      if (difference == 0) {
+        if (mEnqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      }
+      else if (difference < 0) {
+        // Full: the logging thread has not consumed this slot's previous message yet.
+        std::this_thread::yield();
+        position = mEnqueuePosition.load(std::memory_order_relaxed);
+      }
+      else {
+        position = mEnqueuePosition.load(std::memory_order_relaxed);
+      }
+    }
+
+    slot->level = level;
+    slot->time = time;
+    slot->text.assign(message);
+    slot->sequence.store(position + 1, std::memory_order_release);
+    mActiveProducers.fetch_sub(1, std::memory_order_release);
+
+    // Only costs a syscall when the logging thread is actually asleep.
+    mWake.fetch_add(1, std::memory_order_release);
+    mWake.notify_one();
+  }
+
+  void Flush() {
+    if (mStopped.load(std::memory_order_acquire) || std::this_thread::get_id() == mThread.get_id()) {
+      return;
+    }
+
+    uint64_t target = mEnqueuePosition.load(std::memory_order_acquire);
+    uint64_t written = mWrittenPosition.load(std::memory_order_acquire);
+
+    while (written < target) {
+      mWrittenPosition.wait(written, std::memory_order_acquire);
+      written = mWrittenPosition.load(std::memory_order_acquire);
+    }
+  }
+
+  void Stop() {
+    // New messages are written synchronously from here on; the ones already being pushed are waited for, so the
+    // logging thread's last drain sees every message that went into the ring.
+    mStopped.store(true, std::memory_order_seq_cst);
+
+    while (mActiveProducers.load(std::memory_order_seq_cst) != 0) {
+      std::this_thread::yield();
+    }
+
+    mStopping.store(true, std::memory_order_release);
+    mWake.fetch_add(1, std::memory_order_release);
+    mWake.notify_one();
+
+    if (mThread.joinable()) {
+      mThread.join();
+    }
+  }
+
+  void SetConsole(bool enabled) {
+    std::lock_guard lock(mSinkMutex);
+    mConsole = enabled;
+  }
+
+  void SetFile(const std::filesystem::path& path, uint64_t maxFileBytes, uint32_t maxFiles) {
+    std::lock_guard lock(mSinkMutex);
+
+    mFile.close();
+    mFilePath = path;
+    mMaxFileBytes = maxFileBytes;
+    mMaxFiles = maxFiles;
+
+    if (path.empty()) {
+      return;
+    }
+
+    std::error_code ec;
+    mFileBytes = std::filesystem::exists(path, ec) ? std::filesystem::file_size(path, ec) : 0;
+    mFile.open(path, std::ios::app);
+
+    if (!mFile) {
+      std::cerr << "[\033[31mERR\033[0m] Failed to open log file " << path.string() << "\n";
+      mFilePath.clear();
+    }
+  }
+
+private:
+  struct Slot {
+    std::atomic<uint64_t> sequence = 0;
+    LogLevel level = LogLevel::Info;
+    std::chrono::system_clock::time_point time;
+    std::string text;
+  };
+
+  void ThreadMain() {
+    uint64_t position = 0;
+
+    while (true) {
+      uint32_t seenWake = mWake.load(std::memory_order_acquire);
+
+      if (Drain(position)) {
+        continue;
+      }
+
+      if (mStopping.load(std::memory_order_acquire)) {
+        break;
+      }
+
+      mWake.wait(seenWake, std::memory_order_acquire);
+    }
+
+    // Messages published between the last drain and seeing mStopping would otherwise be lost.
+    Drain(position);
+  }
+
+  // Writes every published message from `position` on. Returns false if there was none.
+  bool Drain(uint64_t& position) {
+    uint64_t begin = position;
+
+    {
+      std::lock_guard lock(mSinkMutex);
+
+      while (true) {
+        Slot& slot = mSlots[position % Capacity];
+        if (slot.sequence.load(std::memory_order_acquire) != position + 1) {
+          break;
+        }
+
+        WriteRecord(slot.level, slot.time, slot.text);
+
+        // Hand the slot back to producers for the next lap around the ring.
+        slot.sequence.store(position + Capacity, std::memory_order_release);
+        position++;
+      }
+
+      if (position == begin) {
+        return false;
+      }
+
+      FlushSinks();
+    }
+
+    mWrittenPosition.store(position, std::memory_order_release);
+    mWrittenPosition.notify_all();
+    return true;
+  }
+
+  // Expects the sink mutex to be held.
+  void WriteRecord(LogLevel level, std::chrono::system_clock::time_point time, std::string_view text) {
+    if (mConsole) {
+      switch (level) {
+      case LogLevel::Info:
+        std::cout << "[\033[32mINF\033[0m] " << text << "\n";
+        break;
+      case LogLevel::Warning:
+        std::cout << "[\033[33mWRN\033[0m] " << text << "\n";
+        break;
+      case LogLevel::Error:
+        std::cerr << "[\033[31mERR\033[0m] " << text << "\n";
+        break;
+      }
+    }
+
+    if (!mFile.is_open()) {
+      return;
+    }
+
+    static constexpr const char* LevelTags[] = {"INF", "WRN", "ERR"};
+
+    mLine.clear();
+    std::format_to(
+      std::back_inserter(mLine),
+      "{:%F %T} [{}] {}\n",
+      std::chrono::floor<std::chrono::milliseconds>(time),
+      LevelTags[static_cast<size_t>(level)],
+      text
+    );
+
+    mFile << mLine;
+    mFileBytes += mLine.size();
+
+    if (mMaxFileBytes > 0 && mFileBytes >= mMaxFileBytes) {
+      RotateFile();
+    }
+  }
+
+  // Expects the sink mutex to be held.
+  void FlushSinks() {
+    if (mConsole) {
+      std::cout.flush();
+    }
+
+    if (mFile.is_open()) {
+      mFile.flush();
+    }
+  }
+
+  // Expects the sink mutex to be held.
+  void RotateFile() {
+    mFile.close();
+
+    auto numbered = [&](uint32_t index) {
+      auto path = mFilePath;
+      path += std::format(".{}", index);
+      return path;
+    };
+
+    std::error_code ec;
+
+    if (mMaxFiles > 0) {
+      std::filesystem::remove(numbered(mMaxFiles), ec);
+
+      for (uint32_t i = mMaxFiles - 1; i >= 1; i--) {
+        std::filesystem::rename(numbered(i), numbered(i + 1), ec);
+      }
+
+      std::filesystem::rename(mFilePath, numbered(1), ec);
+    }
+
+    mFile.open(mFilePath, std::ios::trunc);
+    mFileBytes = 0;
+  }
+
+private:
+  std::unique_ptr<Slot[]> mSlots;
+
+  alignas(64) std::atomic<uint64_t> mEnqueuePosition = 0;
+  // Everything before this position has been written and flushed.
+  alignas(64) std::atomic<uint64_t> mWrittenPosition = 0;
+  alignas(64) std::atomic<uint32_t> mWake = 0;
+
+  // Producers between announcing themselves and publishing their slot, see Push() and Stop().
+  std::atomic<uint32_t> mActiveProducers = 0;
+  // mStopped sends new messages down the synchronous path; mStopping then tells the logging thread to finish.
+  std::atomic<bool> mStopping = false;
+  std::atomic<bool> mStopped = false;
+  std::thread mThread;
+
+  // Guards the sinks below. Only the logging thread and configuration calls take it, never a producer.
+  std::mutex mSinkMutex;
+  bool mConsole = true;
+  std::ofstream mFile;
+  std::filesystem::path mFilePath;
+  uint64_t mMaxFileBytes = 0;
+  uint64_t mFileBytes = 0;
+  uint32_t mMaxFiles = 0;
+  std::string mLine;
+};
+
+AsyncLogger& GetLogger() {
+  // Never destroyed, so logging from static destructors stays valid; the thread is stopped (and everything queued
+  // written out) at exit, after which messages are written synchronously.
+  static AsyncLogger* logger = [] {
+    auto* instance = new AsyncLogger();
+    std::atexit([] { GetLogger().Stop(); });
+    return instance;
+  }();
+
+  return *logger;
+}
+
+thread_local std::string tFormatBuffer;
+
+} // namespace
+
+void LogWrite(LogLevel level, std::string_view message) {
+  GetLogger().Push(level, message);
+}
+
+void LogFormat(LogLevel level, std::string_view format, std::format_args args) {
+  // Reused across calls, so formatting on the caller's thread does not allocate once the buffer has grown.
+  tFormatBuffer.clear();
+  std::vformat_to(std::back_inserter(tFormatBuffer), format, args);
+
+  GetLogger().Push(level, tFormatBuffer);
+}
+
+void LogFlush() {
+  GetLogger().Flush();
+}
+
+void LogToConsole(bool enabled) {
+  GetLogger().SetConsole(enabled);
+}
+
+void LogToFile(const std::filesystem::path& path, uint64_t maxFileBytes, uint32_t maxFiles) {
+  GetLogger().SetFile(path, maxFileBytes, maxFiles);
+}
+
+} // namespace qpl
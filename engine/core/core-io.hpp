@@ -5,21 +5,74 @@
 #ifndef QPL_CORE_IO_HPP
 #define QPL_CORE_IO_HPP
 
-#include <iostream>
+#include <format>
+#include <string>
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
 #include "core-config.hpp"
 
+//
+// ─── Log Level Filter ──────────────────────────────────────────────────
+//
+// Messages below QPL_LOG_LEVEL are compiled out along with their formatting: 0 keeps everything, 1 drops info,
+// 2 keeps only errors and 3 drops those too. Assertion failures are always reported.
+//
+#ifndef QPL_LOG_LEVEL
+#define QPL_LOG_LEVEL 0
+#endif
+
 namespace qpl {
 
-QPL_INLINE void LogInfo(const std::string& message) {
-  std::cout << "[\033[32mINF\033[0m] " << message << "\n";
+enum class LogLevel : uint8_t {
+  Info,
+  Warning,
+  Error,
+};
+
+//
+// ---- Logging ---------------------------------
+//
+// Messages are formatted on the calling thread into a reused thread-local buffer and queued in a lock-free ring.
+// A background thread writes them to the console and, optionally, a rotating log file, so callers never wait on
+// I/O. A caller only ever waits if the ring is full.
+//
+
+// Queues an already formatted message.
+void LogWrite(LogLevel level, std::string_view message);
+
+// Formats and queues a message. Prefer the typed LogInfo/LogWarning/LogError wrappers, which check the format
+// string at compile time.
+void LogFormat(LogLevel level, std::string_view format, std::format_args args);
+
+// Blocks until every message queued before the call has been written and flushed.
+void LogFlush();
+
+void LogToConsole(bool enabled);
+
+// Also writes to `path`. Once the file exceeds `maxFileBytes` it is renamed to `path`.1 (shifting older files up to
+// `path`.`maxFiles`, and dropping the oldest) and a new one is started. An empty path stops file logging.
+void LogToFile(const std::filesystem::path& path, uint64_t maxFileBytes = 8ull * 1024 * 1024, uint32_t maxFiles = 4);
+
+template <typename... Args>
+QPL_INLINE void LogInfo(std::format_string<Args...> format, Args&&... args) {
+  if constexpr (QPL_LOG_LEVEL <= 0) {
+    LogFormat(LogLevel::Info, format.get(), std::make_format_args(args...));
+  }
 }
 
-QPL_INLINE void LogWarning(const std::string& message) {
-  std::cout << "[\033[33mWRN\033[0m] " << message << "\n";
+template <typename... Args>
+QPL_INLINE void LogWarning(std::format_string<Args...> format, Args&&... args) {
+  if constexpr (QPL_LOG_LEVEL <= 1) {
+    LogFormat(LogLevel::Warning, format.get(), std::make_format_args(args...));
+  }
 }
 
-QPL_INLINE void LogError(const std::string& message) {
-  std::cerr << "[\033[31mERR\033[0m] " << message << "\n";
+template <typename... Args>
+QPL_INLINE void LogError(std::format_string<Args...> format, Args&&... args) {
+  if constexpr (QPL_LOG_LEVEL <= 2) {
+    LogFormat(LogLevel::Error, format.get(), std::make_format_args(args...));
+  }
 }
 
 } // namespace qpl
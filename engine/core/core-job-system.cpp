@@ -0,0 +1,324 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#include "core-job-system.hpp"
+#include "core-profiler.hpp"
+
+#include <string>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+namespace qpl {
+
+// Failed attempts at finding a job before a worker goes to sleep, or a waiter starts yielding its time slice.
+static constexpr uint32_t IdleSpins = 64;
+
+static QPL_INLINE void CpuRelax() {
+#if defined(__x86_64__) || defined(_M_X64)
+  _mm_pause();
+#endif
+}
+
+//
+// ---- Work Deque ---------------------------------
+//
+// Indices only grow, so top == bottom means empty and the last job is the only one the owner and a thief can race
+// for; that race is settled by a CAS on the top. The orderings are sequentially consistent where the owner's pop has
+// to see a concurrent steal and the other way around.
+//
+bool JobSystem::WorkDeque::Push(Job* job) {
+  int64_t bottom = mBottom.load(std::memory_order_relaxed);
+  int64_t top = mTop.load(std::memory_order_acquire);
+
+  if (bottom - top >= (int64_t)DequeCapacity) {
+    return false;
+  }
+
+  mJobs[bottom & (DequeCapacity - 1)].store(job, std::memory_order_relaxed);
+  // Sequentially consistent so a worker about to sleep either sees this job or is seen sleeping.
+  mBottom.store(bottom + 1, std::memory_order_seq_cst);
+  return true;
+}
+
+Job* JobSystem::WorkDeque::Pop() {
+  int64_t bottom = mBottom.load(std::memory_order_relaxed) - 1;
+  mBottom.store(bottom, std::memory_order_seq_cst);
+  int64_t top = mTop.load(std::memory_order_seq_cst);
+
+  if (top > bottom) {
+    mBottom.store(bottom + 1, std::memory_order_relaxed);
+    return nullptr;
+  }
+
+  Job* job = mJobs[bottom & (DequeCapacity - 1)].load(std::memory_order_relaxed);
+
+  if (top == bottom) {
+    // Last job: a thief may be taking it at the same time.
+    if (!mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+      job = nullptr;
+    }
+
+    mBottom.store(bottom + 1, std::memory_order_relaxed);
+  }
+
+  return job;
+}
+
+Job* JobSystem::WorkDeque::Steal() {
+  int64_t top = mTop.load(std::memory_order_seq_cst);
+  int64_t bottom = mBottom.load(std::memory_order_seq_cst);
+
+  if (top >= bottom) {
+    return nullptr;
+  }
+
+  Job* job = mJobs[top & (DequeCapacity - 1)].load(std::memory_order_relaxed);
+
+  // Losing the race means the owner or another thief got it; the caller just moves on to another victim.
+  if (!mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+    return nullptr;
+  }
+
+  return job;
+}
+
+void JobSystem::LockedQueue::Push(Job* job) {
+  std::lock_guard lock(mutex);
+  jobs.push_back(job);
+  count.fetch_add(1, std::memory_order_seq_cst);
+}
+
+Job* JobSystem::LockedQueue::Pop() {
+  if (count.load(std::memory_order_seq_cst) == 0) {
+    return nullptr;
+  }
+
+  std::lock_guard lock(mutex);
+
+  if (jobs.empty()) {
+    return nullptr;
+  }
+
+  Job* job = jobs.front();
+  jobs.pop_front();
+  count.fetch_sub(1, std::memory_order_relaxed);
+  return job;
+}
+
+//
+// ---- Job System ---------------------------------
+//
+JobSystem::JobSystem(uint32_t threadCount) {
+  // Every deque has to exist before any thread starts stealing from it.
+  for (uint32_t i = 0; i <= threadCount; i++) {
+    mWorkers.push_back(std::make_unique<Worker>());
+    mWorkers.back()->stealSeed = i * 0x9E3779B9u + 1;
+  }
+
+  tCurrentSystem = this;
+  tCurrentWorker = 0;
+
+  for (uint32_t i = 1; i <= threadCount; i++) {
+    mWorkers[i]->thread = std::thread([this, i] { WorkerMain(i); });
+  }
+}
+
+JobSystem::~JobSystem() {
+  mStopping.store(true, std::memory_order_seq_cst);
+  mWakeEpoch.fetch_add(1, std::memory_order_seq_cst);
+  mWakeEpoch.notify_all();
+
+  for (std::unique_ptr<Worker>& worker : mWorkers) {
+    if (worker->thread.joinable()) {
+      worker->thread.join();
+    }
+  }
+
+  if (tCurrentSystem == this) {
+    tCurrentSystem = nullptr;
+    tCurrentWorker = ExternalThread;
+  }
+}
+
+void JobSystem::Run(std::span<Job> jobs, JobCounter& counter) {
+  if (jobs.empty()) {
+    return;
+  }
+
+  // Counted up front, so the counter cannot touch zero while later jobs are still being pushed.
+  counter.mValue.fetch_add(static_cast<uint32_t>(jobs.size()), std::memory_order_relaxed);
+
+  uint32_t worker = GetWorkerIndex();
+
+  for (Job& job : jobs) {
+    job.counter = &counter;
+
+    if (worker == ExternalThread) {
+      mInjected.Push(&job);
+    }
+    else if (!mWorkers[worker]->deque.Push(&job)) {
+      Execute(&job);
+    }
+  }
+
+  mWakeEpoch.fetch_add(1, std::memory_order_seq_cst);
+
+  if (mSleepingWorkers.load(std::memory_order_seq_cst) > 0) {
+    if (jobs.size() == 1) {
+      mWakeEpoch.notify_one();
+    }
+    else {
+      mWakeEpoch.notify_all();
+    }
+  }
+}
+
+void JobSystem::RunOnMainThread(Job& job, JobCounter& counter) {
+  counter.mValue.fetch_add(1, std::memory_order_relaxed);
+  job.counter = &counter;
+  mMainThreadJobs.Push(&job);
+}
+
+void JobSystem::RunMainThreadJobs() {
+  QPL_CORE_ASSERT(IsMainThread() && "main-thread jobs can only be run by the main thread");
+
+  // Only what is queued now; a job that queues another one does not keep the main thread here.
+  uint32_t count = mMainThreadJobs.count.load(std::memory_order_acquire);
+
+  for (uint32_t i = 0; i < count; i++) {
+    if (Job* job = mMainThreadJobs.Pop()) {
+      Execute(job);
+    }
+  }
+}
+
+void JobSystem::Wait(JobCounter& counter) {
+  uint32_t worker = GetWorkerIndex();
+
+  if (worker == ExternalThread) {
+    while (true) {
+      uint32_t epoch = mDoneEpoch.load(std::memory_order_acquire);
+
+      if (counter.IsDone()) {
+        return;
+      }
+
+      mDoneEpoch.wait(epoch, std::memory_order_acquire);
+    }
+  }
+
+  uint32_t spins = 0;
+
+  while (!counter.IsDone()) {
+    if (Job* job = FindJob(worker)) {
+      Execute(job);
+      spins = 0;
+    }
+    else if (++spins < IdleSpins) {
+      CpuRelax();
+    }
+    else {
+      std::this_thread::yield();
+    }
+  }
+}
+
+void JobSystem::WorkerMain(uint32_t worker) {
+  tCurrentSystem = this;
+  tCurrentWorker = worker;
+  QPL_PROFILE_THREAD("job-worker-" + std::to_string(worker));
+
+  uint32_t spins = 0;
+
+  while (!mStopping.load(std::memory_order_relaxed)) {
+    if (Job* job = FindJob(worker)) {
+      Execute(job);
+      spins = 0;
+      continue;
+    }
+
+    if (++spins < IdleSpins) {
+      CpuRelax();
+      continue;
+    }
+
+    // The epoch is read before the last look for work: a job pushed after that look bumps it, and wait() returns
+    // straight away.
+    uint32_t epoch = mWakeEpoch.load(std::memory_order_seq_cst);
+    mSleepingWorkers.fetch_add(1, std::memory_order_seq_cst);
+
+    if (Job* job = FindJob(worker)) {
+      mSleepingWorkers.fetch_sub(1, std::memory_order_relaxed);
+      Execute(job);
+      spins = 0;
+      continue;
+    }
+
+    if (!mStopping.load(std::memory_order_seq_cst)) {
+      mWakeEpoch.wait(epoch, std::memory_order_seq_cst);
+    }
+
+    mSleepingWorkers.fetch_sub(1, std::memory_order_relaxed);
+    spins = 0;
+  }
+}
+
+Job* JobSystem::FindJob(uint32_t worker) {
+  Worker& self = *mWorkers[worker];
+
+  if (Job* job = self.deque.Pop()) {
+    return job;
+  }
+
+  if (worker == 0) {
+    if (Job* job = mMainThreadJobs.Pop()) {
+      return job;
+    }
+  }
+
+  if (Job* job = mInjected.Pop()) {
+    return job;
+  }
+
+  uint32_t workerCount = GetWorkerCount();
+  if (workerCount == 1) {
+    return nullptr;
+  }
+
+  // Start at a random victim so that thieves spread out instead of all hammering the same deque.
+  self.stealSeed ^= self.stealSeed << 13;
+  self.stealSeed ^= self.stealSeed >> 17;
+  self.stealSeed ^= self.stealSeed << 5;
+
+  uint32_t first = self.stealSeed % workerCount;
+
+  for (uint32_t i = 0; i < workerCount; i++) {
+    uint32_t victim = (first + i) % workerCount;
+
+    if (victim == worker) {
+      continue;
+    }
+
+    if (Job* job = mWorkers[victim]->deque.Steal()) {
+      return job;
+    }
+  }
+
+  return nullptr;
+}
+
+void JobSystem::Execute(Job* job) {
+  // The job and its counter belong to the waiter, which may free both as soon as the counter reads zero.
+  JobCounter* counter = job->counter;
+  job->function(job->data);
+
+  if (counter->mValue.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    mDoneEpoch.fetch_add(1, std::memory_order_release);
+    mDoneEpoch.notify_all();
+  }
+}
+
+} // namespace qpl
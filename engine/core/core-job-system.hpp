@@ -0,0 +1,231 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#ifndef QPL_CORE_JOB_SYSTEM_HPP
+#define QPL_CORE_JOB_SYSTEM_HPP
+
+#include <span>
+#include <array>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <type_traits>
+
+#include "core-config.hpp"
+#include "core-assert.hpp"
+
+namespace qpl {
+
+using JobFunction = void (*)(void* data);
+
+//
+// ---- Job Counter ---------------------------------
+//
+// Counts the unfinished jobs of one or more Run() calls. Work that depends on those jobs waits for the counter to
+// reach zero with JobSystem::Wait(); a counter can be reused once it has.
+//
+class JobCounter final {
+public:
+  QPL_INLINE bool IsDone() const {
+    return mValue.load(std::memory_order_acquire) == 0;
+  }
+
+private:
+  friend class JobSystem;
+
+  std::atomic<uint32_t> mValue = 0;
+};
+
+// A unit of work. Jobs are not copied: the deques hold pointers to them, so a Job must stay alive until its counter
+// has been waited on. Declaring them on the stack of the waiting function is the intended use.
+struct Job {
+  JobFunction function = nullptr;
+  void* data = nullptr;
+
+  // Set by Run().
+  JobCounter* counter = nullptr;
+};
+
+//
+// ---- Job System ---------------------------------
+//
+// A work-stealing scheduler over one deque per worker. The thread that constructs the system is worker 0 and has
+// no thread of its own; the others each own one. Jobs are pushed onto the deque of the worker that runs them and
+// popped from it LIFO, so nested work stays hot in its cache, while idle workers steal the oldest jobs from others.
+// Threads that are not workers push into a shared injection queue instead.
+//
+// Waiting is continuation-style rather than fiber-based: a worker waiting on a counter keeps running other jobs
+// until it reaches zero, so jobs may spawn and wait on further jobs without blocking a thread. A waiter only
+// returns once the jobs it waits on are done, which also means it can return late if it picked up a long job. Threads
+// outside the system sleep until the counter reaches zero.
+//
+// Jobs queued with RunOnMainThread() are only ever run by worker 0, either while it waits or when it calls
+// RunMainThreadJobs(); they are how jobs get at APIs like SDL's that must be called from the main thread.
+//
+// Every worker has a stable index in [0, GetWorkerCount()), which jobs use to pick per-thread resources without
+// locking.
+//
+class JobSystem final {
+public:
+  // Jobs per worker deque. Run() runs jobs inline rather than overflow a full deque.
+  static constexpr uint32_t DequeCapacity = 1u << 12;
+
+  // Most jobs a single ParallelFor() splits its range into.
+  static constexpr uint32_t MaxParallelForJobs = 256;
+
+  static constexpr uint32_t ExternalThread = UINT32_MAX;
+
+  // Starts `threadCount` worker threads next to the calling thread, which becomes worker 0.
+  explicit JobSystem(uint32_t threadCount = std::max(1u, std::thread::hardware_concurrency()) - 1);
+  ~JobSystem();
+
+  JobSystem(const JobSystem&) = delete;
+  JobSystem& operator=(const JobSystem&) = delete;
+
+  QPL_INLINE uint32_t GetWorkerCount() const {
+    return static_cast<uint32_t>(mWorkers.size());
+  }
+
+  // Worker index of the calling thread in this system, or ExternalThread.
+  QPL_INLINE uint32_t GetWorkerIndex() const {
+    return tCurrentSystem == this ? tCurrentWorker : ExternalThread;
+  }
+
+  QPL_INLINE bool IsMainThread() const {
+    return GetWorkerIndex() == 0;
+  }
+
+  // Adds the jobs to `counter` and makes them available to every worker. May be called from any thread.
+  void Run(std::span<Job> jobs, JobCounter& counter);
+
+  QPL_INLINE void Run(Job& job, JobCounter& counter) {
+    Run(std::span<Job>(&job, 1), counter);
+  }
+
+  // Queues a job that only the main thread runs. May be called from any thread.
+  void RunOnMainThread(Job& job, JobCounter& counter);
+
+  // Runs every main-thread job queued so far. Main thread only.
+  void RunMainThreadJobs();
+
+  // Returns once every job counted by `counter` is done, running other jobs in the meantime.
+  void Wait(JobCounter& counter);
+
+  // Calls `fn(index)` for every index in [0, count) across all workers and waits for it to finish. Indices are
+  // handed out in contiguous runs of at least `grain`. A range that makes a single run is done inline on the calling
+  // thread, so `fn` also runs there, and GetWorkerIndex() inside it is ExternalThread when that thread is not a worker.
+  template <typename Fn>
+  void ParallelFor(uint32_t count, uint32_t grain, Fn&& fn);
+
+private:
+  // Chase-Lev deque: the owner pushes and pops at the bottom, thieves take from the top. Holds job pointers only.
+  class WorkDeque final {
+  public:
+    bool Push(Job* job);
+    Job* Pop();
+    Job* Steal();
+
+  private:
+    alignas(64) std::atomic<int64_t> mTop = 0;
+    alignas(64) std::atomic<int64_t> mBottom = 0;
+    std::array<std::atomic<Job*>, DequeCapacity> mJobs;
+  };
+
+  struct Worker {
+    WorkDeque deque;
+    std::thread thread;
+    uint32_t stealSeed = 0;
+  };
+
+  // Mutex-guarded FIFO, for the injection and main-thread queues. The count is read without the lock to skip
+  // empty queues cheaply.
+  struct LockedQueue {
+    std::mutex mutex;
+    std::deque<Job*> jobs;
+    std::atomic<uint32_t> count = 0;
+
+    void Push(Job* job);
+    Job* Pop();
+  };
+
+  void WorkerMain(uint32_t worker);
+  Job* FindJob(uint32_t worker);
+  void Execute(Job* job);
+
+  template <typename Fn>
+  struct ParallelForRange {
+    Fn* fn;
+    uint32_t begin;
+    uint32_t end;
+  };
+
+private:
+  static inline thread_local const JobSystem* tCurrentSystem = nullptr;
+  static inline thread_local uint32_t tCurrentWorker = ExternalThread;
+
+  std::vector<std::unique_ptr<Worker>> mWorkers;
+  LockedQueue mInjected;
+  LockedQueue mMainThreadJobs;
+
+  // Bumped whenever jobs are added, so a worker going to sleep can tell whether it missed any.
+  alignas(64) std::atomic<uint32_t> mWakeEpoch = 0;
+  std::atomic<uint32_t> mSleepingWorkers = 0;
+  std::atomic<bool> mStopping = false;
+
+  // Bumped whenever a counter reaches zero. Threads outside the system sleep on this rather than on the counter,
+  // which its owner may destroy the moment it reads zero.
+  alignas(64) std::atomic<uint32_t> mDoneEpoch = 0;
+};
+
+template <typename Fn>
+void JobSystem::ParallelFor(uint32_t count, uint32_t grain, Fn&& fn) {
+  if (count == 0) {
+    return;
+  }
+
+  grain = std::max(grain, 1u);
+
+  // A few jobs per worker leaves room for stealing to even out uneven indices.
+  uint32_t jobCount = std::min({(count + grain - 1) / grain, GetWorkerCount() * 4, MaxParallelForJobs});
+
+  if (jobCount <= 1) {
+    for (uint32_t i = 0; i < count; i++) {
+      fn(i);
+    }
+    return;
+  }
+
+  using Range = ParallelForRange<std::remove_reference_t<Fn>>;
+
+  std::array<Range, MaxParallelForJobs> ranges;
+  std::array<Job, MaxParallelForJobs> jobs;
+
+  for (uint32_t i = 0; i < jobCount; i++) {
+    uint32_t begin = static_cast<uint32_t>((uint64_t)count * i / jobCount);
+    uint32_t end = static_cast<uint32_t>((uint64_t)count * (i + 1) / jobCount);
+
+    ranges[i] = {&fn, begin, end};
+    jobs[i].data = &ranges[i];
+    jobs[i].function = [](void* data) {
+      Range& range = *static_cast<Range*>(data);
+
+      for (uint32_t index = range.begin; index < range.end; index++) {
+        (*range.fn)(index);
+      }
+    };
+  }
+
+  JobCounter counter;
+  Run(std::span<Job>(jobs.data(), jobCount), counter);
+  Wait(counter);
+}
+
+} // namespace qpl
+
+#endif
@@ -0,0 +1,146 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#include "core-mapped-file.hpp"
+
+#include <utility>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace qpl {
+
+MappedFile::~MappedFile() {
+  Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+  : mData(std::exchange(other.mData, nullptr)),
+    mSize(std::exchange(other.mSize, 0)),
+    mOpen(std::exchange(other.mOpen, false)) {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+  if (this != &other) {
+    Close();
+    mData = std::exchange(other.mData, nullptr);
+    mSize = std::exchange(other.mSize, 0);
+    mOpen = std::exchange(other.mOpen, false);
+  }
+
+  return *this;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const std::filesystem::path& path) {
+  Close();
+
+  HANDLE file = CreateFileW(
+    path.c_str(),
+    GENERIC_READ,
+    FILE_SHARE_READ | FILE_SHARE_DELETE,
+    nullptr,
+    OPEN_EXISTING,
+    FILE_ATTRIBUTE_NORMAL,
+    nullptr
+  );
+
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+
+  LARGE_INTEGER size;
+
+  if (!GetFileSizeEx(file, &size)) {
+    CloseHandle(file);
+    return false;
+  }
+
+  if (size.QuadPart > 0) {
+    // The view keeps the mapping, and the mapping the file, alive after both handles are closed.
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    mData = mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+
+    if (mapping != nullptr) {
+      CloseHandle(mapping);
+    }
+
+    if (mData == nullptr) {
+      CloseHandle(file);
+      return false;
+    }
+  }
+
+  CloseHandle(file);
+  mSize = static_cast<size_t>(size.QuadPart);
+  mOpen = true;
+  return true;
+}
+
+void MappedFile::Close() {
+  if (mData != nullptr) {
+    UnmapViewOfFile(mData);
+  }
+
+  mData = nullptr;
+  mSize = 0;
+  mOpen = false;
+}
+
+#else
+
+bool MappedFile::Open(const std::filesystem::path& path) {
+  Close();
+
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+  if (fd < 0) {
+    return false;
+  }
+
+  struct stat info;
+
+  if (fstat(fd, &info) != 0) {
+    close(fd);
+    return false;
+  }
+
+  if (info.st_size > 0) {
+    void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if (data == MAP_FAILED) {
+      close(fd);
+      return false;
+    }
+
+    mData = data;
+  }
+
+  // The mapping keeps the file alive on its own.
+  close(fd);
+  mSize = static_cast<size_t>(info.st_size);
+  mOpen = true;
+  return true;
+}
+
+void MappedFile::Close() {
+  if (mData != nullptr) {
+    munmap(const_cast<void*>(mData), mSize);
+  }
+
+  mData = nullptr;
+  mSize = 0;
+  mOpen = false;
+}
+
+#endif
+
+} // namespace qpl
@@ -0,0 +1,62 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#ifndef QPL_CORE_MAPPED_FILE_HPP
+#define QPL_CORE_MAPPED_FILE_HPP
+
+#include <span>
+#include <cstddef>
+#include <filesystem>
+
+#include "core-config.hpp"
+
+namespace qpl {
+
+//
+// ---- Mapped File ---------------------------------
+//
+// A read-only memory mapping of a whole file. Pages are only read from disk when first touched and are shared with
+// the OS file cache, so opening a file costs no copy and no allocation, and reading it again after a change costs
+// nothing until the new bytes are actually used.
+//
+// The mapping reflects the file as it was opened; tools that rewrite files in place should write a new file and
+// rename it over the old one, which leaves existing mappings intact.
+//
+class MappedFile final {
+public:
+  MappedFile() = default;
+  ~MappedFile();
+
+  MappedFile(MappedFile&& other) noexcept;
+  MappedFile& operator=(MappedFile&& other) noexcept;
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  // Maps `path`, closing whatever was mapped before. Returns false if the file cannot be opened or mapped. Empty files
+  // open successfully, with no data.
+  bool Open(const std::filesystem::path& path);
+  void Close();
+
+  QPL_INLINE bool IsOpen() const {
+    return mOpen;
+  }
+
+  QPL_INLINE std::span<const std::byte> GetData() const {
+    return {static_cast<const std::byte*>(mData), mSize};
+  }
+
+  QPL_INLINE size_t GetSize() const {
+    return mSize;
+  }
+
+private:
+  const void* mData = nullptr;
+  size_t mSize = 0;
+  bool mOpen = false;
+};
+
+} // namespace qpl
+
+#endif
@@ -0,0 +1,106 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#ifndef QPL_CORE_PERCENTILE_HISTORY_HPP
+#define QPL_CORE_PERCENTILE_HISTORY_HPP
+
+#include <cmath>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+#include "core-config.hpp"
+
+namespace qpl {
+
+struct PercentileStats {
+  uint32_t sampleCount = 0;
+
+  double average = 0.0;
+  double p50 = 0.0;
+  double p95 = 0.0;
+  double p99 = 0.0;
+  double max = 0.0;
+};
+
+//
+// ---- Percentile History ---------------------------------
+//
+// Keeps the last Capacity samples of a value in a ring and summarizes them with their average and nearest-rank
+// percentiles. Storage grows with the samples up to Capacity, so a history that is never filled stays small.
+//
+template <uint32_t Capacity>
+class PercentileHistory final {
+public:
+  static_assert(Capacity > 0, "a history must hold at least one sample");
+
+  // Adds a sample, replacing the oldest one once the history is full. Returns the slot it went into, in
+  // [0, Capacity), which callers may use to keep data of their own next to each sample.
+  QPL_INLINE uint32_t Push(double value) {
+    uint32_t slot = mNext;
+
+    if (mSamples.size() < Capacity) {
+      mSamples.push_back(value);
+    }
+    else {
+      mSamples[slot] = value;
+    }
+
+    mNext = (mNext + 1) % Capacity;
+    return slot;
+  }
+
+  QPL_INLINE void Clear() {
+    mSamples.clear();
+    mNext = 0;
+  }
+
+  QPL_INLINE uint32_t GetSize() const {
+    return static_cast<uint32_t>(mSamples.size());
+  }
+
+  // Sorts a copy of the samples into `scratch`, which callers may reuse to avoid allocating on every call.
+  PercentileStats Summarize(std::vector<double>& scratch) const {
+    PercentileStats stats;
+
+    if (mSamples.empty()) {
+      return stats;
+    }
+
+    scratch.assign(mSamples.begin(), mSamples.end());
+    std::sort(scratch.begin(), scratch.end());
+
+    for (double sample : scratch) {
+      stats.average += sample;
+    }
+
+    // Nearest-rank percentiles.
+    auto percentile = [&](double p) {
+      size_t rank = (size_t)std::ceil(p * (double)scratch.size());
+      return scratch[std::clamp<size_t>(rank, 1, scratch.size()) - 1];
+    };
+
+    stats.sampleCount = GetSize();
+    stats.average /= (double)scratch.size();
+    stats.p50 = percentile(0.50);
+    stats.p95 = percentile(0.95);
+    stats.p99 = percentile(0.99);
+    stats.max = scratch.back();
+
+    return stats;
+  }
+
+  QPL_INLINE PercentileStats Summarize() const {
+    std::vector<double> scratch;
+    return Summarize(scratch);
+  }
+
+private:
+  std::vector<double> mSamples;
+  uint32_t mNext = 0;
+};
+
+} // namespace qpl
+
+#endif
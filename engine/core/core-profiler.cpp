@@ -0,0 +1,320 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#include "core-profiler.hpp"
+#include "core-io.hpp"
+
+#include <mutex>
+#include <array>
+#include <memory>
+#include <vector>
+#include <fstream>
+#include <unordered_map>
+
+namespace qpl {
+
+namespace {
+
+struct ZoneRecord {
+  const char* name;
+  int64_t start;
+  int64_t end;
+};
+
+struct CapturedZone {
+  ZoneRecord record;
+  uint32_t thread;
+};
+
+// Single-producer single-consumer ring: the owning thread pushes, MarkFrame() drains under the state mutex. The two
+// indices live on separate cache lines so the producer and consumer do not contend on them.
+struct ThreadBuffer {
+  alignas(64) std::atomic<uint32_t> write = 0;
+  alignas(64) std::atomic<uint32_t> read = 0;
+
+  // Producer's last view of `read`; only reloaded when the ring looks full.
+  alignas(64) uint32_t cachedRead = 0;
+  std::atomic<uint64_t> dropped = 0;
+
+  uint32_t index = 0;
+  // Guarded by the state mutex.
+  std::string name;
+
+  std::array<ZoneRecord, CpuProfiler::RingCapacity> ring;
+};
+
+struct ProfilerState {
+  std::mutex mutex;
+  std::vector<std::unique_ptr<ThreadBuffer>> threads;
+
+  std::vector<CapturedZone> zones;
+  std::vector<int64_t> frames;
+  int64_t captureStart = 0;
+  uint64_t droppedAtStart = 0;
+};
+
+// Function-local so zones recorded during static initialization still find it constructed.
+ProfilerState& GetState() {
+  static ProfilerState state;
+  return state;
+}
+
+thread_local ThreadBuffer* tThreadBuffer = nullptr;
+
+ThreadBuffer& GetThreadBuffer() {
+  if (QPL_UNLIKELY(tThreadBuffer == nullptr)) {
+    ProfilerState& state = GetState();
+    std::lock_guard lock(state.mutex);
+
+    // Buffers are never freed, so a thread's zones can still be drained after it exits.
+    auto& buffer = state.threads.emplace_back(std::make_unique<ThreadBuffer>());
+    buffer->index = static_cast<uint32_t>(state.threads.size() - 1);
+    buffer->name = std::format("thread-{}", buffer->index);
+    tThreadBuffer = buffer.get();
+  }
+
+  return *tThreadBuffer;
+}
+
+uint64_t CountDropped(const ProfilerState& state) {
+  uint64_t dropped = 0;
+  for (const auto& buffer : state.threads) {
+    dropped += buffer->dropped.load(std::memory_order_relaxed);
+  }
+
+  return dropped;
+}
+
+// Moves every pending zone into the capture, or throws them away. Expects the state mutex to be held.
+void Drain(ProfilerState& state, bool keep) {
+  for (const auto& buffer : state.threads) {
+    uint32_t read = buffer->read.load(std::memory_order_relaxed);
+    uint32_t write = buffer->write.load(std::memory_order_acquire);
+
+    if (keep) {
+      for (uint32_t i = read; i != write; i++) {
+        state.zones.push_back({buffer->ring[i % CpuProfiler::RingCapacity], buffer->index});
+      }
+    }
+
+    buffer->read.store(write, std::memory_order_release);
+  }
+}
+
+void WriteJsonString(std::ofstream& file, std::string_view text) {
+  file << '"';
+
+  for (char c : text) {
+    switch (c) {
+    case '"':
+      file << "\\\"";
+      break;
+    case '\\':
+      file << "\\\\";
+      break;
+    default:
+      if ((unsigned char)c < 0x20) {
+        file << std::format("\\u{:04x}", (unsigned)c);
+      }
+      else {
+        file << c;
+      }
+    }
+  }
+
+  file << '"';
+}
+
+template <typename T>
+void WriteValue(std::ofstream& file, T value) {
+  file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void WriteString(std::ofstream& file, std::string_view text) {
+  WriteValue(file, static_cast<uint32_t>(text.size()));
+  file.write(text.data(), (std::streamsize)text.size());
+}
+
+} // namespace
+
+void CpuProfiler::RecordZone(const char* name, int64_t start, int64_t end) {
+  ThreadBuffer& buffer = GetThreadBuffer();
+  uint32_t write = buffer.write.load(std::memory_order_relaxed);
+
+  if (write - buffer.cachedRead >= RingCapacity) {
+    buffer.cachedRead = buffer.read.load(std::memory_order_acquire);
+
+    if (write - buffer.cachedRead >= RingCapacity) {
+      buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+  }
+
+  buffer.ring[write % RingCapacity] = {name, start, end};
+  buffer.write.store(write + 1, std::memory_order_release);
+}
+
+void CpuProfiler::BeginCapture() {
+  ProfilerState& state = GetState();
+  std::lock_guard lock(state.mutex);
+
+  // Zones left over from an earlier capture would otherwise show up in this one.
+  Drain(state, /*keep=*/false);
+
+  state.zones.clear();
+  state.frames.clear();
+  state.captureStart = Now();
+  state.droppedAtStart = CountDropped(state);
+
+  sCapturing.store(true, std::memory_order_relaxed);
+}
+
+void CpuProfiler::EndCapture() {
+  sCapturing.store(false, std::memory_order_relaxed);
+
+  ProfilerState& state = GetState();
+  std::lock_guard lock(state.mutex);
+
+  Drain(state, /*keep=*/true);
+
+  LogInfo(
+    "CpuProfiler - Captured {} zones over {} frames on {} threads ({} dropped)",
+    state.zones.size(),
+    state.frames.size(),
+    state.threads.size(),
+    CountDropped(state) - state.droppedAtStart
+  );
+}
+
+void CpuProfiler::ClearCapture() {
+  ProfilerState& state = GetState();
+  std::lock_guard lock(state.mutex);
+
+  state.zones.clear();
+  state.zones.shrink_to_fit();
+  state.frames.clear();
+}
+
+void CpuProfiler::MarkFrame() {
+  if (!IsCapturing()) {
+    return;
+  }
+
+  ProfilerState& state = GetState();
+  std::lock_guard lock(state.mutex);
+
+  state.frames.push_back(Now());
+  Drain(state, /*keep=*/true);
+}
+
+void CpuProfiler::SetThreadName(std::string name) {
+  ThreadBuffer& buffer = GetThreadBuffer();
+
+  std::lock_guard lock(GetState().mutex);
+  buffer.name = std::move(name);
+}
+
+bool CpuProfiler::WriteChromeTrace(const std::filesystem::path& path) {
+  std::ofstream file(path);
+  if (!file) {
+    LogError("CpuProfiler - Failed to open {}", path.string());
+    return false;
+  }
+
+  ProfilerState& state = GetState();
+  std::lock_guard lock(state.mutex);
+
+  // Trace event timestamps are in microseconds.
+  auto toUs = [&](int64_t time) { return (double)(time - state.captureStart) / 1000.0; };
+
+  file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+
+  bool first = true;
+  auto separate = [&] {
+    if (!first) {
+      file << ",\n";
+    }
+    first = false;
+  };
+
+  for (const auto& buffer : state.threads) {
+    separate();
+    file << std::format(R"({{"ph":"M","name":"thread_name","pid":0,"tid":{},"args":{{"name":)", buffer->index);
+    WriteJsonString(file, buffer->name);
+    file << "}}";
+  }
+
+  for (size_t i = 0; i < state.frames.size(); i++) {
+    separate();
+    file << std::format(
+      R"({{"ph":"i","s":"g","name":"frame {}","pid":0,"tid":0,"ts":{:.3f}}})", i, toUs(state.frames[i])
+    );
+  }
+
+  for (const CapturedZone& zone : state.zones) {
+    separate();
+    file << R"({"ph":"X","name":)";
+    WriteJsonString(file, zone.record.name);
+    file << std::format(
+      R"(,"pid":0,"tid":{},"ts":{:.3f},"dur":{:.3f}}})",
+      zone.thread,
+      toUs(zone.record.start),
+      (double)(zone.record.end - zone.record.start) / 1000.0
+    );
+  }
+
+  file << "\n]}\n";
+  return file.good();
+}
+
+bool CpuProfiler::WriteBinaryCapture(const std::filesystem::path& path) {
+  std::ofstream file(path, std::ios::binary);
+  if (!file) {
+    LogError("CpuProfiler - Failed to open {}", path.string());
+    return false;
+  }
+
+  ProfilerState& state = GetState();
+  std::lock_guard lock(state.mutex);
+
+  // Zone names are string literals, so the same pointer always means the same name.
+  std::unordered_map<const char*, uint32_t> stringIndices;
+  std::vector<const char*> strings;
+
+  for (const CapturedZone& zone : state.zones) {
+    if (stringIndices.try_emplace(zone.record.name, static_cast<uint32_t>(strings.size())).second) {
+      strings.push_back(zone.record.name);
+    }
+  }
+
+  file.write("QPLP", 4);
+  WriteValue(file, uint32_t(1));
+
+  WriteValue(file, static_cast<uint32_t>(state.threads.size()));
+  for (const auto& buffer : state.threads) {
+    WriteString(file, buffer->name);
+  }
+
+  WriteValue(file, static_cast<uint32_t>(strings.size()));
+  for (const char* string : strings) {
+    WriteString(file, string);
+  }
+
+  WriteValue(file, static_cast<uint32_t>(state.frames.size()));
+  for (int64_t frame : state.frames) {
+    WriteValue(file, frame - state.captureStart);
+  }
+
+  WriteValue(file, static_cast<uint64_t>(state.zones.size()));
+  for (const CapturedZone& zone : state.zones) {
+    WriteValue(file, zone.thread);
+    WriteValue(file, stringIndices[zone.record.name]);
+    WriteValue(file, zone.record.start - state.captureStart);
+    WriteValue(file, zone.record.end - zone.record.start);
+  }
+
+  return file.good();
+}
+
+} // namespace qpl
@@ -0,0 +1,130 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#ifndef QPL_CORE_PROFILER_HPP
+#define QPL_CORE_PROFILER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <cstdint>
+#include <filesystem>
+
+#include "core-config.hpp"
+
+//
+// ─── Profiler Switch ───────────────────────────────────────────────────
+//
+// With QPL_ENABLE_PROFILER set to 0 the QPL_PROFILE_* macros expand to nothing. CpuProfiler itself stays available
+// so code that starts or writes captures does not need to be conditional; its captures are simply empty.
+//
+#ifndef QPL_ENABLE_PROFILER
+#define QPL_ENABLE_PROFILER 1
+#endif
+
+namespace qpl {
+
+//
+// ---- Cpu Profiler ---------------------------------
+//
+// Records named CPU zones from any thread while a capture is running. Every thread writes its zones into a ring
+// buffer of its own, with a single producer and a single consumer, so recording never takes a lock; the rings are
+// drained into the capture at each frame marker. A thread that fills its ring between two frame markers drops zones
+// rather than blocking, and the number dropped is reported when the capture ends.
+//
+// Outside a capture a zone costs one relaxed load and a branch.
+//
+class CpuProfiler final {
+public:
+  // Zones per thread that can be pending between two frame markers.
+  static constexpr uint32_t RingCapacity = 1u << 14;
+
+  // Discards any previous capture and starts recording.
+  static void BeginCapture();
+  static void EndCapture();
+  static void ClearCapture();
+
+  // Marks the start of a frame and drains every thread's ring. Called by the thread driving the main loop.
+  static void MarkFrame();
+
+  // Name shown for the calling thread in exported captures.
+  static void SetThreadName(std::string name);
+
+  // Chrome trace-event JSON, viewable in chrome://tracing or Perfetto.
+  static bool WriteChromeTrace(const std::filesystem::path& path);
+
+  // Compact little-endian capture:
+  //   "QPLP", u32 version
+  //   u32 thread count,  then per thread   u32 length, name bytes
+  //   u32 string count,  then per string   u32 length, name bytes
+  //   u32 frame count,   then per frame    i64 start ns
+  //   u64 zone count,    then per zone     u32 thread, u32 string, i64 start ns, i64 duration ns
+  // Times are relative to the start of the capture.
+  static bool WriteBinaryCapture(const std::filesystem::path& path);
+
+  QPL_ALWAYS_INLINE static bool IsCapturing() {
+    return sCapturing.load(std::memory_order_relaxed);
+  }
+
+  QPL_ALWAYS_INLINE static int64_t Now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch()
+    )
+      .count();
+  }
+
+  // `name` must outlive the capture; zones are meant to be named with string literals.
+  static void RecordZone(const char* name, int64_t start, int64_t end);
+
+private:
+  static inline std::atomic<bool> sCapturing = false;
+};
+
+//
+// ---- Profile Zone ---------------------------------
+//
+// Scope guard behind QPL_PROFILE_ZONE. A zone that starts outside a capture is not recorded, even if one starts
+// before it ends.
+//
+class ProfileZone final {
+public:
+  QPL_ALWAYS_INLINE explicit ProfileZone(const char* name) {
+    if (CpuProfiler::IsCapturing()) {
+      mName = name;
+      mStart = CpuProfiler::Now();
+    }
+  }
+
+  QPL_ALWAYS_INLINE ~ProfileZone() {
+    if (mName) {
+      CpuProfiler::RecordZone(mName, mStart, CpuProfiler::Now());
+    }
+  }
+
+  ProfileZone(const ProfileZone&) = delete;
+  ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+  const char* mName = nullptr;
+  int64_t mStart = 0;
+};
+
+} // namespace qpl
+
+#define QPL_PROFILE_CONCAT_INNER(a, b) a##b
+#define QPL_PROFILE_CONCAT(a, b)       QPL_PROFILE_CONCAT_INNER(a, b)
+
+#if QPL_ENABLE_PROFILER
+#define QPL_PROFILE_ZONE(name)       ::qpl::ProfileZone QPL_PROFILE_CONCAT(qplProfileZone, __LINE__)(name)
+#define QPL_PROFILE_FUNCTION()       QPL_PROFILE_ZONE(__func__)
+#define QPL_PROFILE_FRAME()          ::qpl::CpuProfiler::MarkFrame()
+#define QPL_PROFILE_THREAD(name)     ::qpl::CpuProfiler::SetThreadName(name)
+#else
+#define QPL_PROFILE_ZONE(name)       ((void)0)
+#define QPL_PROFILE_FUNCTION()       ((void)0)
+#define QPL_PROFILE_FRAME()          ((void)0)
+#define QPL_PROFILE_THREAD(name)     ((void)0)
+#endif
+
+#endif
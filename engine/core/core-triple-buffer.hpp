@@ -0,0 +1,77 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#ifndef QPL_CORE_TRIPLE_BUFFER_HPP
+#define QPL_CORE_TRIPLE_BUFFER_HPP
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include "core-config.hpp"
+
+namespace qpl {
+
+//
+// ---- Triple Buffer ---------------------------------
+//
+// Hands the latest value from one producer thread to one consumer thread without either ever waiting on the other.
+// The producer fills the write buffer and publishes it; the consumer acquires whatever was published last. Values
+// published in between are skipped, which is what a renderer reading simulation snapshots wants.
+//
+// Publishing swaps the write buffer with the shared middle one, and acquiring swaps the read buffer with it, so the
+// buffers themselves are never copied. The write buffer therefore holds stale data after Publish(): a producer that
+// updates a snapshot in place has to rewrite all of it.
+//
+template <typename T>
+class TripleBuffer final {
+public:
+  // Producer only.
+  QPL_INLINE T& GetWriteBuffer() {
+    return mBuffers[mWrite].value;
+  }
+
+  // Producer only. Makes the write buffer the latest value.
+  QPL_INLINE void Publish() {
+    uint8_t previous = mMiddle.exchange(mWrite | FreshBit, std::memory_order_acq_rel);
+    mWrite = previous & IndexMask;
+  }
+
+  // Consumer only. Switches the read buffer to the latest published value, if there is a newer one than it holds.
+  QPL_INLINE bool Acquire() {
+    if ((mMiddle.load(std::memory_order_relaxed) & FreshBit) == 0) {
+      return false;
+    }
+
+    uint8_t previous = mMiddle.exchange(mRead, std::memory_order_acq_rel);
+    mRead = previous & IndexMask;
+    return true;
+  }
+
+  // Consumer only.
+  QPL_INLINE const T& GetReadBuffer() const {
+    return mBuffers[mRead].value;
+  }
+
+private:
+  static constexpr uint8_t IndexMask = 0x3;
+  static constexpr uint8_t FreshBit = 0x4;
+
+  // Each buffer on its own cache lines, so the producer and consumer do not share any.
+  struct alignas(64) Slot {
+    T value{};
+  };
+
+  std::array<Slot, 3> mBuffers;
+
+  // Index of the middle buffer, plus FreshBit if it was published after the consumer last acquired.
+  alignas(64) std::atomic<uint8_t> mMiddle = 1;
+
+  alignas(64) uint8_t mWrite = 0;
+  alignas(64) uint8_t mRead = 2;
+};
+
+} // namespace qpl
+
+#endif
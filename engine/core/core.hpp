@@ -7,5 +7,11 @@
 #include "core-config.hpp"
 #include "core-assert.hpp"
 #include "core-io.hpp"
+#include "core-hash.hpp"
+#include "core-profiler.hpp"
+#include "core-job-system.hpp"
+#include "core-triple-buffer.hpp"
+#include "core-percentile-history.hpp"
+#include "core-mapped-file.hpp"
 
 #endif
@@ -0,0 +1,94 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#include "archetype.hpp"
+
+#include <cstring>
+
+namespace qpl {
+
+static QPL_INLINE uint32_t AlignToCacheLine(uint32_t value) {
+  return (value + 63) & ~63u;
+}
+
+//
+// ---- Archetype ---------------------------------
+//
+Archetype::Archetype(const ComponentMask& mask)
+  : mMask(mask) {
+  mColumnIndex.fill(NoColumn);
+
+  uint32_t rowSize = sizeof(Entity);
+
+  for (ComponentId component = 0; component < MaxComponents; component++) {
+    if (mask.test(component)) {
+      const ComponentInfo& info = ComponentRegistry::GetInfo(component);
+
+      mColumnIndex[component] = static_cast<uint8_t>(mColumns.size());
+      mColumns.push_back({component, info.size, 0});
+      rowSize += info.size;
+    }
+  }
+
+  // Column padding takes up to a cache line per column, so the first guess can be a few rows too many.
+  auto fits = [&](uint32_t capacity) {
+    uint32_t size = AlignToCacheLine(capacity * (uint32_t)sizeof(Entity));
+
+    for (const Column& column : mColumns) {
+      size += AlignToCacheLine(capacity * column.size);
+    }
+
+    return size <= ChunkSize;
+  };
+
+  mChunkCapacity = ChunkSize / rowSize;
+
+  while (mChunkCapacity > 1 && !fits(mChunkCapacity)) {
+    mChunkCapacity--;
+  }
+
+  QPL_CORE_ASSERT(fits(mChunkCapacity) && "archetype row does not fit in a chunk");
+
+  uint32_t offset = AlignToCacheLine(mChunkCapacity * (uint32_t)sizeof(Entity));
+
+  for (Column& column : mColumns) {
+    column.offset = offset;
+    offset += AlignToCacheLine(mChunkCapacity * column.size);
+  }
+}
+
+uint32_t Archetype::AddRow(Entity entity) {
+  uint32_t row = mCount++;
+
+  if (row / mChunkCapacity == mChunks.size()) {
+    // Not value-initialized: rows are written before they are read.
+    mChunks.push_back(std::unique_ptr<Chunk>(new Chunk));
+  }
+
+  GetEntity(row) = entity;
+  return row;
+}
+
+Entity Archetype::RemoveRow(uint32_t row) {
+  uint32_t last = --mCount;
+  Entity moved = NullEntity;
+
+  if (row != last) {
+    moved = GetEntity(last);
+    GetEntity(row) = moved;
+
+    for (uint32_t column = 0; column < mColumns.size(); column++) {
+      std::memcpy(GetComponent(row, column), GetComponent(last, column), mColumns[column].size);
+    }
+  }
+
+  // Keeps one empty chunk around, so an archetype hovering at a chunk boundary does not allocate every frame.
+  while (mChunks.size() > GetChunkCount() + 1) {
+    mChunks.pop_back();
+  }
+
+  return moved;
+}
+
+} // namespace qpl
@@ -0,0 +1,123 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#ifndef QPL_ARCHETYPE_HPP
+#define QPL_ARCHETYPE_HPP
+
+#include <array>
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include <cstddef>
+#include <unordered_map>
+
+#include "entity.hpp"
+
+namespace qpl {
+
+// Storage block of an archetype. Sized to sit comfortably in L1 alongside the data a system writes elsewhere.
+QPL_INLINE_CONSTEXPR uint32_t ChunkSize = 16 * 1024;
+
+struct alignas(64) Chunk {
+  std::byte bytes[ChunkSize];
+};
+
+//
+// ---- Archetype ---------------------------------
+//
+// Every entity with exactly one set of components lives in that set's archetype. An archetype stores its entities
+// as structure-of-arrays inside fixed-size chunks: each chunk holds an entity column followed by one column per
+// component, every column starting on its own cache line, so iterating a component is a linear walk over
+// contiguous memory.
+//
+// Rows are kept dense. All chunks but the last are full, and removing a row moves the archetype's last row into its
+// place, so row r always lives in chunk r / capacity.
+//
+class Archetype final {
+public:
+  static constexpr uint8_t NoColumn = UINT8_MAX;
+
+  struct Column {
+    ComponentId component;
+    uint32_t size;
+    uint32_t offset;
+  };
+
+  explicit Archetype(const ComponentMask& mask);
+
+  QPL_INLINE const ComponentMask& GetMask() const {
+    return mMask;
+  }
+
+  QPL_INLINE uint32_t GetCount() const {
+    return mCount;
+  }
+
+  QPL_INLINE uint32_t GetChunkCapacity() const {
+    return mChunkCapacity;
+  }
+
+  QPL_INLINE uint32_t GetChunkCount() const {
+    return (mCount + mChunkCapacity - 1) / mChunkCapacity;
+  }
+
+  // Rows in use in chunk `chunk`.
+  QPL_INLINE uint32_t GetChunkRowCount(uint32_t chunk) const {
+    return std::min(mCount - chunk * mChunkCapacity, mChunkCapacity);
+  }
+
+  QPL_INLINE const std::vector<Column>& GetColumns() const {
+    return mColumns;
+  }
+
+  // Index into GetColumns(), or NoColumn if the archetype does not have the component.
+  QPL_INLINE uint8_t GetColumnIndex(ComponentId component) const {
+    return mColumnIndex[component];
+  }
+
+  QPL_INLINE Entity* GetEntities(uint32_t chunk) {
+    return reinterpret_cast<Entity*>(mChunks[chunk]->bytes);
+  }
+
+  QPL_INLINE std::byte* GetColumnData(uint32_t chunk, uint32_t column) {
+    return mChunks[chunk]->bytes + mColumns[column].offset;
+  }
+
+  template <typename T>
+  QPL_INLINE T* GetComponents(uint32_t chunk) {
+    return reinterpret_cast<T*>(GetColumnData(chunk, mColumnIndex[ComponentRegistry::GetId<T>()]));
+  }
+
+  QPL_INLINE std::byte* GetComponent(uint32_t row, uint32_t column) {
+    return GetColumnData(row / mChunkCapacity, column) + (size_t)(row % mChunkCapacity) * mColumns[column].size;
+  }
+
+  QPL_INLINE Entity& GetEntity(uint32_t row) {
+    return GetEntities(row / mChunkCapacity)[row % mChunkCapacity];
+  }
+
+  // Appends a row for `entity`, with its components left uninitialized.
+  uint32_t AddRow(Entity entity);
+
+  // Removes `row` by moving the last row into it. Returns the entity that was moved, or NullEntity if `row` was the
+  // last one.
+  Entity RemoveRow(uint32_t row);
+
+  // Archetypes reached by adding or removing one component, cached as the world discovers them.
+  std::unordered_map<ComponentId, Archetype*> addEdges;
+  std::unordered_map<ComponentId, Archetype*> removeEdges;
+
+private:
+  ComponentMask mMask;
+  std::vector<Column> mColumns;
+  std::array<uint8_t, MaxComponents> mColumnIndex;
+
+  uint32_t mChunkCapacity = 0;
+  uint32_t mCount = 0;
+  std::vector<std::unique_ptr<Chunk>> mChunks;
+};
+
+} // namespace qpl
+
+#endif
@@ -0,0 +1,94 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#ifndef QPL_ENTITY_COMMAND_BUFFER_HPP
+#define QPL_ENTITY_COMMAND_BUFFER_HPP
+
+#include <vector>
+#include <cstddef>
+#include <cstring>
+
+#include "entity.hpp"
+
+namespace qpl {
+
+//
+// ---- Entity Command Buffer ---------------------------------
+//
+// Records structural changes (creating and destroying entities, adding and removing components) to be applied to a
+// World later, at a point where nothing is iterating it. Systems running inside a query, or on job system workers,
+// make their structural changes through one of these.
+//
+// Create() returns a placeholder that later commands in the same buffer may refer to; it becomes a real entity when
+// the buffer is played back. Placeholders mean nothing outside their buffer.
+//
+// A buffer belongs to one thread at a time.
+//
+class EntityCommandBuffer final {
+public:
+  // Generation that marks a placeholder from Create().
+  static constexpr uint32_t PendingGeneration = UINT32_MAX;
+
+  QPL_INLINE Entity Create() {
+    Entity pending{mPendingCount++, PendingGeneration};
+    mCommands.push_back({Op::Create, 0, pending, 0, 0});
+    return pending;
+  }
+
+  QPL_INLINE void Destroy(Entity entity) {
+    mCommands.push_back({Op::Destroy, 0, entity, 0, 0});
+  }
+
+  // Adds `component` to `entity`, or overwrites it if the entity already has one.
+  template <typename T>
+  QPL_INLINE void Add(Entity entity, const T& component) {
+    uint32_t offset = static_cast<uint32_t>(mData.size());
+    mData.resize(offset + sizeof(T));
+    std::memcpy(mData.data() + offset, &component, sizeof(T));
+
+    mCommands.push_back({Op::Add, ComponentRegistry::GetId<T>(), entity, offset, static_cast<uint32_t>(sizeof(T))});
+  }
+
+  template <typename T>
+  QPL_INLINE void Remove(Entity entity) {
+    mCommands.push_back({Op::Remove, ComponentRegistry::GetId<T>(), entity, 0, 0});
+  }
+
+  QPL_INLINE bool IsEmpty() const {
+    return mCommands.empty();
+  }
+
+  QPL_INLINE void Clear() {
+    mCommands.clear();
+    mData.clear();
+    mPendingCount = 0;
+  }
+
+private:
+  friend class World;
+
+  enum class Op : uint8_t {
+    Create,
+    Destroy,
+    Add,
+    Remove,
+  };
+
+  struct Command {
+    Op op;
+    ComponentId component;
+    Entity entity;
+    // Component bytes in mData, for Add.
+    uint32_t dataOffset;
+    uint32_t dataSize;
+  };
+
+  std::vector<Command> mCommands;
+  std::vector<std::byte> mData;
+  uint32_t mPendingCount = 0;
+};
+
+} // namespace qpl
+
+#endif
@@ -0,0 +1,42 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#include "entity.hpp"
+
+#include <array>
+#include <mutex>
+
+namespace qpl {
+
+namespace {
+
+struct RegistryState {
+  std::mutex mutex;
+  std::array<ComponentInfo, MaxComponents> infos;
+  uint32_t count = 0;
+};
+
+RegistryState& GetRegistryState() {
+  static RegistryState state;
+  return state;
+}
+
+} // namespace
+
+ComponentId ComponentRegistry::Register(const ComponentInfo& info) {
+  RegistryState& state = GetRegistryState();
+  std::lock_guard lock(state.mutex);
+
+  QPL_CORE_ASSERT(state.count < MaxComponents && "too many component types");
+
+  state.infos[state.count] = info;
+  return state.count++;
+}
+
+const ComponentInfo& ComponentRegistry::GetInfo(ComponentId id) {
+  // Entries never change once registered, and an id is only handed out after its entry is written.
+  return GetRegistryState().infos[id];
+}
+
+} // namespace qpl
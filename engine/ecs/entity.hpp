@@ -0,0 +1,87 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#ifndef QPL_ENTITY_HPP
+#define QPL_ENTITY_HPP
+
+#include <bitset>
+#include <cstdint>
+#include <type_traits>
+
+#include <core/core.hpp>
+
+namespace qpl {
+
+//
+// ---- Entity ---------------------------------
+//
+// A handle to a game object in a World. The index names a slot in the world's entity table and the generation tells
+// apart the entities that have used it over time, so a handle to a destroyed entity never reaches its slot's next
+// occupant.
+//
+struct Entity {
+  uint32_t index = UINT32_MAX;
+  uint32_t generation = 0;
+
+  QPL_INLINE bool IsNull() const {
+    return index == UINT32_MAX;
+  }
+
+  QPL_INLINE bool operator==(const Entity& other) const = default;
+};
+
+QPL_INLINE_CONSTEXPR Entity NullEntity = {};
+
+//
+// ---- Components ---------------------------------
+//
+// Any trivially copyable type can be a component. Components are stored bytewise in chunks and moved with memcpy
+// whenever their entity changes archetype, so they must not own resources; refer to those by handle instead.
+//
+using ComponentId = uint32_t;
+
+QPL_INLINE_CONSTEXPR uint32_t MaxComponents = 128;
+
+// Set of component types; identifies an archetype.
+using ComponentMask = std::bitset<MaxComponents>;
+
+struct ComponentInfo {
+  uint32_t size = 0;
+  uint32_t alignment = 0;
+};
+
+// Hands out component ids in order of first use. Ids are only meaningful within one run of the program.
+class ComponentRegistry final {
+public:
+  template <typename T>
+  static ComponentId GetId() {
+    if constexpr (!std::is_same_v<T, std::remove_cv_t<T>>) {
+      // const T names the same component as T.
+      return GetId<std::remove_cv_t<T>>();
+    }
+    else {
+      static_assert(std::is_trivially_copyable_v<T>, "components are moved bytewise and must be trivially copyable");
+      static_assert(alignof(T) <= 64, "components can be aligned to at most a cache line");
+
+      static const ComponentId id = Register({sizeof(T), alignof(T)});
+      return id;
+    }
+  }
+
+  static const ComponentInfo& GetInfo(ComponentId id);
+
+private:
+  static ComponentId Register(const ComponentInfo& info);
+};
+
+template <typename... Ts>
+QPL_INLINE ComponentMask MakeComponentMask() {
+  ComponentMask mask;
+  (mask.set(ComponentRegistry::GetId<Ts>()), ...);
+  return mask;
+}
+
+} // namespace qpl
+
+#endif
@@ -0,0 +1,232 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#include "world.hpp"
+
+#include <cstring>
+
+namespace qpl {
+
+World::World(uint32_t commandBufferCount)
+  : mCommandBuffers(std::max(commandBufferCount, 1u)) {
+  // The empty archetype, home of entities created without components.
+  GetArchetype({});
+}
+
+World::~World() = default;
+
+bool World::IsAlive(Entity entity) const {
+  return entity.index < mRecords.size() && mRecords[entity.index].generation == entity.generation
+      && mRecords[entity.index].archetype != nullptr;
+}
+
+Entity World::CreateEntity(
+  const ComponentMask& mask, const ComponentId* components, const void* const* data, size_t count
+) {
+  QPL_CORE_ASSERT(mIterating == 0 && "entities cannot be created during a query; use a command buffer");
+
+  uint32_t index;
+
+  if (!mFreeIndices.empty()) {
+    index = mFreeIndices.back();
+    mFreeIndices.pop_back();
+  }
+  else {
+    index = static_cast<uint32_t>(mRecords.size());
+    mRecords.emplace_back();
+  }
+
+  EntityRecord& record = mRecords[index];
+  Entity entity{index, record.generation};
+
+  record.archetype = GetArchetype(mask);
+  record.row = record.archetype->AddRow(entity);
+
+  for (size_t i = 0; i < count; i++) {
+    uint8_t column = record.archetype->GetColumnIndex(components[i]);
+    std::memcpy(
+      record.archetype->GetComponent(record.row, column), data[i], record.archetype->GetColumns()[column].size
+    );
+  }
+
+  mEntityCount++;
+  return entity;
+}
+
+void World::Destroy(Entity entity) {
+  QPL_CORE_ASSERT(mIterating == 0 && "entities cannot be destroyed during a query; use a command buffer");
+
+  if (!IsAlive(entity)) {
+    return;
+  }
+
+  EntityRecord& record = mRecords[entity.index];
+
+  Entity moved = record.archetype->RemoveRow(record.row);
+  if (!moved.IsNull()) {
+    mRecords[moved.index].row = record.row;
+  }
+
+  record.archetype = nullptr;
+  record.generation++;
+  mFreeIndices.push_back(entity.index);
+  mEntityCount--;
+}
+
+void World::AddComponent(Entity entity, ComponentId component, const void* data) {
+  QPL_CORE_ASSERT(IsAlive(entity) && "entity is not alive");
+
+  EntityRecord& record = mRecords[entity.index];
+  Archetype* source = record.archetype;
+
+  if (source->GetColumnIndex(component) == Archetype::NoColumn) {
+    QPL_CORE_ASSERT(mIterating == 0 && "components cannot be added during a query; use a command buffer");
+
+    auto [edge, inserted] = source->addEdges.try_emplace(component, nullptr);
+    if (inserted) {
+      edge->second = GetArchetype(ComponentMask(source->GetMask()).set(component));
+    }
+
+    MoveEntity(record, edge->second);
+  }
+
+  uint8_t column = record.archetype->GetColumnIndex(component);
+  std::memcpy(record.archetype->GetComponent(record.row, column), data, record.archetype->GetColumns()[column].size);
+}
+
+void World::RemoveComponent(Entity entity, ComponentId component) {
+  QPL_CORE_ASSERT(IsAlive(entity) && "entity is not alive");
+
+  EntityRecord& record = mRecords[entity.index];
+  Archetype* source = record.archetype;
+
+  if (source->GetColumnIndex(component) == Archetype::NoColumn) {
+    return;
+  }
+
+  QPL_CORE_ASSERT(mIterating == 0 && "components cannot be removed during a query; use a command buffer");
+
+  auto [edge, inserted] = source->removeEdges.try_emplace(component, nullptr);
+  if (inserted) {
+    edge->second = GetArchetype(ComponentMask(source->GetMask()).reset(component));
+  }
+
+  MoveEntity(record, edge->second);
+}
+
+void* World::GetComponent(Entity entity, ComponentId component) {
+  if (!IsAlive(entity)) {
+    return nullptr;
+  }
+
+  EntityRecord& record = mRecords[entity.index];
+  uint8_t column = record.archetype->GetColumnIndex(component);
+
+  return column != Archetype::NoColumn ? record.archetype->GetComponent(record.row, column) : nullptr;
+}
+
+Archetype* World::GetArchetype(const ComponentMask& mask) {
+  auto [it, inserted] = mArchetypeMap.try_emplace(mask, nullptr);
+
+  if (inserted) {
+    mArchetypes.push_back(std::make_unique<Archetype>(mask));
+    it->second = mArchetypes.back().get();
+  }
+
+  return it->second;
+}
+
+void World::MoveEntity(EntityRecord& record, Archetype* target) {
+  Archetype* source = record.archetype;
+  Entity entity = source->GetEntity(record.row);
+
+  uint32_t row = target->AddRow(entity);
+
+  // Components the target does not have are dropped; the ones it adds are written by the caller.
+  for (uint32_t column = 0; column < target->GetColumns().size(); column++) {
+    const Archetype::Column& targetColumn = target->GetColumns()[column];
+    uint8_t sourceColumn = source->GetColumnIndex(targetColumn.component);
+
+    if (sourceColumn != Archetype::NoColumn) {
+      std::memcpy(target->GetComponent(row, column), source->GetComponent(record.row, sourceColumn), targetColumn.size);
+    }
+  }
+
+  Entity moved = source->RemoveRow(record.row);
+  if (!moved.IsNull()) {
+    mRecords[moved.index].row = record.row;
+  }
+
+  record.archetype = target;
+  record.row = row;
+}
+
+const std::vector<Archetype*>& World::MatchArchetypes(const ComponentMask& required) {
+  QueryCache& query = mQueries[required];
+
+  for (; query.archetypesSeen < mArchetypes.size(); query.archetypesSeen++) {
+    Archetype* archetype = mArchetypes[query.archetypesSeen].get();
+
+    if ((archetype->GetMask() & required) == required) {
+      query.archetypes.push_back(archetype);
+    }
+  }
+
+  return query.archetypes;
+}
+
+void World::Playback(EntityCommandBuffer& commandBuffer) {
+  using Op = EntityCommandBuffer::Op;
+
+  mPlaybackEntities.assign(commandBuffer.mPendingCount, NullEntity);
+
+  auto resolve = [&](Entity entity) {
+    return entity.generation == EntityCommandBuffer::PendingGeneration ? mPlaybackEntities[entity.index] : entity;
+  };
+
+  for (const EntityCommandBuffer::Command& command : commandBuffer.mCommands) {
+    switch (command.op) {
+    case Op::Create:
+      mPlaybackEntities[command.entity.index] = CreateEntity({}, nullptr, nullptr, 0);
+      break;
+
+    case Op::Destroy:
+      Destroy(resolve(command.entity));
+      break;
+
+    case Op::Add: {
+      Entity entity = resolve(command.entity);
+
+      if (IsAlive(entity)) {
+        QPL_CORE_ASSERT(
+          ComponentRegistry::GetInfo(command.component).size == command.dataSize && "component size mismatch"
+        );
+        AddComponent(entity, command.component, commandBuffer.mData.data() + command.dataOffset);
+      }
+      break;
+    }
+
+    case Op::Remove: {
+      Entity entity = resolve(command.entity);
+
+      if (IsAlive(entity)) {
+        RemoveComponent(entity, command.component);
+      }
+      break;
+    }
+    }
+  }
+
+  commandBuffer.Clear();
+}
+
+void World::FlushCommandBuffers() {
+  for (EntityCommandBuffer& commandBuffer : mCommandBuffers) {
+    if (!commandBuffer.IsEmpty()) {
+      Playback(commandBuffer);
+    }
+  }
+}
+
+} // namespace qpl
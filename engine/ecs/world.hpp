@@ -0,0 +1,212 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#ifndef QPL_WORLD_HPP
+#define QPL_WORLD_HPP
+
+#include <memory>
+#include <vector>
+#include <unordered_map>
+
+#include <core/core.hpp>
+#include "entity.hpp"
+#include "archetype.hpp"
+#include "entity-command-buffer.hpp"
+
+namespace qpl {
+
+//
+// ---- World ---------------------------------
+//
+// Owns every entity and component of a game. Entities are grouped into archetypes by the set of components they
+// have, see Archetype; adding or removing a component moves the entity to another archetype.
+//
+// Queries visit every archetype that has at least the requested components, chunk by chunk. EachChunk() hands the
+// callback the chunk's component columns as plain arrays, which is the form compilers vectorize; Each() is the
+// per-entity convenience on top of it. ParallelEachChunk() spreads the chunks over a JobSystem.
+//
+// Structural changes are not allowed while a query runs. Code inside a query, or on job system workers, records
+// them into a command buffer instead, and they are applied by FlushCommandBuffers() (the engine does so after every
+// fixed update). Writing existing components in place is always allowed.
+//
+class World final {
+public:
+  // Command buffers available through GetCommandBuffer(), one per thread recording concurrently; usually one per job
+  // system worker.
+  explicit World(uint32_t commandBufferCount = 1);
+  ~World();
+
+  World(const World&) = delete;
+  World& operator=(const World&) = delete;
+
+  template <typename... Ts>
+  Entity Create(const Ts&... components);
+
+  void Destroy(Entity entity);
+
+  bool IsAlive(Entity entity) const;
+
+  // Adds `component` to `entity`, or overwrites it if the entity already has one.
+  template <typename T>
+  QPL_INLINE void Add(Entity entity, const T& component) {
+    AddComponent(entity, ComponentRegistry::GetId<T>(), &component);
+  }
+
+  template <typename T>
+  QPL_INLINE void Remove(Entity entity) {
+    RemoveComponent(entity, ComponentRegistry::GetId<T>());
+  }
+
+  // The entity's component, or nullptr if it does not have one. Invalidated by the next structural change.
+  template <typename T>
+  QPL_INLINE T* Get(Entity entity) {
+    return static_cast<T*>(GetComponent(entity, ComponentRegistry::GetId<T>()));
+  }
+
+  template <typename T>
+  QPL_INLINE bool Has(Entity entity) {
+    return GetComponent(entity, ComponentRegistry::GetId<T>()) != nullptr;
+  }
+
+  QPL_INLINE uint32_t GetEntityCount() const {
+    return mEntityCount;
+  }
+
+  // Calls `fn(count, entities, components...)` once per chunk of every archetype that has all of Ts, where each
+  // components argument is a `T*` to `count` consecutive components. Const Ts are passed as pointers to const.
+  template <typename... Ts, typename Fn>
+  void EachChunk(Fn&& fn);
+
+  // Calls `fn(components&...)` for every entity that has all of Ts.
+  template <typename... Ts, typename Fn>
+  void Each(Fn&& fn);
+
+  // EachChunk(), with the chunks spread over `jobSystem`. `fn` runs concurrently on different chunks, and must not
+  // start queries of its own. Like JobSystem::ParallelFor(), it may run `fn` on the calling thread alone.
+  template <typename... Ts, typename Fn>
+  void ParallelEachChunk(JobSystem& jobSystem, Fn&& fn);
+
+  QPL_INLINE EntityCommandBuffer& GetCommandBuffer(uint32_t index) {
+    QPL_CORE_ASSERT(index < mCommandBuffers.size() && "command buffer index out of range");
+    return mCommandBuffers[index];
+  }
+
+  // Applies the buffer's commands in the order they were recorded, and clears it. Commands on entities that have
+  // been destroyed in the meantime are skipped.
+  void Playback(EntityCommandBuffer& commandBuffer);
+
+  // Plays back every buffer from GetCommandBuffer(), in index order.
+  void FlushCommandBuffers();
+
+private:
+  struct EntityRecord {
+    // nullptr while the slot is free.
+    Archetype* archetype = nullptr;
+    uint32_t row = 0;
+    uint32_t generation = 0;
+  };
+
+  struct QueryCache {
+    std::vector<Archetype*> archetypes;
+    // Archetypes already checked against the query; newer ones are matched on the next run.
+    size_t archetypesSeen = 0;
+  };
+
+  struct ChunkRef {
+    Archetype* archetype;
+    uint32_t chunk;
+  };
+
+  Entity CreateEntity(const ComponentMask& mask, const ComponentId* components, const void* const* data, size_t count);
+  void AddComponent(Entity entity, ComponentId component, const void* data);
+  void RemoveComponent(Entity entity, ComponentId component);
+  void* GetComponent(Entity entity, ComponentId component);
+
+  Archetype* GetArchetype(const ComponentMask& mask);
+  void MoveEntity(EntityRecord& record, Archetype* target);
+  const std::vector<Archetype*>& MatchArchetypes(const ComponentMask& required);
+
+  template <typename... Ts, typename Fn>
+  QPL_INLINE static void CallChunk(Archetype& archetype, uint32_t chunk, Fn& fn) {
+    fn(archetype.GetChunkRowCount(chunk), archetype.GetEntities(chunk), archetype.GetComponents<Ts>(chunk)...);
+  }
+
+private:
+  std::vector<EntityRecord> mRecords;
+  std::vector<uint32_t> mFreeIndices;
+  uint32_t mEntityCount = 0;
+
+  std::vector<std::unique_ptr<Archetype>> mArchetypes;
+  std::unordered_map<ComponentMask, Archetype*> mArchetypeMap;
+  std::unordered_map<ComponentMask, QueryCache> mQueries;
+
+  std::vector<EntityCommandBuffer> mCommandBuffers;
+  std::vector<Entity> mPlaybackEntities;
+
+  // Queries in progress; structural changes are refused while it is not zero.
+  uint32_t mIterating = 0;
+};
+
+template <typename... Ts>
+Entity World::Create(const Ts&... components) {
+  if constexpr (sizeof...(Ts) == 0) {
+    return CreateEntity({}, nullptr, nullptr, 0);
+  }
+  else {
+    const ComponentId ids[] = {ComponentRegistry::GetId<Ts>()...};
+    const void* const data[] = {&components...};
+
+    return CreateEntity(MakeComponentMask<Ts...>(), ids, data, sizeof...(Ts));
+  }
+}
+
+template <typename... Ts, typename Fn>
+void World::EachChunk(Fn&& fn) {
+  mIterating++;
+
+  for (Archetype* archetype : MatchArchetypes(MakeComponentMask<Ts...>())) {
+    uint32_t chunkCount = archetype->GetChunkCount();
+
+    for (uint32_t chunk = 0; chunk < chunkCount; chunk++) {
+      CallChunk<Ts...>(*archetype, chunk, fn);
+    }
+  }
+
+  mIterating--;
+}
+
+template <typename... Ts, typename Fn>
+void World::Each(Fn&& fn) {
+  EachChunk<Ts...>([&](uint32_t count, const Entity*, Ts*... components) {
+    for (uint32_t i = 0; i < count; i++) {
+      fn(components[i]...);
+    }
+  });
+}
+
+template <typename... Ts, typename Fn>
+void World::ParallelEachChunk(JobSystem& jobSystem, Fn&& fn) {
+  mIterating++;
+
+  std::vector<ChunkRef> chunks;
+
+  for (Archetype* archetype : MatchArchetypes(MakeComponentMask<Ts...>())) {
+    uint32_t chunkCount = archetype->GetChunkCount();
+
+    for (uint32_t chunk = 0; chunk < chunkCount; chunk++) {
+      chunks.push_back({archetype, chunk});
+    }
+  }
+
+  jobSystem.ParallelFor(static_cast<uint32_t>(chunks.size()), 1, [&](uint32_t index) {
+    const ChunkRef& ref = chunks[index];
+    CallChunk<Ts...>(*ref.archetype, ref.chunk, fn);
+  });
+
+  mIterating--;
+}
+
+} // namespace qpl
+
+#endif
@@ -4,26 +4,135 @@
 
 #include "engine.hpp"
 
+#include <cmath>
+
 namespace qpl {
 
+static QPL_INLINE double NsToSeconds(int64_t ns) {
+  return (double)ns / 1e9;
+}
+
 void Engine::PollEvents() {
-  SDL_Event event;
-  while (SDL_PollEvent(&event)) {
-    mEventDispatcher.Dispatch((Event)event.type, &event);
+  QPL_PROFILE_ZONE("Engine::PollEvents");
+
+  // There is no window to receive events from, but other threads may still have posted some.
+  if (!mWindowContext.IsHeadless()) {
+    SDL_Event event;
+
+    while (SDL_PollEvent(&event)) {
+      if (mEventDispatchMode == EventDispatchMode::Queued) {
+        mEventQueue.Push(event);
+      }
+      else {
+        // Unknown SDL event types still fall inside the table; they just have no handlers.
+        mEventDispatcher.Dispatch((Event)event.type, &event);
+      }
+    }
   }
+
+  mEventQueue.Flush(mEventDispatcher);
 }
 
 void Engine::Init() {
   mIsRunning = true;
+  mLastTime = CpuProfiler::Now();
+
+  QPL_CORE_ASSERT(mConfig.fixedTimestep > 0.0 && "fixedTimestep must be positive");
+
+  if (mConfig.threadedRendering && mJobSystem.GetWorkerCount() == 1) {
+    LogWarning("Engine - Threaded rendering needs at least one job thread, rendering on the main thread instead");
+    mConfig.threadedRendering = false;
+  }
+
+  // Low latency pacing holds back input sampling until the previous present, but with threaded rendering the wait
+  // happens on the render thread while the main thread samples input on its own schedule, so it would only cost
+  // frames without saving any latency.
+  if (mConfig.threadedRendering && mRenderer.GetFramePacing() == FramePacing::LowLatency) {
+    LogWarning("Engine - Low latency pacing does not work with threaded rendering, pacing to the target rate instead");
+    mRenderer.SetFramePacing(FramePacing::TargetFps);
+  }
+
+  // A frame only cares where a resize or a burst of mouse motion ended up.
+  mEventQueue.SetCoalescing(Event::SDL_WindowResize, EventCoalescing::KeepLast);
+  mEventQueue.SetCoalescing(Event::SDL_MouseMotion, EventCoalescing::Merge, EventQueue::MergeMouseMotion);
 
   // Subscribe to events
-  mEventDispatcher.Subscribe(Event::SDL_Quit, [this](void*) { mIsRunning = false; });
+  mEventDispatcher.Subscribe<Event::SDL_Quit>(this, [](Engine* engine, const SDL_QuitEvent&) {
+    engine->mIsRunning = false;
+  });
+  mEventDispatcher.Subscribe<Event::SDL_WindowResize>(this, [](Engine* engine, const SDL_WindowEvent&) {
+    // The event carries the size in window coordinates; the swap chain needs pixels.
+    int width, height;
+    SDL_GetWindowSizeInPixels(engine->mWindowContext.GetSDLWindow(), &width, &height);
+    engine->mRenderer.OnWindowResized(static_cast<uint32_t>(width), static_cast<uint32_t>(height));
+  });
+}
+
+void Engine::Update() {
+  QPL_PROFILE_ZONE("Engine::Update");
+
+  mJobSystem.RunMainThreadJobs();
+
+  int64_t now = CpuProfiler::Now();
+  mAccumulator += NsToSeconds(now - mLastTime);
+  mLastTime = now;
+
+  const double step = mConfig.fixedTimestep;
+  uint32_t steps = 0;
+
+  while (mAccumulator >= step && steps < mConfig.maxStepsPerFrame) {
+    mEventDispatcher.Dispatch<Event::Engine_FixedUpdate>({mTick, step, (double)mTick * step});
+    mWorld.FlushCommandBuffers();
+
+    mAccumulator -= step;
+    mTick++;
+    steps++;
+  }
+
+  // Whatever could not be simulated this frame is dropped, so one long hitch does not turn into many.
+  if (mAccumulator >= step) {
+    mAccumulator = std::fmod(mAccumulator, step);
+  }
+
+  if (steps == 0) {
+    return;
+  }
+
+  mEventDispatcher.Dispatch<Event::Engine_PublishSnapshot>({mTick, (double)mTick * step});
+
+  SimulationTiming& timing = mTiming.GetWriteBuffer();
+  timing.tick = mTick;
+  timing.accumulator = mAccumulator;
+  timing.publishedAt = now;
+  timing.inputTime = mInputTime;
+  mTiming.Publish();
 }
 
-void Engine::Update() {}
+void Engine::Render(float interpolationAlpha, int64_t inputTime) {
+  QPL_PROFILE_ZONE("Engine::Render");
 
-void Engine::Render() {
-  mRenderer.Render();
+  mRenderer.Render(interpolationAlpha, inputTime);
+
+  if (mRenderer.IsFrameLimitReached()) {
+    mIsRunning.store(false, std::memory_order_release);
+  }
+}
+
+void Engine::RenderThreadMain() {
+  QPL_PROFILE_THREAD("render");
+
+  while (IsRunning()) {
+    mRenderer.WaitForNextFrame();
+
+    mTiming.Acquire();
+    const SimulationTiming& timing = mTiming.GetReadBuffer();
+
+    // Real time has moved on since the snapshot was published; the alpha has to account for that too.
+    double elapsed = timing.accumulator + NsToSeconds(CpuProfiler::Now() - timing.publishedAt);
+    double alpha = timing.tick > 0 ? std::clamp(elapsed / mConfig.fixedTimestep, 0.0, 1.0) : 0.0;
+
+    Render((float)alpha, timing.inputTime);
+  }
 }
 
 void Engine::Shutdown() {
@@ -32,11 +141,39 @@ void Engine::Shutdown() {
 
 void Engine::Start() {
   Init();
+  QPL_PROFILE_THREAD("main");
+
+  if (mConfig.threadedRendering) {
+    mRenderThread = std::thread([this] { RenderThreadMain(); });
+  }
 
   while (IsRunning()) {
+    QPL_PROFILE_FRAME();
+
+    // The render thread paces itself.
+    if (!mConfig.threadedRendering) {
+      mRenderer.WaitForNextFrame();
+    }
+
+    mInputTime = CpuProfiler::Now();
+
     PollEvents();
     Update();
-    Render();
+
+    if (!mConfig.threadedRendering) {
+      Render((float)(mAccumulator / mConfig.fixedTimestep), mInputTime);
+      continue;
+    }
+
+    // Nothing to do until the next step is due; rendering carries on meanwhile.
+    QPL_PROFILE_ZONE("Engine::WaitForStep");
+
+    int64_t nextStep = mLastTime + (int64_t)((mConfig.fixedTimestep - mAccumulator) * 1e9);
+    std::this_thread::sleep_for(std::chrono::nanoseconds(nextStep - CpuProfiler::Now()));
+  }
+
+  if (mRenderThread.joinable()) {
+    mRenderThread.join();
   }
 
   Shutdown();
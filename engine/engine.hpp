@@ -8,42 +8,145 @@
 #include <core/core.hpp>
 #include <events/event.hpp>
 #include <events/event-dispatcher.hpp>
+#include <events/event-queue.hpp>
 #include <rendering/renderer.hpp>
+#include <ecs/world.hpp>
+#include <assets/asset-archive.hpp>
 #include "window.hpp"
 
 namespace qpl {
 
+enum class EventDispatchMode : uint8_t {
+  // Every SDL event is dispatched the moment it is polled.
+  Immediate,
+  // SDL events are queued, coalesced and dispatched together once polling is done.
+  Queued,
+};
+
+struct EngineConfig {
+  // Job system threads besides the main thread. 0 runs every job on the main thread.
+  uint32_t jobThreads = std::max(1u, std::thread::hardware_concurrency()) - 1;
+
+  // Length of a simulation step, in seconds. Engine_FixedUpdate fires once per step, however fast frames are.
+  double fixedTimestep = 1.0 / 60.0;
+
+  // Most steps simulated in one frame. Past it the simulation falls behind real time rather than spending ever
+  // longer frames catching up.
+  uint32_t maxStepsPerFrame = 8;
+
+  // Renders on a thread of its own, so a frame's simulation overlaps the previous frame's rendering. Needs at least
+  // one job thread, since the render thread records through the job system without being part of it. Replaces
+  // FramePacing::LowLatency with FramePacing::TargetFps.
+  bool threadedRendering = false;
+};
+
+// Simulation clock as of the last published snapshot. Lets the render thread work out the interpolation alpha.
+struct SimulationTiming {
+  uint64_t tick = 0;
+  // Time left over in the accumulator when it was published, in seconds.
+  double accumulator = 0.0;
+  // CpuProfiler::Now() when it was published.
+  int64_t publishedAt = 0;
+  // CpuProfiler::Now() when the input the snapshot was simulated from was sampled.
+  int64_t inputTime = 0;
+};
+
 //
 // ---- Engine Class ---------------------------------
 //
+//
+// The main loop runs the simulation at a fixed rate: real time goes into an accumulator, and every full step in it
+// fires Engine_FixedUpdate. Engine_PublishSnapshot follows the last step of a frame; handlers copy what the renderer
+// needs into a TripleBuffer there. Frames are rendered with the fraction of a step left in the accumulator as the
+// interpolation alpha.
+//
+// With threaded rendering the render thread draws the latest published snapshot in a loop of its own while the
+// main thread polls events and simulates, sleeping until the next step is due. Draw tasks then run on the render
+// thread and must only read simulation state through snapshots.
+//
 class Engine final {
 public:
-  QPL_INLINE Engine(WindowConfig& windowConfig)
-    : mWindowContext(windowConfig),
-      mRenderer(mWindowContext) {}
+  QPL_INLINE Engine(
+    WindowConfig& windowConfig, const RendererConfig& rendererConfig = {}, const EngineConfig& engineConfig = {}
+  )
+    : mConfig(engineConfig),
+      mWindowContext(windowConfig),
+      mJobSystem(engineConfig.jobThreads),
+      mWorld(mJobSystem.GetWorkerCount()),
+      mRenderer(mWindowContext, mJobSystem, rendererConfig) {}
 
   void Start();
 
   QPL_INLINE bool IsRunning() const {
-    return mIsRunning;
+    return mIsRunning.load(std::memory_order_acquire);
+  }
+
+  // Ticks simulated so far.
+  QPL_INLINE uint64_t GetTick() const {
+    return mTick;
+  }
+
+  QPL_INLINE void SetEventDispatchMode(EventDispatchMode mode) {
+    mEventDispatchMode = mode;
+  }
+
+  QPL_INLINE EventDispatcher& GetEventDispatcher() {
+    return mEventDispatcher;
+  }
+
+  // Engine events may be posted to it from any thread; they are delivered with the next frame's events.
+  QPL_INLINE EventQueue& GetEventQueue() {
+    return mEventQueue;
+  }
+
+  // The engine's thread is the job system's main thread. Jobs that need SDL go through RunOnMainThread(); the main
+  // thread runs those whenever it waits on a counter, and at the start of every update.
+  QPL_INLINE JobSystem& GetJobSystem() {
+    return mJobSystem;
+  }
+
+  // Has one command buffer per job system worker, indexed by JobSystem::GetWorkerIndex(). They are flushed after
+  // every Engine_FixedUpdate. Small ParallelFor() and ParallelEachChunk() calls run inline on the caller, so code that
+  // may run outside the job system, such as on the render thread, gets ExternalThread there and must not index with it.
+  QPL_INLINE World& GetWorld() {
+    return mWorld;
   }
 
 private:
   void Init();
   void PollEvents();
   void Update();
-  void Render();
+  void Render(float interpolationAlpha, int64_t inputTime);
+  void RenderThreadMain();
   void Shutdown();
 
 private:
-  // Main flag that controls the event loop.
-  bool mIsRunning = false;
+  EngineConfig mConfig;
+
+  // Main flag that controls the event loop. Also cleared by the render thread once the frame limit is reached.
+  std::atomic<bool> mIsRunning = false;
+
+  // Fixed timestep
+  int64_t mLastTime = 0;
+  int64_t mInputTime = 0;
+  double mAccumulator = 0.0;
+  uint64_t mTick = 0;
+  TripleBuffer<SimulationTiming> mTiming;
+  std::thread mRenderThread;
 
   // Window
   WindowContext mWindowContext;
 
+  // Declared before everything that runs jobs, so it outlives them.
+  JobSystem mJobSystem;
+
+  // Entities and components
+  World mWorld;
+
   // Event handler
   EventDispatcher mEventDispatcher;
+  EventQueue mEventQueue;
+  EventDispatchMode mEventDispatchMode = EventDispatchMode::Queued;
 
   // Renderer
   Renderer mRenderer;
@@ -4,16 +4,89 @@
 
 #include "event-dispatcher.hpp"
 
+#include <algorithm>
+
 namespace qpl {
 
-void EventDispatcher::Subscribe(Event event, EventCallback&& callback) {
-  mSubscribers[event].push_back(std::move(callback));
+EventDispatcher::EventDispatcher()
+  : mTable(std::make_unique<uint16_t[]>(EventCount)),
+    mLists(1) {}
+
+EventSubscription EventDispatcher::Add(Event event, void* context, Thunk thunk) {
+  uint32_t index = static_cast<uint32_t>(event);
+  QPL_CORE_ASSERT(index < EventCount && "event out of range");
+
+  if (mTable[index] == 0) {
+    QPL_CORE_ASSERT(mLists.size() <= UINT16_MAX && "too many distinct events with handlers");
+
+    mTable[index] = static_cast<uint16_t>(mLists.size());
+    mLists.emplace_back();
+  }
+
+  uint32_t id = mNextId++;
+  mLists[mTable[index]].handlers.push_back({context, thunk, id});
+
+  return {event, id};
+}
+
+void EventDispatcher::Unsubscribe(EventSubscription subscription) {
+  uint32_t index = static_cast<uint32_t>(subscription.event);
+  if (!subscription.IsValid() || index >= EventCount || mTable[index] == 0) {
+    return;
+  }
+
+  HandlerList& list = mLists[mTable[index]];
+
+  auto it = std::find_if(list.handlers.begin(), list.handlers.end(), [&](const Handler& handler) {
+    return handler.id == subscription.id;
+  });
+
+  if (it == list.handlers.end()) {
+    return;
+  }
+
+  // A dispatch in progress may be iterating this list; removal has to wait until it is done.
+  it->thunk = nullptr;
+  list.hasRemoved = true;
+
+  if (mDispatchDepth == 0) {
+    Compact(list);
+  }
 }
 
-void EventDispatcher::Dispatch(const Event& event, void* pEvent) {
-  for (const EventCallback& callback : mSubscribers[event]) {
-    callback(pEvent);
+void EventDispatcher::Dispatch(Event event, const void* payload) {
+  uint32_t index = static_cast<uint32_t>(event);
+  QPL_CORE_ASSERT(index < EventCount && "event out of range");
+
+  uint16_t listIndex = mTable[index];
+  if (listIndex == 0) {
+    return;
+  }
+
+  mDispatchDepth++;
+
+  // Handlers added by the handlers below land past `count` and wait for the next dispatch. The list is looked up
+  // again on every call, since subscribing to a new event can move it.
+  size_t count = mLists[listIndex].handlers.size();
+
+  for (size_t i = 0; i < count; i++) {
+    const Handler& handler = mLists[listIndex].handlers[i];
+
+    if (handler.thunk) {
+      handler.thunk(handler.context, payload);
+    }
   }
+
+  mDispatchDepth--;
+
+  if (mDispatchDepth == 0 && mLists[listIndex].hasRemoved) {
+    Compact(mLists[listIndex]);
+  }
+}
+
+void EventDispatcher::Compact(HandlerList& list) {
+  std::erase_if(list.handlers, [](const Handler& handler) { return handler.thunk == nullptr; });
+  list.hasRemoved = false;
 }
 
 } // namespace qpl
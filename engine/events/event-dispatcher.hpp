@@ -5,30 +5,100 @@
 #ifndef EVENT_DISPATCHER_HPP
 #define EVENT_DISPATCHER_HPP
 
+#include <memory>
 #include <vector>
-#include <bit>
-#include <unordered_map>
-#include <functional>
-#include <typeindex>
+#include <type_traits>
 
 #include <core/core.hpp>
 #include "event.hpp"
 
 namespace qpl {
 
+// Returned by EventDispatcher::Subscribe(); hand it back to Unsubscribe() to remove the handler.
+struct EventSubscription {
+  Event event = Event::SDL_First;
+  uint32_t id = 0;
+
+  QPL_INLINE bool IsValid() const {
+    return id != 0;
+  }
+};
+
 //
 // ---- Event Dispatcher --------------------------------
 //
+// Routes events to handlers through a flat table indexed by the event value, so dispatching costs two array loads
+// and a loop over the event's handlers, whether it has any or not.
+//
+// Handlers are a context pointer plus a plain function pointer generated per subscription, never a heap-allocated
+// closure. They receive the payload type declared for their event by EventPayload.
+//
+// Handlers may subscribe and unsubscribe while an event is being dispatched. New handlers are first called for the
+// next dispatch; removed handlers are not called again, even later in the same dispatch.
+//
 class EventDispatcher final {
 public:
-  using EventCallback = std::function<void(void*)>;
+  EventDispatcher();
+
+  // Calls `handler(context, payload)`. `handler` must be a captureless lambda (or any empty function object), so
+  // that it can be rebuilt from its type alone instead of being stored.
+  template <Event E, typename T, typename Handler>
+  QPL_INLINE EventSubscription Subscribe(T* context, Handler) {
+    static_assert(
+      std::is_empty_v<Handler> && std::is_default_constructible_v<Handler>,
+      "event handlers must not capture; pass state through the context pointer"
+    );
+
+    return Add(E, context, [](void* context, const void* payload) {
+      Handler{}(static_cast<T*>(context), *static_cast<const EventPayloadType<E>*>(payload));
+    });
+  }
 
-  void Subscribe(Event event, EventCallback&& callback);
+  // Calls `(context->*Method)(payload)`.
+  template <Event E, auto Method, typename T>
+  QPL_INLINE EventSubscription Subscribe(T* context) {
+    return Add(E, context, [](void* context, const void* payload) {
+      (static_cast<T*>(context)->*Method)(*static_cast<const EventPayloadType<E>*>(payload));
+    });
+  }
 
-  void Dispatch(const Event& event, void* pEvent);
+  void Unsubscribe(EventSubscription subscription);
+
+  template <Event E>
+  QPL_INLINE void Dispatch(const EventPayloadType<E>& payload) {
+    Dispatch(E, &payload);
+  }
+
+  // For events whose type is only known at runtime, such as those polled from SDL. `payload` must point to the
+  // event's declared payload type; for SDL events a pointer to the SDL_Event itself is always valid.
+  void Dispatch(Event event, const void* payload);
+
+private:
+  using Thunk = void (*)(void* context, const void* payload);
+
+  struct Handler {
+    void* context = nullptr;
+    // Null once unsubscribed during a dispatch, until the list is compacted.
+    Thunk thunk = nullptr;
+    uint32_t id = 0;
+  };
+
+  struct HandlerList {
+    std::vector<Handler> handlers;
+    bool hasRemoved = false;
+  };
+
+  EventSubscription Add(Event event, void* context, Thunk thunk);
+  void Compact(HandlerList& list);
 
 private:
-  std::unordered_map<Event, std::vector<EventCallback>> mSubscribers;
+  // Indexed by event value; 0 means the event has never had handlers. Points into mLists.
+  std::unique_ptr<uint16_t[]> mTable;
+  // mLists[0] is always empty.
+  std::vector<HandlerList> mLists;
+
+  uint32_t mNextId = 1;
+  uint32_t mDispatchDepth = 0;
 };
 
 } // namespace qpl
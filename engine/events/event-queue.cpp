@@ -0,0 +1,158 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#include "event-queue.hpp"
+
+#include <cstring>
+
+namespace qpl {
+
+void* EventQueue::Arena::Allocate(size_t size, size_t alignment) {
+  QPL_CORE_ASSERT(size + alignment <= BlockSize && "event payload too large for the arena");
+
+  while (true) {
+    if (mBlock == mBlocks.size()) {
+      mBlocks.push_back(std::make_unique<std::byte[]>(BlockSize));
+    }
+
+    std::byte* base = mBlocks[mBlock].get();
+    size_t offset = (reinterpret_cast<uintptr_t>(base) + mOffset + alignment - 1) / alignment * alignment
+                  - reinterpret_cast<uintptr_t>(base);
+
+    if (offset + size <= BlockSize) {
+      mOffset = offset + size;
+      return base + offset;
+    }
+
+    mBlock++;
+    mOffset = 0;
+  }
+}
+
+void EventQueue::Arena::Reset() {
+  mBlock = 0;
+  mOffset = 0;
+}
+
+EventQueue::EventQueue()
+  : mRuleTable(std::make_unique<uint8_t[]>(EventCount)),
+    mRules(1) {}
+
+void EventQueue::SetCoalescing(Event event, EventCoalescing coalescing, EventMergeFn merge) {
+  uint32_t index = static_cast<uint32_t>(event);
+  QPL_CORE_ASSERT(index < EventCount && "event out of range");
+  QPL_CORE_ASSERT((coalescing != EventCoalescing::Merge || merge) && "merge coalescing needs a merge function");
+
+  if (mRuleTable[index] == 0) {
+    QPL_CORE_ASSERT(mRules.size() <= UINT8_MAX && "too many coalescing rules");
+
+    mRuleTable[index] = static_cast<uint8_t>(mRules.size());
+    mRules.emplace_back();
+  }
+
+  Rule& rule = mRules[mRuleTable[index]];
+  rule.coalescing = coalescing;
+  rule.merge = merge;
+}
+
+void EventQueue::Push(Event event, const void* payload, size_t size, size_t alignment) {
+  uint32_t index = static_cast<uint32_t>(event);
+  QPL_CORE_ASSERT(index < EventCount && "event out of range");
+
+  Rule& rule = mRules[mRuleTable[index]];
+
+  if (rule.coalescing != EventCoalescing::None && rule.pendingFrame == mFrame) {
+    Record& pending = mRecords[rule.pendingRecord];
+    QPL_CORE_ASSERT(pending.size == size && "coalesced events must have the same payload size");
+
+    if (rule.coalescing == EventCoalescing::KeepLast) {
+      std::memcpy(pending.payload, payload, size);
+      return;
+    }
+
+    if (rule.merge(pending.payload, payload)) {
+      return;
+    }
+  }
+
+  void* storage = mArena.Allocate(size, alignment);
+  std::memcpy(storage, payload, size);
+
+  if (rule.coalescing != EventCoalescing::None) {
+    rule.pendingRecord = static_cast<uint32_t>(mRecords.size());
+    rule.pendingFrame = mFrame;
+  }
+
+  mRecords.push_back({event, static_cast<uint32_t>(size), storage});
+}
+
+void EventQueue::Post(Event event, const void* payload, size_t size, size_t alignment) {
+  std::lock_guard lock(mInboxMutex);
+
+  void* storage = mInboxArena.Allocate(size, alignment);
+  std::memcpy(storage, payload, size);
+  mInbox.push_back({event, static_cast<uint32_t>(size), storage});
+}
+
+void EventQueue::Flush(EventDispatcher& dispatcher) {
+  {
+    std::lock_guard lock(mInboxMutex);
+
+    // Posted payloads are copied once more, into the frame arena, so that they coalesce like any other event.
+    for (const Record& record : mInbox) {
+      Push(record.event, record.payload, record.size, alignof(std::max_align_t));
+    }
+
+    mInbox.clear();
+    mInboxArena.Reset();
+  }
+
+  // Events pushed by handlers from here on must not coalesce into ones that were already delivered.
+  mFrame++;
+
+  // Indexed rather than iterated: handlers may push more events while we go.
+  for (size_t i = 0; i < mRecords.size(); i++) {
+    dispatcher.Dispatch(mRecords[i].event, mRecords[i].payload);
+  }
+
+  for (const BatchListener& listener : mBatchListeners) {
+    mBatchScratch.clear();
+
+    for (const Record& record : mRecords) {
+      if (record.event == listener.event) {
+        mBatchScratch.push_back(record.payload);
+      }
+    }
+
+    if (!mBatchScratch.empty()) {
+      listener.thunk(listener.context, mBatchScratch);
+    }
+  }
+
+  mRecords.clear();
+  mArena.Reset();
+
+  // Invalidates every rule's pending record at once, including any that handlers queued above.
+  mFrame++;
+}
+
+bool EventQueue::MergeMouseMotion(void* pending, const void* incoming) {
+  // Queued SDL events are whole SDL_Events; the motion member sits at the start of the union.
+  auto& accumulated = *static_cast<SDL_MouseMotionEvent*>(pending);
+  const auto& latest = *static_cast<const SDL_MouseMotionEvent*>(incoming);
+
+  if (accumulated.which != latest.which) {
+    return false;
+  }
+
+  float xrel = accumulated.xrel + latest.xrel;
+  float yrel = accumulated.yrel + latest.yrel;
+
+  accumulated = latest;
+  accumulated.xrel = xrel;
+  accumulated.yrel = yrel;
+  return true;
+}
+
+} // namespace qpl
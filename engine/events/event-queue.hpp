@@ -0,0 +1,243 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#ifndef QPL_EVENT_QUEUE_HPP
+#define QPL_EVENT_QUEUE_HPP
+
+#include <span>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+#include <core/core.hpp>
+#include "event.hpp"
+#include "event-dispatcher.hpp"
+
+namespace qpl {
+
+// What happens when an event is queued while an earlier one of the same type is still pending this frame.
+enum class EventCoalescing : uint8_t {
+  None,     // Both are delivered.
+  KeepLast, // The pending event's payload is replaced by the new one.
+  Merge,    // The new payload is folded into the pending one with the rule's merge function.
+};
+
+// Folds `incoming` into `pending`; both point to the event's queued payload. Returns false, leaving `pending` as it
+// was, if the two must stay apart; `incoming` is then queued on its own and later events coalesce into it instead.
+using EventMergeFn = bool (*)(void* pending, const void* incoming);
+
+//
+// ---- Event Batch ---------------------------------
+//
+// Every queued event of type E in a frame, in the order they were queued.
+//
+template <Event E>
+class EventBatch final {
+public:
+  using Payload = EventPayloadType<E>;
+
+  class Iterator final {
+  public:
+    QPL_INLINE explicit Iterator(const void* const* current)
+      : mCurrent(current) {}
+
+    QPL_INLINE const Payload& operator*() const {
+      return *static_cast<const Payload*>(*mCurrent);
+    }
+
+    QPL_INLINE Iterator& operator++() {
+      mCurrent++;
+      return *this;
+    }
+
+    QPL_INLINE bool operator==(const Iterator& other) const = default;
+
+  private:
+    const void* const* mCurrent;
+  };
+
+  QPL_INLINE explicit EventBatch(std::span<const void* const> payloads)
+    : mPayloads(payloads) {}
+
+  QPL_INLINE size_t size() const {
+    return mPayloads.size();
+  }
+
+  QPL_INLINE bool empty() const {
+    return mPayloads.empty();
+  }
+
+  QPL_INLINE const Payload& operator[](size_t index) const {
+    return *static_cast<const Payload*>(mPayloads[index]);
+  }
+
+  QPL_INLINE const Payload& back() const {
+    return (*this)[mPayloads.size() - 1];
+  }
+
+  QPL_INLINE Iterator begin() const {
+    return Iterator(mPayloads.data());
+  }
+
+  QPL_INLINE Iterator end() const {
+    return Iterator(mPayloads.data() + mPayloads.size());
+  }
+
+private:
+  std::span<const void* const> mPayloads;
+};
+
+//
+// ---- Event Queue ---------------------------------
+//
+// Collects a frame's events and delivers them all at once in Flush(), instead of one by one as they arrive.
+// Payloads are copied into an arena that is rewound every frame, so queuing does not allocate once the arena has
+// grown to the frame's needs.
+//
+// Per-event coalescing rules collapse bursts: a coalesced event keeps the position of the frame's first occurrence
+// but carries the latest (or merged) data. Batch listeners receive every event of their type at once, after the
+// individual handlers have run.
+//
+// Push() and Flush() belong to the thread that owns the queue. Post() may be called from any thread; posted events
+// are merged into the queue at the start of the next Flush().
+//
+class EventQueue final {
+public:
+  EventQueue();
+
+  void SetCoalescing(Event event, EventCoalescing coalescing, EventMergeFn merge = nullptr);
+
+  template <Event E>
+  QPL_INLINE void Push(const EventPayloadType<E>& payload) {
+    static_assert(std::is_trivially_copyable_v<EventPayloadType<E>>, "queued payloads are copied bytewise");
+
+    if constexpr (E < Event::Engine_First) {
+      Push(WrapSDLEvent<E>(payload));
+    }
+    else {
+      Push(E, &payload, sizeof(payload), alignof(EventPayloadType<E>));
+    }
+  }
+
+  // Queues an SDL event under its runtime type. The whole SDL_Event is kept, so every handler's payload type fits.
+  QPL_INLINE void Push(const SDL_Event& event) {
+    Push(static_cast<Event>(event.type), &event, sizeof(event), alignof(SDL_Event));
+  }
+
+  // Thread-safe.
+  template <Event E>
+  QPL_INLINE void Post(const EventPayloadType<E>& payload) {
+    static_assert(std::is_trivially_copyable_v<EventPayloadType<E>>, "queued payloads are copied bytewise");
+
+    if constexpr (E < Event::Engine_First) {
+      SDL_Event event = WrapSDLEvent<E>(payload);
+      Post(E, &event, sizeof(event), alignof(SDL_Event));
+    }
+    else {
+      Post(E, &payload, sizeof(payload), alignof(EventPayloadType<E>));
+    }
+  }
+
+  // Calls `handler(context, batch)` once per flush in which at least one E was queued. Same handler rules as
+  // EventDispatcher::Subscribe().
+  template <Event E, typename T, typename Handler>
+  QPL_INLINE void SubscribeBatch(T* context, Handler) {
+    static_assert(
+      std::is_empty_v<Handler> && std::is_default_constructible_v<Handler>,
+      "event handlers must not capture; pass state through the context pointer"
+    );
+
+    auto thunk = [](void* context, std::span<const void* const> payloads) {
+      Handler{}(static_cast<T*>(context), EventBatch<E>(payloads));
+    };
+
+    mBatchListeners.push_back({E, context, thunk});
+  }
+
+  // Delivers everything queued since the last flush, through `dispatcher` and then to batch listeners, and rewinds
+  // the arena. Events pushed by handlers during the flush are delivered in it too.
+  void Flush(EventDispatcher& dispatcher);
+
+  QPL_INLINE size_t GetPendingCount() const {
+    return mRecords.size();
+  }
+
+  // The coalescing rule for SDL_MouseMotion: sums the relative motion, keeps the latest position and buttons. Motion
+  // from different mice is kept apart.
+  static bool MergeMouseMotion(void* pending, const void* incoming);
+
+private:
+  // Bump allocator over fixed-size blocks. Rewinding keeps the blocks, and allocations never move.
+  class Arena final {
+  public:
+    static constexpr size_t BlockSize = 64 * 1024;
+
+    void* Allocate(size_t size, size_t alignment);
+    void Reset();
+
+  private:
+    std::vector<std::unique_ptr<std::byte[]>> mBlocks;
+    size_t mBlock = 0;
+    size_t mOffset = 0;
+  };
+
+  struct Record {
+    Event event;
+    uint32_t size;
+    void* payload;
+  };
+
+  struct Rule {
+    EventCoalescing coalescing = EventCoalescing::None;
+    EventMergeFn merge = nullptr;
+    // Record that later events of this frame coalesce into; only valid if `pendingFrame` is the current frame.
+    uint32_t pendingRecord = 0;
+    uint64_t pendingFrame = UINT64_MAX;
+  };
+
+  struct BatchListener {
+    Event event;
+    void* context;
+    void (*thunk)(void* context, std::span<const void* const> payloads);
+  };
+
+  // SDL events are queued as whole SDL_Events however they arrive, so every event of a type has the same size and
+  // coalesces with the others.
+  template <Event E>
+  QPL_INLINE static SDL_Event WrapSDLEvent(const EventPayloadType<E>& payload) {
+    static_assert(sizeof(payload) <= sizeof(SDL_Event), "SDL payloads must be members of SDL_Event");
+
+    SDL_Event event{};
+    std::memcpy(&event, &payload, sizeof(payload));
+    event.type = static_cast<Uint32>(E);
+    return event;
+  }
+
+  void Push(Event event, const void* payload, size_t size, size_t alignment);
+  void Post(Event event, const void* payload, size_t size, size_t alignment);
+
+private:
+  Arena mArena;
+  std::vector<Record> mRecords;
+  uint64_t mFrame = 0;
+
+  // Indexed by event value; 0 means no rule. Points into mRules, whose first entry is unused.
+  std::unique_ptr<uint8_t[]> mRuleTable;
+  std::vector<Rule> mRules;
+
+  std::vector<BatchListener> mBatchListeners;
+  std::vector<const void*> mBatchScratch;
+
+  // Events posted from other threads, waiting for the next Flush().
+  std::mutex mInboxMutex;
+  Arena mInboxArena;
+  std::vector<Record> mInbox;
+};
+
+} // namespace qpl
+
+#endif
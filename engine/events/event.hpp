@@ -18,13 +18,82 @@ enum class Event : uint32_t {
 
   SDL_Quit = SDL_EVENT_QUIT,
   SDL_WindowResize = SDL_EVENT_WINDOW_RESIZED,
+  SDL_MouseMotion = SDL_EVENT_MOUSE_MOTION,
 
   SDL_Last = SDL_EVENT_LAST, // Sentinel
 
   // Engine Events
   Engine_First = 0x9000, // Sentinel
+
+  Engine_FixedUpdate,     // One fixed simulation step.
+  Engine_PublishSnapshot, // After the last fixed step of a frame: time to hand the renderer a new snapshot.
+
+  Engine_Last = 0xFFFF, // Sentinel
+};
+
+// Every event value indexes the dispatcher's table directly, so the whole enum has to fit in it.
+QPL_INLINE_CONSTEXPR uint32_t EventCount = static_cast<uint32_t>(Event::Engine_Last) + 1;
+
+static_assert(static_cast<uint32_t>(Event::SDL_Last) < EventCount, "SDL events do not fit the event table");
+
+// Payload of engine events that carry no data.
+struct EmptyEventPayload {};
+
+struct FixedUpdateEvent {
+  // Ticks completed before this one.
+  uint64_t tick;
+  // Length of every step, in seconds.
+  double step;
+  // Simulation time at the start of the step, in seconds.
+  double time;
+};
+
+struct PublishSnapshotEvent {
+  // Ticks completed so far; the snapshot is the state after the last of them.
+  uint64_t tick;
+  double time;
+};
+
+//
+// ---- Event Payloads ---------------------------------
+//
+// The type handed to handlers of each event. SDL events default to the full SDL_Event union, engine events to
+// EmptyEventPayload; specialize EventPayload to give an event a more precise type. An SDL specialization must be
+// the member of SDL_Event that SDL fills in for that event type.
+//
+template <Event E>
+struct EventPayload {
+  using Type = std::conditional_t<(E < Event::Engine_First), SDL_Event, EmptyEventPayload>;
 };
 
+template <>
+struct EventPayload<Event::SDL_Quit> {
+  using Type = SDL_QuitEvent;
+};
+
+template <>
+struct EventPayload<Event::SDL_WindowResize> {
+  using Type = SDL_WindowEvent;
+};
+
+template <>
+struct EventPayload<Event::SDL_MouseMotion> {
+  using Type = SDL_MouseMotionEvent;
+};
+
+template <>
+struct EventPayload<Event::Engine_FixedUpdate> {
+  using Type = FixedUpdateEvent;
+};
+
+template <>
+struct EventPayload<Event::Engine_PublishSnapshot> {
+  using Type = PublishSnapshotEvent;
+};
+
+template <Event E>
+using EventPayloadType = typename EventPayload<E>::Type;
+
 } // namespace qpl
 
 #endif
@@ -0,0 +1,198 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#include "bindless-heap.hpp"
+
+#include <algorithm>
+
+namespace qpl {
+
+static constexpr VkDescriptorType DescriptorTypes[BindlessTypeCount] = {
+  VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+  VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+  VK_DESCRIPTOR_TYPE_SAMPLER,
+};
+
+void BindlessHeap::Init(
+  VkDevice device, VkPhysicalDevice physicalDevice, GpuTimeline& timeline, const BindlessLimits& limits
+) {
+  mDevice = device;
+  mTimeline = &timeline;
+
+  VkPhysicalDeviceVulkan12Properties vulkan12Properties{};
+  vulkan12Properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+
+  VkPhysicalDeviceProperties2 properties{};
+  properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+  properties.pNext = &vulkan12Properties;
+  vkGetPhysicalDeviceProperties2(physicalDevice, &properties);
+
+  // Every array is visible to every stage, so the per-stage limits apply to each of them in full.
+  std::array<uint32_t, BindlessTypeCount> counts = {
+    std::min(
+      {limits.sampledImages,
+       vulkan12Properties.maxDescriptorSetUpdateAfterBindSampledImages,
+       vulkan12Properties.maxPerStageDescriptorUpdateAfterBindSampledImages}
+    ),
+    std::min(
+      {limits.storageBuffers,
+       vulkan12Properties.maxDescriptorSetUpdateAfterBindStorageBuffers,
+       vulkan12Properties.maxPerStageDescriptorUpdateAfterBindStorageBuffers}
+    ),
+    std::min(
+      {limits.samplers,
+       vulkan12Properties.maxDescriptorSetUpdateAfterBindSamplers,
+       vulkan12Properties.maxPerStageDescriptorUpdateAfterBindSamplers}
+    ),
+  };
+
+  LogInfo(
+    "Renderer - Creating BindlessHeap ({} sampled images, {} storage buffers, {} samplers)",
+    counts[0],
+    counts[1],
+    counts[2]
+  );
+
+  std::array<VkDescriptorSetLayoutBinding, BindlessTypeCount> bindings{};
+  std::array<VkDescriptorBindingFlags, BindlessTypeCount> bindingFlags{};
+  std::array<VkDescriptorPoolSize, BindlessTypeCount> poolSizes{};
+
+  for (uint32_t i = 0; i < BindlessTypeCount; i++) {
+    bindings[i].binding = i;
+    bindings[i].descriptorType = DescriptorTypes[i];
+    bindings[i].descriptorCount = counts[i];
+    bindings[i].stageFlags = VK_SHADER_STAGE_ALL;
+
+    bindingFlags[i] = VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT
+      | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+
+    poolSizes[i] = {DescriptorTypes[i], counts[i]};
+    mAllocators[i].Init(counts[i]);
+  }
+
+  VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+  bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+  bindingFlagsInfo.bindingCount = BindlessTypeCount;
+  bindingFlagsInfo.pBindingFlags = bindingFlags.data();
+
+  VkDescriptorSetLayoutCreateInfo layoutInfo{};
+  layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+  layoutInfo.pNext = &bindingFlagsInfo;
+  layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+  layoutInfo.bindingCount = BindlessTypeCount;
+  layoutInfo.pBindings = bindings.data();
+
+  if (vkCreateDescriptorSetLayout(mDevice, &layoutInfo, nullptr, &mSetLayout) != VK_SUCCESS) {
+    QPL_CORE_ASSERT(false && "failed to create bindless descriptor set layout!");
+  }
+
+  VkDescriptorPoolCreateInfo poolInfo{};
+  poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+  poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+  poolInfo.maxSets = 1;
+  poolInfo.poolSizeCount = BindlessTypeCount;
+  poolInfo.pPoolSizes = poolSizes.data();
+
+  if (vkCreateDescriptorPool(mDevice, &poolInfo, nullptr, &mPool) != VK_SUCCESS) {
+    QPL_CORE_ASSERT(false && "failed to create bindless descriptor pool!");
+  }
+
+  VkDescriptorSetAllocateInfo allocInfo{};
+  allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  allocInfo.descriptorPool = mPool;
+  allocInfo.descriptorSetCount = 1;
+  allocInfo.pSetLayouts = &mSetLayout;
+
+  if (vkAllocateDescriptorSets(mDevice, &allocInfo, &mSet) != VK_SUCCESS) {
+    QPL_CORE_ASSERT(false && "failed to allocate bindless descriptor set!");
+  }
+}
+
+void BindlessHeap::Destroy() {
+  if (mDevice == VK_NULL_HANDLE) {
+    return;
+  }
+
+  // Frees the set along with the pool.
+  vkDestroyDescriptorPool(mDevice, mPool, nullptr);
+  vkDestroyDescriptorSetLayout(mDevice, mSetLayout, nullptr);
+
+  mRetired.clear();
+  mDevice = VK_NULL_HANDLE;
+}
+
+BindlessIndex BindlessHeap::AddSampledImage(VkImageView view, VkImageLayout layout) {
+  BindlessIndex index = Allocate(BindlessType::SampledImage);
+
+  VkDescriptorImageInfo imageInfo{VK_NULL_HANDLE, view, layout};
+  Write(BindlessType::SampledImage, index, &imageInfo, nullptr);
+  return index;
+}
+
+BindlessIndex BindlessHeap::AddStorageBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range) {
+  BindlessIndex index = Allocate(BindlessType::StorageBuffer);
+
+  VkDescriptorBufferInfo bufferInfo{buffer, offset, range};
+  Write(BindlessType::StorageBuffer, index, nullptr, &bufferInfo);
+  return index;
+}
+
+BindlessIndex BindlessHeap::AddSampler(VkSampler sampler) {
+  BindlessIndex index = Allocate(BindlessType::Sampler);
+
+  VkDescriptorImageInfo imageInfo{sampler, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_UNDEFINED};
+  Write(BindlessType::Sampler, index, &imageInfo, nullptr);
+  return index;
+}
+
+void BindlessHeap::UpdateSampledImage(BindlessIndex index, VkImageView view, VkImageLayout layout) {
+  VkDescriptorImageInfo imageInfo{VK_NULL_HANDLE, view, layout};
+  Write(BindlessType::SampledImage, index, &imageInfo, nullptr);
+}
+
+void BindlessHeap::Free(BindlessType type, BindlessIndex index) {
+  QPL_CORE_ASSERT(index < GetCapacity(type) && "invalid bindless index");
+
+  // The frame being recorded may still reference the slot, and it signals the value after the last submitted one.
+  mRetired.push_back({type, index, mTimeline->GetLastSubmitted() + 1});
+}
+
+void BindlessHeap::ReleaseRetired() {
+  while (!mRetired.empty()) {
+    const RetiredIndex& retired = mRetired.front();
+
+    // Retired in order, so the first one still in use means every later one is too.
+    if (!mTimeline->IsComplete(retired.lastUsedValue)) {
+      break;
+    }
+
+    mAllocators[static_cast<uint32_t>(retired.type)].Free(retired.index);
+    mRetired.pop_front();
+  }
+}
+
+BindlessIndex BindlessHeap::Allocate(BindlessType type) {
+  BindlessIndex index = mAllocators[static_cast<uint32_t>(type)].Allocate();
+
+  QPL_CORE_ASSERT(index != InvalidBindlessIndex && "bindless heap is full!");
+  return index;
+}
+
+void BindlessHeap::Write(
+  BindlessType type, BindlessIndex index, const VkDescriptorImageInfo* image, const VkDescriptorBufferInfo* buffer
+) {
+  VkWriteDescriptorSet write{};
+  write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+  write.dstSet = mSet;
+  write.dstBinding = static_cast<uint32_t>(type);
+  write.dstArrayElement = index;
+  write.descriptorCount = 1;
+  write.descriptorType = DescriptorTypes[static_cast<uint32_t>(type)];
+  write.pImageInfo = image;
+  write.pBufferInfo = buffer;
+
+  vkUpdateDescriptorSets(mDevice, 1, &write, 0, nullptr);
+}
+
+} // namespace qpl
@@ -0,0 +1,165 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#ifndef QPL_BINDLESS_HEAP_HPP
+#define QPL_BINDLESS_HEAP_HPP
+
+#include <array>
+#include <deque>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+#include <core/core.hpp>
+#include "gpu-timeline.hpp"
+
+namespace qpl {
+
+// Slot of a descriptor inside its BindlessHeap array. Shaders receive it as a plain uint and index the array with it.
+using BindlessIndex = uint32_t;
+
+QPL_INLINE_CONSTEXPR BindlessIndex InvalidBindlessIndex = UINT32_MAX;
+
+// Descriptor arrays of the heap. The value is the array's binding in bindless.glsl.
+enum class BindlessType : uint32_t {
+  SampledImage,
+  StorageBuffer,
+  Sampler,
+};
+
+QPL_INLINE_CONSTEXPR uint32_t BindlessTypeCount = 3;
+
+// Requested array sizes; clamped to what the device supports for update-after-bind descriptors.
+struct BindlessLimits {
+  uint32_t sampledImages = 16 * 1024;
+  uint32_t storageBuffers = 16 * 1024;
+  uint32_t samplers = 256;
+};
+
+//
+// ---- Bindless Index Allocator ---------------------------------
+//
+// Hands out the slots of one descriptor array. Freed slots are reused last-in first-out, so a heap that churns keeps
+// touching the same few descriptors.
+//
+class BindlessIndexAllocator final {
+public:
+  QPL_INLINE void Init(uint32_t capacity) {
+    mCapacity = capacity;
+    mNext = 0;
+    mFree.clear();
+  }
+
+  // InvalidBindlessIndex once every slot is taken.
+  QPL_INLINE BindlessIndex Allocate() {
+    if (!mFree.empty()) {
+      BindlessIndex index = mFree.back();
+      mFree.pop_back();
+      return index;
+    }
+
+    return mNext < mCapacity ? mNext++ : InvalidBindlessIndex;
+  }
+
+  QPL_INLINE void Free(BindlessIndex index) {
+    QPL_CORE_ASSERT(index < mNext && "bindless index was never allocated");
+    mFree.push_back(index);
+  }
+
+  QPL_INLINE uint32_t GetCapacity() const {
+    return mCapacity;
+  }
+
+  QPL_INLINE uint32_t GetUsedCount() const {
+    return mNext - static_cast<uint32_t>(mFree.size());
+  }
+
+private:
+  uint32_t mCapacity = 0;
+  uint32_t mNext = 0;
+  std::vector<BindlessIndex> mFree;
+};
+
+//
+// ---- Bindless Heap ---------------------------------
+//
+// One descriptor set, bound once per command buffer, holding every sampled image, storage buffer and sampler the
+// renderer uses in large arrays. Registering a resource writes its descriptor into a free slot and returns the slot's
+// index; shaders pick resources by those indices, so nothing is allocated, written or bound per draw.
+//
+// The arrays are update-after-bind and partially bound: slots can be written while the set is bound in command
+// buffers that are still executing, as long as those command buffers do not use the slot. A freed slot is therefore
+// only reused once every graphics submission that could still reference it has finished.
+//
+// Not thread safe; meant for the render thread, between frames.
+//
+class BindlessHeap final {
+public:
+  void Init(VkDevice device, VkPhysicalDevice physicalDevice, GpuTimeline& timeline, const BindlessLimits& limits);
+  void Destroy();
+
+  QPL_INLINE VkDescriptorSetLayout GetSetLayout() const {
+    return mSetLayout;
+  }
+
+  QPL_INLINE VkDescriptorSet GetSet() const {
+    return mSet;
+  }
+
+  QPL_INLINE uint32_t GetCapacity(BindlessType type) const {
+    return mAllocators[static_cast<uint32_t>(type)].GetCapacity();
+  }
+
+  QPL_INLINE uint32_t GetUsedCount(BindlessType type) const {
+    return mAllocators[static_cast<uint32_t>(type)].GetUsedCount();
+  }
+
+  BindlessIndex AddSampledImage(VkImageView view, VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+  BindlessIndex AddStorageBuffer(VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+  BindlessIndex AddSampler(VkSampler sampler);
+
+  // Points an existing slot at another view, e.g. once more mips of a texture are resident. Work already submitted
+  // must not use the slot anymore, just as with freeing it.
+  void UpdateSampledImage(
+    BindlessIndex index, VkImageView view, VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+  );
+
+  // Returns the slot to the heap once the GPU is done with it. The resource itself may be destroyed as soon as no
+  // submitted work uses it; partially bound slots are allowed to hold stale descriptors.
+  void Free(BindlessType type, BindlessIndex index);
+
+  // Recycles the slots whose last possible use has finished. Called once per frame.
+  void ReleaseRetired();
+
+  // Binds the heap as set 0 of `layout`, which must have been created with GetSetLayout() there.
+  QPL_INLINE void Bind(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint, VkPipelineLayout layout) const {
+    vkCmdBindDescriptorSets(commandBuffer, bindPoint, layout, 0, 1, &mSet, 0, nullptr);
+  }
+
+private:
+  struct RetiredIndex {
+    BindlessType type;
+    BindlessIndex index;
+    uint64_t lastUsedValue;
+  };
+
+  BindlessIndex Allocate(BindlessType type);
+  void Write(
+    BindlessType type, BindlessIndex index, const VkDescriptorImageInfo* image, const VkDescriptorBufferInfo* buffer
+  );
+
+private:
+  VkDevice mDevice = VK_NULL_HANDLE;
+  GpuTimeline* mTimeline = nullptr;
+
+  VkDescriptorSetLayout mSetLayout = VK_NULL_HANDLE;
+  VkDescriptorPool mPool = VK_NULL_HANDLE;
+  VkDescriptorSet mSet = VK_NULL_HANDLE;
+
+  std::array<BindlessIndexAllocator, BindlessTypeCount> mAllocators;
+  std::deque<RetiredIndex> mRetired;
+};
+
+} // namespace qpl
+
+#endif
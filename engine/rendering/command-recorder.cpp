@@ -0,0 +1,131 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#include "command-recorder.hpp"
+
+#include <magic_enum/magic_enum.hpp>
+
+namespace qpl {
+
+void CommandRecorder::Init(VkDevice device, uint32_t queueFamily, uint32_t frameCount, JobSystem& jobSystem) {
+  LogInfo(
+    "Renderer - Creating CommandRecorder ({} frames, {} recording threads)", frameCount, jobSystem.GetWorkerCount()
+  );
+
+  mDevice = device;
+  mJobSystem = &jobSystem;
+
+  VkCommandPoolCreateInfo poolInfo{};
+  poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+  // Buffers live for a single frame and are only ever reset together with their pool.
+  poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+  poolInfo.queueFamilyIndex = queueFamily;
+
+  mPools.resize(frameCount);
+
+  for (std::vector<WorkerPool>& framePools : mPools) {
+    // One pool per worker, and one for the thread calling Record().
+    framePools.resize(jobSystem.GetWorkerCount() + 1);
+
+    for (WorkerPool& workerPool : framePools) {
+      if (VkResult code = vkCreateCommandPool(mDevice, &poolInfo, nullptr, &workerPool.commandPool);
+          code != VK_SUCCESS) {
+        LogError("vkCreateCommandPool failed with code {}", magic_enum::enum_name(code));
+        QPL_CORE_ASSERT(false && "failed to create worker command pool!");
+      }
+    }
+  }
+}
+
+void CommandRecorder::Destroy() {
+  // Destroying a pool frees every buffer allocated from it.
+  for (std::vector<WorkerPool>& framePools : mPools) {
+    for (WorkerPool& workerPool : framePools) {
+      vkDestroyCommandPool(mDevice, workerPool.commandPool, nullptr);
+    }
+  }
+
+  mPools.clear();
+  mOrdered.clear();
+}
+
+void CommandRecorder::BeginFrame(uint32_t frameIndex) {
+  for (WorkerPool& workerPool : mPools[frameIndex]) {
+    if (workerPool.usedCount == 0) {
+      continue;
+    }
+
+    // One call per pool instead of one per buffer; the pool keeps its memory for the next frame.
+    vkResetCommandPool(mDevice, workerPool.commandPool, 0);
+    workerPool.usedCount = 0;
+  }
+}
+
+VkCommandBuffer CommandRecorder::AcquireSecondary(WorkerPool& workerPool) {
+  if (workerPool.usedCount == workerPool.commandBuffers.size()) {
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = workerPool.commandPool;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+    allocInfo.commandBufferCount = 1;
+
+    VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+    if (vkAllocateCommandBuffers(mDevice, &allocInfo, &commandBuffer) != VK_SUCCESS) {
+      QPL_CORE_ASSERT(false && "failed to allocate secondary command buffer!");
+    }
+
+    workerPool.commandBuffers.push_back(commandBuffer);
+  }
+
+  return workerPool.commandBuffers[workerPool.usedCount++];
+}
+
+void CommandRecorder::Record(
+  uint32_t frameIndex,
+  VkCommandBuffer primary,
+  const VkCommandBufferInheritanceInfo& inheritance,
+  uint32_t taskCount,
+  const RecordFn& record
+) {
+  if (taskCount == 0) {
+    return;
+  }
+
+  std::vector<WorkerPool>& framePools = mPools[frameIndex];
+  mOrdered.assign(taskCount, VK_NULL_HANDLE);
+  mRecording.store(true, std::memory_order_release);
+
+  mJobSystem->ParallelFor(taskCount, 1, [&](uint32_t task) {
+    // ParallelFor() runs a single job inline on the caller, which is not a worker when it is the render thread.
+    uint32_t worker = mJobSystem->GetWorkerIndex();
+    WorkerPool& workerPool = framePools[worker != JobSystem::ExternalThread ? worker : framePools.size() - 1];
+
+    VkCommandBuffer commandBuffer = AcquireSecondary(workerPool);
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags =
+      VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    beginInfo.pInheritanceInfo = &inheritance;
+
+    if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+      QPL_CORE_ASSERT(false && "failed to begin recording secondary command buffer!");
+    }
+
+    record(commandBuffer, task);
+
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+      QPL_CORE_ASSERT(false && "failed to record secondary command buffer!");
+    }
+
+    // Each task writes only its own slot.
+    mOrdered[task] = commandBuffer;
+  });
+
+  // ParallelFor() returns once every task is done, so nothing records past this point.
+  mRecording.store(false, std::memory_order_release);
+  vkCmdExecuteCommands(primary, taskCount, mOrdered.data());
+}
+
+} // namespace qpl
@@ -0,0 +1,81 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#ifndef QPL_COMMAND_RECORDER_HPP
+#define QPL_COMMAND_RECORDER_HPP
+
+#include <atomic>
+#include <vector>
+#include <functional>
+
+#include <vulkan/vulkan.h>
+#include <core/core.hpp>
+
+namespace qpl {
+
+//
+// ---- Command Recorder ---------------------------------
+//
+// Records a frame's draw work into secondary command buffers on every worker of a JobSystem at once.
+//
+// Command pools are externally synchronized, so each (frame slot, worker) pair owns a pool of its own and no two
+// threads ever allocate from or record into the same one. Every slot has one more pool for the thread calling Record(),
+// which need not be a worker (the render thread is not) and records tasks itself whenever ParallelFor() runs them
+// inline. A slot's pools are reset wholesale in BeginFrame() instead of resetting buffers one by one, and the
+// secondaries they hold are reused from frame to frame.
+//
+// Workers pick tasks up in whatever order they get to them, but the recorded secondaries are always executed in
+// task order, so the submitted command stream does not depend on thread scheduling.
+//
+class CommandRecorder final {
+public:
+  // Records task `task` into `commandBuffer`, which is already begun inside the inherited rendering scope.
+  using RecordFn = std::function<void(VkCommandBuffer commandBuffer, uint32_t task)>;
+
+  void Init(VkDevice device, uint32_t queueFamily, uint32_t frameCount, JobSystem& jobSystem);
+  void Destroy();
+
+  // Recycles every command buffer recorded for `frameIndex`. The GPU must be done with that slot's last submission.
+  void BeginFrame(uint32_t frameIndex);
+
+  // Records `taskCount` secondaries in parallel and executes them into `primary`, which must be inside a rendering
+  // scope that allows secondary command buffers and matches `inheritance`. Called from one thread at a time.
+  void Record(
+    uint32_t frameIndex,
+    VkCommandBuffer primary,
+    const VkCommandBufferInheritanceInfo& inheritance,
+    uint32_t taskCount,
+    const RecordFn& record
+  );
+
+  // Whether a Record() call is running, i.e. draw tasks may be recording on some thread.
+  QPL_INLINE bool IsRecording() const {
+    return mRecording.load(std::memory_order_acquire);
+  }
+
+private:
+  struct WorkerPool {
+    VkCommandPool commandPool = VK_NULL_HANDLE;
+    std::vector<VkCommandBuffer> commandBuffers;
+    // Buffers handed out since the last reset; the rest are free for reuse.
+    uint32_t usedCount = 0;
+  };
+
+  VkCommandBuffer AcquireSecondary(WorkerPool& workerPool);
+
+private:
+  VkDevice mDevice = VK_NULL_HANDLE;
+  JobSystem* mJobSystem = nullptr;
+
+  // Indexed by [frame slot][worker], with the calling thread's pool last.
+  std::vector<std::vector<WorkerPool>> mPools;
+
+  // Secondaries of the current Record() call, in task order.
+  std::vector<VkCommandBuffer> mOrdered;
+  std::atomic<bool> mRecording = false;
+};
+
+} // namespace qpl
+
+#endif
@@ -0,0 +1,74 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#include "frame-pacer.hpp"
+
+#include <thread>
+#include <algorithm>
+
+namespace qpl {
+
+// Bounds of the spin margin before a deadline. The floor covers the time a wakeup takes even when the sleep itself
+// is accurate; the ceiling keeps a single bad oversleep from turning the wait into a busy loop.
+static constexpr int64_t MinSpinNs = 200'000;
+static constexpr int64_t MaxSpinNs = 4'000'000;
+
+void FramePacer::Init(double targetFps) {
+  mInterval = targetFps > 0.0 ? (int64_t)(1e9 / targetFps) : 0;
+  mNextDeadline = 0;
+  mOversleep = 0.0;
+
+  mLatencyMs.Clear();
+}
+
+void FramePacer::WaitForNextFrame() {
+  if (mInterval == 0) {
+    return;
+  }
+
+  QPL_PROFILE_ZONE("FramePacer::WaitForNextFrame");
+
+  int64_t now = CpuProfiler::Now();
+
+  if (mNextDeadline == 0 || now - mNextDeadline > mInterval) {
+    mNextDeadline = now + mInterval;
+    return;
+  }
+
+  int64_t spinMargin = std::clamp((int64_t)(2.0 * mOversleep), MinSpinNs, MaxSpinNs);
+  int64_t sleepNs = mNextDeadline - spinMargin - now;
+
+  if (sleepNs > 0) {
+    std::this_thread::sleep_for(std::chrono::nanoseconds(sleepNs));
+
+    int64_t oversleep = std::max<int64_t>(CpuProfiler::Now() - now - sleepNs, 0);
+    mOversleep += ((double)oversleep - mOversleep) * 0.1;
+  }
+
+  while (CpuProfiler::Now() < mNextDeadline) {
+    std::this_thread::yield();
+  }
+
+  mNextDeadline += mInterval;
+}
+
+void FramePacer::RecordLatency(int64_t latencyNs) {
+  mLatencyMs.Push((double)latencyNs / 1e6);
+}
+
+FrameLatencyStats FramePacer::GetLatencyStats() const {
+  PercentileStats latency = mLatencyMs.Summarize();
+
+  FrameLatencyStats stats;
+  stats.sampleCount = latency.sampleCount;
+  stats.averageMs = latency.average;
+  stats.p50Ms = latency.p50;
+  stats.p95Ms = latency.p95;
+  stats.p99Ms = latency.p99;
+  stats.maxMs = latency.max;
+
+  return stats;
+}
+
+} // namespace qpl
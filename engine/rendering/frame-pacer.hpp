@@ -0,0 +1,77 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#ifndef QPL_FRAME_PACER_HPP
+#define QPL_FRAME_PACER_HPP
+
+#include <cstdint>
+
+#include <core/core.hpp>
+
+namespace qpl {
+
+enum class FramePacing : uint8_t {
+  // Frames start as soon as the previous one is submitted; only the present mode holds them back.
+  Uncapped,
+  // Frames start at a fixed rate, see RendererConfig::targetFps.
+  TargetFps,
+  // Each frame waits until the previous one has been presented before it samples input, so input never sits behind
+  // queued frames. Also honors a target frame rate if one is set.
+  LowLatency,
+};
+
+// Input-to-present latency over the last LatencyHistory frames.
+struct FrameLatencyStats {
+  uint32_t sampleCount = 0;
+
+  double averageMs = 0.0;
+  double p50Ms = 0.0;
+  double p95Ms = 0.0;
+  double p99Ms = 0.0;
+  double maxMs = 0.0;
+};
+
+//
+// ---- Frame Pacer ---------------------------------
+//
+// Holds frames to a target rate and keeps the latency history. Waiting for a frame deadline sleeps for most of the
+// interval and spins for the rest: the OS oversleeps by anywhere from tens of microseconds to a couple of
+// milliseconds, so the spin margin tracks the oversleep seen so far instead of being fixed.
+//
+// Deadlines advance by whole intervals, so the rate holds on average even if single frames start late. A frame
+// that starts more than an interval late restarts the schedule rather than letting the next frames catch up in a
+// burst.
+//
+class FramePacer final {
+public:
+  static constexpr uint32_t LatencyHistory = 1024;
+
+  // `targetFps` of 0 disables the cap.
+  void Init(double targetFps);
+
+  QPL_INLINE bool IsCapped() const {
+    return mInterval > 0;
+  }
+
+  // Blocks until the next frame is due. Returns immediately if uncapped.
+  void WaitForNextFrame();
+
+  // Time between sampling a frame's input and its present, in nanoseconds.
+  void RecordLatency(int64_t latencyNs);
+
+  FrameLatencyStats GetLatencyStats() const;
+
+private:
+  int64_t mInterval = 0;
+  int64_t mNextDeadline = 0;
+
+  // Moving average of how far sleeps overshoot, in nanoseconds.
+  double mOversleep = 0.0;
+
+  PercentileHistory<LatencyHistory> mLatencyMs;
+};
+
+} // namespace qpl
+
+#endif
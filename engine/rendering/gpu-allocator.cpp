@@ -0,0 +1,379 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#include "gpu-allocator.hpp"
+
+#include <bit>
+#include <algorithm>
+#include <magic_enum/magic_enum.hpp>
+
+namespace qpl {
+
+void GpuAllocator::Init(VkPhysicalDevice physicalDevice, VkDevice device, VkDeviceSize preferredBlockSize) {
+  mDevice = device;
+  mPreferredBlockSize = std::bit_floor(std::max(preferredBlockSize, MinAllocationSize));
+
+  VkPhysicalDeviceProperties properties;
+  vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+  vkGetPhysicalDeviceMemoryProperties(physicalDevice, &mMemoryProperties);
+
+  mBufferImageGranularity = properties.limits.bufferImageGranularity;
+  mMaxAllocationCount = properties.limits.maxMemoryAllocationCount;
+  mSeparateResourceKinds = mBufferImageGranularity > MinAllocationSize;
+
+  LogInfo(
+    "Renderer - Creating GpuAllocator (bufferImageGranularity {}, maxMemoryAllocationCount {})",
+    mBufferImageGranularity,
+    mMaxAllocationCount
+  );
+}
+
+void GpuAllocator::Destroy() {
+  std::lock_guard lock(mMutex);
+
+  if (mAllocationCount > 0) {
+    LogWarning("Renderer - GpuAllocator destroyed with {} live allocations", mAllocationCount);
+  }
+
+  for (auto& pools : mPools) {
+    for (Pool& pool : pools) {
+      for (Block& block : pool.blocks) {
+        if (block.memory != VK_NULL_HANDLE) {
+          vkFreeMemory(mDevice, block.memory, nullptr);
+        }
+      }
+
+      pool.blocks.clear();
+    }
+  }
+
+  mDeviceMemoryCount = 0;
+}
+
+GpuAllocation GpuAllocator::Allocate(
+  const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, GpuResourceKind kind
+) {
+  std::optional<uint32_t> memoryType = FindMemoryType(requirements.memoryTypeBits, properties);
+  QPL_CORE_ASSERT(memoryType.has_value() && "no memory type satisfies the requested properties!");
+
+  std::lock_guard lock(mMutex);
+
+  Pool& pool = GetPool(*memoryType, kind);
+
+  // Buddy ranges are aligned to their own size, so rounding up to the alignment covers it as well.
+  VkDeviceSize rangeSize = std::bit_ceil(std::max({requirements.size, requirements.alignment, MinAllocationSize}));
+
+  if (rangeSize > pool.blockSize / 2) {
+    return AllocateDedicated(requirements, *memoryType);
+  }
+
+  uint8_t order = static_cast<uint8_t>(std::countr_zero(rangeSize / MinAllocationSize));
+
+  auto tryAllocate = [&](uint32_t blockIndex) -> std::optional<GpuAllocation> {
+    Block& block = pool.blocks[blockIndex];
+    if (block.memory == VK_NULL_HANDLE) {
+      return std::nullopt;
+    }
+
+    std::optional<VkDeviceSize> offset = AllocateFromBlock(pool, block, order);
+    if (!offset.has_value()) {
+      return std::nullopt;
+    }
+
+    GpuAllocation allocation{};
+    allocation.memory = block.memory;
+    allocation.offset = *offset;
+    allocation.size = requirements.size;
+    allocation.mapped = block.mapped != nullptr ? static_cast<char*>(block.mapped) + *offset : nullptr;
+    allocation.memoryType = *memoryType;
+    allocation.blockIndex = blockIndex;
+    allocation.order = order;
+    allocation.kind = kind;
+
+    mAllocationCount++;
+    mRequestedBytes += requirements.size;
+    return allocation;
+  };
+
+  for (uint32_t i = 0; i < pool.blocks.size(); i++) {
+    if (auto allocation = tryAllocate(i); allocation.has_value()) {
+      return *allocation;
+    }
+  }
+
+  bool created = CreateBlock(pool, *memoryType);
+  QPL_CORE_ASSERT(created && "failed to allocate GPU memory block!");
+
+  // CreateBlock reuses released slots before growing, so search for the fresh one.
+  for (uint32_t i = 0; i < pool.blocks.size(); i++) {
+    if (pool.blocks[i].memory != VK_NULL_HANDLE && pool.blocks[i].usedBytes == 0) {
+      if (auto allocation = tryAllocate(i); allocation.has_value()) {
+        return *allocation;
+      }
+    }
+  }
+
+  QPL_UNREACHABLE();
+}
+
+void GpuAllocator::Free(GpuAllocation& allocation) {
+  if (!allocation.IsValid()) {
+    return;
+  }
+
+  std::lock_guard lock(mMutex);
+
+  mAllocationCount--;
+  mRequestedBytes -= allocation.size;
+
+  if (allocation.dedicated) {
+    vkFreeMemory(mDevice, allocation.memory, nullptr);
+    mDeviceMemoryCount--;
+    mDedicatedCount--;
+    mDedicatedBytes -= allocation.size;
+    allocation = {};
+    return;
+  }
+
+  Pool& pool = GetPool(allocation.memoryType, allocation.kind);
+  Block& block = pool.blocks[allocation.blockIndex];
+
+  FreeToBlock(pool, block, allocation.offset, allocation.order);
+
+  // Give fully empty blocks back to the driver, but keep one around per pool to absorb allocation churn.
+  if (block.usedBytes == 0) {
+    size_t liveBlocks = std::count_if(pool.blocks.begin(), pool.blocks.end(), [](const Block& b) {
+      return b.memory != VK_NULL_HANDLE;
+    });
+
+    if (liveBlocks > 1) {
+      vkFreeMemory(mDevice, block.memory, nullptr);
+      block = {};
+      mDeviceMemoryCount--;
+    }
+  }
+
+  allocation = {};
+}
+
+GpuBuffer GpuAllocator::CreateBuffer(const VkBufferCreateInfo& createInfo, VkMemoryPropertyFlags properties) {
+  GpuBuffer buffer{};
+
+  if (vkCreateBuffer(mDevice, &createInfo, nullptr, &buffer.buffer) != VK_SUCCESS) {
+    QPL_CORE_ASSERT(false && "failed to create buffer!");
+  }
+
+  VkMemoryRequirements requirements;
+  vkGetBufferMemoryRequirements(mDevice, buffer.buffer, &requirements);
+
+  buffer.allocation = Allocate(requirements, properties, GpuResourceKind::Linear);
+
+  if (vkBindBufferMemory(mDevice, buffer.buffer, buffer.allocation.memory, buffer.allocation.offset) != VK_SUCCESS) {
+    QPL_CORE_ASSERT(false && "failed to bind buffer memory!");
+  }
+
+  return buffer;
+}
+
+void GpuAllocator::DestroyBuffer(GpuBuffer& buffer) {
+  vkDestroyBuffer(mDevice, buffer.buffer, nullptr);
+  Free(buffer.allocation);
+  buffer.buffer = VK_NULL_HANDLE;
+}
+
+GpuImage GpuAllocator::CreateImage(const VkImageCreateInfo& createInfo, VkMemoryPropertyFlags properties) {
+  GpuImage image{};
+
+  if (vkCreateImage(mDevice, &createInfo, nullptr, &image.image) != VK_SUCCESS) {
+    QPL_CORE_ASSERT(false && "failed to create image!");
+  }
+
+  VkMemoryRequirements requirements;
+  vkGetImageMemoryRequirements(mDevice, image.image, &requirements);
+
+  GpuResourceKind kind =
+    createInfo.tiling == VK_IMAGE_TILING_OPTIMAL ? GpuResourceKind::Optimal : GpuResourceKind::Linear;
+  image.allocation = Allocate(requirements, properties, kind);
+
+  if (vkBindImageMemory(mDevice, image.image, image.allocation.memory, image.allocation.offset) != VK_SUCCESS) {
+    QPL_CORE_ASSERT(false && "failed to bind image memory!");
+  }
+
+  return image;
+}
+
+void GpuAllocator::DestroyImage(GpuImage& image) {
+  vkDestroyImage(mDevice, image.image, nullptr);
+  Free(image.allocation);
+  image.image = VK_NULL_HANDLE;
+}
+
+std::optional<uint32_t> GpuAllocator::FindMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties) const {
+  for (uint32_t i = 0; i < mMemoryProperties.memoryTypeCount; i++) {
+    if ((typeBits & (1u << i)) && (mMemoryProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+      return i;
+    }
+  }
+
+  return std::nullopt;
+}
+
+GpuAllocatorStats GpuAllocator::GetStats() const {
+  std::lock_guard lock(mMutex);
+
+  GpuAllocatorStats stats{};
+  stats.dedicatedAllocationCount = mDedicatedCount;
+  stats.allocationCount = mAllocationCount;
+  stats.reservedBytes = mDedicatedBytes;
+  stats.usedBytes = mDedicatedBytes;
+  stats.requestedBytes = mRequestedBytes;
+
+  for (const auto& pools : mPools) {
+    for (const Pool& pool : pools) {
+      for (const Block& block : pool.blocks) {
+        if (block.memory == VK_NULL_HANDLE) {
+          continue;
+        }
+
+        stats.blockCount++;
+        stats.reservedBytes += pool.blockSize;
+        stats.usedBytes += block.usedBytes;
+
+        for (int order = pool.maxOrder; order >= 0; order--) {
+          if (!block.freeLists[order].empty()) {
+            stats.largestFreeRange = std::max(stats.largestFreeRange, OrderSize(static_cast<uint8_t>(order)));
+            break;
+          }
+        }
+      }
+    }
+  }
+
+  return stats;
+}
+
+GpuAllocator::Pool& GpuAllocator::GetPool(uint32_t memoryType, GpuResourceKind kind) {
+  Pool& pool = mPools[memoryType][mSeparateResourceKinds ? (size_t)kind : 0];
+
+  if (pool.blockSize == 0) {
+    // Never let a single block claim a large share of a small heap (e.g. a 256 MiB BAR heap).
+    uint32_t heapIndex = mMemoryProperties.memoryTypes[memoryType].heapIndex;
+    VkDeviceSize heapSize = mMemoryProperties.memoryHeaps[heapIndex].size;
+
+    pool.blockSize = std::bit_floor(std::max(std::min(mPreferredBlockSize, heapSize / 8), MinAllocationSize * 2));
+    pool.maxOrder = static_cast<uint8_t>(std::countr_zero(pool.blockSize / MinAllocationSize));
+  }
+
+  return pool;
+}
+
+bool GpuAllocator::CreateBlock(Pool& pool, uint32_t memoryType) {
+  void* mapped = nullptr;
+  VkDeviceMemory memory = AllocateDeviceMemory(pool.blockSize, memoryType, &mapped);
+  if (memory == VK_NULL_HANDLE) {
+    return false;
+  }
+
+  auto slot = std::find_if(pool.blocks.begin(), pool.blocks.end(), [](const Block& b) {
+    return b.memory == VK_NULL_HANDLE;
+  });
+
+  Block& block = slot != pool.blocks.end() ? *slot : pool.blocks.emplace_back();
+  block.memory = memory;
+  block.mapped = mapped;
+  block.usedBytes = 0;
+  block.freeLists.assign(pool.maxOrder + 1, {});
+  block.freeLists[pool.maxOrder].insert(0);
+  return true;
+}
+
+std::optional<VkDeviceSize> GpuAllocator::AllocateFromBlock(Pool& pool, Block& block, uint8_t order) {
+  uint8_t available = order;
+  while (available <= pool.maxOrder && block.freeLists[available].empty()) {
+    available++;
+  }
+
+  if (available > pool.maxOrder) {
+    return std::nullopt;
+  }
+
+  auto& freeList = block.freeLists[available];
+  VkDeviceSize offset = *freeList.begin();
+  freeList.erase(freeList.begin());
+
+  // Split down to the requested order, keeping the upper halves free.
+  while (available > order) {
+    available--;
+    block.freeLists[available].insert(offset + OrderSize(available));
+  }
+
+  block.usedBytes += OrderSize(order);
+  return offset;
+}
+
+void GpuAllocator::FreeToBlock(Pool& pool, Block& block, VkDeviceSize offset, uint8_t order) {
+  block.usedBytes -= OrderSize(order);
+
+  // Coalesce with the buddy for as long as it is free as well.
+  while (order < pool.maxOrder) {
+    VkDeviceSize buddy = offset ^ OrderSize(order);
+    if (block.freeLists[order].erase(buddy) == 0) {
+      break;
+    }
+
+    offset = std::min(offset, buddy);
+    order++;
+  }
+
+  block.freeLists[order].insert(offset);
+}
+
+GpuAllocation GpuAllocator::AllocateDedicated(const VkMemoryRequirements& requirements, uint32_t memoryType) {
+  GpuAllocation allocation{};
+  allocation.memory = AllocateDeviceMemory(requirements.size, memoryType, &allocation.mapped);
+  QPL_CORE_ASSERT(allocation.memory != VK_NULL_HANDLE && "failed to allocate dedicated GPU memory!");
+
+  allocation.offset = 0;
+  allocation.size = requirements.size;
+  allocation.memoryType = memoryType;
+  allocation.dedicated = true;
+
+  mAllocationCount++;
+  mDedicatedCount++;
+  mDedicatedBytes += requirements.size;
+  mRequestedBytes += requirements.size;
+  return allocation;
+}
+
+VkDeviceMemory GpuAllocator::AllocateDeviceMemory(VkDeviceSize size, uint32_t memoryType, void** mapped) {
+  if (mDeviceMemoryCount >= mMaxAllocationCount) {
+    LogError("Renderer - maxMemoryAllocationCount reached");
+    return VK_NULL_HANDLE;
+  }
+
+  VkMemoryAllocateInfo allocInfo{};
+  allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+  allocInfo.allocationSize = size;
+  allocInfo.memoryTypeIndex = memoryType;
+
+  VkDeviceMemory memory = VK_NULL_HANDLE;
+  if (VkResult code = vkAllocateMemory(mDevice, &allocInfo, nullptr, &memory); code != VK_SUCCESS) {
+    LogError("vkAllocateMemory failed with code {}", magic_enum::enum_name(code));
+    return VK_NULL_HANDLE;
+  }
+
+  mDeviceMemoryCount++;
+
+  // Host visible memory stays mapped for its whole lifetime.
+  *mapped = nullptr;
+  if (mMemoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+    if (vkMapMemory(mDevice, memory, 0, VK_WHOLE_SIZE, 0, mapped) != VK_SUCCESS) {
+      QPL_CORE_ASSERT(false && "failed to map GPU memory!");
+    }
+  }
+
+  return memory;
+}
+
+} // namespace qpl
@@ -0,0 +1,176 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#ifndef QPL_GPU_ALLOCATOR_HPP
+#define QPL_GPU_ALLOCATOR_HPP
+
+#include <array>
+#include <mutex>
+#include <vector>
+#include <optional>
+#include <unordered_set>
+
+#include <vulkan/vulkan.h>
+#include <core/core.hpp>
+
+namespace qpl {
+
+// What kind of resource an allocation backs. Linear resources (buffers, linear images) and optimal-tiling images
+// must not share a bufferImageGranularity page, so on devices with a coarse granularity they live in separate pools.
+enum class GpuResourceKind : uint8_t {
+  Linear,
+  Optimal,
+};
+
+//
+// ---- Gpu Allocation ---------------------------------
+//
+// A sub-range of a VkDeviceMemory block. Plain data; ownership is tracked by the allocator.
+//
+struct GpuAllocation {
+  VkDeviceMemory memory = VK_NULL_HANDLE;
+  VkDeviceSize offset = 0;
+  VkDeviceSize size = 0;
+
+  // Host pointer to the start of the allocation if the memory type is host visible, nullptr otherwise.
+  void* mapped = nullptr;
+
+  uint32_t memoryType = 0;
+  uint32_t blockIndex = 0;
+  uint8_t order = 0;
+  GpuResourceKind kind = GpuResourceKind::Linear;
+  bool dedicated = false;
+
+  QPL_INLINE bool IsValid() const {
+    return memory != VK_NULL_HANDLE;
+  }
+};
+
+struct GpuBuffer {
+  VkBuffer buffer = VK_NULL_HANDLE;
+  GpuAllocation allocation;
+};
+
+struct GpuImage {
+  VkImage image = VK_NULL_HANDLE;
+  GpuAllocation allocation;
+};
+
+//
+// ---- Gpu Allocator Stats ---------------------------------
+//
+struct GpuAllocatorStats {
+  uint32_t blockCount = 0;
+  uint32_t dedicatedAllocationCount = 0;
+  uint32_t allocationCount = 0;
+
+  // Bytes of VkDeviceMemory owned by the allocator, including dedicated allocations.
+  VkDeviceSize reservedBytes = 0;
+  // Bytes handed out, rounded up to buddy block sizes.
+  VkDeviceSize usedBytes = 0;
+  // Bytes actually asked for by callers.
+  VkDeviceSize requestedBytes = 0;
+  // Largest single range that could still be handed out without allocating a new block.
+  VkDeviceSize largestFreeRange = 0;
+
+  // Share of used bytes lost to power-of-two rounding.
+  QPL_INLINE double InternalFragmentation() const {
+    return usedBytes > 0 ? 1.0 - (double)requestedBytes / (double)usedBytes : 0.0;
+  }
+
+  // Share of free bytes that are not part of the largest free range.
+  QPL_INLINE double ExternalFragmentation() const {
+    VkDeviceSize freeBytes = reservedBytes - usedBytes;
+    return freeBytes > 0 ? 1.0 - (double)largestFreeRange / (double)freeBytes : 0.0;
+  }
+};
+
+//
+// ---- Gpu Allocator ---------------------------------
+//
+// Sub-allocates buffers and images out of large VkDeviceMemory blocks, one set of blocks per memory type (and per
+// resource kind where bufferImageGranularity requires it). Ranges are handed out by a buddy allocator: every block is
+// a power of two and every range is naturally aligned to its own size, which satisfies any alignment up to that
+// size. Requests larger than half a block get their own dedicated VkDeviceMemory.
+//
+// Thread safe.
+//
+class GpuAllocator final {
+public:
+  // Smallest range the buddy allocator hands out.
+  static constexpr VkDeviceSize MinAllocationSize = 256;
+  static constexpr VkDeviceSize DefaultBlockSize = 64ull * 1024 * 1024;
+
+  void Init(VkPhysicalDevice physicalDevice, VkDevice device, VkDeviceSize preferredBlockSize = DefaultBlockSize);
+  void Destroy();
+
+  GpuAllocation Allocate(
+    const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, GpuResourceKind kind
+  );
+  void Free(GpuAllocation& allocation);
+
+  GpuBuffer CreateBuffer(const VkBufferCreateInfo& createInfo, VkMemoryPropertyFlags properties);
+  void DestroyBuffer(GpuBuffer& buffer);
+
+  GpuImage CreateImage(const VkImageCreateInfo& createInfo, VkMemoryPropertyFlags properties);
+  void DestroyImage(GpuImage& image);
+
+  std::optional<uint32_t> FindMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties) const;
+
+  GpuAllocatorStats GetStats() const;
+
+  QPL_INLINE const VkPhysicalDeviceMemoryProperties& GetMemoryProperties() const {
+    return mMemoryProperties;
+  }
+
+private:
+  struct Block {
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    void* mapped = nullptr;
+    VkDeviceSize usedBytes = 0;
+    // Free ranges, indexed by order. Offsets are relative to the start of the block.
+    std::vector<std::unordered_set<VkDeviceSize>> freeLists;
+  };
+
+  struct Pool {
+    std::vector<Block> blocks;
+    VkDeviceSize blockSize = 0;
+    uint8_t maxOrder = 0;
+  };
+
+  Pool& GetPool(uint32_t memoryType, GpuResourceKind kind);
+  bool CreateBlock(Pool& pool, uint32_t memoryType);
+  std::optional<VkDeviceSize> AllocateFromBlock(Pool& pool, Block& block, uint8_t order);
+  void FreeToBlock(Pool& pool, Block& block, VkDeviceSize offset, uint8_t order);
+
+  GpuAllocation AllocateDedicated(const VkMemoryRequirements& requirements, uint32_t memoryType);
+  VkDeviceMemory AllocateDeviceMemory(VkDeviceSize size, uint32_t memoryType, void** mapped);
+
+  QPL_INLINE static VkDeviceSize OrderSize(uint8_t order) {
+    return MinAllocationSize << order;
+  }
+
+private:
+  VkDevice mDevice = VK_NULL_HANDLE;
+  VkPhysicalDeviceMemoryProperties mMemoryProperties{};
+  VkDeviceSize mBufferImageGranularity = 1;
+  VkDeviceSize mPreferredBlockSize = DefaultBlockSize;
+  uint32_t mMaxAllocationCount = 0;
+
+  // When the granularity is no coarser than the smallest range, naturally aligned ranges never share a page and both
+  // resource kinds can live in the same pool.
+  bool mSeparateResourceKinds = false;
+
+  mutable std::mutex mMutex;
+  std::array<std::array<Pool, 2>, VK_MAX_MEMORY_TYPES> mPools;
+  uint32_t mDeviceMemoryCount = 0;
+  uint32_t mDedicatedCount = 0;
+  uint32_t mAllocationCount = 0;
+  VkDeviceSize mDedicatedBytes = 0;
+  VkDeviceSize mRequestedBytes = 0;
+};
+
+} // namespace qpl
+
+#endif
@@ -0,0 +1,346 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#include "gpu-profiler.hpp"
+
+#include <fstream>
+#include <algorithm>
+
+#include <magic_enum/magic_enum.hpp>
+
+namespace qpl {
+
+static constexpr VkQueryPipelineStatisticFlags StatisticFlags =
+  VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT | VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT
+  | VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT | VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT
+  | VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+
+// One value per statistic bit above, plus the availability word.
+static constexpr uint32_t StatisticValueCount = 5;
+static constexpr uint32_t StatisticStride = StatisticValueCount + 1;
+
+// A begin and an end timestamp, each followed by its availability word.
+static constexpr uint32_t TimestampStride = 2;
+
+void GpuProfiler::Init(
+  VkDevice device,
+  VkPhysicalDevice physicalDevice,
+  uint32_t queueFamily,
+  uint32_t frameCount,
+  uint32_t maxScopes,
+  bool enableStatistics
+) {
+  mDevice = device;
+  mMaxScopes = maxScopes;
+
+  VkPhysicalDeviceProperties properties;
+  vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+  uint32_t queueFamilyCount = 0;
+  vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+
+  std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+  vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+  uint32_t validBits = queueFamilies[queueFamily].timestampValidBits;
+
+  if (validBits == 0 || maxScopes == 0) {
+    LogWarning("Renderer - GPU profiler disabled: the graphics queue does not support timestamps");
+    return;
+  }
+
+  mEnabled = true;
+  mStatisticsEnabled = enableStatistics;
+  mTimestampPeriodNs = properties.limits.timestampPeriod;
+  mTimestampMask = validBits >= 64 ? UINT64_MAX : (1ull << validBits) - 1;
+
+  LogInfo(
+    "Renderer - Creating GpuProfiler ({} scopes per frame, {:.2f} ns per tick, statistics {})",
+    maxScopes,
+    mTimestampPeriodNs,
+    mStatisticsEnabled ? "on" : "off"
+  );
+
+  VkQueryPoolCreateInfo timestampInfo{};
+  timestampInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+  timestampInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+  timestampInfo.queryCount = maxScopes * 2;
+
+  VkQueryPoolCreateInfo statisticsInfo{};
+  statisticsInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+  statisticsInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+  statisticsInfo.queryCount = maxScopes;
+  statisticsInfo.pipelineStatistics = StatisticFlags;
+
+  for (uint32_t i = 0; i < frameCount; i++) {
+    auto& frame = mFrames.emplace_back(std::make_unique<FrameQueries>());
+    frame->scopes.resize(maxScopes);
+
+    if (VkResult code = vkCreateQueryPool(mDevice, &timestampInfo, nullptr, &frame->timestampPool);
+        code != VK_SUCCESS) {
+      LogError("vkCreateQueryPool failed with code {}", magic_enum::enum_name(code));
+      QPL_CORE_ASSERT(false && "failed to create timestamp query pool!");
+    }
+
+    if (!mStatisticsEnabled) {
+      continue;
+    }
+
+    if (VkResult code = vkCreateQueryPool(mDevice, &statisticsInfo, nullptr, &frame->statisticsPool);
+        code != VK_SUCCESS) {
+      LogError("vkCreateQueryPool failed with code {}", magic_enum::enum_name(code));
+      QPL_CORE_ASSERT(false && "failed to create pipeline statistics query pool!");
+    }
+  }
+
+  mTimestampResults.resize((size_t)maxScopes * 2 * TimestampStride);
+  mStatisticsResults.resize((size_t)maxScopes * StatisticStride);
+}
+
+void GpuProfiler::Destroy() {
+  for (auto& frame : mFrames) {
+    vkDestroyQueryPool(mDevice, frame->timestampPool, nullptr);
+    vkDestroyQueryPool(mDevice, frame->statisticsPool, nullptr);
+  }
+
+  mFrames.clear();
+  mEnabled = false;
+}
+
+void GpuProfiler::BeginFrame(uint32_t frameIndex, VkCommandBuffer commandBuffer) {
+  if (!mEnabled) {
+    return;
+  }
+
+  mCurrentFrame = frameIndex;
+  FrameQueries& frame = *mFrames[frameIndex];
+
+  Collect(frame);
+
+  // Queries have to be reset before they are written again; doing it on the GPU keeps it in submission order.
+  vkCmdResetQueryPool(commandBuffer, frame.timestampPool, 0, mMaxScopes * 2);
+
+  if (mStatisticsEnabled) {
+    vkCmdResetQueryPool(commandBuffer, frame.statisticsPool, 0, mMaxScopes);
+  }
+
+  frame.scopeCount.store(0, std::memory_order_relaxed);
+  frame.statisticsCount.store(0, std::memory_order_relaxed);
+}
+
+GpuScope GpuProfiler::BeginScope(VkCommandBuffer commandBuffer, std::string_view name, bool statistics) {
+  if (!mEnabled) {
+    return InvalidGpuScope;
+  }
+
+  FrameQueries& frame = *mFrames[mCurrentFrame];
+
+  GpuScope scope = frame.scopeCount.fetch_add(1, std::memory_order_relaxed);
+  if (scope >= mMaxScopes) {
+    return InvalidGpuScope;
+  }
+
+  // Each scope index is handed out once per frame, so its record is only ever touched by one thread.
+  ScopeRecord& record = frame.scopes[scope];
+  record.name.assign(name);
+  record.statisticsQuery = UINT32_MAX;
+
+  vkCmdWriteTimestamp2(commandBuffer, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, frame.timestampPool, scope * 2);
+
+  if (statistics && mStatisticsEnabled) {
+    uint32_t query = frame.statisticsCount.fetch_add(1, std::memory_order_relaxed);
+
+    // Never more statistics queries than scopes, so this always fits.
+    record.statisticsQuery = query;
+    vkCmdBeginQuery(commandBuffer, frame.statisticsPool, query, 0);
+  }
+
+  return scope;
+}
+
+void GpuProfiler::EndScope(VkCommandBuffer commandBuffer, GpuScope scope) {
+  if (scope == InvalidGpuScope) {
+    return;
+  }
+
+  FrameQueries& frame = *mFrames[mCurrentFrame];
+  const ScopeRecord& record = frame.scopes[scope];
+
+  if (record.statisticsQuery != UINT32_MAX) {
+    vkCmdEndQuery(commandBuffer, frame.statisticsPool, record.statisticsQuery);
+  }
+
+  vkCmdWriteTimestamp2(commandBuffer, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, frame.timestampPool, scope * 2 + 1);
+}
+
+void GpuProfiler::Collect(FrameQueries& frame) {
+  uint32_t scopeCount = std::min(frame.scopeCount.load(std::memory_order_relaxed), mMaxScopes);
+  uint32_t statisticsCount = std::min(frame.statisticsCount.load(std::memory_order_relaxed), mMaxScopes);
+
+  if (scopeCount == 0) {
+    return;
+  }
+
+  // No WAIT bit: the slot has already completed, and if some query somehow has not, it is skipped rather than
+  // waited on. VK_NOT_READY only means at least one query was unavailable.
+  constexpr VkQueryResultFlags resultFlags = VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT;
+
+  vkGetQueryPoolResults(
+    mDevice,
+    frame.timestampPool,
+    0,
+    scopeCount * 2,
+    scopeCount * 2 * TimestampStride * sizeof(uint64_t),
+    mTimestampResults.data(),
+    TimestampStride * sizeof(uint64_t),
+    resultFlags
+  );
+
+  if (statisticsCount > 0) {
+    vkGetQueryPoolResults(
+      mDevice,
+      frame.statisticsPool,
+      0,
+      statisticsCount,
+      statisticsCount * StatisticStride * sizeof(uint64_t),
+      mStatisticsResults.data(),
+      StatisticStride * sizeof(uint64_t),
+      resultFlags
+    );
+  }
+
+  std::lock_guard lock(mHistoryMutex);
+
+  for (uint32_t scope = 0; scope < scopeCount; scope++) {
+    const ScopeRecord& record = frame.scopes[scope];
+    const uint64_t* begin = &mTimestampResults[(size_t)scope * 2 * TimestampStride];
+    const uint64_t* end = begin + TimestampStride;
+
+    if (begin[1] == 0 || end[1] == 0) {
+      continue;
+    }
+
+    // Masking the difference keeps it correct across a wrap of a counter narrower than 64 bits.
+    double durationMs = (double)((end[0] - begin[0]) & mTimestampMask) * mTimestampPeriodNs / 1e6;
+
+    SampleStatistics statistics;
+
+    if (record.statisticsQuery != UINT32_MAX) {
+      const uint64_t* values = &mStatisticsResults[(size_t)record.statisticsQuery * StatisticStride];
+
+      if (values[StatisticValueCount] != 0) {
+        statistics.valid = true;
+        statistics.values.inputVertices = values[0];
+        statistics.values.vertexInvocations = values[1];
+        statistics.values.clippingPrimitives = values[2];
+        statistics.values.fragmentInvocations = values[3];
+        statistics.values.computeInvocations = values[4];
+      }
+    }
+
+    History& history = mHistory[record.name];
+    uint32_t slot = history.durationsMs.Push(durationMs);
+
+    if (slot < history.statistics.size()) {
+      history.statistics[slot] = statistics;
+    }
+    else {
+      history.statistics.push_back(statistics);
+    }
+  }
+}
+
+std::vector<GpuScopeStats> GpuProfiler::GetScopeStats() const {
+  std::vector<GpuScopeStats> result;
+  std::vector<double> durations;
+
+  std::lock_guard lock(mHistoryMutex);
+
+  for (const auto& [name, history] : mHistory) {
+    if (history.durationsMs.GetSize() == 0) {
+      continue;
+    }
+
+    PercentileStats durationStats = history.durationsMs.Summarize(durations);
+
+    GpuScopeStats& stats = result.emplace_back();
+    stats.name = name;
+    stats.sampleCount = durationStats.sampleCount;
+    stats.averageMs = durationStats.average;
+    stats.p50Ms = durationStats.p50;
+    stats.p95Ms = durationStats.p95;
+    stats.p99Ms = durationStats.p99;
+    stats.maxMs = durationStats.max;
+
+    uint32_t statisticsSamples = 0;
+
+    for (const SampleStatistics& sample : history.statistics) {
+      if (sample.valid) {
+        statisticsSamples++;
+        stats.statistics.inputVertices += sample.values.inputVertices;
+        stats.statistics.vertexInvocations += sample.values.vertexInvocations;
+        stats.statistics.clippingPrimitives += sample.values.clippingPrimitives;
+        stats.statistics.fragmentInvocations += sample.values.fragmentInvocations;
+        stats.statistics.computeInvocations += sample.values.computeInvocations;
+      }
+    }
+
+    if (statisticsSamples > 0) {
+      stats.hasStatistics = true;
+      stats.statistics.inputVertices /= statisticsSamples;
+      stats.statistics.vertexInvocations /= statisticsSamples;
+      stats.statistics.clippingPrimitives /= statisticsSamples;
+      stats.statistics.fragmentInvocations /= statisticsSamples;
+      stats.statistics.computeInvocations /= statisticsSamples;
+    }
+  }
+
+  std::sort(result.begin(), result.end(), [](const GpuScopeStats& a, const GpuScopeStats& b) {
+    return a.averageMs > b.averageMs;
+  });
+
+  return result;
+}
+
+bool GpuProfiler::DumpToFile(const std::filesystem::path& path) const {
+  std::ofstream file(path);
+  if (!file) {
+    LogError("Renderer - Failed to open GPU profile {}", path.string());
+    return false;
+  }
+
+  file << "scope,samples,avg_ms,p50_ms,p95_ms,p99_ms,max_ms,"
+          "input_vertices,vs_invocations,clipping_primitives,fs_invocations,cs_invocations\n";
+
+  for (const GpuScopeStats& stats : GetScopeStats()) {
+    file << std::format(
+      "{},{},{:.4f},{:.4f},{:.4f},{:.4f},{:.4f}",
+      stats.name,
+      stats.sampleCount,
+      stats.averageMs,
+      stats.p50Ms,
+      stats.p95Ms,
+      stats.p99Ms,
+      stats.maxMs
+    );
+
+    if (stats.hasStatistics) {
+      file << std::format(
+        ",{},{},{},{},{}\n",
+        stats.statistics.inputVertices,
+        stats.statistics.vertexInvocations,
+        stats.statistics.clippingPrimitives,
+        stats.statistics.fragmentInvocations,
+        stats.statistics.computeInvocations
+      );
+    }
+    else {
+      file << ",,,,,\n";
+    }
+  }
+
+  return file.good();
+}
+
+} // namespace qpl
@@ -0,0 +1,147 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#ifndef QPL_GPU_PROFILER_HPP
+#define QPL_GPU_PROFILER_HPP
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <string_view>
+#include <unordered_map>
+
+#include <vulkan/vulkan.h>
+#include <core/core.hpp>
+
+namespace qpl {
+
+// Index of a scope within the frame it was opened in.
+using GpuScope = uint32_t;
+
+QPL_INLINE_CONSTEXPR GpuScope InvalidGpuScope = UINT32_MAX;
+
+struct GpuPipelineStatistics {
+  uint64_t inputVertices = 0;
+  uint64_t vertexInvocations = 0;
+  uint64_t clippingPrimitives = 0;
+  uint64_t fragmentInvocations = 0;
+  uint64_t computeInvocations = 0;
+};
+
+//
+// ---- Gpu Scope Stats ---------------------------------
+//
+// Rolling numbers for every scope with a given name, over the last GpuProfiler::HistoryLength samples.
+//
+struct GpuScopeStats {
+  std::string name;
+  uint32_t sampleCount = 0;
+
+  double averageMs = 0.0;
+  double p50Ms = 0.0;
+  double p95Ms = 0.0;
+  double p99Ms = 0.0;
+  double maxMs = 0.0;
+
+  // Averaged over the samples that had statistics queries; false if none did.
+  bool hasStatistics = false;
+  GpuPipelineStatistics statistics;
+};
+
+//
+// ---- Gpu Profiler ---------------------------------
+//
+// Measures GPU time of named scopes with timestamp queries, and optionally what they did with pipeline statistics
+// queries. Every frame slot has its own query pools; a slot's results are read back when the slot is reused, by
+// which point the renderer has already waited for it, so reading them never stalls.
+//
+// Scopes may be opened from any thread recording for the current frame, in primary or secondary command buffers.
+// Timestamp scopes nest freely; scopes with statistics must not nest within a command buffer, and must not be open
+// around vkCmdExecuteCommands.
+//
+class GpuProfiler final {
+public:
+  // Samples kept per scope name for averages and percentiles.
+  static constexpr uint32_t HistoryLength = 240;
+
+  void Init(
+    VkDevice device,
+    VkPhysicalDevice physicalDevice,
+    uint32_t queueFamily,
+    uint32_t frameCount,
+    uint32_t maxScopes,
+    bool enableStatistics
+  );
+  void Destroy();
+
+  // Collects the results left in `frameIndex`'s pools by its previous use and resets them. Must be called at the
+  // start of the slot's primary command buffer, after the GPU is done with its previous submission.
+  void BeginFrame(uint32_t frameIndex, VkCommandBuffer commandBuffer);
+
+  // Returns InvalidGpuScope (and records nothing) when profiling is unavailable or the frame ran out of queries.
+  GpuScope BeginScope(VkCommandBuffer commandBuffer, std::string_view name, bool statistics = true);
+  void EndScope(VkCommandBuffer commandBuffer, GpuScope scope);
+
+  // Every scope seen so far, most expensive first.
+  std::vector<GpuScopeStats> GetScopeStats() const;
+
+  // Writes GetScopeStats() as CSV.
+  bool DumpToFile(const std::filesystem::path& path) const;
+
+  QPL_INLINE bool IsEnabled() const {
+    return mEnabled;
+  }
+
+private:
+  struct ScopeRecord {
+    std::string name;
+    uint32_t statisticsQuery = UINT32_MAX;
+  };
+
+  struct FrameQueries {
+    VkQueryPool timestampPool = VK_NULL_HANDLE;
+    VkQueryPool statisticsPool = VK_NULL_HANDLE;
+    std::vector<ScopeRecord> scopes;
+    std::atomic<uint32_t> scopeCount = 0;
+    std::atomic<uint32_t> statisticsCount = 0;
+  };
+
+  struct SampleStatistics {
+    bool valid = false;
+    GpuPipelineStatistics values;
+  };
+
+  struct History {
+    PercentileHistory<HistoryLength> durationsMs;
+    // Statistics of every sample, in the slot its duration went into.
+    std::vector<SampleStatistics> statistics;
+  };
+
+  void Collect(FrameQueries& frame);
+
+private:
+  VkDevice mDevice = VK_NULL_HANDLE;
+  bool mEnabled = false;
+  bool mStatisticsEnabled = false;
+  uint32_t mMaxScopes = 0;
+  double mTimestampPeriodNs = 1.0;
+  uint64_t mTimestampMask = UINT64_MAX;
+
+  std::vector<std::unique_ptr<FrameQueries>> mFrames;
+  uint32_t mCurrentFrame = 0;
+
+  mutable std::mutex mHistoryMutex;
+  std::unordered_map<std::string, History> mHistory;
+
+  // Scratch for query results, reused across frames.
+  std::vector<uint64_t> mTimestampResults;
+  std::vector<uint64_t> mStatisticsResults;
+};
+
+} // namespace qpl
+
+#endif
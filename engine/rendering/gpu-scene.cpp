@@ -0,0 +1,556 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#include "gpu-scene.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+namespace qpl {
+
+//
+// ---- Matrices ---------------------------------
+//
+Matrix4 MultiplyMatrices(const Matrix4& a, const Matrix4& b) {
+  Matrix4 result{};
+
+  for (int column = 0; column < 4; column++) {
+    for (int row = 0; row < 4; row++) {
+      float sum = 0.0f;
+
+      for (int k = 0; k < 4; k++) {
+        sum += a[k * 4 + row] * b[column * 4 + k];
+      }
+
+      result[column * 4 + row] = sum;
+    }
+  }
+
+  return result;
+}
+
+static std::array<float, 3> Normalize(const std::array<float, 3>& v) {
+  float length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+  return {v[0] / length, v[1] / length, v[2] / length};
+}
+
+static std::array<float, 3> Cross(const std::array<float, 3>& a, const std::array<float, 3>& b) {
+  return {a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]};
+}
+
+static float Dot(const std::array<float, 3>& a, const std::array<float, 3>& b) {
+  return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+Matrix4 MakeLookAtMatrix(const std::array<float, 3>& eye, const std::array<float, 3>& target) {
+  std::array<float, 3> forward = Normalize({target[0] - eye[0], target[1] - eye[1], target[2] - eye[2]});
+  std::array<float, 3> side = Normalize(Cross(forward, {0.0f, 1.0f, 0.0f}));
+  std::array<float, 3> up = Cross(side, forward);
+
+  return {
+    side[0],
+    up[0],
+    -forward[0],
+    0.0f,
+    side[1],
+    up[1],
+    -forward[1],
+    0.0f,
+    side[2],
+    up[2],
+    -forward[2],
+    0.0f,
+    -Dot(side, eye),
+    -Dot(up, eye),
+    Dot(forward, eye),
+    1.0f,
+  };
+}
+
+Matrix4 MakePerspectiveMatrix(float verticalFov, float aspectRatio, float nearPlane, float farPlane) {
+  float focal = 1.0f / std::tan(verticalFov * 0.5f);
+
+  Matrix4 result{};
+  result[0] = focal / aspectRatio;
+  result[5] = -focal;
+  result[10] = farPlane / (nearPlane - farPlane);
+  result[11] = -1.0f;
+  result[14] = nearPlane * farPlane / (nearPlane - farPlane);
+  return result;
+}
+
+// Gribb-Hartmann: each clip space boundary is a sum or difference of two rows of the view-projection matrix.
+static void ExtractFrustumPlanes(const Matrix4& m, float (&planes)[6][4]) {
+  auto row = [&](int r, int c) {
+    return m[c * 4 + r];
+  };
+
+  for (int c = 0; c < 4; c++) {
+    planes[0][c] = row(3, c) + row(0, c);
+    planes[1][c] = row(3, c) - row(0, c);
+    planes[2][c] = row(3, c) + row(1, c);
+    planes[3][c] = row(3, c) - row(1, c);
+    // Vulkan clip space depth starts at 0, not -w.
+    planes[4][c] = row(2, c);
+    planes[5][c] = row(3, c) - row(2, c);
+  }
+
+  for (auto& plane : planes) {
+    float length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+
+    for (float& value : plane) {
+      value /= length;
+    }
+  }
+}
+
+//
+// ---- Gpu Scene ---------------------------------
+//
+void GpuScene::Init(
+  VkDevice device,
+  VkPipelineCache pipelineCache,
+  GpuAllocator& allocator,
+  UploadRing& uploadRing,
+  BindlessHeap& bindlessHeap,
+  ShaderLibrary& shaderLibrary,
+  uint32_t frameCount,
+  const GpuSceneLimits& limits
+) {
+  LogInfo(
+    "Renderer - Creating GpuScene ({} objects, {} vertices, {} indices)",
+    limits.maxObjects,
+    limits.maxVertices,
+    limits.maxIndices
+  );
+
+  mDevice = device;
+  mPipelineCache = pipelineCache;
+  mAllocator = &allocator;
+  mUploadRing = &uploadRing;
+  mBindlessHeap = &bindlessHeap;
+  mLimits = limits;
+
+  CreateBuffers(limits, frameCount);
+  RegisterBuffers();
+  CreateCullPipeline(shaderLibrary);
+}
+
+void GpuScene::Destroy() {
+  if (mDevice == VK_NULL_HANDLE) {
+    return;
+  }
+
+  if (mCullPipeline != VK_NULL_HANDLE) {
+    vkDestroyPipeline(mDevice, mCullPipeline, nullptr);
+  }
+
+  for (BindlessIndex index : {
+         mBufferIndices.objects,
+         mBufferIndices.meshes,
+         mBufferIndices.vertices,
+         mBufferIndices.batches,
+         mBufferIndices.draws,
+         mBufferIndices.drawCounts,
+       }) {
+    mBindlessHeap->Free(BindlessType::StorageBuffer, index);
+  }
+
+  for (GpuBuffer* buffer :
+       {&mObjectBuffer, &mMeshBuffer, &mVertexBuffer, &mIndexBuffer, &mBatchBuffer, &mDrawBuffer, &mDrawCountBuffer}) {
+    mAllocator->DestroyBuffer(*buffer);
+  }
+
+  for (GpuBuffer& buffer : mStagingBuffers) {
+    mAllocator->DestroyBuffer(buffer);
+  }
+
+  mStagingBuffers.clear();
+  mDevice = VK_NULL_HANDLE;
+}
+
+void GpuScene::CreateBuffers(const GpuSceneLimits& limits, uint32_t frameCount) {
+  auto create = [&](VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties) {
+    VkBufferCreateInfo bufferInfo{};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = size;
+    bufferInfo.usage = usage;
+    // Exclusive, so the upload ring can hand ownership over from the transfer queue.
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    return mAllocator->CreateBuffer(bufferInfo, properties);
+  };
+
+  constexpr VkBufferUsageFlags storage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+  constexpr VkMemoryPropertyFlags deviceLocal = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+  mObjectBuffer = create(limits.maxObjects * sizeof(ObjectData), storage, deviceLocal);
+  mMeshBuffer = create(limits.maxObjects * sizeof(MeshData), storage, deviceLocal);
+  mVertexBuffer = create(limits.maxVertices * sizeof(GpuVertex), storage, deviceLocal);
+  mIndexBuffer = create(
+    limits.maxIndices * sizeof(uint32_t),
+    VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+    deviceLocal
+  );
+  mBatchBuffer = create(MaxBatches * sizeof(uint32_t), storage, deviceLocal);
+  mDrawBuffer = create(
+    limits.maxObjects * sizeof(VkDrawIndexedIndirectCommand),
+    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+    deviceLocal
+  );
+  mDrawCountBuffer = create(MaxBatches * sizeof(uint32_t), storage | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, deviceLocal);
+
+  for (uint32_t i = 0; i < frameCount; i++) {
+    GpuBuffer& staging = mStagingBuffers.emplace_back(create(
+      limits.maxObjects * sizeof(ObjectData),
+      VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+    ));
+
+    QPL_CORE_ASSERT(staging.allocation.mapped != nullptr && "scene staging memory is not host visible!");
+  }
+
+  mObjects.resize(limits.maxObjects);
+  mDirtyFlags.resize(limits.maxObjects);
+}
+
+void GpuScene::RegisterBuffers() {
+  // The buffers never move, so their descriptors are written once; every frame only pushes the indices.
+  mBufferIndices.objects = mBindlessHeap->AddStorageBuffer(mObjectBuffer.buffer);
+  mBufferIndices.meshes = mBindlessHeap->AddStorageBuffer(mMeshBuffer.buffer);
+  mBufferIndices.vertices = mBindlessHeap->AddStorageBuffer(mVertexBuffer.buffer);
+  mBufferIndices.batches = mBindlessHeap->AddStorageBuffer(mBatchBuffer.buffer);
+  mBufferIndices.draws = mBindlessHeap->AddStorageBuffer(mDrawBuffer.buffer);
+  mBufferIndices.drawCounts = mBindlessHeap->AddStorageBuffer(mDrawCountBuffer.buffer);
+}
+
+void GpuScene::CreateCullPipeline(ShaderLibrary& shaderLibrary) {
+  // The scene shaders are compiled at build time when glslc is available; without them there is nothing to draw.
+  for (const char* shader : {CullShader, VertexShader, FragmentShader}) {
+    if (!std::filesystem::exists(shaderLibrary.GetDirectory() / shader)) {
+      LogWarning("Renderer - {} not found, GPU scene disabled", shader);
+      return;
+    }
+  }
+
+  ShaderRef cullShader = shaderLibrary.Load(CullShader);
+
+  if (cullShader == nullptr) {
+    return;
+  }
+
+  if (cullShader->reflection.pushConstantSize < sizeof(CullConstants)) {
+    LogError("Renderer - {} push constants do not match CullConstants, GPU scene disabled", CullShader);
+    return;
+  }
+
+  // Set 0 is the bindless heap; the push constant range comes from the shader.
+  VkDescriptorSetLayout sets[] = {mBindlessHeap->GetSetLayout()};
+  mCullLayout = shaderLibrary.GetPipelineLayout(std::span<const ShaderRef>(&cullShader, 1), sets);
+
+  if (mCullLayout == VK_NULL_HANDLE) {
+    return;
+  }
+
+  VkComputePipelineCreateInfo pipelineInfo{};
+  pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+  pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+  pipelineInfo.stage.module = cullShader->module;
+  pipelineInfo.stage.pName = "main";
+  pipelineInfo.layout = mCullLayout;
+
+  if (vkCreateComputePipelines(mDevice, mPipelineCache, 1, &pipelineInfo, nullptr, &mCullPipeline) != VK_SUCCESS) {
+    LogError("Renderer - Failed to compile the cull pipeline, GPU scene disabled");
+    mCullPipeline = VK_NULL_HANDLE;
+  }
+}
+
+MeshHandle GpuScene::CreateMesh(std::span<const GpuVertex> vertices, std::span<const uint32_t> indices) {
+  QPL_CORE_ASSERT(!vertices.empty() && !indices.empty() && "empty mesh");
+  QPL_CORE_ASSERT(mMeshes.size() < mLimits.maxObjects && "too many meshes");
+  QPL_CORE_ASSERT(mVertexCount + vertices.size() <= mLimits.maxVertices && "scene vertex buffer is full");
+  QPL_CORE_ASSERT(mIndexCount + indices.size() <= mLimits.maxIndices && "scene index buffer is full");
+
+  MeshHandle handle = static_cast<MeshHandle>(mMeshes.size());
+  Mesh& mesh = mMeshes.emplace_back();
+
+  mesh.data.indexCount = static_cast<uint32_t>(indices.size());
+  mesh.data.firstIndex = mIndexCount;
+  mesh.data.vertexOffset = static_cast<int32_t>(mVertexCount);
+  mesh.data.pad = 0;
+
+  // Bounding sphere around the center of the bounding box; loose, but cheap and good enough to cull with.
+  float min[3] = {vertices[0].position[0], vertices[0].position[1], vertices[0].position[2]};
+  float max[3] = {min[0], min[1], min[2]};
+
+  for (const GpuVertex& vertex : vertices) {
+    for (int i = 0; i < 3; i++) {
+      min[i] = std::min(min[i], vertex.position[i]);
+      max[i] = std::max(max[i], vertex.position[i]);
+    }
+  }
+
+  float radiusSquared = 0.0f;
+
+  for (int i = 0; i < 3; i++) {
+    mesh.center[i] = (min[i] + max[i]) * 0.5f;
+  }
+
+  for (const GpuVertex& vertex : vertices) {
+    float dx = vertex.position[0] - mesh.center[0];
+    float dy = vertex.position[1] - mesh.center[1];
+    float dz = vertex.position[2] - mesh.center[2];
+    radiusSquared = std::max(radiusSquared, dx * dx + dy * dy + dz * dz);
+  }
+
+  mesh.radius = std::sqrt(radiusSquared);
+
+  mUploadRing->UploadBuffer(mVertexBuffer.buffer, mVertexCount * sizeof(GpuVertex), std::as_bytes(vertices));
+  mUploadRing->UploadBuffer(mIndexBuffer.buffer, mIndexCount * sizeof(uint32_t), std::as_bytes(indices));
+  mUploadRing->UploadBuffer(
+    mMeshBuffer.buffer, handle * sizeof(MeshData), std::as_bytes(std::span<const MeshData>(&mesh.data, 1))
+  );
+
+  mVertexCount += static_cast<uint32_t>(vertices.size());
+  mIndexCount += static_cast<uint32_t>(indices.size());
+  return handle;
+}
+
+ObjectHandle GpuScene::CreateObject(
+  MeshHandle mesh, PipelineHandle pipeline, const Matrix4& transform, const std::array<float, 4>& color
+) {
+  QPL_CORE_ASSERT(mesh < mMeshes.size() && "invalid mesh handle");
+
+  ObjectHandle handle;
+
+  if (!mFreeObjects.empty()) {
+    handle = mFreeObjects.back();
+    mFreeObjects.pop_back();
+  }
+  else {
+    QPL_CORE_ASSERT(mObjectCount < mLimits.maxObjects && "too many scene objects");
+    handle = mObjectCount++;
+  }
+
+  uint32_t batch = GetBatch(pipeline);
+  mBatches[batch].objectCount++;
+  mBatchesDirty = true;
+
+  ObjectData& data = mObjects[handle];
+  data.transform = transform;
+  std::memcpy(data.color, color.data(), sizeof(data.color));
+  data.mesh = mesh;
+  data.batch = batch;
+  UpdateBounds(data);
+
+  mLiveObjectCount++;
+  MarkDirty(handle);
+  return handle;
+}
+
+void GpuScene::DestroyObject(ObjectHandle object) {
+  QPL_CORE_ASSERT(object < mObjectCount && mObjects[object].mesh != InvalidMeshHandle && "invalid object handle");
+
+  ObjectData& data = mObjects[object];
+  mBatches[data.batch].objectCount--;
+  mBatchesDirty = true;
+
+  // The slot stays in the buffer; the cull shader skips it.
+  data.mesh = InvalidMeshHandle;
+
+  mFreeObjects.push_back(object);
+  mLiveObjectCount--;
+  MarkDirty(object);
+}
+
+void GpuScene::SetTransform(ObjectHandle object, const Matrix4& transform) {
+  QPL_CORE_ASSERT(object < mObjectCount && mObjects[object].mesh != InvalidMeshHandle && "invalid object handle");
+
+  ObjectData& data = mObjects[object];
+  data.transform = transform;
+  UpdateBounds(data);
+  MarkDirty(object);
+}
+
+uint32_t GpuScene::GetBatch(PipelineHandle pipeline) {
+  auto [it, inserted] = mBatchLookup.try_emplace(pipeline, static_cast<uint32_t>(mBatches.size()));
+
+  if (inserted) {
+    QPL_CORE_ASSERT(mBatches.size() < MaxBatches && "too many scene pipelines");
+    mBatches.push_back({pipeline, 0, 0});
+  }
+
+  return it->second;
+}
+
+void GpuScene::UpdateBounds(ObjectData& data) {
+  const Mesh& mesh = mMeshes[data.mesh];
+  const Matrix4& m = data.transform;
+
+  for (int row = 0; row < 3; row++) {
+    data.bounds[row] =
+      m[row] * mesh.center[0] + m[4 + row] * mesh.center[1] + m[8 + row] * mesh.center[2] + m[12 + row];
+  }
+
+  // Non-uniform scale stretches the sphere by the longest axis.
+  float maxScaleSquared = 0.0f;
+
+  for (int column = 0; column < 3; column++) {
+    const float* axis = &m[column * 4];
+    maxScaleSquared = std::max(maxScaleSquared, axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+  }
+
+  data.bounds[3] = mesh.radius * std::sqrt(maxScaleSquared);
+}
+
+void GpuScene::MarkDirty(ObjectHandle object) {
+  if (!mDirtyFlags[object]) {
+    mDirtyFlags[object] = true;
+    mDirtyObjects.push_back(object);
+  }
+}
+
+void GpuScene::RecordCull(VkCommandBuffer commandBuffer, uint32_t frameIndex) {
+  QPL_PROFILE_ZONE("GpuScene::RecordCull");
+
+  if (!IsAvailable()) {
+    return;
+  }
+
+  // The previous frame's cull and draws use the buffers rewritten below.
+  VkMemoryBarrier2 barrier{};
+  barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+  barrier.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT
+    | VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT;
+  barrier.srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+  barrier.dstStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+  barrier.dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+
+  VkDependencyInfo dependencyInfo{};
+  dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+  dependencyInfo.memoryBarrierCount = 1;
+  dependencyInfo.pMemoryBarriers = &barrier;
+
+  vkCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+
+  if (!mDirtyObjects.empty()) {
+    // Sorted, so neighbouring objects go out as one copy region.
+    std::sort(mDirtyObjects.begin(), mDirtyObjects.end());
+
+    auto* staging = static_cast<ObjectData*>(mStagingBuffers[frameIndex].allocation.mapped);
+    mCopyScratch.clear();
+
+    for (uint32_t i = 0; i < mDirtyObjects.size(); i++) {
+      ObjectHandle object = mDirtyObjects[i];
+      staging[i] = mObjects[object];
+      mDirtyFlags[object] = false;
+
+      VkDeviceSize dstOffset = object * sizeof(ObjectData);
+
+      if (!mCopyScratch.empty()) {
+        VkBufferCopy& last = mCopyScratch.back();
+
+        if (last.dstOffset + last.size == dstOffset) {
+          last.size += sizeof(ObjectData);
+          continue;
+        }
+      }
+
+      mCopyScratch.push_back({i * sizeof(ObjectData), dstOffset, sizeof(ObjectData)});
+    }
+
+    vkCmdCopyBuffer(
+      commandBuffer,
+      mStagingBuffers[frameIndex].buffer,
+      mObjectBuffer.buffer,
+      static_cast<uint32_t>(mCopyScratch.size()),
+      mCopyScratch.data()
+    );
+
+    mDirtyObjects.clear();
+  }
+
+  if (mBatchesDirty) {
+    // Each batch gets as many draw slots as it has objects, which is as many as can survive culling.
+    std::array<uint32_t, MaxBatches> drawOffsets{};
+    uint32_t offset = 0;
+
+    for (uint32_t i = 0; i < mBatches.size(); i++) {
+      mBatches[i].drawOffset = offset;
+      drawOffsets[i] = offset;
+      offset += mBatches[i].objectCount;
+    }
+
+    vkCmdUpdateBuffer(
+      commandBuffer, mBatchBuffer.buffer, 0, mBatches.size() * sizeof(uint32_t), drawOffsets.data()
+    );
+
+    mBatchesDirty = false;
+  }
+
+  vkCmdFillBuffer(commandBuffer, mDrawCountBuffer.buffer, 0, MaxBatches * sizeof(uint32_t), 0);
+
+  barrier.srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+  barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+  barrier.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT;
+  barrier.dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+  vkCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+
+  if (mObjectCount > 0) {
+    CullConstants constants{};
+    ExtractFrustumPlanes(mViewProjection, constants.frustumPlanes);
+    constants.objectCount = mObjectCount;
+    constants.buffers = mBufferIndices;
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, mCullPipeline);
+    mBindlessHeap->Bind(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, mCullLayout);
+    vkCmdPushConstants(commandBuffer, mCullLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+    vkCmdDispatch(commandBuffer, (mObjectCount + CullGroupSize - 1) / CullGroupSize, 1, 1);
+  }
+
+  barrier.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+  barrier.srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+  barrier.dstStageMask = VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT;
+  barrier.dstAccessMask = VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT;
+  vkCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+}
+
+void GpuScene::RecordDraw(VkCommandBuffer commandBuffer, const PipelineRegistry& pipelineRegistry) {
+  QPL_PROFILE_ZONE("GpuScene::RecordDraw");
+
+  if (!IsAvailable() || mLiveObjectCount == 0) {
+    return;
+  }
+
+  VkPipelineLayout layout = pipelineRegistry.GetLayout();
+  DrawConstants constants{mViewProjection, mBufferIndices};
+
+  mBindlessHeap->Bind(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout);
+  vkCmdPushConstants(commandBuffer, layout, VK_SHADER_STAGE_ALL_GRAPHICS, 0, sizeof(constants), &constants);
+  vkCmdBindIndexBuffer(commandBuffer, mIndexBuffer.buffer, 0, VK_INDEX_TYPE_UINT32);
+
+  for (uint32_t i = 0; i < mBatches.size(); i++) {
+    const Batch& batch = mBatches[i];
+
+    // Drawn with the fallback, the objects would come out as garbage; better not to draw them at all.
+    if (batch.objectCount == 0 || !pipelineRegistry.IsReady(batch.pipeline)) {
+      continue;
+    }
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineRegistry.Get(batch.pipeline));
+    vkCmdDrawIndexedIndirectCount(
+      commandBuffer,
+      mDrawBuffer.buffer,
+      batch.drawOffset * sizeof(VkDrawIndexedIndirectCommand),
+      mDrawCountBuffer.buffer,
+      i * sizeof(uint32_t),
+      batch.objectCount,
+      sizeof(VkDrawIndexedIndirectCommand)
+    );
+  }
+}
+
+} // namespace qpl
@@ -0,0 +1,250 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#ifndef QPL_GPU_SCENE_HPP
+#define QPL_GPU_SCENE_HPP
+
+#include <span>
+#include <array>
+#include <vector>
+#include <filesystem>
+#include <unordered_map>
+
+#include <vulkan/vulkan.h>
+#include <core/core.hpp>
+#include "gpu-allocator.hpp"
+#include "upload-ring.hpp"
+#include "pipeline-registry.hpp"
+#include "bindless-heap.hpp"
+#include "shader-library.hpp"
+
+namespace qpl {
+
+// Column-major 4x4 matrix, laid out the way GLSL expects a mat4.
+using Matrix4 = std::array<float, 16>;
+
+QPL_INLINE_CONSTEXPR Matrix4 IdentityMatrix = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+
+Matrix4 MultiplyMatrices(const Matrix4& a, const Matrix4& b);
+
+// Right-handed view looking from `eye` towards `target`, with +y up.
+Matrix4 MakeLookAtMatrix(const std::array<float, 3>& eye, const std::array<float, 3>& target);
+
+// Vulkan clip space: depth from 0 at `nearPlane` to 1 at `farPlane`, y pointing down.
+Matrix4 MakePerspectiveMatrix(float verticalFov, float aspectRatio, float nearPlane, float farPlane);
+
+// Index of a mesh inside a GpuScene. Meshes live as long as the scene.
+using MeshHandle = uint32_t;
+
+// Index of an object inside a GpuScene. Reused once the object is destroyed.
+using ObjectHandle = uint32_t;
+
+QPL_INLINE_CONSTEXPR MeshHandle InvalidMeshHandle = UINT32_MAX;
+QPL_INLINE_CONSTEXPR ObjectHandle InvalidObjectHandle = UINT32_MAX;
+
+// Vertices are pulled from a storage buffer by index, so this is the whole vertex format.
+struct GpuVertex {
+  float position[3];
+  float normal[3];
+};
+
+// Meshes are capped at maxObjects as well.
+struct GpuSceneLimits {
+  uint32_t maxObjects = 64 * 1024;
+  uint32_t maxVertices = 1024 * 1024;
+  uint32_t maxIndices = 4 * 1024 * 1024;
+};
+
+//
+// ---- Gpu Scene ---------------------------------
+//
+// GPU-driven drawing of every object in the scene. Objects, meshes and geometry live in storage buffers that persist
+// across frames and are reached through the bindless heap; the CPU only sends the objects that changed. Every frame a
+// compute pass tests each object's bounding sphere against the view frustum and appends the survivors to their
+// batch's range of an indirect draw buffer, and each batch is then drawn with a single vkCmdDrawIndexedIndirectCount.
+// A batch is the set of objects sharing one pipeline, so the CPU cost of a frame depends on the number of pipelines,
+// not on the number of objects.
+//
+// Object changes are copied on the graphics queue at the start of the frame rather than through the upload ring:
+// the transfer queue does not wait for earlier frames, and would overwrite objects they are still drawing. Meshes are
+// written once and go through the upload ring.
+//
+// The cull pipeline is built once at Init(); shader hot reload only reaches the scene's graphics pipelines, which live
+// in the pipeline registry.
+//
+// Everything but the Record*() calls is meant for the render thread, between frames.
+//
+class GpuScene final {
+public:
+  // Different pipelines drawn by the scene, at most.
+  static constexpr uint32_t MaxBatches = 64;
+
+  static constexpr uint32_t CullGroupSize = 64;
+
+  // Shaders the scene is drawn with, relative to the shader directory.
+  static constexpr const char* CullShader = "cull.comp.spv";
+  static constexpr const char* VertexShader = "scene.vert.spv";
+  static constexpr const char* FragmentShader = "scene.frag.spv";
+
+  void Init(
+    VkDevice device,
+    VkPipelineCache pipelineCache,
+    GpuAllocator& allocator,
+    UploadRing& uploadRing,
+    BindlessHeap& bindlessHeap,
+    ShaderLibrary& shaderLibrary,
+    uint32_t frameCount,
+    const GpuSceneLimits& limits
+  );
+  void Destroy();
+
+  // False if the scene's shaders could not be found; nothing is culled or drawn then.
+  QPL_INLINE bool IsAvailable() const {
+    return mCullPipeline != VK_NULL_HANDLE;
+  }
+
+  MeshHandle CreateMesh(std::span<const GpuVertex> vertices, std::span<const uint32_t> indices);
+
+  // `pipeline` must take the scene's push constants, like the one made from VertexShader and FragmentShader. Objects
+  // whose pipeline is still compiling are skipped.
+  ObjectHandle CreateObject(
+    MeshHandle mesh, PipelineHandle pipeline, const Matrix4& transform, const std::array<float, 4>& color
+  );
+  void DestroyObject(ObjectHandle object);
+  void SetTransform(ObjectHandle object, const Matrix4& transform);
+
+  QPL_INLINE void SetCamera(const Matrix4& viewProjection) {
+    mViewProjection = viewProjection;
+  }
+
+  QPL_INLINE uint32_t GetObjectCount() const {
+    return mLiveObjectCount;
+  }
+
+  // Applies the object changes made since the last frame and culls, refilling the indirect draw buffer. Recorded
+  // outside of any rendering scope, before RecordDraw().
+  void RecordCull(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+
+  // Draws every batch. Recorded inside a rendering scope.
+  void RecordDraw(VkCommandBuffer commandBuffer, const PipelineRegistry& pipelineRegistry);
+
+private:
+  // GPU side of an object; matches SceneObject in scene.glsl.
+  struct ObjectData {
+    Matrix4 transform;
+    float bounds[4];
+    float color[4];
+    uint32_t mesh;
+    uint32_t batch;
+    uint32_t pad[2];
+  };
+
+  static_assert(sizeof(ObjectData) == 112, "ObjectData must match the std430 layout of SceneObject");
+
+  // GPU side of a mesh; matches SceneMesh in scene.glsl.
+  struct MeshData {
+    uint32_t indexCount;
+    uint32_t firstIndex;
+    int32_t vertexOffset;
+    uint32_t pad;
+  };
+
+  struct Mesh {
+    MeshData data;
+    // Object space bounding sphere.
+    float center[3];
+    float radius;
+  };
+
+  struct Batch {
+    PipelineHandle pipeline = InvalidPipelineHandle;
+    uint32_t objectCount = 0;
+    // First slot of the batch in the draw buffer.
+    uint32_t drawOffset = 0;
+  };
+
+  // Bindless indices of the scene buffers; matches SceneBuffers in scene.glsl.
+  struct BufferIndices {
+    BindlessIndex objects;
+    BindlessIndex meshes;
+    BindlessIndex vertices;
+    BindlessIndex batches;
+    BindlessIndex draws;
+    BindlessIndex drawCounts;
+  };
+
+  struct CullConstants {
+    float frustumPlanes[6][4];
+    uint32_t objectCount;
+    BufferIndices buffers;
+  };
+
+  struct DrawConstants {
+    Matrix4 viewProjection;
+    BufferIndices buffers;
+  };
+
+  static_assert(sizeof(CullConstants) <= PipelineRegistry::PushConstantSize, "cull constants do not fit");
+  static_assert(sizeof(DrawConstants) <= PipelineRegistry::PushConstantSize, "draw constants do not fit");
+
+  void CreateBuffers(const GpuSceneLimits& limits, uint32_t frameCount);
+  void RegisterBuffers();
+  void CreateCullPipeline(ShaderLibrary& shaderLibrary);
+
+  uint32_t GetBatch(PipelineHandle pipeline);
+  void UpdateBounds(ObjectData& data);
+  void MarkDirty(ObjectHandle object);
+
+private:
+  VkDevice mDevice = VK_NULL_HANDLE;
+  VkPipelineCache mPipelineCache = VK_NULL_HANDLE;
+  GpuAllocator* mAllocator = nullptr;
+  UploadRing* mUploadRing = nullptr;
+  BindlessHeap* mBindlessHeap = nullptr;
+  GpuSceneLimits mLimits;
+
+  GpuBuffer mObjectBuffer;
+  GpuBuffer mMeshBuffer;
+  GpuBuffer mVertexBuffer;
+  GpuBuffer mIndexBuffer;
+  GpuBuffer mBatchBuffer;
+  GpuBuffer mDrawBuffer;
+  GpuBuffer mDrawCountBuffer;
+
+  // Host-visible copies of changed objects, one per frame in flight, so a frame never overwrites the staging area an
+  // earlier frame is still copying from.
+  std::vector<GpuBuffer> mStagingBuffers;
+
+  BufferIndices mBufferIndices{};
+
+  // Derived from the cull shader's reflection, owned by the shader library.
+  VkPipelineLayout mCullLayout = VK_NULL_HANDLE;
+  VkPipeline mCullPipeline = VK_NULL_HANDLE;
+
+  std::vector<Mesh> mMeshes;
+  uint32_t mVertexCount = 0;
+  uint32_t mIndexCount = 0;
+
+  // Indexed by ObjectHandle. Slots past mObjectCount have never been used.
+  std::vector<ObjectData> mObjects;
+  std::vector<ObjectHandle> mFreeObjects;
+  uint32_t mObjectCount = 0;
+  uint32_t mLiveObjectCount = 0;
+
+  // Objects to copy with the next RecordCull(), each listed once.
+  std::vector<ObjectHandle> mDirtyObjects;
+  std::vector<bool> mDirtyFlags;
+  std::vector<VkBufferCopy> mCopyScratch;
+
+  std::vector<Batch> mBatches;
+  std::unordered_map<PipelineHandle, uint32_t> mBatchLookup;
+  // Batch object counts changed, so the draw offsets have to be laid out again.
+  bool mBatchesDirty = false;
+
+  Matrix4 mViewProjection = IdentityMatrix;
+};
+
+} // namespace qpl
+
+#endif
@@ -0,0 +1,85 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#include "gpu-timeline.hpp"
+
+#include <algorithm>
+#include <magic_enum/magic_enum.hpp>
+
+namespace qpl {
+
+void GpuTimeline::Init(VkDevice device, std::string name) {
+  LogInfo("Renderer - Creating GpuTimeline '{}'", name);
+
+  mDevice = device;
+  mName = std::move(name);
+
+  VkSemaphoreTypeCreateInfo typeInfo{};
+  typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+  typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+  typeInfo.initialValue = 0;
+
+  VkSemaphoreCreateInfo createInfo{};
+  createInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+  createInfo.pNext = &typeInfo;
+
+  if (vkCreateSemaphore(mDevice, &createInfo, nullptr, &mSemaphore) != VK_SUCCESS) {
+    QPL_CORE_ASSERT(false && "failed to create timeline semaphore!");
+  }
+}
+
+void GpuTimeline::Destroy() {
+  vkDestroySemaphore(mDevice, mSemaphore, nullptr);
+  mSemaphore = VK_NULL_HANDLE;
+}
+
+uint64_t GpuTimeline::PollCompleted() {
+  uint64_t value = 0;
+  if (VkResult code = vkGetSemaphoreCounterValue(mDevice, mSemaphore, &value); code != VK_SUCCESS) {
+    LogError("vkGetSemaphoreCounterValue failed with code {}", magic_enum::enum_name(code));
+    QPL_CORE_ASSERT(false && "failed to query timeline semaphore!");
+  }
+
+  // Several threads may poll at once; never let the cached value move backwards.
+  uint64_t cached = mCompleted.load(std::memory_order_relaxed);
+  while (cached < value && !mCompleted.compare_exchange_weak(cached, value, std::memory_order_acq_rel)) {
+  }
+
+  return std::max(cached, value);
+}
+
+bool GpuTimeline::IsComplete(uint64_t value) {
+  if (value <= mCompleted.load(std::memory_order_acquire)) {
+    return true;
+  }
+
+  return value <= PollCompleted();
+}
+
+bool GpuTimeline::Wait(uint64_t value, uint64_t timeout) {
+  if (IsComplete(value)) {
+    return true;
+  }
+
+  VkSemaphoreWaitInfo waitInfo{};
+  waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+  waitInfo.semaphoreCount = 1;
+  waitInfo.pSemaphores = &mSemaphore;
+  waitInfo.pValues = &value;
+
+  VkResult code = vkWaitSemaphores(mDevice, &waitInfo, timeout);
+  if (code == VK_TIMEOUT) {
+    return false;
+  }
+
+  if (code != VK_SUCCESS) {
+    LogError("vkWaitSemaphores failed with code {}", magic_enum::enum_name(code));
+    QPL_CORE_ASSERT(false && "failed to wait on timeline semaphore!");
+  }
+
+  PollCompleted();
+  return true;
+}
+
+} // namespace qpl
@@ -0,0 +1,69 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#ifndef QPL_GPU_TIMELINE_HPP
+#define QPL_GPU_TIMELINE_HPP
+
+#include <atomic>
+#include <string>
+
+#include <vulkan/vulkan.h>
+#include <core/core.hpp>
+
+namespace qpl {
+
+//
+// ---- Gpu Timeline ---------------------------------
+//
+// A Vulkan 1.2 timeline semaphore paired with a CPU-side counter of the values handed out for signalling. Every
+// submission to a queue signals the next value of that queue's timeline, so "has submission X finished" becomes
+// "has the timeline reached X", which any subsystem can poll or wait on without owning a fence.
+//
+// Values only ever increase. 0 is the initial value and is always complete, so it doubles as "nothing submitted".
+// Thread safe.
+//
+class GpuTimeline final {
+public:
+  void Init(VkDevice device, std::string name);
+  void Destroy();
+
+  // Reserves the value the caller's next submission to this timeline's queue must signal.
+  QPL_INLINE uint64_t NextValue() {
+    return mLastSubmitted.fetch_add(1, std::memory_order_acq_rel) + 1;
+  }
+
+  // Last value handed out by NextValue().
+  QPL_INLINE uint64_t GetLastSubmitted() const {
+    return mLastSubmitted.load(std::memory_order_acquire);
+  }
+
+  // Queries the semaphore for the latest value the GPU has reached.
+  uint64_t PollCompleted();
+
+  // Cheap check against the last polled value, polling the semaphore only if that is not enough.
+  bool IsComplete(uint64_t value);
+
+  // Blocks until the timeline reaches `value`. Returns false on timeout.
+  bool Wait(uint64_t value, uint64_t timeout = UINT64_MAX);
+
+  QPL_INLINE VkSemaphore GetHandle() const {
+    return mSemaphore;
+  }
+
+  QPL_INLINE const std::string& GetName() const {
+    return mName;
+  }
+
+private:
+  VkDevice mDevice = VK_NULL_HANDLE;
+  VkSemaphore mSemaphore = VK_NULL_HANDLE;
+  std::string mName;
+
+  std::atomic<uint64_t> mLastSubmitted = 0;
+  std::atomic<uint64_t> mCompleted = 0;
+};
+
+} // namespace qpl
+
+#endif
@@ -0,0 +1,157 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#include "pipeline-cache.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <magic_enum/magic_enum.hpp>
+
+namespace qpl {
+
+void PipelineCache::Init(VkDevice device, VkPhysicalDevice physicalDevice, const std::filesystem::path& directory) {
+  mDevice = device;
+  vkGetPhysicalDeviceProperties(physicalDevice, &mDeviceProperties);
+
+  mPath = directory
+    / std::format("pipelines-{:04x}-{:04x}.bin", mDeviceProperties.vendorID, mDeviceProperties.deviceID);
+
+  std::vector<char> blob = LoadFile();
+  mLoadedFromDisk = !blob.empty();
+
+  VkPipelineCacheCreateInfo createInfo{};
+  createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+  createInfo.initialDataSize = blob.size();
+  createInfo.pInitialData = blob.empty() ? nullptr : blob.data();
+
+  if (VkResult code = vkCreatePipelineCache(mDevice, &createInfo, nullptr, &mCache); code != VK_SUCCESS) {
+    // Drivers are allowed to reject data they accepted the header of; fall back to an empty cache.
+    LogWarning("vkCreatePipelineCache rejected cached data with code {}", magic_enum::enum_name(code));
+
+    createInfo.initialDataSize = 0;
+    createInfo.pInitialData = nullptr;
+    mLoadedFromDisk = false;
+
+    if (vkCreatePipelineCache(mDevice, &createInfo, nullptr, &mCache) != VK_SUCCESS) {
+      QPL_CORE_ASSERT(false && "failed to create pipeline cache!");
+    }
+  }
+
+  LogInfo("Renderer - Pipeline cache {} ({})", mLoadedFromDisk ? "loaded" : "empty", mPath.string());
+}
+
+void PipelineCache::Destroy() {
+  if (mCache == VK_NULL_HANDLE) {
+    return;
+  }
+
+  Save();
+
+  vkDestroyPipelineCache(mDevice, mCache, nullptr);
+  mCache = VK_NULL_HANDLE;
+}
+
+bool PipelineCache::Save() {
+  size_t dataSize = 0;
+  if (vkGetPipelineCacheData(mDevice, mCache, &dataSize, nullptr) != VK_SUCCESS || dataSize == 0) {
+    return false;
+  }
+
+  std::vector<char> data(dataSize);
+  if (vkGetPipelineCacheData(mDevice, mCache, &dataSize, data.data()) != VK_SUCCESS) {
+    return false;
+  }
+
+  FileHeader header{};
+  header.magic = FileMagic;
+  header.version = FileVersion;
+  header.dataSize = dataSize;
+  header.dataHash = HashBytes(data.data(), dataSize);
+
+  std::error_code ec;
+  std::filesystem::create_directories(mPath.parent_path(), ec);
+
+  // Write to a temporary file and rename it over the old one, so a crash mid-write never leaves a torn cache.
+  std::filesystem::path tempPath = mPath;
+  tempPath += ".tmp";
+
+  {
+    std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+      LogWarning("Renderer - Failed to open pipeline cache file for writing: {}", tempPath.string());
+      return false;
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(data.data(), static_cast<std::streamsize>(dataSize));
+
+    if (!file.good()) {
+      LogWarning("Renderer - Failed to write pipeline cache file: {}", tempPath.string());
+      return false;
+    }
+  }
+
+  std::filesystem::rename(tempPath, mPath, ec);
+  if (ec) {
+    LogWarning("Renderer - Failed to replace pipeline cache file: {}", ec.message());
+    return false;
+  }
+
+  LogInfo("Renderer - Saved pipeline cache ({} bytes)", dataSize);
+  return true;
+}
+
+std::vector<char> PipelineCache::LoadFile() const {
+  std::ifstream file(mPath, std::ios::binary | std::ios::ate);
+  if (!file.is_open()) {
+    return {};
+  }
+
+  size_t fileSize = (size_t)file.tellg();
+  if (fileSize < sizeof(FileHeader)) {
+    LogWarning("Renderer - Discarding truncated pipeline cache");
+    return {};
+  }
+
+  FileHeader header{};
+  file.seekg(0);
+  file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+  if (header.magic != FileMagic || header.version != FileVersion
+      || header.dataSize != fileSize - sizeof(FileHeader)) {
+    LogWarning("Renderer - Discarding pipeline cache with mismatching file header");
+    return {};
+  }
+
+  std::vector<char> blob(header.dataSize);
+  file.read(blob.data(), static_cast<std::streamsize>(blob.size()));
+
+  if (!file.good() || HashBytes(blob.data(), blob.size()) != header.dataHash) {
+    LogWarning("Renderer - Discarding corrupted pipeline cache");
+    return {};
+  }
+
+  if (!ValidateBlob(blob)) {
+    LogWarning("Renderer - Discarding pipeline cache written by a different device or driver");
+    return {};
+  }
+
+  return blob;
+}
+
+bool PipelineCache::ValidateBlob(const std::vector<char>& blob) const {
+  VkPipelineCacheHeaderVersionOne header{};
+  if (blob.size() < sizeof(header)) {
+    return false;
+  }
+
+  std::memcpy(&header, blob.data(), sizeof(header));
+
+  return header.headerSize >= sizeof(header) && header.headerSize <= blob.size()
+    && header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+    && header.vendorID == mDeviceProperties.vendorID && header.deviceID == mDeviceProperties.deviceID
+    && std::memcmp(header.pipelineCacheUUID, mDeviceProperties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+} // namespace qpl
@@ -0,0 +1,66 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#ifndef QPL_PIPELINE_CACHE_HPP
+#define QPL_PIPELINE_CACHE_HPP
+
+#include <vector>
+#include <filesystem>
+
+#include <vulkan/vulkan.h>
+#include <core/core.hpp>
+
+namespace qpl {
+
+//
+// ---- Pipeline Cache --------------------------------
+//
+// Owns a VkPipelineCache that is seeded from disk when created and written back when destroyed. Cache files are
+// named after the vendor and device ID of the GPU, and the blob's header is checked against the running driver's
+// pipelineCacheUUID before it is handed to Vulkan, so a cache written by another GPU or driver version is discarded
+// instead of being trusted.
+//
+class PipelineCache final {
+public:
+  void Init(VkDevice device, VkPhysicalDevice physicalDevice, const std::filesystem::path& directory);
+  void Destroy();
+
+  // Writes the cache to disk. Returns false if the data could not be retrieved or written.
+  bool Save();
+
+  QPL_INLINE VkPipelineCache GetHandle() const {
+    return mCache;
+  }
+
+  // True if valid cache data was found on disk, i.e. pipeline creation is expected to be warm.
+  QPL_INLINE bool IsWarm() const {
+    return mLoadedFromDisk;
+  }
+
+private:
+  std::vector<char> LoadFile() const;
+  bool ValidateBlob(const std::vector<char>& blob) const;
+
+private:
+  // Prepended to the driver's blob so truncated or corrupted files can be told apart from valid ones.
+  struct FileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t dataSize;
+    uint64_t dataHash;
+  };
+
+  static constexpr uint32_t FileMagic = 0x43504C51; // "QPLC"
+  static constexpr uint32_t FileVersion = 1;
+
+  VkDevice mDevice = VK_NULL_HANDLE;
+  VkPipelineCache mCache = VK_NULL_HANDLE;
+  VkPhysicalDeviceProperties mDeviceProperties{};
+  std::filesystem::path mPath;
+  bool mLoadedFromDisk = false;
+};
+
+} // namespace qpl
+
+#endif
@@ -0,0 +1,399 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#include "pipeline-registry.hpp"
+
+#include <array>
+#include <chrono>
+#include <algorithm>
+
+namespace qpl {
+
+void PipelineRegistry::Init(
+  VkDevice device,
+  VkPipelineCache pipelineCache,
+  bool warmCache,
+  VkFormat defaultColorFormat,
+  VkFormat depthFormat,
+  std::span<const VkDescriptorSetLayout> setLayouts,
+  ShaderLibrary& shaderLibrary,
+  uint32_t workerCount
+) {
+  LogInfo("Renderer - Creating PipelineRegistry ({} compile threads)", workerCount);
+
+  mDevice = device;
+  mPipelineCache = pipelineCache;
+  mWarmCache = warmCache;
+  mDefaultColorFormat = defaultColorFormat;
+  mDepthFormat = depthFormat;
+  mSetLayoutCount = static_cast<uint32_t>(setLayouts.size());
+  mShaderLibrary = &shaderLibrary;
+
+  CreatePipelineLayout(setLayouts);
+
+  for (uint32_t i = 0; i < workerCount; i++) {
+    mWorkers.emplace_back([this](std::stop_token stopToken) { WorkerMain(stopToken); });
+  }
+}
+
+void PipelineRegistry::Destroy() {
+  {
+    std::lock_guard lock(mQueueMutex);
+    mQueue.clear();
+  }
+
+  // Joining wakes every worker; each one finishes the pipeline it is compiling (if any) before exiting.
+  mWorkers.clear();
+
+  for (const auto& entry : mEntries) {
+    if (VkPipeline pipeline = entry->pipeline.load(); pipeline != VK_NULL_HANDLE) {
+      vkDestroyPipeline(mDevice, pipeline, nullptr);
+    }
+
+    if (VkPipeline replacement = entry->replacement.load(); replacement != VK_NULL_HANDLE) {
+      vkDestroyPipeline(mDevice, replacement, nullptr);
+    }
+  }
+
+  for (const RetiredPipeline& retired : mRetired) {
+    vkDestroyPipeline(mDevice, retired.pipeline, nullptr);
+  }
+
+  mRetired.clear();
+  mEntries.clear();
+  mLookup.clear();
+
+  vkDestroyPipelineLayout(mDevice, mPipelineLayout, nullptr);
+  mPipelineLayout = VK_NULL_HANDLE;
+}
+
+PipelineHandle PipelineRegistry::SetFallback(const GraphicsPipelineDesc& desc) {
+  if (auto it = mLookup.find(desc); it != mLookup.end() && IsReady(it->second)) {
+    mFallback = it->second;
+    return mFallback;
+  }
+
+  VkPipeline pipeline = CompilePipeline(desc);
+  QPL_CORE_ASSERT(pipeline != VK_NULL_HANDLE && "failed to compile fallback pipeline!");
+
+  auto entry = std::make_unique<Entry>();
+  entry->desc = desc;
+  entry->pipeline = pipeline;
+  entry->state = EntryState::Ready;
+
+  mFallback = static_cast<PipelineHandle>(mEntries.size());
+  mEntries.push_back(std::move(entry));
+  mLookup[desc] = mFallback;
+  return mFallback;
+}
+
+PipelineHandle PipelineRegistry::Request(const GraphicsPipelineDesc& desc) {
+  if (auto it = mLookup.find(desc); it != mLookup.end()) {
+    return it->second;
+  }
+
+  PipelineHandle handle = static_cast<PipelineHandle>(mEntries.size());
+
+  auto& entry = mEntries.emplace_back(std::make_unique<Entry>());
+  entry->desc = desc;
+  mLookup.emplace(desc, handle);
+
+  {
+    std::lock_guard lock(mQueueMutex);
+    mQueue.push_back(entry.get());
+  }
+
+  mQueueCondition.notify_one();
+  return handle;
+}
+
+VkPipeline PipelineRegistry::Get(PipelineHandle handle) const {
+  QPL_CORE_ASSERT(handle < mEntries.size() && "invalid pipeline handle");
+
+  if (VkPipeline pipeline = mEntries[handle]->pipeline.load(std::memory_order_acquire); pipeline != VK_NULL_HANDLE) {
+    return pipeline;
+  }
+
+  QPL_CORE_ASSERT(mFallback != InvalidPipelineHandle && "pipeline requested before a fallback was set");
+  return mEntries[mFallback]->pipeline.load(std::memory_order_relaxed);
+}
+
+bool PipelineRegistry::IsReady(PipelineHandle handle) const {
+  return handle < mEntries.size() && mEntries[handle]->state.load(std::memory_order_acquire) == EntryState::Ready;
+}
+
+void PipelineRegistry::ReloadShaders(std::span<const std::string> shaders) {
+  uint32_t queued = 0;
+
+  {
+    std::lock_guard lock(mQueueMutex);
+
+    for (const auto& entry : mEntries) {
+      bool affected = std::any_of(shaders.begin(), shaders.end(), [&](const std::string& shader) {
+        return entry->desc.vertexShader == shader || entry->desc.fragmentShader == shader;
+      });
+
+      // Pending entries are still queued and will pick up the new shader anyway.
+      if (affected && entry->state.load(std::memory_order_acquire) != EntryState::Pending) {
+        mQueue.push_back(entry.get());
+        queued++;
+      }
+    }
+  }
+
+  if (queued > 0) {
+    LogInfo("Renderer - Recompiling {} pipelines after a shader reload", queued);
+    mQueueCondition.notify_all();
+  }
+}
+
+void PipelineRegistry::Update(GpuTimeline& timeline) {
+  if (mReplacementCount.load(std::memory_order_acquire) > 0) {
+    for (const auto& entry : mEntries) {
+      VkPipeline replacement = entry->replacement.exchange(VK_NULL_HANDLE, std::memory_order_acq_rel);
+
+      if (replacement == VK_NULL_HANDLE) {
+        continue;
+      }
+
+      mReplacementCount.fetch_sub(1, std::memory_order_relaxed);
+
+      // The frame being recorded signals the value after the last submitted one, and may already use the old pipeline.
+      VkPipeline previous = entry->pipeline.exchange(replacement, std::memory_order_acq_rel);
+      mRetired.push_back({previous, timeline.GetLastSubmitted() + 1});
+    }
+  }
+
+  while (!mRetired.empty() && timeline.IsComplete(mRetired.front().lastUsedValue)) {
+    vkDestroyPipeline(mDevice, mRetired.front().pipeline, nullptr);
+    mRetired.pop_front();
+  }
+}
+
+void PipelineRegistry::CreatePipelineLayout(std::span<const VkDescriptorSetLayout> setLayouts) {
+  VkPushConstantRange pushConstantRange{};
+  pushConstantRange.stageFlags = VK_SHADER_STAGE_ALL_GRAPHICS;
+  pushConstantRange.size = PushConstantSize;
+
+  VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+  pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+  pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+  pipelineLayoutInfo.pSetLayouts = setLayouts.data();
+  pipelineLayoutInfo.pushConstantRangeCount = 1;
+  pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+  if (vkCreatePipelineLayout(mDevice, &pipelineLayoutInfo, nullptr, &mPipelineLayout) != VK_SUCCESS) {
+    QPL_CORE_ASSERT(false && "failed to create pipeline layout!");
+  }
+}
+
+bool PipelineRegistry::ValidateShader(const ShaderRef& shader, const std::string& name) const {
+  if (shader == nullptr) {
+    return false;
+  }
+
+  const ShaderReflection& reflection = shader->reflection;
+
+  if (reflection.pushConstantSize > PushConstantSize) {
+    LogError(
+      "Renderer - {} uses {} bytes of push constants, more than the {} available",
+      name,
+      reflection.pushConstantSize,
+      PushConstantSize
+    );
+    return false;
+  }
+
+  for (const ShaderBinding& binding : reflection.bindings) {
+    if (binding.set >= mSetLayoutCount) {
+      LogError("Renderer - {} uses descriptor set {}, which the pipeline layout does not have", name, binding.set);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+VkPipeline PipelineRegistry::CompilePipeline(const GraphicsPipelineDesc& desc) {
+  QPL_PROFILE_ZONE("PipelineRegistry::CompilePipeline");
+
+  // Held until the pipeline is created; a reload in the meantime does not pull the modules out from under it.
+  ShaderRef vertShader = mShaderLibrary->Load(desc.vertexShader);
+  ShaderRef fragShader = mShaderLibrary->Load(desc.fragmentShader);
+
+  if (!ValidateShader(vertShader, desc.vertexShader) || !ValidateShader(fragShader, desc.fragmentShader)) {
+    return VK_NULL_HANDLE;
+  }
+
+  VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
+  vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
+  vertShaderStageInfo.module = vertShader->module;
+  vertShaderStageInfo.pName = "main";
+
+  VkPipelineShaderStageCreateInfo fragShaderStageInfo{};
+  fragShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+  fragShaderStageInfo.module = fragShader->module;
+  fragShaderStageInfo.pName = "main";
+
+  VkPipelineShaderStageCreateInfo shaderStages[] = {vertShaderStageInfo, fragShaderStageInfo};
+
+  VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+  vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+  vertexInputInfo.vertexBindingDescriptionCount = 0;
+  vertexInputInfo.vertexAttributeDescriptionCount = 0;
+
+  VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+  inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+  inputAssembly.topology = desc.topology;
+  inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+  VkPipelineViewportStateCreateInfo viewportState{};
+  viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+  viewportState.viewportCount = 1;
+  viewportState.scissorCount = 1;
+
+  VkPipelineRasterizationStateCreateInfo rasterizer{};
+  rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+  rasterizer.depthClampEnable = VK_FALSE;
+  rasterizer.rasterizerDiscardEnable = VK_FALSE;
+  rasterizer.polygonMode = desc.polygonMode;
+  rasterizer.lineWidth = 1.0f;
+  rasterizer.cullMode = desc.cullMode;
+  rasterizer.frontFace = desc.frontFace;
+  rasterizer.depthBiasEnable = VK_FALSE;
+
+  VkPipelineMultisampleStateCreateInfo multisampling{};
+  multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+  multisampling.sampleShadingEnable = VK_FALSE;
+  multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+  VkPipelineDepthStencilStateCreateInfo depthStencil{};
+  depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+  depthStencil.depthTestEnable = desc.depthTest ? VK_TRUE : VK_FALSE;
+  depthStencil.depthWriteEnable = desc.depthWrite ? VK_TRUE : VK_FALSE;
+  depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
+
+  VkPipelineColorBlendAttachmentState colorBlendAttachment{};
+  colorBlendAttachment.colorWriteMask =
+    VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+  colorBlendAttachment.blendEnable = desc.blendEnable ? VK_TRUE : VK_FALSE;
+  colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+  colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+  colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+  colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+  colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+  colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+
+  VkPipelineColorBlendStateCreateInfo colorBlending{};
+  colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+  colorBlending.logicOpEnable = VK_FALSE;
+  colorBlending.logicOp = VK_LOGIC_OP_COPY;
+  colorBlending.attachmentCount = 1;
+  colorBlending.pAttachments = &colorBlendAttachment;
+
+  std::array<VkDynamicState, 2> dynamicStates = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+  VkPipelineDynamicStateCreateInfo dynamicState{};
+  dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+  dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
+  dynamicState.pDynamicStates = dynamicStates.data();
+
+  VkFormat colorFormat = desc.colorFormat != VK_FORMAT_UNDEFINED ? desc.colorFormat : mDefaultColorFormat;
+
+  VkPipelineRenderingCreateInfo renderingInfo{};
+  renderingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+  renderingInfo.colorAttachmentCount = 1;
+  renderingInfo.pColorAttachmentFormats = &colorFormat;
+  // Declared even when depth testing is off, so the pipeline can be used inside any pass with the depth attachment.
+  renderingInfo.depthAttachmentFormat = mDepthFormat;
+
+  VkGraphicsPipelineCreateInfo pipelineInfo{};
+  pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+  pipelineInfo.pNext = &renderingInfo;
+  pipelineInfo.stageCount = 2;
+  pipelineInfo.pStages = shaderStages;
+  pipelineInfo.pVertexInputState = &vertexInputInfo;
+  pipelineInfo.pInputAssemblyState = &inputAssembly;
+  pipelineInfo.pViewportState = &viewportState;
+  pipelineInfo.pRasterizationState = &rasterizer;
+  pipelineInfo.pMultisampleState = &multisampling;
+  pipelineInfo.pDepthStencilState = &depthStencil;
+  pipelineInfo.pColorBlendState = &colorBlending;
+  pipelineInfo.pDynamicState = &dynamicState;
+  pipelineInfo.layout = mPipelineLayout;
+  pipelineInfo.renderPass = VK_NULL_HANDLE;
+  pipelineInfo.subpass = 0;
+  pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
+  pipelineInfo.basePipelineIndex = -1;              // Optional
+
+  // The pipeline cache is internally synchronized, so every worker can compile against it at once.
+  VkPipeline pipeline = VK_NULL_HANDLE;
+  auto startTime = std::chrono::steady_clock::now();
+
+  if (vkCreateGraphicsPipelines(mDevice, mPipelineCache, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS) {
+    LogError("Failed to compile pipeline ({}, {})", desc.vertexShader, desc.fragmentShader);
+    pipeline = VK_NULL_HANDLE;
+  }
+
+  double creationTimeMs =
+    std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+  LogInfo(
+    "Renderer - Compiled pipeline {:016x} in {:.3f} ms with a {} cache ({}, {})",
+    desc.Hash(),
+    creationTimeMs,
+    mWarmCache ? "warm" : "cold",
+    desc.vertexShader,
+    desc.fragmentShader
+  );
+
+  return pipeline;
+}
+
+void PipelineRegistry::WorkerMain(std::stop_token stopToken) {
+  QPL_PROFILE_THREAD("pipeline-compiler");
+
+  while (true) {
+    Entry* entry = nullptr;
+
+    {
+      std::unique_lock lock(mQueueMutex);
+      if (!mQueueCondition.wait(lock, stopToken, [this] { return !mQueue.empty(); })) {
+        return;
+      }
+
+      entry = mQueue.front();
+      mQueue.pop_front();
+    }
+
+    VkPipeline pipeline = CompilePipeline(entry->desc);
+
+    // A reload of an entry already drawing is handed to Update(); the render thread may be using the old pipeline.
+    if (entry->pipeline.load(std::memory_order_acquire) != VK_NULL_HANDLE) {
+      if (pipeline == VK_NULL_HANDLE) {
+        continue;
+      }
+
+      // A replacement nobody has swapped in yet was never used, so a newer one can simply take its place.
+      VkPipeline stale = entry->replacement.exchange(pipeline, std::memory_order_acq_rel);
+
+      if (stale != VK_NULL_HANDLE) {
+        vkDestroyPipeline(mDevice, stale, nullptr);
+      }
+      else {
+        mReplacementCount.fetch_add(1, std::memory_order_release);
+      }
+
+      continue;
+    }
+
+    entry->pipeline.store(pipeline, std::memory_order_release);
+    entry->state.store(
+      pipeline != VK_NULL_HANDLE ? EntryState::Ready : EntryState::Failed, std::memory_order_release
+    );
+  }
+}
+
+} // namespace qpl
@@ -0,0 +1,198 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#ifndef QPL_PIPELINE_REGISTRY_HPP
+#define QPL_PIPELINE_REGISTRY_HPP
+
+#include <span>
+#include <mutex>
+#include <deque>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <filesystem>
+#include <unordered_map>
+#include <condition_variable>
+
+#include <vulkan/vulkan.h>
+#include <core/core.hpp>
+#include "gpu-timeline.hpp"
+#include "shader-library.hpp"
+
+namespace qpl {
+
+//
+// ---- Graphics Pipeline Description ---------------------------------
+//
+// The subset of graphics pipeline state that actually varies between materials. Everything else (viewport and
+// scissor as dynamic state, single-sample rasterization, one color attachment and the registry's depth attachment) is
+// fixed by the registry. Pipelines are built for dynamic rendering, so they only depend on attachment formats, not on
+// a VkRenderPass.
+//
+struct GraphicsPipelineDesc {
+  // SPIR-V file names, loaded through the registry's shader library.
+  std::string vertexShader;
+  std::string fragmentShader;
+
+  VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+  VkPolygonMode polygonMode = VK_POLYGON_MODE_FILL;
+  VkCullModeFlags cullMode = VK_CULL_MODE_BACK_BIT;
+  VkFrontFace frontFace = VK_FRONT_FACE_CLOCKWISE;
+  bool blendEnable = false;
+
+  // Depth test against the depth attachment with VK_COMPARE_OP_LESS, and whether passing fragments write it.
+  bool depthTest = false;
+  bool depthWrite = false;
+
+  // Format of the color attachment rendered to. VK_FORMAT_UNDEFINED uses the registry's default (the swap chain's).
+  VkFormat colorFormat = VK_FORMAT_UNDEFINED;
+
+  bool operator==(const GraphicsPipelineDesc&) const = default;
+
+  QPL_INLINE uint64_t Hash() const {
+    uint64_t hash = HashString(vertexShader);
+    hash = HashCombine(hash, HashString(fragmentShader));
+    hash = HashCombine(hash, (uint64_t)topology);
+    hash = HashCombine(hash, (uint64_t)polygonMode);
+    hash = HashCombine(hash, (uint64_t)cullMode);
+    hash = HashCombine(hash, (uint64_t)frontFace);
+    hash = HashCombine(hash, (uint64_t)blendEnable);
+    hash = HashCombine(hash, (uint64_t)depthTest);
+    hash = HashCombine(hash, (uint64_t)depthWrite);
+    hash = HashCombine(hash, (uint64_t)colorFormat);
+    return hash;
+  }
+};
+
+struct GraphicsPipelineDescHasher {
+  QPL_INLINE size_t operator()(const GraphicsPipelineDesc& desc) const {
+    return (size_t)desc.Hash();
+  }
+};
+
+// Index of a pipeline inside a PipelineRegistry. Stable for the lifetime of the registry.
+using PipelineHandle = uint32_t;
+
+QPL_INLINE_CONSTEXPR PipelineHandle InvalidPipelineHandle = UINT32_MAX;
+
+//
+// ---- Pipeline Registry ---------------------------------
+//
+// Deduplicates graphics pipelines by their description and compiles new ones on worker threads. Until a pipeline
+// has finished compiling, Get() returns the fallback pipeline, so requesting a new material never blocks the frame.
+//
+// Every pipeline shares one layout: the descriptor set layouts passed to Init(), and PushConstantSize bytes of push
+// constants visible to all graphics stages. Shaders are checked against it through their reflection before compiling,
+// so a shader that expects another layout fails to compile instead of misbehaving on the GPU.
+//
+// ReloadShaders() recompiles only the pipelines using the given shaders. They keep drawing with their old pipeline
+// until the new one is ready, and Update() swaps it in between frames; a reload that fails to compile leaves the old
+// pipeline in place.
+//
+// Get() and IsReady() only read the entry table, so draw tasks on job system workers may call them at the same time
+// as each other. Everything that changes the table or swaps pipelines - SetFallback(), Request(), ReloadShaders() and
+// Update() - belongs to the render thread between frames, and must never overlap a CommandRecorder::Record() whose
+// tasks look pipelines up. Compile threads never touch the table either; they only publish the finished VkPipeline
+// into its entry.
+//
+class PipelineRegistry final {
+public:
+  // The minimum every implementation supports.
+  static constexpr uint32_t PushConstantSize = 128;
+
+  void Init(
+    VkDevice device,
+    VkPipelineCache pipelineCache,
+    bool warmCache,
+    VkFormat defaultColorFormat,
+    VkFormat depthFormat,
+    std::span<const VkDescriptorSetLayout> setLayouts,
+    ShaderLibrary& shaderLibrary,
+    uint32_t workerCount
+  );
+  void Destroy();
+
+  // Compiles `desc` synchronously and makes it the pipeline returned for entries that are not ready yet.
+  PipelineHandle SetFallback(const GraphicsPipelineDesc& desc);
+
+  // Returns the handle for `desc`, queueing it for compilation the first time it is seen.
+  PipelineHandle Request(const GraphicsPipelineDesc& desc);
+
+  // Returns the compiled pipeline, or the fallback while it is still compiling (or failed to compile).
+  VkPipeline Get(PipelineHandle handle) const;
+
+  bool IsReady(PipelineHandle handle) const;
+
+  // Queues every pipeline using one of `shaders` for recompilation. Render thread only.
+  void ReloadShaders(std::span<const std::string> shaders);
+
+  // Swaps in recompiled pipelines and destroys the ones they replaced once `timeline` shows the GPU is done with
+  // them. Called once per frame, before recording starts, never while draw tasks may call Get().
+  void Update(GpuTimeline& timeline);
+
+  QPL_INLINE VkPipelineLayout GetLayout() const {
+    return mPipelineLayout;
+  }
+
+  QPL_INLINE size_t GetPipelineCount() const {
+    return mEntries.size();
+  }
+
+private:
+  enum class EntryState : uint8_t {
+    Pending,
+    Ready,
+    Failed,
+  };
+
+  struct Entry {
+    GraphicsPipelineDesc desc;
+    std::atomic<VkPipeline> pipeline = VK_NULL_HANDLE;
+    std::atomic<EntryState> state = EntryState::Pending;
+    // Recompiled pipeline waiting for Update() to swap it in.
+    std::atomic<VkPipeline> replacement = VK_NULL_HANDLE;
+  };
+
+  struct RetiredPipeline {
+    VkPipeline pipeline;
+    uint64_t lastUsedValue;
+  };
+
+  void CreatePipelineLayout(std::span<const VkDescriptorSetLayout> setLayouts);
+  bool ValidateShader(const ShaderRef& shader, const std::string& name) const;
+  VkPipeline CompilePipeline(const GraphicsPipelineDesc& desc);
+  void WorkerMain(std::stop_token stopToken);
+
+private:
+  VkDevice mDevice = VK_NULL_HANDLE;
+  VkPipelineCache mPipelineCache = VK_NULL_HANDLE;
+  // Whether the cache was seeded from disk; logged with every compile time.
+  bool mWarmCache = false;
+  VkFormat mDefaultColorFormat = VK_FORMAT_UNDEFINED;
+  VkFormat mDepthFormat = VK_FORMAT_UNDEFINED;
+  VkPipelineLayout mPipelineLayout = VK_NULL_HANDLE;
+  uint32_t mSetLayoutCount = 0;
+  ShaderLibrary* mShaderLibrary = nullptr;
+
+  // Entries are heap-allocated so workers can hold on to them while the table grows.
+  std::vector<std::unique_ptr<Entry>> mEntries;
+  std::unordered_map<GraphicsPipelineDesc, PipelineHandle, GraphicsPipelineDescHasher> mLookup;
+  PipelineHandle mFallback = InvalidPipelineHandle;
+
+  // Compile queue shared with the worker threads.
+  std::mutex mQueueMutex;
+  std::condition_variable_any mQueueCondition;
+  std::deque<Entry*> mQueue;
+  std::vector<std::jthread> mWorkers;
+
+  // Replacements published by workers and not yet swapped in.
+  std::atomic<uint32_t> mReplacementCount = 0;
+  std::deque<RetiredPipeline> mRetired;
+};
+
+} // namespace qpl
+
+#endif
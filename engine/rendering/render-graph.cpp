@@ -0,0 +1,819 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#include "render-graph.hpp"
+
+#include <array>
+#include <algorithm>
+
+#include <magic_enum/magic_enum.hpp>
+
+namespace qpl {
+
+QPL_INLINE static VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+static VkImageAspectFlags GetAspectMask(VkFormat format) {
+  switch (format) {
+  case VK_FORMAT_D16_UNORM:
+  case VK_FORMAT_X8_D24_UNORM_PACK32:
+  case VK_FORMAT_D32_SFLOAT:
+    return VK_IMAGE_ASPECT_DEPTH_BIT;
+  case VK_FORMAT_D16_UNORM_S8_UINT:
+  case VK_FORMAT_D24_UNORM_S8_UINT:
+  case VK_FORMAT_D32_SFLOAT_S8_UINT:
+    return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+  case VK_FORMAT_S8_UINT:
+    return VK_IMAGE_ASPECT_STENCIL_BIT;
+  default:
+    return VK_IMAGE_ASPECT_COLOR_BIT;
+  }
+}
+
+RenderAccessInfo GetRenderAccessInfo(RenderAccess access) {
+  switch (access) {
+  case RenderAccess::ColorAttachment:
+    return {
+      VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+      VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+      VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+      VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+      true,
+    };
+  case RenderAccess::DepthAttachment:
+    return {
+      VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+      VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+      VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+      VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+      true,
+    };
+  case RenderAccess::DepthRead:
+    return {
+      VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT
+        | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+      VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+      VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+      VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+      false,
+    };
+  case RenderAccess::SampledFragment:
+    return {
+      VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+      VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+      VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+      VK_IMAGE_USAGE_SAMPLED_BIT,
+      false,
+    };
+  case RenderAccess::SampledCompute:
+    return {
+      VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+      VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+      VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+      VK_IMAGE_USAGE_SAMPLED_BIT,
+      false,
+    };
+  case RenderAccess::StorageReadCompute:
+    return {
+      VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+      VK_ACCESS_2_SHADER_STORAGE_READ_BIT,
+      VK_IMAGE_LAYOUT_GENERAL,
+      VK_IMAGE_USAGE_STORAGE_BIT,
+      false,
+    };
+  case RenderAccess::StorageWriteCompute:
+    return {
+      VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+      VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+      VK_IMAGE_LAYOUT_GENERAL,
+      VK_IMAGE_USAGE_STORAGE_BIT,
+      true,
+    };
+  case RenderAccess::TransferSrc:
+    return {
+      VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+      VK_ACCESS_2_TRANSFER_READ_BIT,
+      VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+      VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+      false,
+    };
+  case RenderAccess::TransferDst:
+    return {
+      VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+      VK_ACCESS_2_TRANSFER_WRITE_BIT,
+      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+      VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+      true,
+    };
+  }
+
+  QPL_CORE_ASSERT(false && "unknown render access");
+  return {};
+}
+
+//
+// ---- Render Pass Builder ---------------------------------
+//
+
+RenderPassBuilder& RenderPassBuilder::Read(RenderResource resource, RenderAccess access) {
+  QPL_CORE_ASSERT(resource < mGraph.mResources.size() && "invalid render resource");
+  QPL_CORE_ASSERT(!GetRenderAccessInfo(access).write && "Read() called with a write access");
+
+  mGraph.mPasses[mPass].accesses.push_back({resource, access});
+  return *this;
+}
+
+RenderPassBuilder& RenderPassBuilder::Write(RenderResource resource, RenderAccess access) {
+  QPL_CORE_ASSERT(resource < mGraph.mResources.size() && "invalid render resource");
+  QPL_CORE_ASSERT(GetRenderAccessInfo(access).write && "Write() called with a read access");
+
+  mGraph.mPasses[mPass].accesses.push_back({resource, access});
+  return *this;
+}
+
+RenderPassBuilder& RenderPassBuilder::ColorAttachment(
+  RenderResource resource, VkAttachmentLoadOp loadOp, VkClearColorValue clear
+) {
+  Write(resource, RenderAccess::ColorAttachment);
+
+  RenderGraph::Attachment& attachment = mGraph.mPasses[mPass].colorAttachments.emplace_back();
+  attachment.resource = resource;
+  attachment.loadOp = loadOp;
+  attachment.clearValue.color = clear;
+  return *this;
+}
+
+RenderPassBuilder& RenderPassBuilder::DepthAttachment(
+  RenderResource resource, VkAttachmentLoadOp loadOp, float clearDepth
+) {
+  Write(resource, RenderAccess::DepthAttachment);
+
+  RenderGraph::Attachment& attachment = mGraph.mPasses[mPass].depthAttachment.emplace();
+  attachment.resource = resource;
+  attachment.loadOp = loadOp;
+  attachment.clearValue.depthStencil = {clearDepth, 0};
+  return *this;
+}
+
+RenderPassBuilder& RenderPassBuilder::SecondaryContents() {
+  mGraph.mPasses[mPass].secondaryContents = true;
+  return *this;
+}
+
+RenderPassBuilder& RenderPassBuilder::SideEffects() {
+  mGraph.mPasses[mPass].sideEffects = true;
+  return *this;
+}
+
+RenderPassBuilder& RenderPassBuilder::Execute(RenderPassFn execute) {
+  mGraph.mPasses[mPass].execute = std::move(execute);
+  return *this;
+}
+
+//
+// ---- Render Graph ---------------------------------
+//
+
+void RenderGraph::Init(VkDevice device, GpuAllocator& allocator, GpuTimeline& timeline) {
+  mDevice = device;
+  mAllocator = &allocator;
+  mTimeline = &timeline;
+}
+
+void RenderGraph::Destroy() {
+  // Callers idle the device first.
+  for (TransientSet& set : mRetiredSets) {
+    DestroyTransientSet(set);
+  }
+
+  mRetiredSets.clear();
+  DestroyTransientSet(mCurrentSet);
+  mCurrentSet = {};
+
+  Reset();
+  mRequirementCache.clear();
+}
+
+void RenderGraph::Reset() {
+  mResources.clear();
+  mPasses.clear();
+  mExecutionOrder.clear();
+  mBarriers.clear();
+  mHeaps.clear();
+  mTransients.clear();
+  mFinalBarrierBegin = 0;
+  mFinalBarrierCount = 0;
+  mStats = {};
+}
+
+RenderResource RenderGraph::CreateTexture(std::string name, const RenderTextureDesc& desc) {
+  ResourceNode& resource = mResources.emplace_back();
+  resource.name = std::move(name);
+  resource.desc = desc;
+  return static_cast<RenderResource>(mResources.size() - 1);
+}
+
+RenderResource RenderGraph::ImportTexture(
+  std::string name,
+  VkImage image,
+  VkImageView view,
+  const RenderTextureDesc& desc,
+  VkImageLayout initialLayout,
+  VkImageLayout finalLayout
+) {
+  ResourceNode& resource = mResources.emplace_back();
+  resource.name = std::move(name);
+  resource.desc = desc;
+  resource.imported = true;
+  resource.image = image;
+  resource.view = view;
+  resource.initialLayout = initialLayout;
+  resource.finalLayout = finalLayout;
+  return static_cast<RenderResource>(mResources.size() - 1);
+}
+
+RenderPassBuilder RenderGraph::AddPass(std::string name) {
+  PassNode& pass = mPasses.emplace_back();
+  pass.name = std::move(name);
+  return RenderPassBuilder(*this, static_cast<uint32_t>(mPasses.size() - 1));
+}
+
+void RenderGraph::Compile() {
+  QPL_PROFILE_ZONE("RenderGraph::Compile");
+
+  CullPasses();
+  ComputeLifetimes();
+  PackTransients();
+  PlanBarriers();
+}
+
+void RenderGraph::CullPasses() {
+  for (ResourceNode& resource : mResources) {
+    resource.needed = resource.imported && resource.finalLayout != VK_IMAGE_LAYOUT_UNDEFINED;
+  }
+
+  // Walk backwards from the outputs: a pass survives if something after it needs one of the textures it writes.
+  // A later pass that overwrites a texture completely still keeps earlier writers alive, which is conservative but
+  // never wrong.
+  for (size_t i = mPasses.size(); i-- > 0;) {
+    PassNode& pass = mPasses[i];
+    bool keep = pass.sideEffects;
+
+    for (size_t j = 0; !keep && j < pass.accesses.size(); j++) {
+      const PassAccess& access = pass.accesses[j];
+      keep = GetRenderAccessInfo(access.access).write && mResources[access.resource].needed;
+    }
+
+    pass.culled = !keep;
+
+    if (!keep) {
+      continue;
+    }
+
+    for (const PassAccess& access : pass.accesses) {
+      if (!GetRenderAccessInfo(access.access).write) {
+        mResources[access.resource].needed = true;
+      }
+    }
+
+    for (const Attachment& attachment : pass.colorAttachments) {
+      if (attachment.loadOp == VK_ATTACHMENT_LOAD_OP_LOAD) {
+        mResources[attachment.resource].needed = true;
+      }
+    }
+
+    if (pass.depthAttachment && pass.depthAttachment->loadOp == VK_ATTACHMENT_LOAD_OP_LOAD) {
+      mResources[pass.depthAttachment->resource].needed = true;
+    }
+  }
+
+  mStats.passCount = static_cast<uint32_t>(mPasses.size());
+
+  for (uint32_t i = 0; i < mPasses.size(); i++) {
+    if (mPasses[i].culled) {
+      mStats.culledPassCount++;
+    }
+    else {
+      mExecutionOrder.push_back(i);
+    }
+  }
+}
+
+void RenderGraph::ComputeLifetimes() {
+  PlannedBarrier unused;
+
+  for (uint32_t order = 0; order < mExecutionOrder.size(); order++) {
+    for (const PassAccess& access : mPasses[mExecutionOrder[order]].accesses) {
+      ResourceNode& resource = mResources[access.resource];
+      RenderAccessInfo info = GetRenderAccessInfo(access.access);
+
+      resource.firstPass = std::min(resource.firstPass, order);
+      resource.lastPass = order;
+      resource.usage |= info.usage;
+
+      // Dry run of the barrier planner; only the state the texture is left in matters here.
+      Transition(resource.finalState, info, unused);
+    }
+  }
+}
+
+VkImageCreateInfo RenderGraph::MakeImageInfo(const ResourceNode& resource) const {
+  VkImageCreateInfo imageInfo{};
+  imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+  imageInfo.imageType = VK_IMAGE_TYPE_2D;
+  imageInfo.format = resource.desc.format;
+  imageInfo.extent = {resource.desc.extent.width, resource.desc.extent.height, 1};
+  imageInfo.mipLevels = resource.desc.mipLevels;
+  imageInfo.arrayLayers = 1;
+  imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+  imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+  imageInfo.usage = resource.usage;
+  imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  return imageInfo;
+}
+
+VkMemoryRequirements RenderGraph::QueryRequirements(const ResourceNode& resource) {
+  uint64_t key = HashCombine((uint64_t)resource.desc.format, (uint64_t)resource.desc.extent.width);
+  key = HashCombine(key, (uint64_t)resource.desc.extent.height);
+  key = HashCombine(key, (uint64_t)resource.desc.mipLevels);
+  key = HashCombine(key, (uint64_t)resource.usage);
+
+  if (auto it = mRequirementCache.find(key); it != mRequirementCache.end()) {
+    return it->second;
+  }
+
+  VkImageCreateInfo imageInfo = MakeImageInfo(resource);
+
+  VkDeviceImageMemoryRequirements requirementsInfo{};
+  requirementsInfo.sType = VK_STRUCTURE_TYPE_DEVICE_IMAGE_MEMORY_REQUIREMENTS;
+  requirementsInfo.pCreateInfo = &imageInfo;
+
+  VkMemoryRequirements2 requirements{};
+  requirements.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+  vkGetDeviceImageMemoryRequirements(mDevice, &requirementsInfo, &requirements);
+
+  mRequirementCache.emplace(key, requirements.memoryRequirements);
+  return requirements.memoryRequirements;
+}
+
+void RenderGraph::PackTransients() {
+  for (RenderResource i = 0; i < mResources.size(); i++) {
+    ResourceNode& resource = mResources[i];
+
+    if (resource.imported || resource.firstPass == UINT32_MAX) {
+      continue;
+    }
+
+    resource.requirements = QueryRequirements(resource);
+    resource.physicalIndex = static_cast<uint32_t>(mTransients.size());
+    mTransients.push_back(i);
+
+    mStats.transientTextureCount++;
+    mStats.transientBytes += resource.requirements.size;
+  }
+
+  // Largest first, so the big targets claim the bottom of each heap and the small ones fill the gaps.
+  std::vector<RenderResource> sorted = mTransients;
+  std::stable_sort(sorted.begin(), sorted.end(), [this](RenderResource a, RenderResource b) {
+    return mResources[a].requirements.size > mResources[b].requirements.size;
+  });
+
+  std::vector<std::vector<RenderResource>> placed;
+
+  for (RenderResource index : sorted) {
+    ResourceNode& resource = mResources[index];
+    const VkMemoryRequirements& requirements = resource.requirements;
+
+    // Only textures that agree on the memory types they accept can share a heap.
+    uint32_t heap = 0;
+    while (heap < mHeaps.size() && mHeaps[heap].memoryTypeBits != requirements.memoryTypeBits) {
+      heap++;
+    }
+
+    if (heap == mHeaps.size()) {
+      mHeaps.push_back({requirements.memoryTypeBits, 0, 1});
+      placed.emplace_back();
+    }
+
+    // Bump the offset past every already placed texture that is alive at the same time and in the way, until it
+    // fits. Textures whose lifetimes do not overlap are free to share bytes.
+    VkDeviceSize offset = 0;
+    bool moved = true;
+
+    while (moved) {
+      moved = false;
+
+      for (RenderResource otherIndex : placed[heap]) {
+        const ResourceNode& other = mResources[otherIndex];
+
+        bool livesOverlap = resource.firstPass <= other.lastPass && other.firstPass <= resource.lastPass;
+        bool rangesOverlap =
+          offset < other.heapOffset + other.requirements.size && other.heapOffset < offset + requirements.size;
+
+        if (livesOverlap && rangesOverlap) {
+          offset = AlignUp(other.heapOffset + other.requirements.size, requirements.alignment);
+          moved = true;
+        }
+      }
+    }
+
+    resource.heap = heap;
+    resource.heapOffset = offset;
+    placed[heap].push_back(index);
+
+    mHeaps[heap].size = std::max(mHeaps[heap].size, offset + requirements.size);
+    mHeaps[heap].alignment = std::max(mHeaps[heap].alignment, requirements.alignment);
+  }
+
+  for (const TransientHeap& heap : mHeaps) {
+    mStats.transientHeapBytes += heap.size;
+  }
+}
+
+bool RenderGraph::Transition(AccessState& state, const RenderAccessInfo& info, PlannedBarrier& barrier) {
+  // Reads of the same layout can run concurrently. Later writers have to wait for all of them, so their stages
+  // accumulate into the state.
+  if (state.layout == info.layout && !state.written && !info.write) {
+    state.stages |= info.stages;
+    state.access |= info.access;
+    return false;
+  }
+
+  barrier.srcStages = state.stages;
+  // Write-after-read only needs an execution dependency; anything after a write also needs its memory made available.
+  barrier.srcAccess = state.written ? state.access : VK_ACCESS_2_NONE;
+  barrier.dstStages = info.stages;
+  barrier.dstAccess = info.access;
+  barrier.oldLayout = state.layout;
+  barrier.newLayout = info.layout;
+
+  state.layout = info.layout;
+  state.stages = info.stages;
+  state.access = info.access;
+  state.written = info.write;
+  return true;
+}
+
+void RenderGraph::PlanBarriers() {
+  std::vector<AccessState> states(mResources.size());
+  std::vector<bool> touched(mResources.size(), false);
+
+  for (RenderResource i = 0; i < mResources.size(); i++) {
+    ResourceNode& resource = mResources[i];
+    AccessState& state = states[i];
+
+    if (resource.imported) {
+      state.layout = resource.initialLayout;
+      continue;
+    }
+
+    if (resource.heap == UINT32_MAX) {
+      continue;
+    }
+
+    // The first use of a transient has to wait for whatever touched its memory last, which is either a texture it
+    // aliases earlier in this frame or any of them (itself included) in the previous frame. Pipeline barriers also
+    // order against earlier submissions on the queue, so waiting on all of them covers both cases.
+    state.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    state.written = true;
+
+    for (RenderResource otherIndex : mTransients) {
+      const ResourceNode& other = mResources[otherIndex];
+
+      bool rangesOverlap = other.heap == resource.heap && resource.heapOffset < other.heapOffset + other.requirements.size
+        && other.heapOffset < resource.heapOffset + resource.requirements.size;
+
+      if (rangesOverlap) {
+        state.stages |= other.finalState.stages;
+        state.access |= other.finalState.written ? other.finalState.access : VK_ACCESS_2_NONE;
+      }
+    }
+  }
+
+  for (uint32_t passIndex : mExecutionOrder) {
+    PassNode& pass = mPasses[passIndex];
+    pass.barrierBegin = static_cast<uint32_t>(mBarriers.size());
+
+    for (const PassAccess& access : pass.accesses) {
+      AccessState& state = states[access.resource];
+      RenderAccessInfo info = GetRenderAccessInfo(access.access);
+
+      // Imported textures arrive from outside the graph; chaining their first barrier to the stages that use them
+      // picks up whatever semaphore wait the submit uses for them.
+      if (mResources[access.resource].imported && !touched[access.resource]) {
+        state.stages = info.stages;
+      }
+
+      touched[access.resource] = true;
+
+      PlannedBarrier barrier{};
+      barrier.resource = access.resource;
+
+      if (Transition(state, info, barrier)) {
+        mBarriers.push_back(barrier);
+      }
+    }
+
+    pass.barrierCount = static_cast<uint32_t>(mBarriers.size()) - pass.barrierBegin;
+
+    if (pass.barrierCount > 0) {
+      mStats.barrierBatchCount++;
+    }
+  }
+
+  mFinalBarrierBegin = static_cast<uint32_t>(mBarriers.size());
+
+  for (RenderResource i = 0; i < mResources.size(); i++) {
+    const ResourceNode& resource = mResources[i];
+    const AccessState& state = states[i];
+
+    if (!resource.imported || resource.finalLayout == VK_IMAGE_LAYOUT_UNDEFINED || state.layout == resource.finalLayout) {
+      continue;
+    }
+
+    PlannedBarrier barrier{};
+    barrier.resource = i;
+    barrier.srcStages = state.stages;
+    barrier.srcAccess = state.written ? state.access : VK_ACCESS_2_NONE;
+    // Whoever consumes the texture next synchronizes with the end of the submission (e.g. through a semaphore).
+    barrier.dstStages = VK_PIPELINE_STAGE_2_NONE;
+    barrier.dstAccess = VK_ACCESS_2_NONE;
+    barrier.oldLayout = state.layout;
+    barrier.newLayout = resource.finalLayout;
+    mBarriers.push_back(barrier);
+  }
+
+  mFinalBarrierCount = static_cast<uint32_t>(mBarriers.size()) - mFinalBarrierBegin;
+
+  if (mFinalBarrierCount > 0) {
+    mStats.barrierBatchCount++;
+  }
+
+  mStats.imageBarrierCount = static_cast<uint32_t>(mBarriers.size());
+}
+
+uint64_t RenderGraph::ComputeLayoutHash() const {
+  uint64_t hash = HashCombine(0, mHeaps.size());
+
+  for (const TransientHeap& heap : mHeaps) {
+    hash = HashCombine(hash, heap.memoryTypeBits);
+    hash = HashCombine(hash, heap.size);
+  }
+
+  for (RenderResource index : mTransients) {
+    const ResourceNode& resource = mResources[index];
+    hash = HashCombine(hash, (uint64_t)resource.desc.format);
+    hash = HashCombine(hash, resource.desc.extent.width);
+    hash = HashCombine(hash, resource.desc.extent.height);
+    hash = HashCombine(hash, resource.desc.mipLevels);
+    hash = HashCombine(hash, resource.usage);
+    hash = HashCombine(hash, resource.heap);
+    hash = HashCombine(hash, resource.heapOffset);
+  }
+
+  return hash;
+}
+
+void RenderGraph::PrepareTransients() {
+  while (!mRetiredSets.empty() && mTimeline->IsComplete(mRetiredSets.front().lastUsedValue)) {
+    DestroyTransientSet(mRetiredSets.front());
+    mRetiredSets.pop_front();
+  }
+
+  uint64_t layoutHash = ComputeLayoutHash();
+
+  if (layoutHash != mCurrentSet.layoutHash) {
+    // Frames still in flight may be using the old textures; every one of them has already been submitted.
+    if (!mCurrentSet.heaps.empty()) {
+      mCurrentSet.lastUsedValue = mTimeline->GetLastSubmitted();
+      mRetiredSets.push_back(std::move(mCurrentSet));
+    }
+
+    mCurrentSet = {};
+    mCurrentSet.layoutHash = layoutHash;
+    CreateTransientSet(mCurrentSet);
+  }
+
+  for (RenderResource index : mTransients) {
+    ResourceNode& resource = mResources[index];
+    resource.image = mCurrentSet.images[resource.physicalIndex];
+    resource.view = mCurrentSet.views[resource.physicalIndex];
+  }
+}
+
+void RenderGraph::CreateTransientSet(TransientSet& set) {
+  if (!mTransients.empty()) {
+    LogInfo(
+      "Renderer - Allocating {} transient textures in {} bytes ({} bytes without aliasing)",
+      mStats.transientTextureCount,
+      mStats.transientHeapBytes,
+      mStats.transientBytes
+    );
+  }
+
+  for (const TransientHeap& heap : mHeaps) {
+    VkMemoryRequirements requirements{};
+    requirements.size = heap.size;
+    requirements.alignment = heap.alignment;
+    requirements.memoryTypeBits = heap.memoryTypeBits;
+
+    GpuAllocation allocation =
+      mAllocator->Allocate(requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, GpuResourceKind::Optimal);
+    QPL_CORE_ASSERT(allocation.IsValid() && "failed to allocate transient texture memory!");
+
+    set.heaps.push_back(allocation);
+  }
+
+  for (RenderResource index : mTransients) {
+    const ResourceNode& resource = mResources[index];
+    VkImageCreateInfo imageInfo = MakeImageInfo(resource);
+
+    VkImage image = VK_NULL_HANDLE;
+    if (VkResult code = vkCreateImage(mDevice, &imageInfo, nullptr, &image); code != VK_SUCCESS) {
+      LogError("vkCreateImage failed with code {}", magic_enum::enum_name(code));
+      QPL_CORE_ASSERT(false && "failed to create transient texture!");
+    }
+
+    const GpuAllocation& heap = set.heaps[resource.heap];
+    vkBindImageMemory(mDevice, image, heap.memory, heap.offset + resource.heapOffset);
+
+    VkImageViewCreateInfo viewInfo{};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = image;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = resource.desc.format;
+    viewInfo.subresourceRange.aspectMask = GetAspectMask(resource.desc.format);
+    viewInfo.subresourceRange.levelCount = resource.desc.mipLevels;
+    viewInfo.subresourceRange.layerCount = 1;
+
+    VkImageView view = VK_NULL_HANDLE;
+    if (vkCreateImageView(mDevice, &viewInfo, nullptr, &view) != VK_SUCCESS) {
+      QPL_CORE_ASSERT(false && "failed to create transient texture view!");
+    }
+
+    set.images.push_back(image);
+    set.views.push_back(view);
+  }
+}
+
+void RenderGraph::DestroyTransientSet(TransientSet& set) {
+  for (VkImageView view : set.views) {
+    vkDestroyImageView(mDevice, view, nullptr);
+  }
+
+  for (VkImage image : set.images) {
+    vkDestroyImage(mDevice, image, nullptr);
+  }
+
+  for (GpuAllocation& heap : set.heaps) {
+    mAllocator->Free(heap);
+  }
+
+  set.views.clear();
+  set.images.clear();
+  set.heaps.clear();
+}
+
+void RenderGraph::RecordBarriers(VkCommandBuffer commandBuffer, uint32_t begin, uint32_t count) {
+  if (count == 0) {
+    return;
+  }
+
+  mBarrierScratch.clear();
+
+  for (uint32_t i = begin; i < begin + count; i++) {
+    const PlannedBarrier& planned = mBarriers[i];
+    const ResourceNode& resource = mResources[planned.resource];
+
+    VkImageMemoryBarrier2& barrier = mBarrierScratch.emplace_back();
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+    barrier.srcStageMask = planned.srcStages;
+    barrier.srcAccessMask = planned.srcAccess;
+    barrier.dstStageMask = planned.dstStages;
+    barrier.dstAccessMask = planned.dstAccess;
+    barrier.oldLayout = planned.oldLayout;
+    barrier.newLayout = planned.newLayout;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = resource.image;
+    barrier.subresourceRange.aspectMask = GetAspectMask(resource.desc.format);
+    barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+    barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+  }
+
+  VkDependencyInfo dependencyInfo{};
+  dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+  dependencyInfo.imageMemoryBarrierCount = static_cast<uint32_t>(mBarrierScratch.size());
+  dependencyInfo.pImageMemoryBarriers = mBarrierScratch.data();
+
+  vkCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+}
+
+void RenderGraph::Execute(VkCommandBuffer commandBuffer) {
+  QPL_PROFILE_ZONE("RenderGraph::Execute");
+
+  PrepareTransients();
+
+  for (uint32_t passIndex : mExecutionOrder) {
+    const PassNode& pass = mPasses[passIndex];
+
+    GpuScope scope =
+      mProfiler ? mProfiler->BeginScope(commandBuffer, pass.name, !pass.secondaryContents) : InvalidGpuScope;
+
+    RecordBarriers(commandBuffer, pass.barrierBegin, pass.barrierCount);
+
+    RenderPassContext context{};
+    context.commandBuffer = commandBuffer;
+
+    bool rendering = !pass.colorAttachments.empty() || pass.depthAttachment.has_value();
+
+    std::array<VkRenderingAttachmentInfo, 8> colorInfos{};
+    std::array<VkFormat, 8> colorFormats{};
+    VkRenderingAttachmentInfo depthInfo{};
+    VkCommandBufferInheritanceRenderingInfo inheritanceRenderingInfo{};
+    VkCommandBufferInheritanceInfo inheritanceInfo{};
+
+    if (rendering) {
+      QPL_CORE_ASSERT(pass.colorAttachments.size() <= colorInfos.size() && "too many color attachments");
+
+      for (size_t i = 0; i < pass.colorAttachments.size(); i++) {
+        const Attachment& attachment = pass.colorAttachments[i];
+        const ResourceNode& resource = mResources[attachment.resource];
+
+        colorInfos[i].sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+        colorInfos[i].imageView = resource.view;
+        colorInfos[i].imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        colorInfos[i].loadOp = attachment.loadOp;
+        colorInfos[i].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        colorInfos[i].clearValue = attachment.clearValue;
+        colorFormats[i] = resource.desc.format;
+        context.renderArea = resource.desc.extent;
+      }
+
+      if (pass.depthAttachment) {
+        const ResourceNode& resource = mResources[pass.depthAttachment->resource];
+
+        depthInfo.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+        depthInfo.imageView = resource.view;
+        depthInfo.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        depthInfo.loadOp = pass.depthAttachment->loadOp;
+        depthInfo.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        depthInfo.clearValue = pass.depthAttachment->clearValue;
+        context.renderArea = resource.desc.extent;
+      }
+
+      VkRenderingInfo renderingInfo{};
+      renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+      renderingInfo.flags = pass.secondaryContents ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT : 0;
+      renderingInfo.renderArea = {{0, 0}, context.renderArea};
+      renderingInfo.layerCount = 1;
+      renderingInfo.colorAttachmentCount = static_cast<uint32_t>(pass.colorAttachments.size());
+      renderingInfo.pColorAttachments = colorInfos.data();
+      renderingInfo.pDepthAttachment = pass.depthAttachment ? &depthInfo : nullptr;
+
+      vkCmdBeginRendering(commandBuffer, &renderingInfo);
+
+      if (pass.secondaryContents) {
+        inheritanceRenderingInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO;
+        inheritanceRenderingInfo.colorAttachmentCount = renderingInfo.colorAttachmentCount;
+        inheritanceRenderingInfo.pColorAttachmentFormats = colorFormats.data();
+        inheritanceRenderingInfo.depthAttachmentFormat =
+          pass.depthAttachment ? mResources[pass.depthAttachment->resource].desc.format : VK_FORMAT_UNDEFINED;
+        inheritanceRenderingInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+        inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritanceInfo.pNext = &inheritanceRenderingInfo;
+        context.inheritanceInfo = &inheritanceInfo;
+      }
+    }
+
+    if (pass.execute) {
+      pass.execute(context);
+    }
+
+    if (rendering) {
+      vkCmdEndRendering(commandBuffer);
+    }
+
+    if (mProfiler) {
+      mProfiler->EndScope(commandBuffer, scope);
+    }
+  }
+
+  RecordBarriers(commandBuffer, mFinalBarrierBegin, mFinalBarrierCount);
+}
+
+VkImage RenderGraph::GetImage(RenderResource resource) const {
+  QPL_CORE_ASSERT(resource < mResources.size() && "invalid render resource");
+  return mResources[resource].image;
+}
+
+VkImageView RenderGraph::GetImageView(RenderResource resource) const {
+  QPL_CORE_ASSERT(resource < mResources.size() && "invalid render resource");
+  return mResources[resource].view;
+}
+
+} // namespace qpl
@@ -0,0 +1,313 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#ifndef QPL_RENDER_GRAPH_HPP
+#define QPL_RENDER_GRAPH_HPP
+
+#include <deque>
+#include <string>
+#include <vector>
+#include <optional>
+#include <functional>
+#include <unordered_map>
+
+#include <vulkan/vulkan.h>
+#include <core/core.hpp>
+#include "gpu-allocator.hpp"
+#include "gpu-timeline.hpp"
+#include "gpu-profiler.hpp"
+
+namespace qpl {
+
+// Index of a texture inside a RenderGraph. Only valid until the next RenderGraph::Reset().
+using RenderResource = uint32_t;
+
+QPL_INLINE_CONSTEXPR RenderResource InvalidRenderResource = UINT32_MAX;
+
+// How a pass uses a texture. Every access maps to a fixed layout, set of pipeline stages and access flags, which is
+// all the graph needs to derive barriers.
+enum class RenderAccess : uint8_t {
+  ColorAttachment,
+  DepthAttachment,
+  DepthRead,
+  SampledFragment,
+  SampledCompute,
+  StorageReadCompute,
+  StorageWriteCompute,
+  TransferSrc,
+  TransferDst,
+};
+
+struct RenderAccessInfo {
+  VkPipelineStageFlags2 stages = VK_PIPELINE_STAGE_2_NONE;
+  VkAccessFlags2 access = VK_ACCESS_2_NONE;
+  VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+  VkImageUsageFlags usage = 0;
+  bool write = false;
+};
+
+RenderAccessInfo GetRenderAccessInfo(RenderAccess access);
+
+struct RenderTextureDesc {
+  VkFormat format = VK_FORMAT_UNDEFINED;
+  VkExtent2D extent{};
+  uint32_t mipLevels = 1;
+};
+
+//
+// ---- Render Graph Stats ---------------------------------
+//
+struct RenderGraphStats {
+  uint32_t passCount = 0;
+  uint32_t culledPassCount = 0;
+
+  // vkCmdPipelineBarrier2 calls, and the image barriers batched into them.
+  uint32_t barrierBatchCount = 0;
+  uint32_t imageBarrierCount = 0;
+
+  uint32_t transientTextureCount = 0;
+  // Memory the transient textures would need with one allocation each.
+  VkDeviceSize transientBytes = 0;
+  // Memory they actually occupy once textures with disjoint lifetimes share it.
+  VkDeviceSize transientHeapBytes = 0;
+};
+
+struct RenderPassContext {
+  VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+  VkExtent2D renderArea{};
+
+  // Set for passes declared with SecondaryContents(): the inheritance info secondaries executed inside the pass's
+  // rendering scope must be begun with.
+  const VkCommandBufferInheritanceInfo* inheritanceInfo = nullptr;
+};
+
+using RenderPassFn = std::function<void(const RenderPassContext& context)>;
+
+class RenderGraph;
+
+//
+// ---- Render Pass Builder ---------------------------------
+//
+// Declares what a single pass reads and writes. Returned by RenderGraph::AddPass().
+//
+class RenderPassBuilder final {
+public:
+  RenderPassBuilder& Read(RenderResource resource, RenderAccess access);
+  RenderPassBuilder& Write(RenderResource resource, RenderAccess access);
+
+  // Attachments are bound with dynamic rendering for the duration of the pass. LOAD counts as a read of the
+  // previous contents.
+  RenderPassBuilder& ColorAttachment(
+    RenderResource resource, VkAttachmentLoadOp loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR, VkClearColorValue clear = {}
+  );
+  RenderPassBuilder& DepthAttachment(
+    RenderResource resource, VkAttachmentLoadOp loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR, float clearDepth = 1.0f
+  );
+
+  // The pass body only executes secondary command buffers.
+  RenderPassBuilder& SecondaryContents();
+
+  // The pass does something observable outside of the graph (readback, queries...) and is never culled.
+  RenderPassBuilder& SideEffects();
+
+  RenderPassBuilder& Execute(RenderPassFn execute);
+
+private:
+  friend class RenderGraph;
+
+  QPL_INLINE RenderPassBuilder(RenderGraph& graph, uint32_t pass)
+    : mGraph(graph),
+      mPass(pass) {}
+
+private:
+  RenderGraph& mGraph;
+  uint32_t mPass;
+};
+
+//
+// ---- Render Graph ---------------------------------
+//
+// Frame graph rebuilt every frame: passes declare the textures they read and write, and the graph works out the rest.
+//
+// Compile() culls passes whose outputs never reach an imported texture (or a pass with side effects), derives every
+// layout transition and memory dependency, batched into a single vkCmdPipelineBarrier2 per pass boundary, and packs
+// transient textures with non-overlapping lifetimes into the same memory. Execute() then records the frame, binding
+// attachments with dynamic rendering.
+//
+// Transient textures are only reallocated when the packed layout changes; the old ones are kept alive until the
+// graphics timeline shows the last frame that used them has completed.
+//
+class RenderGraph final {
+public:
+  void Init(VkDevice device, GpuAllocator& allocator, GpuTimeline& timeline);
+  void Destroy();
+
+  // Starts describing a new frame. Handles from the previous frame become invalid.
+  void Reset();
+
+  // A texture owned by the graph. It only exists between its first and last use within the frame, and its contents
+  // are undefined on first use.
+  RenderResource CreateTexture(std::string name, const RenderTextureDesc& desc);
+
+  // A texture owned by someone else. The graph transitions it out of `initialLayout` on first use and into
+  // `finalLayout` at the end of the frame. Imported textures with a final layout are what keeps passes alive.
+  RenderResource ImportTexture(
+    std::string name,
+    VkImage image,
+    VkImageView view,
+    const RenderTextureDesc& desc,
+    VkImageLayout initialLayout,
+    VkImageLayout finalLayout
+  );
+
+  RenderPassBuilder AddPass(std::string name);
+
+  // Culls passes, plans barriers and packs transient memory. Does not record anything or allocate memory.
+  void Compile();
+
+  // Records the compiled frame into `commandBuffer`.
+  void Execute(VkCommandBuffer commandBuffer);
+
+  // Wraps every executed pass, barriers included, in a profiler scope named after it. Passes that record into
+  // secondaries only get timestamps, as a statistics query cannot stay open across vkCmdExecuteCommands.
+  QPL_INLINE void SetProfiler(GpuProfiler* profiler) {
+    mProfiler = profiler;
+  }
+
+  // Only valid during Execute() for transient textures.
+  VkImage GetImage(RenderResource resource) const;
+  VkImageView GetImageView(RenderResource resource) const;
+
+  QPL_INLINE const RenderGraphStats& GetStats() const {
+    return mStats;
+  }
+
+private:
+  friend class RenderPassBuilder;
+
+  struct AccessState {
+    VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkPipelineStageFlags2 stages = VK_PIPELINE_STAGE_2_NONE;
+    VkAccessFlags2 access = VK_ACCESS_2_NONE;
+    // Whether the last access was a write, i.e. whether the next one needs a memory dependency.
+    bool written = false;
+  };
+
+  struct ResourceNode {
+    std::string name;
+    RenderTextureDesc desc;
+    bool imported = false;
+    VkImage image = VK_NULL_HANDLE;
+    VkImageView view = VK_NULL_HANDLE;
+    VkImageLayout initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkImageLayout finalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    // Filled in by Compile().
+    bool needed = false;
+    uint32_t firstPass = UINT32_MAX;
+    uint32_t lastPass = 0;
+    VkImageUsageFlags usage = 0;
+    AccessState finalState;
+    VkMemoryRequirements requirements{};
+    uint32_t heap = UINT32_MAX;
+    VkDeviceSize heapOffset = 0;
+    uint32_t physicalIndex = UINT32_MAX;
+  };
+
+  struct PassAccess {
+    RenderResource resource;
+    RenderAccess access;
+  };
+
+  struct Attachment {
+    RenderResource resource = InvalidRenderResource;
+    VkAttachmentLoadOp loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    VkClearValue clearValue{};
+  };
+
+  struct PassNode {
+    std::string name;
+    std::vector<PassAccess> accesses;
+    std::vector<Attachment> colorAttachments;
+    std::optional<Attachment> depthAttachment;
+    RenderPassFn execute;
+    bool sideEffects = false;
+    bool secondaryContents = false;
+
+    // Filled in by Compile().
+    bool culled = false;
+    uint32_t barrierBegin = 0;
+    uint32_t barrierCount = 0;
+  };
+
+  struct PlannedBarrier {
+    RenderResource resource;
+    VkPipelineStageFlags2 srcStages;
+    VkAccessFlags2 srcAccess;
+    VkPipelineStageFlags2 dstStages;
+    VkAccessFlags2 dstAccess;
+    VkImageLayout oldLayout;
+    VkImageLayout newLayout;
+  };
+
+  struct TransientHeap {
+    uint32_t memoryTypeBits = 0;
+    VkDeviceSize size = 0;
+    VkDeviceSize alignment = 1;
+  };
+
+  // The memory and images backing one particular packing of the transient textures.
+  struct TransientSet {
+    uint64_t layoutHash = 0;
+    std::vector<GpuAllocation> heaps;
+    std::vector<VkImage> images;
+    std::vector<VkImageView> views;
+    uint64_t lastUsedValue = 0;
+  };
+
+  void CullPasses();
+  void ComputeLifetimes();
+  void PackTransients();
+  void PlanBarriers();
+
+  static bool Transition(AccessState& state, const RenderAccessInfo& info, PlannedBarrier& barrier);
+
+  VkMemoryRequirements QueryRequirements(const ResourceNode& resource);
+  VkImageCreateInfo MakeImageInfo(const ResourceNode& resource) const;
+  uint64_t ComputeLayoutHash() const;
+
+  void PrepareTransients();
+  void CreateTransientSet(TransientSet& set);
+  void DestroyTransientSet(TransientSet& set);
+  void RecordBarriers(VkCommandBuffer commandBuffer, uint32_t begin, uint32_t count);
+
+private:
+  VkDevice mDevice = VK_NULL_HANDLE;
+  GpuAllocator* mAllocator = nullptr;
+  GpuTimeline* mTimeline = nullptr;
+  GpuProfiler* mProfiler = nullptr;
+
+  std::vector<ResourceNode> mResources;
+  std::vector<PassNode> mPasses;
+
+  // Compile() output.
+  std::vector<uint32_t> mExecutionOrder;
+  std::vector<PlannedBarrier> mBarriers;
+  uint32_t mFinalBarrierBegin = 0;
+  uint32_t mFinalBarrierCount = 0;
+  std::vector<TransientHeap> mHeaps;
+  std::vector<RenderResource> mTransients;
+  RenderGraphStats mStats;
+
+  // Image memory requirements only depend on the create info, so they are queried once per distinct texture.
+  std::unordered_map<uint64_t, VkMemoryRequirements> mRequirementCache;
+
+  TransientSet mCurrentSet;
+  std::deque<TransientSet> mRetiredSets;
+  std::vector<VkImageMemoryBarrier2> mBarrierScratch;
+};
+
+} // namespace qpl
+
+#endif
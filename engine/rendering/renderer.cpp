@@ -4,6 +4,9 @@
 
 #include "renderer.hpp"
 
+#include <cmath>
+#include <fstream>
+
 namespace qpl {
 
 static VKAPI_ATTR VkBool32 VKAPI_CALL DebugCallback(
@@ -13,7 +16,7 @@ static VKAPI_ATTR VkBool32 VKAPI_CALL DebugCallback(
   [[maybe_unused]] void* pUserData
 ) {
 
-  LogError(std::format("Validation layer: {}", pCallbackData->pMessage));
+  LogError("Validation layer: {}", pCallbackData->pMessage);
   return VK_FALSE;
 }
 
@@ -41,43 +44,106 @@ void DestroyDebugUtilsMessengerEXT(
   }
 }
 
-Renderer::Renderer(WindowContext& windowContext)
-  : mWindow(windowContext) {
+Renderer::Renderer(WindowContext& windowContext, JobSystem& jobSystem, const RendererConfig& config)
+  : mWindow(windowContext),
+    mJobSystem(jobSystem),
+    mConfig(config),
+    mHeadless(windowContext.IsHeadless()) {
+  QPL_CORE_ASSERT(mConfig.framesInFlight > 0 && "framesInFlight must be at least 1");
+
   CreateInstance();
   CreateDebugMessenger();
   CreateSurface();
   ChoosePhysicalDevice();
   CreateLogicalDevice();
-  CreateSwapChain();
+  mGpuAllocator.Init(mPhysicalDevice, mDevice);
+  mPipelineCache.Init(mDevice, mPhysicalDevice, mConfig.pipelineCacheDirectory);
+
+  if (mHeadless) {
+    CreateOffscreenTargets();
+  }
+  else {
+    // Constructed on the main thread, so the window can still be asked directly; later sizes come from
+    // OnWindowResized().
+    int width, height;
+    SDL_GetWindowSizeInPixels(mWindow.GetSDLWindow(), &width, &height);
+    mWindowWidth = static_cast<uint32_t>(width);
+    mWindowHeight = static_cast<uint32_t>(height);
+
+    CreateSwapChain();
+  }
+
   CreateImageViews();
-  CreateRenderPass();
-  CreateGraphicsPipeline();
-  CreateFrameBuffers();
+  CreateUploadRing();
+  CreateAssetStreamer();
+  CreateShaderLibrary();
+  CreateBindlessHeap();
+  CreateTextureStreamer();
+  CreateGpuScene();
+  CreatePipelineRegistry();
   CreateCommandPool();
-  CreateCommandBuffer();
+  CreateCommandBuffers();
+  CreateReadbackBuffers();
+  CreateSyncObjects();
+  CreateCommandRecorder();
+  CreateRenderGraph();
+  CreateGpuProfiler();
+  CreateDemoScene();
+
+  if (mConfig.framePacing == FramePacing::TargetFps && mConfig.targetFps <= 0.0) {
+    LogWarning("Renderer - TargetFps pacing without a targetFps, frames are uncapped");
+  }
+
+  mFramePacer.Init(mConfig.framePacing == FramePacing::Uncapped ? 0.0 : mConfig.targetFps);
 }
 
 Renderer::~Renderer() {
-  vkDestroySemaphore(mDevice, mImageAvailableSemaphore, nullptr);
-  vkDestroySemaphore(mDevice, mRenderFinishedSemaphore, nullptr);
-  vkDestroyFence(mDevice, mInFlightFence, nullptr);
-  vkDestroyCommandPool(mDevice, mCommandPool, nullptr);
+  for (FrameData& frame : mFrames) {
+    vkDestroySemaphore(mDevice, frame.imageAvailableSemaphore, nullptr);
+
+    if (frame.readbackBuffer.buffer != VK_NULL_HANDLE) {
+      mGpuAllocator.DestroyBuffer(frame.readbackBuffer);
+    }
+  }
 
-  for (auto framebuffer : mSwapChainFramebuffers) {
-    vkDestroyFramebuffer(mDevice, framebuffer, nullptr);
+  for (auto semaphore : mRenderFinishedSemaphores) {
+    vkDestroySemaphore(mDevice, semaphore, nullptr);
   }
 
-  vkDestroyPipeline(mDevice, mGraphicsPipeline, nullptr);
-  vkDestroyPipelineLayout(mDevice, mPipelineLayout, nullptr);
-  vkDestroyRenderPass(mDevice, mRenderPass, nullptr);
+  ReleaseRetiredSwapChains(/*force=*/true);
+  mTextureStreamer.Destroy();
+  mAssetStreamer.Destroy();
+  mUploadRing.Destroy();
+  mGpuScene.Destroy();
+  mBindlessHeap.Destroy();
+  mRenderGraph.Destroy();
+  mGpuProfiler.Destroy();
+  mCommandRecorder.Destroy();
+  mGraphicsTimeline.Destroy();
+
+  vkDestroyCommandPool(mDevice, mCommandPool, nullptr);
+  mPipelineRegistry.Destroy();
+  mShaderLibrary.Destroy();
 
   for (auto imageView : mSwapChainImageViews) {
     vkDestroyImageView(mDevice, imageView, nullptr);
   }
 
-  vkDestroySwapchainKHR(mDevice, mSwapChain, nullptr);
+  for (GpuImage& image : mOffscreenImages) {
+    mGpuAllocator.DestroyImage(image);
+  }
+
+  if (!mHeadless) {
+    vkDestroySwapchainKHR(mDevice, mSwapChain, nullptr);
+  }
+
+  mPipelineCache.Destroy();
+  mGpuAllocator.Destroy();
   vkDestroyDevice(mDevice, nullptr);
-  vkDestroySurfaceKHR(mInstance, mSurface, nullptr);
+
+  if (!mHeadless) {
+    vkDestroySurfaceKHR(mInstance, mSurface, nullptr);
+  }
 
   if (EnableValidationLayers) {
     DestroyDebugUtilsMessengerEXT(mInstance, mDebugMessenger, nullptr);
@@ -94,13 +160,17 @@ void Renderer::CreateInstance() {
   }
 
   std::vector<const char*> extensions;
-  uint32_t sdlExtensionCount = 0;
-  auto sdlExtensions = SDL_Vulkan_GetInstanceExtensions(&sdlExtensionCount);
 
-  QPL_CORE_ASSERT(sdlExtensions != nullptr && "Failed to get SDL_Vulkan extensions");
+  // Headless rendering needs no surface, and therefore no WSI extensions either.
+  if (!mHeadless) {
+    uint32_t sdlExtensionCount = 0;
+    auto sdlExtensions = SDL_Vulkan_GetInstanceExtensions(&sdlExtensionCount);
 
-  for (uint32_t i = 0; i < sdlExtensionCount; ++i) {
-    extensions.push_back(sdlExtensions[i]);
+    QPL_CORE_ASSERT(sdlExtensions != nullptr && "Failed to get SDL_Vulkan extensions");
+
+    for (uint32_t i = 0; i < sdlExtensionCount; ++i) {
+      extensions.push_back(sdlExtensions[i]);
+    }
   }
 
   if (EnableValidationLayers) {
@@ -113,7 +183,7 @@ void Renderer::CreateInstance() {
   appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
   appInfo.pEngineName = "No Engine";
   appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-  appInfo.apiVersion = VK_API_VERSION_1_0;
+  appInfo.apiVersion = VK_API_VERSION_1_3;
 
   VkInstanceCreateInfo createInfo = {};
   createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -140,12 +210,16 @@ void Renderer::CreateInstance() {
   }
 
   if (VkResult code = vkCreateInstance(&createInfo, nullptr, &mInstance); code != VK_SUCCESS) {
-    LogError(std::format("vkCreateInstance failed with code {}", magic_enum::enum_name(code)));
+    LogError("vkCreateInstance failed with code {}", magic_enum::enum_name(code));
     QPL_CORE_ASSERT(false && "Failed to create VkInstance");
   }
 }
 
 void Renderer::CreateSurface() {
+  if (mHeadless) {
+    return;
+  }
+
   LogInfo("Renderer - Creating VkSurface");
 
   if (!SDL_Vulkan_CreateSurface(mWindow.GetSDLWindow(), mInstance, nullptr, &mSurface)) {
@@ -178,7 +252,9 @@ void Renderer::CreateLogicalDevice() {
   QueueFamilyIndices indices = QueryQueueFamilies(mPhysicalDevice);
 
   std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-  std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily.value(), indices.presentFamily.value()};
+  std::set<uint32_t> uniqueQueueFamilies = {
+    indices.graphicsFamily.value(), indices.presentFamily.value(), indices.transferFamily.value()
+  };
 
   float queuePriority = 1.0f;
   for (uint32_t queueFamily : uniqueQueueFamilies) {
@@ -196,26 +272,110 @@ void Renderer::CreateLogicalDevice() {
   queueCreateInfo.queueCount = 1;
   queueCreateInfo.pQueuePriorities = &queuePriority;
 
+  VkPhysicalDeviceFeatures supportedFeatures;
+  vkGetPhysicalDeviceFeatures(mPhysicalDevice, &supportedFeatures);
+
+  // Optional; without it the GPU profiler only measures time.
+  mPipelineStatistics = mConfig.gpuProfiling && supportedFeatures.pipelineStatisticsQuery;
+
   VkPhysicalDeviceFeatures deviceFeatures{};
+  deviceFeatures.pipelineStatisticsQuery = mPipelineStatistics ? VK_TRUE : VK_FALSE;
+
+  // The GPU scene draws every batch with one vkCmdDrawIndexedIndirectCount, and passes the object index as the first
+  // instance.
+  deviceFeatures.multiDrawIndirect = VK_TRUE;
+  deviceFeatures.drawIndirectFirstInstance = VK_TRUE;
+
+  VkPhysicalDeviceVulkan12Features vulkan12Features{};
+  vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+  vulkan12Features.timelineSemaphore = VK_TRUE;
+  vulkan12Features.drawIndirectCount = VK_TRUE;
+
+  // Descriptor indexing for the bindless heap.
+  vulkan12Features.runtimeDescriptorArray = VK_TRUE;
+  vulkan12Features.descriptorBindingPartiallyBound = VK_TRUE;
+  vulkan12Features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+  vulkan12Features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+  vulkan12Features.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+  vulkan12Features.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+  vulkan12Features.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
+
+  // The render graph records its barriers with synchronization2 and binds attachments with dynamic rendering.
+  VkPhysicalDeviceVulkan13Features vulkan13Features{};
+  vulkan13Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+  vulkan13Features.synchronization2 = VK_TRUE;
+  vulkan13Features.dynamicRendering = VK_TRUE;
+  vulkan12Features.pNext = &vulkan13Features;
+
+  std::vector<const char*> extensions;
+
+  if (!mHeadless) {
+    extensions.assign(DeviceExtensions.begin(), DeviceExtensions.end());
+  }
+
+  // Optional; without present wait the frame pacer falls back to the graphics timeline for low-latency pacing, and
+  // latency is measured up to the present call rather than the present itself.
+  VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures{};
+  presentWaitFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+
+  VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures{};
+  presentIdFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+  presentIdFeatures.pNext = &presentWaitFeatures;
+
+  if (!mHeadless && CheckDeviceExtensionSupport(mPhysicalDevice, PresentWaitExtensions)) {
+    VkPhysicalDeviceFeatures2 supported{};
+    supported.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    supported.pNext = &presentIdFeatures;
+    vkGetPhysicalDeviceFeatures2(mPhysicalDevice, &supported);
+
+    mPresentWait = presentIdFeatures.presentId && presentWaitFeatures.presentWait;
+  }
+
+  if (mPresentWait) {
+    extensions.insert(extensions.end(), PresentWaitExtensions.begin(), PresentWaitExtensions.end());
+
+    // Only the two features queried above are left in the chain, so nothing else gets enabled by accident.
+    presentWaitFeatures.pNext = nullptr;
+    vulkan13Features.pNext = &presentIdFeatures;
+  }
+
+  // Optional, and without features to enable; without it the texture streamer keeps to a fixed budget.
+  mMemoryBudget = CheckDeviceExtensionSupport(mPhysicalDevice, MemoryBudgetExtensions);
+
+  if (mMemoryBudget) {
+    extensions.insert(extensions.end(), MemoryBudgetExtensions.begin(), MemoryBudgetExtensions.end());
+  }
+
   VkDeviceCreateInfo createInfo{};
   createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+  createInfo.pNext = &vulkan12Features;
   createInfo.pQueueCreateInfos = &queueCreateInfo;
   createInfo.queueCreateInfoCount = 1;
   createInfo.pEnabledFeatures = &deviceFeatures;
   createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
   createInfo.pQueueCreateInfos = queueCreateInfos.data();
-  createInfo.enabledExtensionCount = static_cast<uint32_t>(DeviceExtensions.size());
-  createInfo.ppEnabledExtensionNames = DeviceExtensions.data();
+  createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+  createInfo.ppEnabledExtensionNames = extensions.data();
 
   if (vkCreateDevice(mPhysicalDevice, &createInfo, nullptr, &mDevice) != VK_SUCCESS) {
     QPL_CORE_ASSERT(false && "failed to create logical mDevice!");
   }
 
+  if (mPresentWait) {
+    // Not exported by the loader; device extension entry points have to be looked up.
+    mWaitForPresent = (PFN_vkWaitForPresentKHR)vkGetDeviceProcAddr(mDevice, "vkWaitForPresentKHR");
+    mPresentWait = mWaitForPresent != nullptr;
+  }
+
+  LogInfo("Renderer - Present wait {}", mPresentWait ? "enabled" : "unavailable");
+  LogInfo("Renderer - Memory budget {}", mMemoryBudget ? "enabled" : "unavailable");
+
   vkGetDeviceQueue(mDevice, indices.graphicsFamily.value(), 0, &mGraphicsQueue);
   vkGetDeviceQueue(mDevice, indices.presentFamily.value(), 0, &mPresentQueue);
+  vkGetDeviceQueue(mDevice, indices.transferFamily.value(), 0, &mTransferQueue);
 }
 
-void Renderer::CreateSwapChain() {
+void Renderer::CreateSwapChain(VkSwapchainKHR oldSwapChain) {
   LogInfo("Renderer - Creating VkSwapChain");
 
   SwapChainSupportDetails swapChainSupport = QuerySwapChainSupport(mPhysicalDevice);
@@ -242,7 +402,7 @@ void Renderer::CreateSwapChain() {
   createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
   createInfo.presentMode = presentMode;
   createInfo.clipped = VK_TRUE;
-  createInfo.oldSwapchain = VK_NULL_HANDLE;
+  createInfo.oldSwapchain = oldSwapChain;
 
   QueueFamilyIndices indices = QueryQueueFamilies(mPhysicalDevice);
   uint32_t queueFamilyIndices[] = {indices.graphicsFamily.value(), indices.presentFamily.value()};
@@ -270,6 +430,66 @@ void Renderer::CreateSwapChain() {
   mSwapChainExtent = extent;
 }
 
+void Renderer::CreateOffscreenTargets() {
+  const WindowConfig& windowConfig = mWindow.GetConfig();
+
+  mSwapChainImageFormat = OffscreenFormat;
+  mSwapChainExtent = {static_cast<uint32_t>(windowConfig.width), static_cast<uint32_t>(windowConfig.height)};
+
+  LogInfo(
+    "Renderer - Creating {} offscreen targets ({}x{})",
+    mConfig.framesInFlight,
+    mSwapChainExtent.width,
+    mSwapChainExtent.height
+  );
+
+  VkImageCreateInfo imageInfo{};
+  imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+  imageInfo.imageType = VK_IMAGE_TYPE_2D;
+  imageInfo.format = mSwapChainImageFormat;
+  imageInfo.extent = {mSwapChainExtent.width, mSwapChainExtent.height, 1};
+  imageInfo.mipLevels = 1;
+  imageInfo.arrayLayers = 1;
+  imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+  imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+  imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+  imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+  // One target per frame in flight, so a frame never draws over an image an earlier one is still being read from.
+  for (uint32_t i = 0; i < mConfig.framesInFlight; i++) {
+    GpuImage& image = mOffscreenImages.emplace_back(
+      mGpuAllocator.CreateImage(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
+    );
+    mSwapChainImages.push_back(image.image);
+  }
+}
+
+void Renderer::CreateReadbackBuffers() {
+  if (!mHeadless || mConfig.readbackInterval == 0) {
+    return;
+  }
+
+  if (!mConfig.readbackDirectory.empty()) {
+    std::error_code error;
+    std::filesystem::create_directories(mConfig.readbackDirectory, error);
+  }
+
+  VkBufferCreateInfo bufferInfo{};
+  bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+  bufferInfo.size = (VkDeviceSize)mSwapChainExtent.width * mSwapChainExtent.height * 4;
+  bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+  bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+  for (FrameData& frame : mFrames) {
+    frame.readbackBuffer = mGpuAllocator.CreateBuffer(
+      bufferInfo, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+    );
+
+    QPL_CORE_ASSERT(frame.readbackBuffer.allocation.mapped != nullptr && "readback memory is not host visible!");
+  }
+}
+
 void Renderer::CreateImageViews() {
   LogInfo("Renderer - Creating VkImageView");
 
@@ -299,174 +519,40 @@ void Renderer::CreateImageViews() {
   }
 }
 
-void Renderer::CreateRenderPass() {
-  LogInfo("Renderer - Creating VkRenderPass");
-
-  VkAttachmentDescription colorAttachment{};
-  colorAttachment.format = mSwapChainImageFormat;
-  colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-  colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-  colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-  colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-  colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-  colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-  colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-  VkAttachmentReference colorAttachmentRef{};
-  colorAttachmentRef.attachment = 0;
-  colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-  VkSubpassDescription subpass{};
-  subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-  subpass.colorAttachmentCount = 1;
-  subpass.pColorAttachments = &colorAttachmentRef;
-
-  VkRenderPassCreateInfo renderPassInfo{};
-  renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-  renderPassInfo.attachmentCount = 1;
-  renderPassInfo.pAttachments = &colorAttachment;
-  renderPassInfo.subpassCount = 1;
-  renderPassInfo.pSubpasses = &subpass;
-
-  if (vkCreateRenderPass(mDevice, &renderPassInfo, nullptr, &mRenderPass) != VK_SUCCESS) {
-    QPL_CORE_ASSERT(false && "failed to create render pass!");
-  }
-}
-
-void Renderer::CreateGraphicsPipeline() {
-#define __DIR__ (std::filesystem::path(__FILE__).parent_path())
-
-  LogInfo("Renderer - Creating VkGraphicsPipeline");
-
-  // TODO: BIG WARNING! THIS SHIT WILL BREAK IF YOU ARE NOT IN THE BUILD DIRECTORY!!!!!!!!!!!!!!!!
-  auto vertShaderCode = LoadShader((__DIR__ / "shaders" / "vert.spv").string());
-  auto fragShaderCode = LoadShader((__DIR__ / "shaders" / "frag.spv").string());
-
-  VkShaderModule vertShaderModule = CreateShaderModule(vertShaderCode);
-  VkShaderModule fragShaderModule = CreateShaderModule(fragShaderCode);
-
-  VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
-  vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-  vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
-  vertShaderStageInfo.module = vertShaderModule;
-  vertShaderStageInfo.pName = "main";
-
-  VkPipelineShaderStageCreateInfo fragShaderStageInfo{};
-  fragShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-  fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-  fragShaderStageInfo.module = fragShaderModule;
-  fragShaderStageInfo.pName = "main";
-
-  [[maybe_unused]]
-  VkPipelineShaderStageCreateInfo shaderStages[] = {vertShaderStageInfo, fragShaderStageInfo};
-
-  VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
-  vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-  vertexInputInfo.vertexBindingDescriptionCount = 0;
-  vertexInputInfo.vertexAttributeDescriptionCount = 0;
-
-  VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
-  inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-  inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-  inputAssembly.primitiveRestartEnable = VK_FALSE;
-
-  VkPipelineViewportStateCreateInfo viewportState{};
-  viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-  viewportState.viewportCount = 1;
-  viewportState.scissorCount = 1;
-
-  VkPipelineRasterizationStateCreateInfo rasterizer{};
-  rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-  rasterizer.depthClampEnable = VK_FALSE;
-  rasterizer.rasterizerDiscardEnable = VK_FALSE;
-  rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
-  rasterizer.lineWidth = 1.0f;
-  rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
-  rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE;
-  rasterizer.depthBiasEnable = VK_FALSE;
-
-  VkPipelineMultisampleStateCreateInfo multisampling{};
-  multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-  multisampling.sampleShadingEnable = VK_FALSE;
-  multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-
-  VkPipelineColorBlendAttachmentState colorBlendAttachment{};
-  colorBlendAttachment.colorWriteMask =
-    VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-  colorBlendAttachment.blendEnable = VK_FALSE;
-
-  VkPipelineColorBlendStateCreateInfo colorBlending{};
-  colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-  colorBlending.logicOpEnable = VK_FALSE;
-  colorBlending.logicOp = VK_LOGIC_OP_COPY;
-  colorBlending.attachmentCount = 1;
-  colorBlending.pAttachments = &colorBlendAttachment;
-  colorBlending.blendConstants[0] = 0.0f;
-  colorBlending.blendConstants[1] = 0.0f;
-  colorBlending.blendConstants[2] = 0.0f;
-  colorBlending.blendConstants[3] = 0.0f;
-
-  std::vector<VkDynamicState> dynamicStates = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
-  VkPipelineDynamicStateCreateInfo dynamicState{};
-  dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-  dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
-  dynamicState.pDynamicStates = dynamicStates.data();
-
-  VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-  pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-  pipelineLayoutInfo.setLayoutCount = 0;
-  pipelineLayoutInfo.pushConstantRangeCount = 0;
-
-  if (vkCreatePipelineLayout(mDevice, &pipelineLayoutInfo, nullptr, &mPipelineLayout) != VK_SUCCESS) {
-    QPL_CORE_ASSERT(false && "failed to create pipeline layout!");
-  }
-
-  VkGraphicsPipelineCreateInfo pipelineInfo{};
-  pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-  pipelineInfo.stageCount = 2;
-  pipelineInfo.pStages = shaderStages;
-  pipelineInfo.pVertexInputState = &vertexInputInfo;
-  pipelineInfo.pInputAssemblyState = &inputAssembly;
-  pipelineInfo.pViewportState = &viewportState;
-  pipelineInfo.pRasterizationState = &rasterizer;
-  pipelineInfo.pMultisampleState = &multisampling;
-  pipelineInfo.pDepthStencilState = nullptr; // Optional
-  pipelineInfo.pColorBlendState = &colorBlending;
-  pipelineInfo.pDynamicState = &dynamicState;
-  pipelineInfo.layout = mPipelineLayout;
-  pipelineInfo.renderPass = mRenderPass;
-  pipelineInfo.subpass = 0;
-  pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
-  pipelineInfo.basePipelineIndex = -1;              // Optional
-
-  if (vkCreateGraphicsPipelines(mDevice, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &mGraphicsPipeline) != VK_SUCCESS) {
-    QPL_CORE_ASSERT(false && "failed to create graphics pipeline!");
-  }
-
-  vkDestroyShaderModule(mDevice, fragShaderModule, nullptr);
-  vkDestroyShaderModule(mDevice, vertShaderModule, nullptr);
-}
-
-void Renderer::CreateFrameBuffers() {
-  LogInfo("Renderer - Creating VkFrameBuffers");
-
-  mSwapChainFramebuffers.resize(mSwapChainImageViews.size());
-
-  for (size_t i = 0; i < mSwapChainImageViews.size(); i++) {
-    VkImageView attachments[] = {mSwapChainImageViews[i]};
-
-    VkFramebufferCreateInfo framebufferInfo{};
-    framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-    framebufferInfo.renderPass = mRenderPass;
-    framebufferInfo.attachmentCount = 1;
-    framebufferInfo.pAttachments = attachments;
-    framebufferInfo.width = mSwapChainExtent.width;
-    framebufferInfo.height = mSwapChainExtent.height;
-    framebufferInfo.layers = 1;
-
-    if (vkCreateFramebuffer(mDevice, &framebufferInfo, nullptr, &mSwapChainFramebuffers[i]) != VK_SUCCESS) {
-      QPL_CORE_ASSERT(false && "failed to create framebuffer!");
-    }
+void Renderer::CreatePipelineRegistry() {
+  mDepthFormat = ChooseDepthFormat();
+
+  // Set 0 of every pipeline is the bindless heap, so draws bind nothing but the heap itself.
+  VkDescriptorSetLayout setLayouts[] = {mBindlessHeap.GetSetLayout()};
+
+  mPipelineRegistry.Init(
+    mDevice,
+    mPipelineCache.GetHandle(),
+    mPipelineCache.IsWarm(),
+    mSwapChainImageFormat,
+    mDepthFormat,
+    setLayouts,
+    mShaderLibrary,
+    mConfig.pipelineCompileThreads
+  );
+
+  GraphicsPipelineDesc triangleDesc{};
+  triangleDesc.vertexShader = "triangle.vert.spv";
+  triangleDesc.fragmentShader = "triangle.frag.spv";
+
+  // The triangle pipeline doubles as the fallback every other pipeline renders with until it has compiled.
+  mTrianglePipeline = mPipelineRegistry.SetFallback(triangleDesc);
+
+  if (mGpuScene.IsAvailable()) {
+    GraphicsPipelineDesc sceneDesc{};
+    sceneDesc.vertexShader = GpuScene::VertexShader;
+    sceneDesc.fragmentShader = GpuScene::FragmentShader;
+    // The projection flips y, which turns counter-clockwise meshes counter-clockwise in framebuffer space too.
+    sceneDesc.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    sceneDesc.depthTest = true;
+    sceneDesc.depthWrite = true;
+
+    mScenePipeline = mPipelineRegistry.Request(sceneDesc);
   }
 }
 
@@ -485,18 +571,209 @@ void Renderer::CreateCommandPool() {
   }
 }
 
-void Renderer::CreateCommandBuffer() {
-  LogInfo("Renderer - Creating VkCommandBuffer");
+void Renderer::CreateCommandBuffers() {
+  LogInfo("Renderer - Creating VkCommandBuffers ({} frames in flight)", mConfig.framesInFlight);
+
+  mFrames.resize(mConfig.framesInFlight);
+
+  std::vector<VkCommandBuffer> commandBuffers(mFrames.size());
 
   VkCommandBufferAllocateInfo allocInfo{};
   allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
   allocInfo.commandPool = mCommandPool;
   allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-  allocInfo.commandBufferCount = 1;
+  allocInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
 
-  if (vkAllocateCommandBuffers(mDevice, &allocInfo, &mCommandBuffer) != VK_SUCCESS) {
+  if (vkAllocateCommandBuffers(mDevice, &allocInfo, commandBuffers.data()) != VK_SUCCESS) {
     QPL_CORE_ASSERT(false && "failed to allocate command buffers!");
   }
+
+  for (size_t i = 0; i < mFrames.size(); i++) {
+    mFrames[i].commandBuffer = commandBuffers[i];
+  }
+}
+
+void Renderer::CreateUploadRing() {
+  QueueFamilyIndices indices = QueryQueueFamilies(mPhysicalDevice);
+
+  // The graphics timeline is only read once uploads complete, after CreateSyncObjects() initialized it.
+  mUploadRing.Init(
+    mDevice,
+    mGpuAllocator,
+    mGraphicsTimeline,
+    indices.transferFamily.value(),
+    indices.graphicsFamily.value(),
+    mConfig.uploadRingSize
+  );
+}
+
+void Renderer::CreateAssetStreamer() {
+  mAssetStreamer.Init(mJobSystem, &mUploadRing, mConfig.streaming);
+
+  for (const std::filesystem::path& archive : mConfig.assetArchives) {
+    if (!mAssetStreamer.Mount(archive)) {
+      LogWarning("Renderer - Failed to mount asset archive {}", archive.string());
+    }
+  }
+}
+
+void Renderer::CreateTextureStreamer() {
+  mTextureStreamer.Init(
+    mDevice,
+    mPhysicalDevice,
+    mGpuAllocator,
+    mUploadRing,
+    mAssetStreamer,
+    mBindlessHeap,
+    mGraphicsTimeline,
+    mMemoryBudget,
+    mConfig.textureStreaming
+  );
+}
+
+void Renderer::CreateCommandRecorder() {
+  QueueFamilyIndices indices = QueryQueueFamilies(mPhysicalDevice);
+
+  mCommandRecorder.Init(mDevice, indices.graphicsFamily.value(), mConfig.framesInFlight, mJobSystem);
+
+  AddDrawTask([this](VkCommandBuffer commandBuffer) {
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mPipelineRegistry.Get(mTrianglePipeline));
+    vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+  });
+
+  AddDrawTask(
+    [this](VkCommandBuffer commandBuffer) { mGpuScene.RecordDraw(commandBuffer, mPipelineRegistry); }, "scene"
+  );
+}
+
+void Renderer::CreateRenderGraph() {
+  mRenderGraph.Init(mDevice, mGpuAllocator, mGraphicsTimeline);
+}
+
+void Renderer::CreateGpuProfiler() {
+  if (!mConfig.gpuProfiling) {
+    return;
+  }
+
+  QueueFamilyIndices indices = QueryQueueFamilies(mPhysicalDevice);
+
+  mGpuProfiler.Init(
+    mDevice,
+    mPhysicalDevice,
+    indices.graphicsFamily.value(),
+    mConfig.framesInFlight,
+    mConfig.gpuProfilerMaxScopes,
+    mPipelineStatistics
+  );
+  mRenderGraph.SetProfiler(&mGpuProfiler);
+}
+
+void Renderer::CreateShaderLibrary() {
+  std::filesystem::path shaderDirectory = mConfig.shaderDirectory;
+
+  // Resolved against the executable rather than the working directory, so the game can be started from anywhere.
+  if (shaderDirectory.empty()) {
+    const char* basePath = SDL_GetBasePath();
+    shaderDirectory = std::filesystem::path(basePath != nullptr ? basePath : "") / "shaders";
+  }
+
+  mShaderLibrary.Init(mDevice, shaderDirectory, mConfig.shaderHotReload);
+}
+
+void Renderer::CreateBindlessHeap() {
+  // The timeline is only read once slots are freed, long after CreateSyncObjects() initialized it.
+  mBindlessHeap.Init(mDevice, mPhysicalDevice, mGraphicsTimeline, mConfig.bindlessLimits);
+}
+
+void Renderer::CreateGpuScene() {
+  mGpuScene.Init(
+    mDevice,
+    mPipelineCache.GetHandle(),
+    mGpuAllocator,
+    mUploadRing,
+    mBindlessHeap,
+    mShaderLibrary,
+    mConfig.framesInFlight,
+    mConfig.sceneLimits
+  );
+}
+
+void Renderer::CreateDemoScene() {
+  if (mConfig.demoSceneObjects == 0 || !mGpuScene.IsAvailable()) {
+    return;
+  }
+
+  uint32_t objectCount = std::min(mConfig.demoSceneObjects, mConfig.sceneLimits.maxObjects);
+
+  LogInfo("Renderer - Creating demo scene ({} cubes)", objectCount);
+
+  // Unit cube, one quad per face so every face gets its own normal. Each face is spanned by two axes whose cross
+  // product is the normal, which makes the winding counter-clockwise seen from outside.
+  std::vector<GpuVertex> vertices;
+  std::vector<uint32_t> indices;
+
+  const float faces[6][3][3] = {
+    {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}},
+    {{-1, 0, 0}, {0, 0, 1}, {0, 1, 0}},
+    {{0, 1, 0}, {0, 0, 1}, {1, 0, 0}},
+    {{0, -1, 0}, {1, 0, 0}, {0, 0, 1}},
+    {{0, 0, 1}, {1, 0, 0}, {0, 1, 0}},
+    {{0, 0, -1}, {0, 1, 0}, {1, 0, 0}},
+  };
+
+  const float corners[4][2] = {{-1, -1}, {1, -1}, {1, 1}, {-1, 1}};
+
+  for (const auto& face : faces) {
+    uint32_t base = static_cast<uint32_t>(vertices.size());
+
+    for (const auto& corner : corners) {
+      GpuVertex& vertex = vertices.emplace_back();
+
+      for (int i = 0; i < 3; i++) {
+        vertex.position[i] = 0.5f * (face[0][i] + corner[0] * face[1][i] + corner[1] * face[2][i]);
+        vertex.normal[i] = face[0][i];
+      }
+    }
+
+    indices.insert(indices.end(), {base, base + 1, base + 2, base, base + 2, base + 3});
+  }
+
+  MeshHandle cube = mGpuScene.CreateMesh(vertices, indices);
+
+  uint32_t side = static_cast<uint32_t>(std::ceil(std::sqrt((double)objectCount)));
+
+  for (uint32_t i = 0; i < objectCount; i++) {
+    float x = ((float)(i % side) - (float)side * 0.5f) * 2.0f;
+    float z = ((float)(i / side) - (float)side * 0.5f) * 2.0f;
+
+    Matrix4 transform = IdentityMatrix;
+    transform[12] = x;
+    transform[14] = z;
+
+    std::array<float, 4> color = {
+      0.3f + 0.7f * (float)(i % 7) / 6.0f,
+      0.3f + 0.7f * (float)(i % 11) / 10.0f,
+      0.3f + 0.7f * (float)(i % 13) / 12.0f,
+      1.0f,
+    };
+
+    mGpuScene.CreateObject(cube, mScenePipeline, transform, color);
+  }
+}
+
+void Renderer::UpdateDemoScene() {
+  uint32_t side = static_cast<uint32_t>(std::ceil(std::sqrt((double)mGpuScene.GetObjectCount())));
+
+  // Orbits over the grid close enough that most of it falls outside the frustum at any time.
+  float radius = std::max(8.0f, (float)side * 0.5f);
+  float angle = (float)mFrameNumber * 0.005f;
+
+  Matrix4 view = MakeLookAtMatrix({radius * std::cos(angle), radius * 0.4f, radius * std::sin(angle)}, {0, 0, 0});
+  Matrix4 projection = MakePerspectiveMatrix(
+    1.0f, (float)mSwapChainExtent.width / (float)mSwapChainExtent.height, 0.1f, radius * 4.0f
+  );
+
+  mGpuScene.SetCamera(MultiplyMatrices(projection, view));
 }
 
 void Renderer::CreateSyncObjects() {
@@ -505,30 +782,105 @@ void Renderer::CreateSyncObjects() {
   VkSemaphoreCreateInfo semaphoreInfo{};
   semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-  VkFenceCreateInfo fenceInfo{};
-  fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+  // Completion of every graphics submission is tracked on this timeline instead of per-frame fences.
+  mGraphicsTimeline.Init(mDevice, "graphics");
+
+  // Headless frames are neither acquired nor presented, so they need no binary semaphores at all.
+  if (mHeadless) {
+    return;
+  }
+
+  for (FrameData& frame : mFrames) {
+    if (vkCreateSemaphore(mDevice, &semaphoreInfo, nullptr, &frame.imageAvailableSemaphore) != VK_SUCCESS) {
+      QPL_CORE_ASSERT(false && "failed to create frame sync objects!");
+    }
+  }
+
+  CreateRenderFinishedSemaphores();
+}
+
+void Renderer::CreateRenderFinishedSemaphores() {
+  VkSemaphoreCreateInfo semaphoreInfo{};
+  semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+  mRenderFinishedSemaphores.resize(mSwapChainImages.size());
+
+  for (VkSemaphore& semaphore : mRenderFinishedSemaphores) {
+    if (vkCreateSemaphore(mDevice, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS) {
+      QPL_CORE_ASSERT(false && "failed to create semaphores!");
+    }
+  }
+}
+
+bool Renderer::RecreateSwapChain() {
+  SwapChainSupportDetails swapChainSupport = QuerySwapChainSupport(mPhysicalDevice);
+  VkExtent2D extent = ChooseSwapExtent(swapChainSupport.capabilities);
 
-  if (vkCreateSemaphore(mDevice, &semaphoreInfo, nullptr, &mImageAvailableSemaphore) != VK_SUCCESS
-      || vkCreateSemaphore(mDevice, &semaphoreInfo, nullptr, &mRenderFinishedSemaphore) != VK_SUCCESS
-      || vkCreateFence(mDevice, &fenceInfo, nullptr, &mInFlightFence) != VK_SUCCESS) {
-    QPL_CORE_ASSERT(false && "failed to create semaphores!");
+  // A minimized window has a zero-sized surface; keep the old swap chain until it becomes visible again.
+  if (extent.width == 0 || extent.height == 0) {
+    return false;
   }
+
+  LogInfo("Renderer - Recreating VkSwapChain ({}x{})", extent.width, extent.height);
+
+  // Hand the current swap chain over to the retire list instead of waiting for the device to go idle. Frames
+  // already in flight keep using it; it is destroyed once the last of them has completed.
+  RetiredSwapChain& retired = mRetiredSwapChains.emplace_back();
+  retired.swapChain = mSwapChain;
+  retired.imageViews = std::move(mSwapChainImageViews);
+  retired.renderFinishedSemaphores = std::move(mRenderFinishedSemaphores);
+  retired.lastUsedValue = mGraphicsTimeline.GetLastSubmitted();
+  retired.lastPresentId = mPresentId;
+
+  VkFormat oldFormat = mSwapChainImageFormat;
+
+  mSwapChainImageViews.clear();
+  mRenderFinishedSemaphores.clear();
+
+  CreateSwapChain(retired.swapChain);
+
+  // Pipelines are built against the surface format, which does not change on resize.
+  QPL_CORE_ASSERT(mSwapChainImageFormat == oldFormat && "swap chain format changed during recreation");
+
+  CreateImageViews();
+  CreateRenderFinishedSemaphores();
+
+  // Present ids belong to the swap chain they were presented to.
+  mPendingPresents.clear();
+
+  mSwapChainDirty = false;
+  return true;
 }
 
-VkShaderModule Renderer::CreateShaderModule(const std::vector<char>& code) {
-  LogInfo("Renderer - Creating VkShaderModule");
+void Renderer::ReleaseRetiredSwapChains(bool force) {
+  while (!mRetiredSwapChains.empty()) {
+    RetiredSwapChain& retired = mRetiredSwapChains.front();
 
-  VkShaderModuleCreateInfo createInfo{};
-  createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-  createInfo.codeSize = code.size();
-  createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+    // Retired in order, so the first one still in use means every later one is too.
+    if (!force && !mGraphicsTimeline.IsComplete(retired.lastUsedValue)) {
+      break;
+    }
+
+    // Its last presents may still be waiting on its render-finished semaphores.
+    if (!force && mPresentId < retired.lastPresentId + mConfig.framesInFlight) {
+      break;
+    }
 
-  VkShaderModule shaderModule;
-  if (vkCreateShaderModule(mDevice, &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
-    QPL_CORE_ASSERT(false && "failed to create shader module!");
+    DestroyRetiredSwapChain(retired);
+    mRetiredSwapChains.pop_front();
+  }
+}
+
+void Renderer::DestroyRetiredSwapChain(RetiredSwapChain& retired) {
+  for (auto imageView : retired.imageViews) {
+    vkDestroyImageView(mDevice, imageView, nullptr);
+  }
+
+  for (auto semaphore : retired.renderFinishedSemaphores) {
+    vkDestroySemaphore(mDevice, semaphore, nullptr);
   }
 
-  return shaderModule;
+  vkDestroySwapchainKHR(mDevice, retired.swapChain, nullptr);
 }
 
 bool Renderer::CheckValidationLayerSupport() {
@@ -549,7 +901,7 @@ bool Renderer::CheckValidationLayerSupport() {
     }
 
     if (!layerFound) {
-      LogWarning(std::format("Validation layer not found: {}", layerName));
+      LogWarning("Validation layer not found: {}", layerName);
       return false;
     }
   }
@@ -557,14 +909,14 @@ bool Renderer::CheckValidationLayerSupport() {
   return true;
 }
 
-bool Renderer::CheckDeviceExtensionSupport(VkPhysicalDevice mDevice) {
+bool Renderer::CheckDeviceExtensionSupport(VkPhysicalDevice mDevice, std::span<const char* const> extensions) {
   uint32_t extensionCount;
   vkEnumerateDeviceExtensionProperties(mDevice, nullptr, &extensionCount, nullptr);
 
   std::vector<VkExtensionProperties> availableExtensions(extensionCount);
   vkEnumerateDeviceExtensionProperties(mDevice, nullptr, &extensionCount, availableExtensions.data());
 
-  std::set<std::string> requiredExtensions(DeviceExtensions.begin(), DeviceExtensions.end());
+  std::set<std::string> requiredExtensions(extensions.begin(), extensions.end());
 
   for (const auto& extension : availableExtensions) {
     requiredExtensions.erase(extension.extensionName);
@@ -576,6 +928,10 @@ bool Renderer::CheckDeviceExtensionSupport(VkPhysicalDevice mDevice) {
 bool Renderer::CheckDeviceSuitability(VkPhysicalDevice mDevice) {
   QueueFamilyIndices indices = QueryQueueFamilies(mDevice);
 
+  if (mHeadless) {
+    return indices.IsComplete() && CheckDeviceFeatureSupport(mDevice);
+  }
+
   bool extensionsSupported = CheckDeviceExtensionSupport(mDevice);
   bool swapChainAdequate = false;
 
@@ -584,7 +940,41 @@ bool Renderer::CheckDeviceSuitability(VkPhysicalDevice mDevice) {
     swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
   }
 
-  return indices.IsComplete() && extensionsSupported && swapChainAdequate;
+  return indices.IsComplete() && extensionsSupported && swapChainAdequate && CheckDeviceFeatureSupport(mDevice);
+}
+
+bool Renderer::CheckDeviceFeatureSupport(VkPhysicalDevice mDevice) {
+  VkPhysicalDeviceProperties properties;
+  vkGetPhysicalDeviceProperties(mDevice, &properties);
+
+  if (properties.apiVersion < VK_API_VERSION_1_3) {
+    return false;
+  }
+
+  VkPhysicalDeviceVulkan13Features vulkan13Features{};
+  vulkan13Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+
+  VkPhysicalDeviceVulkan12Features vulkan12Features{};
+  vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+  vulkan12Features.pNext = &vulkan13Features;
+
+  VkPhysicalDeviceFeatures2 features{};
+  features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+  features.pNext = &vulkan12Features;
+  vkGetPhysicalDeviceFeatures2(mDevice, &features);
+
+  bool indirectDraws = features.features.multiDrawIndirect && features.features.drawIndirectFirstInstance
+    && vulkan12Features.drawIndirectCount;
+
+  bool descriptorIndexing = vulkan12Features.runtimeDescriptorArray && vulkan12Features.descriptorBindingPartiallyBound
+    && vulkan12Features.descriptorBindingUpdateUnusedWhilePending
+    && vulkan12Features.descriptorBindingSampledImageUpdateAfterBind
+    && vulkan12Features.descriptorBindingStorageBufferUpdateAfterBind
+    && vulkan12Features.shaderSampledImageArrayNonUniformIndexing
+    && vulkan12Features.shaderStorageBufferArrayNonUniformIndexing;
+
+  return vulkan12Features.timelineSemaphore && vulkan13Features.synchronization2 && vulkan13Features.dynamicRendering
+      && indirectDraws && descriptorIndexing;
 }
 
 void Renderer::ChoosePhysicalDevice() {
@@ -606,6 +996,20 @@ void Renderer::ChoosePhysicalDevice() {
   QPL_CORE_ASSERT(mPhysicalDevice != VK_NULL_HANDLE && "failed to find a suitable GPU!");
 }
 
+VkFormat Renderer::ChooseDepthFormat() {
+  for (VkFormat format : DepthFormats) {
+    VkFormatProperties properties;
+    vkGetPhysicalDeviceFormatProperties(mPhysicalDevice, format, &properties);
+
+    if (properties.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT) {
+      return format;
+    }
+  }
+
+  QPL_CORE_ASSERT(false && "no supported depth format!");
+  return VK_FORMAT_UNDEFINED;
+}
+
 VkSurfaceFormatKHR Renderer::ChooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats) {
   for (const auto& availableFormat : availableFormats) {
     if (availableFormat.format == VK_FORMAT_B8G8R8A8_SRGB
@@ -619,7 +1023,7 @@ VkSurfaceFormatKHR Renderer::ChooseSwapSurfaceFormat(const std::vector<VkSurface
 
 VkPresentModeKHR Renderer::ChooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes) {
   for (const auto& availablePresentMode : availablePresentModes) {
-    if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR) {
+    if (availablePresentMode == mConfig.presentMode) {
       return availablePresentMode;
     }
   }
@@ -632,10 +1036,8 @@ VkExtent2D Renderer::ChooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabiliti
     return capabilities.currentExtent;
   }
   else {
-    int width, height;
-    SDL_GetWindowSizeInPixels(mWindow.GetSDLWindow(), &width, &height);
-
-    VkExtent2D actualExtent = {static_cast<uint32_t>(width), static_cast<uint32_t>(height)};
+    // The swap chain may be recreated on the render thread, which must not touch the SDL window itself.
+    VkExtent2D actualExtent = {mWindowWidth.load(), mWindowHeight.load()};
 
     actualExtent.width =
       std::clamp(actualExtent.width, capabilities.minImageExtent.width, capabilities.maxImageExtent.width);
@@ -656,24 +1058,41 @@ QueueFamilyIndices Renderer::QueryQueueFamilies(VkPhysicalDevice mDevice) {
   vkGetPhysicalDeviceQueueFamilyProperties(mDevice, &queueFamilyCount, queueFamilies.data());
 
   for (uint32_t idx = 0; const auto& queueFamily : queueFamilies) {
-    if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
-      indices.graphicsFamily = idx;
-    }
+    if (!indices.IsComplete()) {
+      if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+        indices.graphicsFamily = idx;
+      }
 
-    VkBool32 presentSupport = false;
-    vkGetPhysicalDeviceSurfaceSupportKHR(mDevice, idx, mSurface, &presentSupport);
+      // Without a surface nothing is presented; the graphics family stands in so the rest of the setup is shared.
+      VkBool32 presentSupport = false;
+      if (mHeadless) {
+        presentSupport = (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0;
+      }
+      else {
+        vkGetPhysicalDeviceSurfaceSupportKHR(mDevice, idx, mSurface, &presentSupport);
+      }
 
-    if (presentSupport) {
-      indices.presentFamily = idx;
+      if (presentSupport) {
+        indices.presentFamily = idx;
+      }
     }
 
-    if (indices.IsComplete()) {
-      break;
+    // A family that can copy but neither draw nor dispatch is the dedicated DMA engine on discrete GPUs.
+    constexpr VkQueueFlags transferOnly = VK_QUEUE_TRANSFER_BIT;
+    constexpr VkQueueFlags transferMask = VK_QUEUE_TRANSFER_BIT | VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT;
+
+    if (!indices.transferFamily.has_value() && (queueFamily.queueFlags & transferMask) == transferOnly) {
+      indices.transferFamily = idx;
     }
 
     ++idx;
   }
 
+  // Every graphics queue supports transfers, so uploads fall back to it when there is no dedicated family.
+  if (!indices.transferFamily.has_value()) {
+    indices.transferFamily = indices.graphicsFamily;
+  }
+
   return indices;
 }
 
@@ -699,7 +1118,9 @@ SwapChainSupportDetails Renderer::QuerySwapChainSupport(VkPhysicalDevice mDevice
   return details;
 }
 
-void Renderer::RecordCommandBuffer(VkCommandBuffer commandBuffer, [[maybe_unused]] uint32_t imageIndex) {
+void Renderer::RecordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex) {
+  QPL_PROFILE_ZONE("Renderer::RecordCommandBuffer");
+
   VkCommandBufferBeginInfo beginInfo{};
   beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
   beginInfo.flags = 0;                  // Optional
@@ -709,91 +1130,508 @@ void Renderer::RecordCommandBuffer(VkCommandBuffer commandBuffer, [[maybe_unused
     QPL_CORE_ASSERT(false && "failed to begin recording command buffer!");
   }
 
-  VkRenderPassBeginInfo renderPassInfo{};
-  renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-  renderPassInfo.renderPass = mRenderPass;
-  renderPassInfo.framebuffer = mSwapChainFramebuffers[imageIndex];
-  renderPassInfo.renderArea.offset = {0, 0};
-  renderPassInfo.renderArea.extent = mSwapChainExtent;
+  // Results from this slot's previous frame are complete by now, since Render() waited for it.
+  mGpuProfiler.BeginFrame(mCurrentFrame, commandBuffer);
+  GpuScope frameScope = mGpuProfiler.BeginScope(commandBuffer, "frame", /*statistics=*/false);
+
+  // Take ownership of whatever the transfer queue uploaded for this frame, and copy into the buffers this queue
+  // already owns, before anything reads them.
+  mUploadRing.RecordGraphicsCommands(commandBuffer);
+
+  mRenderGraph.Reset();
+
+  // Rewrites this frame's indirect draws. Buffers are not tracked by the graph, so the pass synchronizes them itself.
+  mRenderGraph.AddPass("cull").SideEffects().Execute([this](const RenderPassContext& context) {
+    mGpuScene.RecordCull(context.commandBuffer, mCurrentFrame);
+  });
+
+  // Offscreen targets end the frame ready to be copied out instead of presented.
+  RenderResource backbuffer = mRenderGraph.ImportTexture(
+    "backbuffer",
+    mSwapChainImages[imageIndex],
+    mSwapChainImageViews[imageIndex],
+    {mSwapChainImageFormat, mSwapChainExtent},
+    VK_IMAGE_LAYOUT_UNDEFINED,
+    mHeadless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
+  );
+
+  RenderResource depth = mRenderGraph.CreateTexture("depth", {mDepthFormat, mSwapChainExtent});
+
+  // Everything inside the pass comes from secondaries recorded on the record thread pool.
+  mRenderGraph.AddPass("main")
+    .ColorAttachment(backbuffer, VK_ATTACHMENT_LOAD_OP_CLEAR, {{0.0f, 0.0f, 0.0f, 1.0f}})
+    .DepthAttachment(depth)
+    .SecondaryContents()
+    .Execute([this](const RenderPassContext& context) {
+      VkViewport viewport{};
+      viewport.x = 0.0f;
+      viewport.y = 0.0f;
+      viewport.width = (float)context.renderArea.width;
+      viewport.height = (float)context.renderArea.height;
+      viewport.minDepth = 0.0f;
+      viewport.maxDepth = 1.0f;
+
+      VkRect2D scissor{};
+      scissor.offset = {0, 0};
+      scissor.extent = context.renderArea;
+
+      mCommandRecorder.Record(
+        mCurrentFrame,
+        context.commandBuffer,
+        *context.inheritanceInfo,
+        static_cast<uint32_t>(mDrawTasks.size()),
+        [&](VkCommandBuffer secondary, uint32_t task) {
+          // Dynamic state is not inherited from the primary, so every secondary sets its own.
+          vkCmdSetViewport(secondary, 0, 1, &viewport);
+          vkCmdSetScissor(secondary, 0, 1, &scissor);
+
+          QPL_PROFILE_ZONE("DrawTask");
+
+          GpuScope scope = mGpuProfiler.BeginScope(secondary, mDrawTaskNames[task]);
+          mDrawTasks[task](secondary);
+          mGpuProfiler.EndScope(secondary, scope);
+        }
+      );
+    });
+
+  FrameData& frame = mFrames[mCurrentFrame];
+
+  if (frame.pendingReadback) {
+    mRenderGraph.AddPass("readback")
+      .Read(backbuffer, RenderAccess::TransferSrc)
+      .SideEffects()
+      .Execute([this, &frame, imageIndex](const RenderPassContext& context) {
+        VkBufferImageCopy region{};
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.layerCount = 1;
+        region.imageExtent = {mSwapChainExtent.width, mSwapChainExtent.height, 1};
+
+        vkCmdCopyImageToBuffer(
+          context.commandBuffer,
+          mSwapChainImages[imageIndex],
+          VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+          frame.readbackBuffer.buffer,
+          1,
+          &region
+        );
+
+        // Make the copy visible to the host; the CPU reads it once the frame's timeline value is reached.
+        VkBufferMemoryBarrier2 barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2;
+        barrier.srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+        barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+        barrier.dstStageMask = VK_PIPELINE_STAGE_2_HOST_BIT;
+        barrier.dstAccessMask = VK_ACCESS_2_HOST_READ_BIT;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.buffer = frame.readbackBuffer.buffer;
+        barrier.size = VK_WHOLE_SIZE;
+
+        VkDependencyInfo dependencyInfo{};
+        dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+        dependencyInfo.bufferMemoryBarrierCount = 1;
+        dependencyInfo.pBufferMemoryBarriers = &barrier;
+
+        vkCmdPipelineBarrier2(context.commandBuffer, &dependencyInfo);
+      });
+  }
 
-  VkClearValue clearColor = {{{0.0f, 0.0f, 0.0f, 1.0f}}};
-  renderPassInfo.clearValueCount = 1;
-  renderPassInfo.pClearValues = &clearColor;
+  mRenderGraph.Compile();
+  mRenderGraph.Execute(commandBuffer);
 
-  vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-  {
-    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mGraphicsPipeline);
+  mGpuProfiler.EndScope(commandBuffer, frameScope);
 
-    VkViewport viewport{};
-    viewport.x = 0.0f;
-    viewport.y = 0.0f;
-    viewport.width = (float)mSwapChainExtent.width;
-    viewport.height = (float)mSwapChainExtent.height;
-    viewport.minDepth = 0.0f;
-    viewport.maxDepth = 1.0f;
+  if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+    QPL_CORE_ASSERT(false && "failed to record command buffer!");
+  }
+}
 
-    vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+static bool WriteReadbackPpm(const std::filesystem::path& path, const FrameReadback& readback) {
+  std::ofstream file(path, std::ios::binary);
+  if (!file) {
+    return false;
+  }
 
-    VkRect2D scissor{};
-    scissor.offset = {0, 0};
-    scissor.extent = mSwapChainExtent;
+  file << "P6\n" << readback.width << " " << readback.height << "\n255\n";
 
-    vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
-    vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+  // PPM has no alpha channel.
+  std::vector<char> row(readback.width * 3);
+
+  for (uint32_t y = 0; y < readback.height; y++) {
+    const std::byte* pixel = readback.pixels.data() + (size_t)y * readback.width * 4;
+
+    for (uint32_t x = 0; x < readback.width; x++, pixel += 4) {
+      row[x * 3 + 0] = static_cast<char>(pixel[0]);
+      row[x * 3 + 1] = static_cast<char>(pixel[1]);
+      row[x * 3 + 2] = static_cast<char>(pixel[2]);
+    }
+
+    file.write(row.data(), (std::streamsize)row.size());
   }
-  vkCmdEndRenderPass(commandBuffer);
 
-  if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
-    QPL_CORE_ASSERT(false && "failed to record command buffer!");
+  return file.good();
+}
+
+void Renderer::DeliverReadback(FrameData& frame) {
+  if (!frame.pendingReadback) {
+    return;
+  }
+
+  FrameReadback readback;
+  readback.frameNumber = *frame.pendingReadback;
+  readback.width = mSwapChainExtent.width;
+  readback.height = mSwapChainExtent.height;
+  readback.pixels = {static_cast<const std::byte*>(frame.readbackBuffer.allocation.mapped),
+                     (size_t)readback.width * readback.height * 4};
+
+  frame.pendingReadback.reset();
+
+  if (mConfig.readbackCallback) {
+    mConfig.readbackCallback(readback);
+  }
+
+  if (!mConfig.readbackDirectory.empty()) {
+    auto path = mConfig.readbackDirectory / std::format("frame-{:06}.ppm", readback.frameNumber);
+
+    if (!WriteReadbackPpm(path, readback)) {
+      LogError("Renderer - Failed to write readback {}", path.string());
+    }
+  }
+}
+
+void Renderer::UpdateFrameStats() {
+  auto now = std::chrono::steady_clock::now();
+
+  // The first frame has no predecessor to measure against.
+  if (mLastFrameTime != std::chrono::steady_clock::time_point{}) {
+    double frameTimeMs = std::chrono::duration<double, std::milli>(now - mLastFrameTime).count();
+
+    mFrameStats.frameCount++;
+    mFrameStats.totalFrameTimeMs += frameTimeMs;
+    mFrameStats.minFrameTimeMs = std::min(mFrameStats.minFrameTimeMs, frameTimeMs);
+    mFrameStats.maxFrameTimeMs = std::max(mFrameStats.maxFrameTimeMs, frameTimeMs);
   }
+
+  mLastFrameTime = now;
 }
 
-void Renderer::Render() {
-  vkWaitForFences(mDevice, 1, &mInFlightFence, VK_TRUE, UINT64_MAX);
-  vkResetFences(mDevice, 1, &mInFlightFence);
+void Renderer::CollectPresentLatency(uint64_t timeout) {
+  while (!mPendingPresents.empty()) {
+    const PendingPresent& pending = mPendingPresents.front();
+    VkResult result = mWaitForPresent(mDevice, mSwapChain, pending.presentId, timeout);
 
-  uint32_t imageIndex;
-  vkAcquireNextImageKHR(mDevice, mSwapChain, UINT64_MAX, mImageAvailableSemaphore, VK_NULL_HANDLE, &imageIndex);
+    if (result == VK_TIMEOUT) {
+      return;
+    }
 
-  vkResetCommandBuffer(mCommandBuffer, /*VkCommandBufferResetFlagBits*/ 0);
-  RecordCommandBuffer(mCommandBuffer, imageIndex);
+    if (result != VK_SUCCESS) {
+      // Out of date or surface lost: these presents will never be reported; the swap chain is recreated anyway.
+      mPendingPresents.clear();
+      return;
+    }
+
+    if (pending.inputTime != 0) {
+      mFramePacer.RecordLatency(CpuProfiler::Now() - pending.inputTime);
+    }
+
+    mPendingPresents.pop_front();
+
+    // Presents complete in order, so only the first one is worth waiting for.
+    timeout = 0;
+  }
+}
+
+void Renderer::SetFramePacing(FramePacing pacing) {
+  mConfig.framePacing = pacing;
+  mFramePacer.Init(pacing == FramePacing::Uncapped ? 0.0 : mConfig.targetFps);
+}
+
+void Renderer::WaitForNextFrame() {
+  QPL_PROFILE_ZONE("Renderer::WaitForNextFrame");
+
+  if (mConfig.framePacing == FramePacing::LowLatency) {
+    if (mPresentWait) {
+      // The most recent present; every earlier one completes before it.
+      if (!mPendingPresents.empty()) {
+        mWaitForPresent(mDevice, mSwapChain, mPendingPresents.back().presentId, PresentWaitTimeout);
+      }
+    }
+    else {
+      // Without present wait, the closest available point is the previous frame finishing on the GPU.
+      mGraphicsTimeline.Wait(mGraphicsTimeline.GetLastSubmitted(), PresentWaitTimeout);
+    }
+  }
+
+  mFramePacer.WaitForNextFrame();
+
+  if (mPresentWait) {
+    CollectPresentLatency(0);
+  }
+}
+
+void Renderer::Render(float interpolationAlpha, int64_t inputTime) {
+  QPL_PROFILE_ZONE("Renderer::Render");
+
+  mInterpolationAlpha = interpolationAlpha;
+
+  FrameData& frame = mFrames[mCurrentFrame];
+
+  // Only wait for the submission that last used this slot; the other frames in flight keep the GPU busy while
+  // this one is being recorded.
+  {
+    QPL_PROFILE_ZONE("WaitForFrameSlot");
+    mGraphicsTimeline.Wait(frame.timelineValue);
+  }
+
+  mCommandRecorder.BeginFrame(mCurrentFrame);
+  ReleaseRetiredSwapChains();
+  mBindlessHeap.ReleaseRetired();
+
+  if (mShaderLibrary.IsHotReloadEnabled()) {
+    std::vector<std::string> changedShaders = mShaderLibrary.PollChanges();
+
+    if (!changedShaders.empty()) {
+      mPipelineRegistry.ReloadShaders(changedShaders);
+    }
+  }
+
+  // Draw tasks look pipelines up while they record, so the registry may only change while nothing is recording.
+  QPL_CORE_ASSERT(!mCommandRecorder.IsRecording() && "pipeline registry updated while draw tasks are recording");
+  mPipelineRegistry.Update(mGraphicsTimeline);
+  mAssetStreamer.Update();
+
+  // Ahead of the upload ring's submit below, so the mips it starts uploading go out with this frame.
+  mTextureStreamer.Update();
+  DeliverReadback(frame);
+
+  uint32_t imageIndex = mCurrentFrame;
+
+  if (mConfig.demoSceneObjects > 0) {
+    UpdateDemoScene();
+  }
+
+  if (!mHeadless) {
+    if (mSwapChainDirty && !RecreateSwapChain()) {
+      return;
+    }
+
+    QPL_PROFILE_ZONE("AcquireNextImage");
+
+    VkResult acquireResult = vkAcquireNextImageKHR(
+      mDevice, mSwapChain, UINT64_MAX, frame.imageAvailableSemaphore, VK_NULL_HANDLE, &imageIndex
+    );
+
+    if (acquireResult == VK_ERROR_OUT_OF_DATE_KHR) {
+      // Nothing was acquired or submitted, so the slot can simply be retried next frame.
+      mSwapChainDirty = true;
+      return;
+    }
+    else if (acquireResult == VK_SUBOPTIMAL_KHR) {
+      // The image is still presentable; render into it and recreate afterwards.
+      mSwapChainDirty = true;
+    }
+    else if (acquireResult != VK_SUCCESS) {
+      LogError("vkAcquireNextImageKHR failed with code {}", magic_enum::enum_name(acquireResult));
+      QPL_CORE_ASSERT(false && "failed to acquire swap chain image!");
+    }
+  }
+  else if (mConfig.readbackInterval > 0 && mFrameNumber % mConfig.readbackInterval == 0) {
+    frame.pendingReadback = mFrameNumber;
+  }
+
+  // Every copy staged since the last frame goes out in one transfer submission ahead of the frame that uses it.
+  uint64_t uploadValue = mUploadRing.Submit(mTransferQueue);
+
+  vkResetCommandBuffer(frame.commandBuffer, /*VkCommandBufferResetFlagBits*/ 0);
+  RecordCommandBuffer(frame.commandBuffer, imageIndex);
 
   VkSubmitInfo submitInfo{};
   submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-  VkSemaphore waitSemaphores[] = {mImageAvailableSemaphore};
-  VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-  submitInfo.waitSemaphoreCount = 1;
-  submitInfo.pWaitSemaphores = waitSemaphores;
-  submitInfo.pWaitDstStageMask = waitStages;
+  frame.timelineValue = mGraphicsTimeline.NextValue();
+
+  // Binary semaphores ignore their entry in the value arrays.
+  std::array<VkSemaphore, 2> waitSemaphores;
+  std::array<VkPipelineStageFlags, 2> waitStages;
+  std::array<uint64_t, 2> waitValues;
+  uint32_t waitCount = 0;
+
+  std::array<VkSemaphore, 2> signalSemaphores;
+  std::array<uint64_t, 2> signalValues;
+  uint32_t signalCount = 0;
+
+  if (!mHeadless) {
+    waitSemaphores[waitCount] = frame.imageAvailableSemaphore;
+    waitStages[waitCount] = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    waitValues[waitCount++] = 0;
+
+    signalSemaphores[signalCount] = mRenderFinishedSemaphores[imageIndex];
+    signalValues[signalCount++] = 0;
+  }
+
+  if (uploadValue != 0) {
+    waitSemaphores[waitCount] = mUploadRing.GetTimeline().GetHandle();
+    waitStages[waitCount] = UploadRing::ConsumerStages;
+    waitValues[waitCount++] = uploadValue;
+  }
+
+  signalSemaphores[signalCount] = mGraphicsTimeline.GetHandle();
+  signalValues[signalCount++] = frame.timelineValue;
+
+  VkTimelineSemaphoreSubmitInfo timelineInfo{};
+  timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+  timelineInfo.waitSemaphoreValueCount = waitCount;
+  timelineInfo.pWaitSemaphoreValues = waitValues.data();
+  timelineInfo.signalSemaphoreValueCount = signalCount;
+  timelineInfo.pSignalSemaphoreValues = signalValues.data();
+
+  submitInfo.pNext = &timelineInfo;
+  submitInfo.waitSemaphoreCount = waitCount;
+  submitInfo.pWaitSemaphores = waitSemaphores.data();
+  submitInfo.pWaitDstStageMask = waitStages.data();
 
   submitInfo.commandBufferCount = 1;
-  submitInfo.pCommandBuffers = &mCommandBuffer;
+  submitInfo.pCommandBuffers = &frame.commandBuffer;
+
+  submitInfo.signalSemaphoreCount = signalCount;
+  submitInfo.pSignalSemaphores = signalSemaphores.data();
 
-  VkSemaphore signalSemaphores[] = {mRenderFinishedSemaphore};
-  submitInfo.signalSemaphoreCount = 1;
-  submitInfo.pSignalSemaphores = signalSemaphores;
+  {
+    QPL_PROFILE_ZONE("QueueSubmit");
 
-  if (vkQueueSubmit(mGraphicsQueue, 1, &submitInfo, mInFlightFence) != VK_SUCCESS) {
-    QPL_CORE_ASSERT(false && "failed to submit draw command buffer!");
+    if (vkQueueSubmit(mGraphicsQueue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+      QPL_CORE_ASSERT(false && "failed to submit draw command buffer!");
+    }
   }
 
-  VkPresentInfoKHR presentInfo{};
-  presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+  if (!mHeadless) {
+    QPL_PROFILE_ZONE("QueuePresent");
+
+    VkPresentInfoKHR presentInfo{};
+    presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+
+    presentInfo.waitSemaphoreCount = 1;
+    presentInfo.pWaitSemaphores = &mRenderFinishedSemaphores[imageIndex];
+
+    VkSwapchainKHR swapChains[] = {mSwapChain};
+    presentInfo.swapchainCount = 1;
+    presentInfo.pSwapchains = swapChains;
+    presentInfo.pImageIndices = &imageIndex;
 
-  presentInfo.waitSemaphoreCount = 1;
-  presentInfo.pWaitSemaphores = signalSemaphores;
+    uint64_t presentId = ++mPresentId;
 
-  VkSwapchainKHR swapChains[] = {mSwapChain};
-  presentInfo.swapchainCount = 1;
-  presentInfo.pSwapchains = swapChains;
-  presentInfo.pImageIndices = &imageIndex;
+    VkPresentIdKHR presentIdInfo{};
+    presentIdInfo.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+    presentIdInfo.swapchainCount = 1;
+    presentIdInfo.pPresentIds = &presentId;
 
-  vkQueuePresentKHR(mPresentQueue, &presentInfo);
+    if (mPresentWait) {
+      presentInfo.pNext = &presentIdInfo;
+    }
+
+    VkResult presentResult = vkQueuePresentKHR(mPresentQueue, &presentInfo);
+
+    if (presentResult == VK_SUCCESS || presentResult == VK_SUBOPTIMAL_KHR) {
+      if (mPresentWait) {
+        mPendingPresents.push_back({presentId, inputTime});
+      }
+      else if (inputTime != 0) {
+        mFramePacer.RecordLatency(CpuProfiler::Now() - inputTime);
+      }
+    }
+
+    if (presentResult == VK_ERROR_OUT_OF_DATE_KHR || presentResult == VK_SUBOPTIMAL_KHR) {
+      mSwapChainDirty = true;
+    }
+    else if (presentResult != VK_SUCCESS) {
+      LogError("vkQueuePresentKHR failed with code {}", magic_enum::enum_name(presentResult));
+      QPL_CORE_ASSERT(false && "failed to present swap chain image!");
+    }
+  }
+
+  mFrameNumber++;
+  mCurrentFrame = (mCurrentFrame + 1) % mConfig.framesInFlight;
+  UpdateFrameStats();
 }
 
 void Renderer::Shutdown() {
   vkDeviceWaitIdle(mDevice);
+
+  // The last frames in flight still have their readbacks pending. The current slot holds the oldest one.
+  for (uint32_t i = 0; i < mConfig.framesInFlight; i++) {
+    DeliverReadback(mFrames[(mCurrentFrame + i) % mConfig.framesInFlight]);
+  }
+
+  LogInfo(
+    "Renderer - {} frames, {} in flight, frame time avg {:.3f} ms, min {:.3f} ms, max {:.3f} ms",
+    mFrameStats.frameCount,
+    mConfig.framesInFlight,
+    mFrameStats.AverageFrameTimeMs(),
+    mFrameStats.frameCount > 0 ? mFrameStats.minFrameTimeMs : 0.0,
+    mFrameStats.maxFrameTimeMs
+  );
+
+  FrameLatencyStats latency = mFramePacer.GetLatencyStats();
+
+  if (latency.sampleCount > 0) {
+    LogInfo(
+      "Renderer - Input to {} latency over {} frames: avg {:.3f} ms, p50 {:.3f} ms, p95 {:.3f} ms, p99 {:.3f} ms, max "
+      "{:.3f} ms",
+      mPresentWait ? "present" : "present call",
+      latency.sampleCount,
+      latency.averageMs,
+      latency.p50Ms,
+      latency.p95Ms,
+      latency.p99Ms,
+      latency.maxMs
+    );
+  }
+
+  const RenderGraphStats& graphStats = mRenderGraph.GetStats();
+
+  LogInfo(
+    "Renderer - Render graph: {} passes ({} culled), {} barrier batches, {} image barriers, {} transient textures in "
+    "{} bytes ({} bytes without aliasing)",
+    graphStats.passCount,
+    graphStats.culledPassCount,
+    graphStats.barrierBatchCount,
+    graphStats.imageBarrierCount,
+    graphStats.transientTextureCount,
+    graphStats.transientHeapBytes,
+    graphStats.transientBytes
+  );
+
+  std::vector<GpuScopeStats> gpuScopes = mGpuProfiler.GetScopeStats();
+
+  for (const GpuScopeStats& scope : gpuScopes) {
+    LogInfo(
+      "Renderer - GPU {}: avg {:.3f} ms, p50 {:.3f} ms, p95 {:.3f} ms, p99 {:.3f} ms over {} frames",
+      scope.name,
+      scope.averageMs,
+      scope.p50Ms,
+      scope.p95Ms,
+      scope.p99Ms,
+      scope.sampleCount
+    );
+  }
+
+  if (!mConfig.gpuProfileOutput.empty() && mGpuProfiler.DumpToFile(mConfig.gpuProfileOutput)) {
+    LogInfo("Renderer - Wrote GPU profile to {}", mConfig.gpuProfileOutput.string());
+  }
+
+  GpuAllocatorStats memoryStats = mGpuAllocator.GetStats();
+
+  LogInfo(
+    "Renderer - GPU memory: {} blocks, {} dedicated, {} allocations, {} / {} bytes used, fragmentation {:.1f}% "
+    "internal, {:.1f}% external",
+    memoryStats.blockCount,
+    memoryStats.dedicatedAllocationCount,
+    memoryStats.allocationCount,
+    memoryStats.usedBytes,
+    memoryStats.reservedBytes,
+    memoryStats.InternalFragmentation() * 100.0,
+    memoryStats.ExternalFragmentation() * 100.0
+  );
 }
 
 } // namespace qpl
@@ -8,12 +8,16 @@
 #include <array>     // For std::array
 #include <vector>    // For std::vector
 #include <set>       // For std::set
+#include <deque>     // For std::deque
 #include <cstring>   // For std::strcmp
 #include <optional>  // For std::optional
 #include <limits>    // For std::numeric_limits
 #include <algorithm> // For std::clamp
-#include <fstream>   // For std::ifstream
+#include <chrono>    // For std::chrono::steady_clock
+#include <thread>    // For std::thread::hardware_concurrency
+#include <span>
 #include <filesystem>
+#include <functional>
 
 #include <SDL3/SDL.h>
 #include <SDL3/SDL_vulkan.h>
@@ -22,13 +26,28 @@
 
 #include <events/event.hpp>
 #include <core/core.hpp>
+#include <assets/asset-streamer.hpp>
 #include <window.hpp>
+#include "gpu-allocator.hpp"
+#include "pipeline-cache.hpp"
+#include "pipeline-registry.hpp"
+#include "upload-ring.hpp"
+#include "gpu-timeline.hpp"
+#include "command-recorder.hpp"
+#include "render-graph.hpp"
+#include "gpu-profiler.hpp"
+#include "frame-pacer.hpp"
+#include "bindless-heap.hpp"
+#include "texture-streamer.hpp"
+#include "shader-library.hpp"
+#include "gpu-scene.hpp"
 
 namespace qpl {
 
 struct QueueFamilyIndices {
   std::optional<uint32_t> graphicsFamily;
   std::optional<uint32_t> presentFamily;
+  std::optional<uint32_t> transferFamily;
 
   QPL_INLINE bool IsComplete() {
     return graphicsFamily.has_value() && presentFamily.has_value();
@@ -41,30 +60,267 @@ struct SwapChainSupportDetails {
   std::vector<VkPresentModeKHR> presentModes;
 };
 
-QPL_INLINE std::vector<char> LoadShader(const std::string& filepath) {
-  std::ifstream file(filepath, std::ios::binary | std::ios::ate);
-  if (!file.is_open()) {
-    QPL_CORE_ASSERT(false && "Failed to open shader file");
-  }
+//
+// ---- Frame Readback ---------------------------------
+//
+// A headless frame copied back to host memory. Pixels are tightly packed RGBA8, top row first, and only valid for
+// the duration of the callback they are passed to.
+//
+struct FrameReadback {
+  uint64_t frameNumber = 0;
+  uint32_t width = 0;
+  uint32_t height = 0;
+  std::span<const std::byte> pixels;
+};
+
+//
+// ---- Renderer Config ---------------------------------
+//
+// Tunables that are fixed for the lifetime of a renderer instance.
+//
+struct RendererConfig {
+  // Number of frames the CPU may record ahead of the GPU. 1 fully serializes CPU and GPU work,
+  // 2 or 3 lets recording of frame N+1 overlap GPU execution of frame N.
+  uint32_t framesInFlight = 2;
+
+  // Directory the pipeline cache is loaded from at startup and saved to at shutdown.
+  std::filesystem::path pipelineCacheDirectory = "cache";
+
+  // Directory SPIR-V shaders are loaded from. Empty loads them from the shaders directory next to the executable,
+  // which is where the build compiles them to.
+  std::filesystem::path shaderDirectory;
+
+  // Watches the shader directory and rebuilds the pipelines whose shaders were rewritten, see ShaderLibrary.
+  bool shaderHotReload = false;
+
+  // Size of the persistently mapped staging ring used for buffer and image uploads.
+  VkDeviceSize uploadRingSize = 32ull * 1024 * 1024;
+
+  // Archives mounted into the asset streamer at startup, later ones taking precedence, and how it streams them.
+  std::vector<std::filesystem::path> assetArchives;
+  StreamerConfig streaming;
+
+  // Mip residency and GPU memory budget of streamed textures, see TextureStreamer.
+  TextureStreamerConfig textureStreaming;
+
+  // Worker threads used to compile pipelines in the background.
+  uint32_t pipelineCompileThreads = std::max(1u, std::thread::hardware_concurrency() / 2);
+
+  // Number of frames to render before the renderer reports it is done. 0 renders until the engine quits.
+  uint64_t frameLimit = 0;
+
+  // Headless only: copy every Nth frame back to the host (0 disables readback). Each copied frame is written to
+  // `readbackDirectory` as a PPM if the directory is set, and handed to `readbackCallback` if there is one.
+  uint32_t readbackInterval = 0;
+  std::filesystem::path readbackDirectory;
+  std::function<void(const FrameReadback&)> readbackCallback;
+
+  // GPU timing of every render graph pass and draw task, see GpuProfiler. `gpuProfilerMaxScopes` bounds the scopes
+  // measured per frame; the rest go unmeasured. If `gpuProfileOutput` is set, the profile is written there as CSV
+  // at shutdown.
+  bool gpuProfiling = true;
+  uint32_t gpuProfilerMaxScopes = 256;
+  std::filesystem::path gpuProfileOutput;
+
+  // Swap chain present mode, if the surface supports it. Falls back to FIFO, which every surface does.
+  VkPresentModeKHR presentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+
+  // See FramePacing. A `targetFps` of 0 leaves the frame rate uncapped.
+  FramePacing framePacing = FramePacing::Uncapped;
+  double targetFps = 0.0;
+
+  // Sizes of the descriptor arrays every pipeline indexes into, see BindlessHeap.
+  BindlessLimits bindlessLimits;
+
+  // Capacity of the GPU scene, see GpuScene.
+  GpuSceneLimits sceneLimits;
+
+  // Fills the GPU scene with a grid of this many cubes and orbits the camera around it, to exercise GPU-driven
+  // rendering at scale.
+  uint32_t demoSceneObjects = 0;
+};
+
+// Records one unit of draw work into a secondary command buffer inside the main render pass. Viewport and scissor
+// are already set. Runs on an arbitrary recording thread, concurrently with other draw tasks.
+using DrawTask = std::function<void(VkCommandBuffer commandBuffer)>;
+
+//
+// ---- Frame Data --------------------------------
+//
+// Resources owned by a single slot of the frames-in-flight ring.
+//
+struct FrameData {
+  VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+  // Binary, because vkAcquireNextImageKHR cannot signal timeline semaphores.
+  VkSemaphore imageAvailableSemaphore = VK_NULL_HANDLE;
+
+  // Graphics timeline value signalled by the last submission from this slot, 0 if the slot was never used.
+  uint64_t timelineValue = 0;
+
+  // Headless readback target, and the number of the frame copied into it that has not been handed out yet.
+  GpuBuffer readbackBuffer;
+  std::optional<uint64_t> pendingReadback;
+};
+
+//
+// ---- Retired Swap Chain --------------------------------
+//
+// A swap chain that has been replaced by a newer one. It, and everything built on top of its images, stays alive
+// until the last frame that could have touched it has completed on the GPU and its newest present is done with
+// its render-finished semaphore.
+//
+struct RetiredSwapChain {
+  VkSwapchainKHR swapChain = VK_NULL_HANDLE;
+  std::vector<VkImageView> imageViews;
+  std::vector<VkSemaphore> renderFinishedSemaphores;
+
+  // Graphics timeline value of the last submission made while this swap chain was current.
+  uint64_t lastUsedValue = 0;
 
-  size_t fileSize = (size_t)file.tellg();
-  std::vector<char> buffer(fileSize);
-  file.seekg(0);
-  file.read(buffer.data(), fileSize);
-  return buffer;
-}
+  // Id of the last present made to this swap chain. Presents do not signal anything that says when they stop
+  // waiting on their semaphore, so the semaphores are only trusted to be free once the newer swap chain has
+  // presented a full frames-in-flight ring after it.
+  uint64_t lastPresentId = 0;
+};
+
+// A present whose latency is still to be measured.
+struct PendingPresent {
+  uint64_t presentId = 0;
+  int64_t inputTime = 0;
+};
+
+//
+// ---- Frame Stats --------------------------------
+//
+// CPU-side frame timing, measured between consecutive calls to Renderer::Render.
+//
+struct FrameStats {
+  uint64_t frameCount = 0;
+  double totalFrameTimeMs = 0.0;
+  double minFrameTimeMs = std::numeric_limits<double>::max();
+  double maxFrameTimeMs = 0.0;
+
+  QPL_INLINE double AverageFrameTimeMs() const {
+    return frameCount > 0 ? totalFrameTimeMs / (double)frameCount : 0.0;
+  }
+};
 
 //
 // ---- Renderer --------------------------------
 //
 class Renderer {
 public:
-  Renderer(WindowContext&);
+  Renderer(WindowContext&, JobSystem&, const RendererConfig& config = {});
   ~Renderer();
 
-  void Render();
+  // Blocks until the next frame should start, as set by the frame pacing policy. Called right before the input the
+  // frame is built from is sampled.
+  void WaitForNextFrame();
+
+  // `interpolationAlpha` is how far real time has moved from the latest simulation tick towards the next one, in
+  // fixed steps. Draw tasks read it back with GetInterpolationAlpha(). `inputTime` is the CpuProfiler::Now() at
+  // which the frame's input was sampled, 0 if the frame's latency should not be measured.
+  void Render(float interpolationAlpha = 1.0f, int64_t inputTime = 0);
   void Shutdown();
 
+  // Records the window's new size in pixels and flags the swap chain as out of date; it is recreated at the start of
+  // the next frame. Called on the main thread, which is the only one allowed to query SDL windows, and may be called
+  // while another thread renders.
+  QPL_INLINE void OnWindowResized(uint32_t width, uint32_t height) {
+    mWindowWidth = width;
+    mWindowHeight = height;
+    mSwapChainDirty = true;
+  }
+
+  // Blend factor between the previous and the latest simulation snapshot for the frame being recorded.
+  QPL_INLINE float GetInterpolationAlpha() const {
+    return mInterpolationAlpha;
+  }
+
+  QPL_INLINE const FrameStats& GetFrameStats() const {
+    return mFrameStats;
+  }
+
+  QPL_INLINE bool IsHeadless() const {
+    return mHeadless;
+  }
+
+  QPL_INLINE FramePacing GetFramePacing() const {
+    return mConfig.framePacing;
+  }
+
+  // Switches to another pacing mode, keeping the target frame rate. Must not be called while another thread renders.
+  void SetFramePacing(FramePacing pacing);
+
+  // Number of frames submitted so far.
+  QPL_INLINE uint64_t GetFrameNumber() const {
+    return mFrameNumber;
+  }
+
+  QPL_INLINE bool IsFrameLimitReached() const {
+    return mConfig.frameLimit > 0 && mFrameNumber >= mConfig.frameLimit;
+  }
+
+  QPL_INLINE VkDevice GetDevice() const {
+    return mDevice;
+  }
+
+  QPL_INLINE GpuAllocator& GetGpuAllocator() {
+    return mGpuAllocator;
+  }
+
+  QPL_INLINE UploadRing& GetUploadRing() {
+    return mUploadRing;
+  }
+
+  // Timeline signalled by every graphics submission. Resources used by a frame can be released once it reaches the
+  // value returned by GetLastSubmitted() at the time they were last referenced.
+  QPL_INLINE GpuTimeline& GetGraphicsTimeline() {
+    return mGraphicsTimeline;
+  }
+
+  // Draw tasks are recorded in parallel every frame and executed in the order they were added. `name` labels the
+  // task in the GPU profile; tasks sharing a name are profiled together.
+  QPL_INLINE void AddDrawTask(DrawTask task, std::string name = {}) {
+    mDrawTaskNames.push_back(name.empty() ? std::format("draw-{}", mDrawTasks.size()) : std::move(name));
+    mDrawTasks.push_back(std::move(task));
+  }
+
+  // Draw tasks may call Get() and IsReady() on it; Request() and ReloadShaders() belong to the render thread, outside
+  // of recording.
+  QPL_INLINE PipelineRegistry& GetPipelineRegistry() {
+    return mPipelineRegistry;
+  }
+
+  QPL_INLINE GpuProfiler& GetGpuProfiler() {
+    return mGpuProfiler;
+  }
+
+  QPL_INLINE FrameLatencyStats GetLatencyStats() const {
+    return mFramePacer.GetLatencyStats();
+  }
+
+  QPL_INLINE BindlessHeap& GetBindlessHeap() {
+    return mBindlessHeap;
+  }
+
+  QPL_INLINE AssetStreamer& GetAssetStreamer() {
+    return mAssetStreamer;
+  }
+
+  QPL_INLINE TextureStreamer& GetTextureStreamer() {
+    return mTextureStreamer;
+  }
+
+  QPL_INLINE GpuScene& GetGpuScene() {
+    return mGpuScene;
+  }
+
+  // Pipeline for scene objects drawn with GpuScene's own shaders.
+  QPL_INLINE PipelineHandle GetScenePipeline() const {
+    return mScenePipeline;
+  }
+
 public:
 #ifdef NDEBUG
   static constexpr bool EnableValidationLayers = false;
@@ -76,10 +332,35 @@ public:
     "VK_LAYER_KHRONOS_validation",
   };
 
-  static constexpr std::array<const char*, 2> DeviceExtensions = {
+  static constexpr std::array<const char*, 1> DeviceExtensions = {
     VK_KHR_SWAPCHAIN_EXTENSION_NAME,
   };
 
+  // Enabled together when available, for frame pacing.
+  static constexpr std::array<const char*, 2> PresentWaitExtensions = {
+    VK_KHR_PRESENT_ID_EXTENSION_NAME,
+    VK_KHR_PRESENT_WAIT_EXTENSION_NAME,
+  };
+
+  // Enabled when available, so the texture streamer can size its budget by what the rest of the system leaves free.
+  static constexpr std::array<const char*, 1> MemoryBudgetExtensions = {
+    VK_EXT_MEMORY_BUDGET_EXTENSION_NAME,
+  };
+
+  // Longest a low-latency frame waits for the previous present, in nanoseconds. A present that takes longer has
+  // stalled, and the frame goes ahead rather than hang with it.
+  static constexpr uint64_t PresentWaitTimeout = 100'000'000;
+
+  // Depth formats in order of preference; every implementation supports at least one of them as an attachment.
+  static constexpr std::array<VkFormat, 3> DepthFormats = {
+    VK_FORMAT_D32_SFLOAT,
+    VK_FORMAT_X8_D24_UNORM_PACK32,
+    VK_FORMAT_D16_UNORM,
+  };
+
+  // Format of the images rendered to in headless mode; plain RGBA8 so readbacks need no conversion.
+  static constexpr VkFormat OffscreenFormat = VK_FORMAT_R8G8B8A8_UNORM;
+
   static constexpr std::array<VkDynamicState, 2> DynamicStates = {
     VK_DYNAMIC_STATE_VIEWPORT,
     VK_DYNAMIC_STATE_SCISSOR,
@@ -90,22 +371,38 @@ private:
   void CreateDebugMessenger();
   void CreateSurface();
   void CreateLogicalDevice();
-  void CreateSwapChain();
+  void CreateSwapChain(VkSwapchainKHR oldSwapChain = VK_NULL_HANDLE);
   void CreateImageViews();
-  void CreateRenderPass();
-  void CreateGraphicsPipeline();
-  void CreateFrameBuffers();
+  void CreateOffscreenTargets();
+  void CreateReadbackBuffers();
+  void CreatePipelineRegistry();
   void CreateCommandPool();
-  void CreateCommandBuffer();
+  void CreateCommandBuffers();
   void CreateSyncObjects();
+  void CreateRenderFinishedSemaphores();
+  void CreateUploadRing();
+  void CreateCommandRecorder();
+  void CreateRenderGraph();
+  void CreateGpuProfiler();
+  void CreateAssetStreamer();
+  void CreateTextureStreamer();
+  void CreateShaderLibrary();
+  void CreateBindlessHeap();
+  void CreateGpuScene();
+  void CreateDemoScene();
+  void UpdateDemoScene();
 
-  VkShaderModule CreateShaderModule(const std::vector<char>& code);
+  bool RecreateSwapChain();
+  void ReleaseRetiredSwapChains(bool force = false);
+  void DestroyRetiredSwapChain(RetiredSwapChain& retired);
 
   bool CheckValidationLayerSupport();
-  bool CheckDeviceExtensionSupport(VkPhysicalDevice device);
+  bool CheckDeviceExtensionSupport(VkPhysicalDevice device, std::span<const char* const> extensions = DeviceExtensions);
   bool CheckDeviceSuitability(VkPhysicalDevice device);
+  bool CheckDeviceFeatureSupport(VkPhysicalDevice device);
 
   void ChoosePhysicalDevice();
+  VkFormat ChooseDepthFormat();
   VkSurfaceFormatKHR ChooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats);
   VkPresentModeKHR ChooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes);
   VkExtent2D ChooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities);
@@ -114,9 +411,17 @@ private:
   SwapChainSupportDetails QuerySwapChainSupport(VkPhysicalDevice device);
 
   void RecordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+  void CollectPresentLatency(uint64_t timeout);
+  void DeliverReadback(FrameData& frame);
+  void UpdateFrameStats();
 
 private:
   WindowContext& mWindow;
+  JobSystem& mJobSystem;
+  RendererConfig mConfig;
+  bool mHeadless = false;
+  bool mPipelineStatistics = false;
+  bool mMemoryBudget = false;
 
   VkInstance mInstance;
   VkDebugUtilsMessengerEXT mDebugMessenger;
@@ -124,22 +429,71 @@ private:
   VkPhysicalDevice mPhysicalDevice;
   VkQueue mGraphicsQueue;
   VkQueue mPresentQueue;
-  VkSurfaceKHR mSurface;
-  VkSwapchainKHR mSwapChain;
+  VkQueue mTransferQueue;
+  VkSurfaceKHR mSurface = VK_NULL_HANDLE;
+  VkSwapchainKHR mSwapChain = VK_NULL_HANDLE;
   VkFormat mSwapChainImageFormat;
+  VkFormat mDepthFormat = VK_FORMAT_UNDEFINED;
   VkExtent2D mSwapChainExtent;
-  VkRenderPass mRenderPass;
-  VkPipelineLayout mPipelineLayout;
-  VkPipeline mGraphicsPipeline;
   VkCommandPool mCommandPool;
-  VkCommandBuffer mCommandBuffer;
-  VkSemaphore mImageAvailableSemaphore;
-  VkSemaphore mRenderFinishedSemaphore;
-  VkFence mInFlightFence;
+
+  GpuAllocator mGpuAllocator;
+  PipelineCache mPipelineCache;
+  UploadRing mUploadRing;
+  AssetStreamer mAssetStreamer;
+  ShaderLibrary mShaderLibrary;
+  BindlessHeap mBindlessHeap;
+  TextureStreamer mTextureStreamer;
+  PipelineRegistry mPipelineRegistry;
+  PipelineHandle mTrianglePipeline = InvalidPipelineHandle;
+  GpuScene mGpuScene;
+  PipelineHandle mScenePipeline = InvalidPipelineHandle;
+
+  CommandRecorder mCommandRecorder;
+  std::vector<DrawTask> mDrawTasks;
+  std::vector<std::string> mDrawTaskNames;
+  RenderGraph mRenderGraph;
+  GpuProfiler mGpuProfiler;
 
   std::vector<VkImage> mSwapChainImages;
   std::vector<VkImageView> mSwapChainImageViews;
-  std::vector<VkFramebuffer> mSwapChainFramebuffers;
+
+  // Headless stand-ins for the swap chain images, one per frame in flight. Their handles are mirrored into
+  // mSwapChainImages so recording does not care which kind of target it draws into.
+  std::vector<GpuImage> mOffscreenImages;
+
+  // Frames-in-flight ring, indexed by mCurrentFrame.
+  std::vector<FrameData> mFrames;
+  uint32_t mCurrentFrame = 0;
+
+  // Signalled by the submit that renders into a swapchain image and waited on by its present. Binary, because
+  // presentation cannot wait on timeline semaphores. Indexed by swapchain image rather than by frame, since an
+  // image is only re-acquired once its present has finished.
+  std::vector<VkSemaphore> mRenderFinishedSemaphores;
+
+  // Swap chains waiting for their last frame to complete before being destroyed.
+  std::deque<RetiredSwapChain> mRetiredSwapChains;
+  std::atomic<bool> mSwapChainDirty = false;
+
+  // Window size in pixels as of the last OnWindowResized(), which the swap chain extent is chosen from when the
+  // surface leaves it to the application.
+  std::atomic<uint32_t> mWindowWidth = 0;
+  std::atomic<uint32_t> mWindowHeight = 0;
+
+  GpuTimeline mGraphicsTimeline;
+  uint64_t mFrameNumber = 0;
+  float mInterpolationAlpha = 1.0f;
+
+  FrameStats mFrameStats;
+  std::chrono::steady_clock::time_point mLastFrameTime;
+
+  // Frame pacing. With VK_KHR_present_wait every present carries an id, and its latency is taken when the present
+  // is seen to have completed; without it, when vkQueuePresentKHR returns.
+  FramePacer mFramePacer;
+  bool mPresentWait = false;
+  PFN_vkWaitForPresentKHR mWaitForPresent = nullptr;
+  uint64_t mPresentId = 0;
+  std::deque<PendingPresent> mPendingPresents;
 };
 
 } // namespace qpl
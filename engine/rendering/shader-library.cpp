@@ -0,0 +1,419 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#include "shader-library.hpp"
+
+#include <map>
+#include <chrono>
+#include <algorithm>
+
+#ifdef __linux__
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#endif
+
+namespace qpl {
+
+void ShaderLibrary::Init(VkDevice device, const std::filesystem::path& directory, bool hotReload) {
+  LogInfo("Renderer - Creating ShaderLibrary ({}, hot reload {})", directory.string(), hotReload ? "on" : "off");
+
+  mDevice = device;
+  mDirectory = directory;
+
+  if (hotReload) {
+    mWatcher = std::jthread([this](std::stop_token stopToken) { WatcherMain(stopToken); });
+  }
+}
+
+void ShaderLibrary::Destroy() {
+  if (mWatcher.joinable()) {
+    mWatcher.request_stop();
+    mWatcher.join();
+  }
+
+  std::lock_guard lock(mMutex);
+
+  for (auto& [hash, layout] : mPipelineLayouts) {
+    vkDestroyPipelineLayout(mDevice, layout, nullptr);
+  }
+
+  for (auto& [hash, layout] : mSetLayouts) {
+    vkDestroyDescriptorSetLayout(mDevice, layout, nullptr);
+  }
+
+  mPipelineLayouts.clear();
+  mSetLayouts.clear();
+  mShaders.clear();
+  mModules.clear();
+}
+
+ShaderRef ShaderLibrary::Load(const std::string& name) {
+  {
+    std::lock_guard lock(mMutex);
+
+    if (auto it = mShaders.find(name); it != mShaders.end()) {
+      return it->second;
+    }
+  }
+
+  MappedFile file;
+
+  if (!file.Open(mDirectory / name)) {
+    LogError("Renderer - Failed to open shader {}", name);
+    return nullptr;
+  }
+
+  uint64_t hash = HashBytes(file.GetData().data(), file.GetSize());
+  ShaderRef shader;
+
+  {
+    std::lock_guard lock(mMutex);
+
+    if (auto it = mModules.find(hash); it != mModules.end()) {
+      shader = it->second.lock();
+    }
+  }
+
+  // A different file that happens to share the hash gets a module of its own.
+  if (shader != nullptr && !std::ranges::equal(shader->code, file.GetData())) {
+    shader = nullptr;
+  }
+
+  // Created outside the lock, so compile threads loading different shaders do not wait on each other.
+  if (shader == nullptr) {
+    shader = Create(file.GetData(), hash, name);
+
+    if (shader == nullptr) {
+      return nullptr;
+    }
+  }
+
+  std::lock_guard lock(mMutex);
+
+  // Another thread may have loaded the same name meanwhile; everyone gets the same module either way.
+  auto [it, inserted] = mShaders.try_emplace(name, shader);
+  mModules[it->second->hash] = it->second;
+  return it->second;
+}
+
+ShaderRef ShaderLibrary::Create(std::span<const std::byte> code, uint64_t hash, const std::string& name) {
+  QPL_PROFILE_ZONE("ShaderLibrary::Create");
+
+  // SPIR-V is a stream of words; mappings are page aligned, so the cast is safe.
+  if (code.size() % sizeof(uint32_t) != 0) {
+    LogError("Renderer - {} is not SPIR-V", name);
+    return nullptr;
+  }
+
+  std::span<const uint32_t> words(reinterpret_cast<const uint32_t*>(code.data()), code.size() / sizeof(uint32_t));
+
+  auto shader = std::make_unique<Shader>();
+  shader->hash = hash;
+  shader->code.assign(code.begin(), code.end());
+
+  if (!ReflectShader(words, shader->reflection)) {
+    LogError("Renderer - {} is not SPIR-V", name);
+    return nullptr;
+  }
+
+  VkShaderModuleCreateInfo createInfo{};
+  createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+  createInfo.codeSize = code.size();
+  createInfo.pCode = words.data();
+
+  if (vkCreateShaderModule(mDevice, &createInfo, nullptr, &shader->module) != VK_SUCCESS) {
+    LogError("Renderer - Failed to create shader module for {}", name);
+    return nullptr;
+  }
+
+  VkDevice device = mDevice;
+
+  return ShaderRef(shader.release(), [device](const Shader* shader) {
+    vkDestroyShaderModule(device, shader->module, nullptr);
+    delete shader;
+  });
+}
+
+VkPipelineLayout ShaderLibrary::GetPipelineLayout(
+  std::span<const ShaderRef> shaders, std::span<const VkDescriptorSetLayout> sets
+) {
+  std::vector<ShaderBinding> bindings;
+  VkPushConstantRange pushConstants{};
+
+  for (const ShaderRef& shader : shaders) {
+    const ShaderReflection& reflection = shader->reflection;
+
+    for (const ShaderBinding& binding : reflection.bindings) {
+      auto it = std::find_if(bindings.begin(), bindings.end(), [&](const ShaderBinding& other) {
+        return other.set == binding.set && other.binding == binding.binding;
+      });
+
+      if (it == bindings.end()) {
+        bindings.push_back(binding);
+        continue;
+      }
+
+      if (it->type != binding.type || it->count != binding.count) {
+        LogError("Renderer - Shaders disagree about set {} binding {}", binding.set, binding.binding);
+        return VK_NULL_HANDLE;
+      }
+
+      it->stages |= binding.stages;
+    }
+
+    if (reflection.pushConstantSize > 0) {
+      pushConstants.stageFlags |= reflection.stage;
+      pushConstants.size = std::max(pushConstants.size, reflection.pushConstantSize);
+    }
+  }
+
+  std::sort(bindings.begin(), bindings.end(), [](const ShaderBinding& a, const ShaderBinding& b) {
+    return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+  });
+
+  uint32_t setCount = static_cast<uint32_t>(sets.size());
+
+  if (!bindings.empty()) {
+    setCount = std::max(setCount, bindings.back().set + 1);
+  }
+
+  std::lock_guard lock(mMutex);
+  std::vector<VkDescriptorSetLayout> setLayouts(setCount, VK_NULL_HANDLE);
+  uint64_t hash = HashCombine(pushConstants.stageFlags, pushConstants.size);
+
+  for (uint32_t set = 0; set < setCount; set++) {
+    if (set < sets.size() && sets[set] != VK_NULL_HANDLE) {
+      setLayouts[set] = sets[set];
+    }
+    else {
+      auto inSet = [&](const ShaderBinding& binding) {
+        return binding.set == set;
+      };
+
+      auto first = std::find_if(bindings.begin(), bindings.end(), inSet);
+      auto last = std::find_if_not(first, bindings.end(), inSet);
+
+      setLayouts[set] = GetSetLayout(std::span<const ShaderBinding>(first, last));
+
+      if (setLayouts[set] == VK_NULL_HANDLE) {
+        return VK_NULL_HANDLE;
+      }
+    }
+
+    hash = HashCombine(hash, (uint64_t)setLayouts[set]);
+  }
+
+  if (auto it = mPipelineLayouts.find(hash); it != mPipelineLayouts.end()) {
+    return it->second;
+  }
+
+  VkPipelineLayoutCreateInfo layoutInfo{};
+  layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+  layoutInfo.setLayoutCount = setCount;
+  layoutInfo.pSetLayouts = setLayouts.data();
+  layoutInfo.pushConstantRangeCount = pushConstants.size > 0 ? 1 : 0;
+  layoutInfo.pPushConstantRanges = &pushConstants;
+
+  VkPipelineLayout layout = VK_NULL_HANDLE;
+
+  if (vkCreatePipelineLayout(mDevice, &layoutInfo, nullptr, &layout) != VK_SUCCESS) {
+    QPL_CORE_ASSERT(false && "failed to create reflected pipeline layout!");
+  }
+
+  mPipelineLayouts.emplace(hash, layout);
+  return layout;
+}
+
+VkDescriptorSetLayout ShaderLibrary::GetSetLayout(std::span<const ShaderBinding> bindings) {
+  std::vector<VkDescriptorSetLayoutBinding> layoutBindings;
+  uint64_t hash = Fnv1aOffsetBasis;
+
+  for (const ShaderBinding& binding : bindings) {
+    // Unbounded arrays need descriptor indexing flags SPIR-V cannot express; they belong in an external set.
+    if (binding.count == 0) {
+      LogError(
+        "Renderer - Set {} binding {} is runtime sized but has no layout to go with it", binding.set, binding.binding
+      );
+      return VK_NULL_HANDLE;
+    }
+
+    layoutBindings.push_back({binding.binding, binding.type, binding.count, binding.stages, nullptr});
+
+    hash = HashCombine(hash, binding.binding);
+    hash = HashCombine(hash, (uint64_t)binding.type);
+    hash = HashCombine(hash, binding.count);
+    hash = HashCombine(hash, binding.stages);
+  }
+
+  if (auto it = mSetLayouts.find(hash); it != mSetLayouts.end()) {
+    return it->second;
+  }
+
+  VkDescriptorSetLayoutCreateInfo layoutInfo{};
+  layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+  layoutInfo.bindingCount = static_cast<uint32_t>(layoutBindings.size());
+  layoutInfo.pBindings = layoutBindings.data();
+
+  VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+
+  if (vkCreateDescriptorSetLayout(mDevice, &layoutInfo, nullptr, &layout) != VK_SUCCESS) {
+    QPL_CORE_ASSERT(false && "failed to create reflected descriptor set layout!");
+  }
+
+  mSetLayouts.emplace(hash, layout);
+  return layout;
+}
+
+std::vector<std::string> ShaderLibrary::PollChanges() {
+  std::vector<std::string> changed;
+
+  if (!mHasChanges.exchange(false, std::memory_order_acquire)) {
+    return changed;
+  }
+
+  std::set<std::string> written;
+
+  {
+    std::lock_guard lock(mChangeMutex);
+    written.swap(mChanged);
+  }
+
+  for (const std::string& name : written) {
+    ShaderRef current;
+
+    {
+      std::lock_guard lock(mMutex);
+      auto it = mShaders.find(name);
+
+      // Never loaded, so the next Load() reads the new file anyway.
+      if (it == mShaders.end()) {
+        continue;
+      }
+
+      current = it->second;
+    }
+
+    MappedFile file;
+
+    if (!file.Open(mDirectory / name)) {
+      continue;
+    }
+
+    uint64_t hash = HashBytes(file.GetData().data(), file.GetSize());
+
+    if (hash == current->hash && std::ranges::equal(current->code, file.GetData())) {
+      continue;
+    }
+
+    ShaderRef shader = Create(file.GetData(), hash, name);
+
+    // A broken shader keeps the last one that worked in use.
+    if (shader == nullptr) {
+      continue;
+    }
+
+    {
+      std::lock_guard lock(mMutex);
+      mShaders[name] = shader;
+      mModules[hash] = shader;
+    }
+
+    LogInfo("Renderer - Reloaded shader {} ({:016x})", name, hash);
+    changed.push_back(name);
+  }
+
+  return changed;
+}
+
+void ShaderLibrary::NoteChange(const std::string& name) {
+  if (!name.ends_with(".spv")) {
+    return;
+  }
+
+  {
+    std::lock_guard lock(mChangeMutex);
+    mChanged.insert(name);
+  }
+
+  mHasChanges.store(true, std::memory_order_release);
+}
+
+#ifdef __linux__
+
+void ShaderLibrary::WatcherMain(std::stop_token stopToken) {
+  QPL_PROFILE_THREAD("shader-watcher");
+
+  int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+  // Close-write catches compilers writing in place, moved-to catches tools that write aside and rename.
+  if (fd < 0 || inotify_add_watch(fd, mDirectory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+    LogError("Renderer - Failed to watch {}, shader hot reload disabled", mDirectory.string());
+
+    if (fd >= 0) {
+      close(fd);
+    }
+
+    return;
+  }
+
+  alignas(inotify_event) char buffer[4096];
+
+  while (!stopToken.stop_requested()) {
+    pollfd pollInfo{fd, POLLIN, 0};
+
+    if (poll(&pollInfo, 1, WatchIntervalMs) <= 0) {
+      continue;
+    }
+
+    ssize_t length = read(fd, buffer, sizeof(buffer));
+
+    for (ssize_t offset = 0; offset < length;) {
+      const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+
+      if (event->len > 0) {
+        NoteChange(event->name);
+      }
+
+      offset += sizeof(inotify_event) + event->len;
+    }
+  }
+
+  close(fd);
+}
+
+#else
+
+void ShaderLibrary::WatcherMain(std::stop_token stopToken) {
+  QPL_PROFILE_THREAD("shader-watcher");
+
+  std::map<std::string, std::filesystem::file_time_type> writeTimes;
+
+  while (!stopToken.stop_requested()) {
+    std::error_code error;
+
+    for (const auto& entry : std::filesystem::directory_iterator(mDirectory, error)) {
+      std::string name = entry.path().filename().string();
+      auto writeTime = entry.last_write_time(error);
+
+      if (error) {
+        continue;
+      }
+
+      // The first sighting only records the time; the file has not changed since it was loaded.
+      auto [it, inserted] = writeTimes.try_emplace(name, writeTime);
+
+      if (!inserted && it->second != writeTime) {
+        it->second = writeTime;
+        NoteChange(name);
+      }
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(WatchIntervalMs));
+  }
+}
+
+#endif
+
+} // namespace qpl
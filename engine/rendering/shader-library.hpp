@@ -0,0 +1,107 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#ifndef QPL_SHADER_LIBRARY_HPP
+#define QPL_SHADER_LIBRARY_HPP
+
+#include <set>
+#include <span>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <filesystem>
+#include <unordered_map>
+
+#include <vulkan/vulkan.h>
+#include <core/core.hpp>
+#include "shader-reflection.hpp"
+
+namespace qpl {
+
+struct Shader {
+  // Content hash of the SPIR-V the module was created from.
+  uint64_t hash = 0;
+  // The SPIR-V itself, so a file whose hash matches can be told apart from one with the same bytes.
+  std::vector<std::byte> code;
+  VkShaderModule module = VK_NULL_HANDLE;
+  ShaderReflection reflection;
+};
+
+// Keeps the module alive while held, even if the library has since reloaded the file.
+using ShaderRef = std::shared_ptr<const Shader>;
+
+//
+// ---- Shader Library ---------------------------------
+//
+// Loads SPIR-V files from the shader directory into shader modules. Files are memory mapped rather than read, and
+// modules are keyed by a hash of their content, so two names with the same bytes, or a file rewritten with the same
+// bytes, share one module. A hash match is only trusted once the bytes compare equal too. Every module is reflected on load, which is what pipeline layouts are derived from.
+//
+// With hot reload on, a watcher thread (inotify on Linux, timestamp polling elsewhere) notes every .spv file that is
+// written in the shader directory. PollChanges() re-reads those files and tells the caller which shaders actually
+// changed, so only the pipelines using them need to be rebuilt.
+//
+// Load() and GetPipelineLayout() are thread safe; PollChanges() is meant for the render thread.
+//
+class ShaderLibrary final {
+public:
+  // How often the watcher checks for changes, at most.
+  static constexpr uint32_t WatchIntervalMs = 250;
+
+  void Init(VkDevice device, const std::filesystem::path& directory, bool hotReload);
+  void Destroy();
+
+  // `name` is relative to the shader directory. Returns nullptr if the file is missing or not valid SPIR-V.
+  ShaderRef Load(const std::string& name);
+
+  // Layout covering every binding and push constant the shaders declare. Sets with an entry in `sets` use that layout
+  // (this is how shaders share the bindless heap); the rest are created from reflection. Layouts are cached and owned
+  // by the library. Returns VK_NULL_HANDLE if the shaders disagree about a binding.
+  VkPipelineLayout GetPipelineLayout(
+    std::span<const ShaderRef> shaders, std::span<const VkDescriptorSetLayout> sets = {}
+  );
+
+  // Reloads the shaders written since the last call and returns the names of those whose content changed. Holders of
+  // the old modules keep them until they let go.
+  std::vector<std::string> PollChanges();
+
+  QPL_INLINE bool IsHotReloadEnabled() const {
+    return mWatcher.joinable();
+  }
+
+  QPL_INLINE const std::filesystem::path& GetDirectory() const {
+    return mDirectory;
+  }
+
+private:
+  ShaderRef Create(std::span<const std::byte> code, uint64_t hash, const std::string& name);
+  VkDescriptorSetLayout GetSetLayout(std::span<const ShaderBinding> bindings);
+
+  void NoteChange(const std::string& name);
+  void WatcherMain(std::stop_token stopToken);
+
+private:
+  VkDevice mDevice = VK_NULL_HANDLE;
+  std::filesystem::path mDirectory;
+
+  std::mutex mMutex;
+  std::unordered_map<std::string, ShaderRef> mShaders;
+  // Modules stay shareable for as long as anyone holds them, not only while a name refers to them.
+  std::unordered_map<uint64_t, std::weak_ptr<const Shader>> mModules;
+  std::unordered_map<uint64_t, VkDescriptorSetLayout> mSetLayouts;
+  std::unordered_map<uint64_t, VkPipelineLayout> mPipelineLayouts;
+
+  // Written by the watcher thread.
+  std::mutex mChangeMutex;
+  std::set<std::string> mChanged;
+  std::atomic<bool> mHasChanges = false;
+  std::jthread mWatcher;
+};
+
+} // namespace qpl
+
+#endif
@@ -0,0 +1,413 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#include "shader-reflection.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace qpl {
+
+// The handful of SPIR-V enumerants reflection needs, from the SPIR-V specification.
+namespace spv {
+
+static constexpr uint32_t Magic = 0x07230203;
+static constexpr uint32_t HeaderWords = 5;
+
+static constexpr uint32_t OpEntryPoint = 15;
+static constexpr uint32_t OpTypeBool = 20;
+static constexpr uint32_t OpTypeInt = 21;
+static constexpr uint32_t OpTypeFloat = 22;
+static constexpr uint32_t OpTypeVector = 23;
+static constexpr uint32_t OpTypeMatrix = 24;
+static constexpr uint32_t OpTypeImage = 25;
+static constexpr uint32_t OpTypeSampler = 26;
+static constexpr uint32_t OpTypeSampledImage = 27;
+static constexpr uint32_t OpTypeArray = 28;
+static constexpr uint32_t OpTypeRuntimeArray = 29;
+static constexpr uint32_t OpTypeStruct = 30;
+static constexpr uint32_t OpTypePointer = 32;
+static constexpr uint32_t OpConstant = 43;
+static constexpr uint32_t OpVariable = 59;
+static constexpr uint32_t OpDecorate = 71;
+static constexpr uint32_t OpMemberDecorate = 72;
+static constexpr uint32_t OpTypeAccelerationStructureKHR = 5341;
+
+static constexpr uint32_t DecorationBlock = 2;
+static constexpr uint32_t DecorationBufferBlock = 3;
+static constexpr uint32_t DecorationArrayStride = 6;
+static constexpr uint32_t DecorationMatrixStride = 7;
+static constexpr uint32_t DecorationBinding = 33;
+static constexpr uint32_t DecorationDescriptorSet = 34;
+static constexpr uint32_t DecorationOffset = 35;
+
+static constexpr uint32_t StorageClassUniformConstant = 0;
+static constexpr uint32_t StorageClassUniform = 2;
+static constexpr uint32_t StorageClassPushConstant = 9;
+static constexpr uint32_t StorageClassStorageBuffer = 12;
+static constexpr uint32_t StorageClassPhysicalStorageBuffer = 5349;
+
+static constexpr uint32_t DimBuffer = 5;
+static constexpr uint32_t DimSubpassData = 6;
+
+} // namespace spv
+
+namespace {
+
+struct Decorations {
+  uint32_t set = UINT32_MAX;
+  uint32_t binding = UINT32_MAX;
+  uint32_t arrayStride = 0;
+  bool block = false;
+  bool bufferBlock = false;
+};
+
+struct MemberDecorations {
+  uint32_t offset = 0;
+  uint32_t matrixStride = 0;
+};
+
+//
+// ---- Module ---------------------------------
+//
+// Indexes a module's instructions by result id, so type declarations can be followed without another pass.
+//
+class Module final {
+public:
+  explicit Module(std::span<const uint32_t> code)
+    : mCode(code),
+      mBound(code[3]),
+      mDefinitions(mBound, 0),
+      mDecorations(mBound) {}
+
+  // Returns false if an instruction runs past the end of the module or names an id outside the bound.
+  bool Index(ShaderReflection& reflection, std::vector<uint32_t>& variables) {
+    bool foundEntryPoint = false;
+
+    for (size_t i = spv::HeaderWords; i < mCode.size();) {
+      uint32_t opcode = mCode[i] & 0xFFFF;
+      uint32_t wordCount = mCode[i] >> 16;
+
+      if (wordCount == 0 || i + wordCount > mCode.size()) {
+        return false;
+      }
+
+      auto operand = [&](uint32_t index) {
+        return index < wordCount ? mCode[i + index] : UINT32_MAX;
+      };
+
+      switch (opcode) {
+      case spv::OpEntryPoint:
+        if (!foundEntryPoint) {
+          reflection.stage = ToStage(operand(1));
+          foundEntryPoint = true;
+        }
+        break;
+      case spv::OpTypeBool:
+      case spv::OpTypeInt:
+      case spv::OpTypeFloat:
+      case spv::OpTypeVector:
+      case spv::OpTypeMatrix:
+      case spv::OpTypeImage:
+      case spv::OpTypeSampler:
+      case spv::OpTypeSampledImage:
+      case spv::OpTypeArray:
+      case spv::OpTypeRuntimeArray:
+      case spv::OpTypeStruct:
+      case spv::OpTypePointer:
+      case spv::OpTypeAccelerationStructureKHR:
+        if (!Define(operand(1), i)) {
+          return false;
+        }
+        break;
+      case spv::OpConstant:
+      case spv::OpVariable:
+        if (!Define(operand(2), i)) {
+          return false;
+        }
+
+        if (opcode == spv::OpVariable) {
+          variables.push_back(operand(2));
+        }
+        break;
+      case spv::OpDecorate:
+        if (operand(1) >= mBound) {
+          return false;
+        }
+
+        Decorate(mDecorations[operand(1)], operand(2), operand(3));
+        break;
+      case spv::OpMemberDecorate:
+        if (operand(1) >= mBound) {
+          return false;
+        }
+
+        DecorateMember(operand(1), operand(2), operand(3), operand(4));
+        break;
+      }
+
+      i += wordCount;
+    }
+
+    return foundEntryPoint;
+  }
+
+  // Word `index` of the instruction defining `id`; UINT32_MAX past its end or for unknown ids.
+  uint32_t Operand(uint32_t id, uint32_t index) const {
+    if (id >= mBound || mDefinitions[id] == 0) {
+      return UINT32_MAX;
+    }
+
+    size_t start = mDefinitions[id];
+    return index < (mCode[start] >> 16) ? mCode[start + index] : UINT32_MAX;
+  }
+
+  uint32_t Opcode(uint32_t id) const {
+    return Operand(id, 0) & 0xFFFF;
+  }
+
+  const Decorations& GetDecorations(uint32_t id) const {
+    static const Decorations none;
+    return id < mBound ? mDecorations[id] : none;
+  }
+
+  // Byte size of a value of type `id` laid out as its decorations say. 0 for runtime arrays and unknown types.
+  uint32_t SizeOf(uint32_t id, uint32_t matrixStride = 0, uint32_t depth = 0) const {
+    // Types cannot be recursive, so a deep chain is a malformed module.
+    if (depth > 32) {
+      return 0;
+    }
+
+    switch (Opcode(id)) {
+    case spv::OpTypeBool:
+      return 4;
+    case spv::OpTypeInt:
+    case spv::OpTypeFloat:
+      return Operand(id, 2) / 8;
+    case spv::OpTypeVector:
+      return Operand(id, 3) * SizeOf(Operand(id, 2), 0, depth + 1);
+    case spv::OpTypeMatrix: {
+      uint32_t columnSize = matrixStride != 0 ? matrixStride : SizeOf(Operand(id, 2), 0, depth + 1);
+      return Operand(id, 3) * columnSize;
+    }
+    case spv::OpTypeArray: {
+      uint32_t length = Operand(Operand(id, 3), 3);
+      uint32_t stride = GetDecorations(id).arrayStride;
+      return length * (stride != 0 ? stride : SizeOf(Operand(id, 2), matrixStride, depth + 1));
+    }
+    case spv::OpTypeStruct: {
+      uint32_t size = 0;
+      auto members = mMembers.find(id);
+
+      for (uint32_t member = 0; Operand(id, 2 + member) != UINT32_MAX; member++) {
+        MemberDecorations decorations{};
+
+        if (members != mMembers.end() && member < members->second.size()) {
+          decorations = members->second[member];
+        }
+
+        uint32_t memberSize = SizeOf(Operand(id, 2 + member), decorations.matrixStride, depth + 1);
+        size = std::max(size, decorations.offset + memberSize);
+      }
+
+      return size;
+    }
+    case spv::OpTypePointer:
+      return Operand(id, 2) == spv::StorageClassPhysicalStorageBuffer ? 8 : 0;
+    default:
+      return 0;
+    }
+  }
+
+private:
+  static VkShaderStageFlagBits ToStage(uint32_t executionModel) {
+    switch (executionModel) {
+    case 0:
+      return VK_SHADER_STAGE_VERTEX_BIT;
+    case 1:
+      return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+    case 2:
+      return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+    case 3:
+      return VK_SHADER_STAGE_GEOMETRY_BIT;
+    case 4:
+      return VK_SHADER_STAGE_FRAGMENT_BIT;
+    case 5:
+      return VK_SHADER_STAGE_COMPUTE_BIT;
+    default:
+      return VK_SHADER_STAGE_ALL;
+    }
+  }
+
+  bool Define(uint32_t id, size_t word) {
+    if (id >= mBound) {
+      return false;
+    }
+
+    mDefinitions[id] = static_cast<uint32_t>(word);
+    return true;
+  }
+
+  static void Decorate(Decorations& decorations, uint32_t decoration, uint32_t value) {
+    switch (decoration) {
+    case spv::DecorationBlock:
+      decorations.block = true;
+      break;
+    case spv::DecorationBufferBlock:
+      decorations.bufferBlock = true;
+      break;
+    case spv::DecorationArrayStride:
+      decorations.arrayStride = value;
+      break;
+    case spv::DecorationBinding:
+      decorations.binding = value;
+      break;
+    case spv::DecorationDescriptorSet:
+      decorations.set = value;
+      break;
+    }
+  }
+
+  void DecorateMember(uint32_t structId, uint32_t member, uint32_t decoration, uint32_t value) {
+    if (decoration != spv::DecorationOffset && decoration != spv::DecorationMatrixStride) {
+      return;
+    }
+
+    // Guards against absurd member indices in malformed modules; real structs are far smaller.
+    if (member >= 4096) {
+      return;
+    }
+
+    std::vector<MemberDecorations>& members = mMembers[structId];
+
+    if (members.size() <= member) {
+      members.resize(member + 1);
+    }
+
+    if (decoration == spv::DecorationOffset) {
+      members[member].offset = value;
+    }
+    else {
+      members[member].matrixStride = value;
+    }
+  }
+
+private:
+  std::span<const uint32_t> mCode;
+  uint32_t mBound;
+  // Word offset of the instruction defining each id; 0 (the header) for ids without one.
+  std::vector<uint32_t> mDefinitions;
+  std::vector<Decorations> mDecorations;
+  std::unordered_map<uint32_t, std::vector<MemberDecorations>> mMembers;
+};
+
+} // namespace
+
+static VkDescriptorType ToDescriptorType(const Module& module, uint32_t storageClass, uint32_t type) {
+  switch (module.Opcode(type)) {
+  case spv::OpTypeSampler:
+    return VK_DESCRIPTOR_TYPE_SAMPLER;
+  case spv::OpTypeSampledImage:
+    return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+  case spv::OpTypeImage: {
+    uint32_t dim = module.Operand(type, 3);
+    // 1: used with a sampler, 2: read and written without one.
+    bool storage = module.Operand(type, 7) == 2;
+
+    if (dim == spv::DimSubpassData) {
+      return VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+    }
+
+    if (dim == spv::DimBuffer) {
+      return storage ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+    }
+
+    return storage ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+  }
+  case spv::OpTypeAccelerationStructureKHR:
+    return VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
+  case spv::OpTypeStruct:
+    if (storageClass == spv::StorageClassStorageBuffer || module.GetDecorations(type).bufferBlock) {
+      return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    }
+
+    return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+  default:
+    return VK_DESCRIPTOR_TYPE_MAX_ENUM;
+  }
+}
+
+bool ReflectShader(std::span<const uint32_t> code, ShaderReflection& reflection) {
+  reflection = {};
+
+  // Ids are bounded by the module's size in any real module; a larger bound means a corrupt header.
+  if (code.size() < spv::HeaderWords || code[0] != spv::Magic || code[3] > code.size()) {
+    return false;
+  }
+
+  Module module(code);
+  std::vector<uint32_t> variables;
+
+  if (!module.Index(reflection, variables)) {
+    return false;
+  }
+
+  for (uint32_t variable : variables) {
+    uint32_t storageClass = module.Operand(variable, 3);
+    // Variables are pointers; what they point to is the resource.
+    uint32_t type = module.Operand(module.Operand(variable, 1), 3);
+
+    if (storageClass == spv::StorageClassPushConstant) {
+      reflection.pushConstantSize = std::max(reflection.pushConstantSize, module.SizeOf(type));
+      continue;
+    }
+
+    if (storageClass != spv::StorageClassUniformConstant && storageClass != spv::StorageClassUniform
+        && storageClass != spv::StorageClassStorageBuffer) {
+      continue;
+    }
+
+    const Decorations& decorations = module.GetDecorations(variable);
+
+    if (decorations.set == UINT32_MAX || decorations.binding == UINT32_MAX) {
+      continue;
+    }
+
+    ShaderBinding binding{};
+    binding.set = decorations.set;
+    binding.binding = decorations.binding;
+    binding.stages = reflection.stage;
+
+    if (module.Opcode(type) == spv::OpTypeArray) {
+      binding.count = module.Operand(module.Operand(type, 3), 3);
+      type = module.Operand(type, 2);
+    }
+    else if (module.Opcode(type) == spv::OpTypeRuntimeArray) {
+      binding.count = 0;
+      type = module.Operand(type, 2);
+    }
+
+    binding.type = ToDescriptorType(module, storageClass, type);
+
+    if (binding.type != VK_DESCRIPTOR_TYPE_MAX_ENUM) {
+      reflection.bindings.push_back(binding);
+    }
+  }
+
+  auto sameSlot = [](const ShaderBinding& a, const ShaderBinding& b) {
+    return a.set == b.set && a.binding == b.binding;
+  };
+
+  std::sort(reflection.bindings.begin(), reflection.bindings.end(), [](const auto& a, const auto& b) {
+    return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+  });
+
+  // Several blocks may alias one binding, like the typed views of the bindless storage buffer array.
+  auto end = std::unique(reflection.bindings.begin(), reflection.bindings.end(), sameSlot);
+  reflection.bindings.erase(end, reflection.bindings.end());
+
+  return true;
+}
+
+} // namespace qpl
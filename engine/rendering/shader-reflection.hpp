@@ -0,0 +1,42 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#ifndef QPL_SHADER_REFLECTION_HPP
+#define QPL_SHADER_REFLECTION_HPP
+
+#include <span>
+#include <vector>
+#include <cstdint>
+
+#include <vulkan/vulkan.h>
+#include <core/core.hpp>
+
+namespace qpl {
+
+struct ShaderBinding {
+  uint32_t set = 0;
+  uint32_t binding = 0;
+  VkDescriptorType type = VK_DESCRIPTOR_TYPE_MAX_ENUM;
+  // Array size; 0 for runtime-sized arrays.
+  uint32_t count = 1;
+  VkShaderStageFlags stages = 0;
+};
+
+// The interface a SPIR-V module declares towards its pipeline layout.
+struct ShaderReflection {
+  VkShaderStageFlagBits stage = VK_SHADER_STAGE_ALL;
+  // Sorted by set, then binding.
+  std::vector<ShaderBinding> bindings;
+  // Bytes of the push constant block, 0 if there is none.
+  uint32_t pushConstantSize = 0;
+};
+
+// Reads the descriptor bindings and push constant block of `code`'s single entry point. Only the declarations are
+// looked at, not which of them the entry point uses. Returns false if `code` is not a SPIR-V module or declares no
+// entry point.
+bool ReflectShader(std::span<const uint32_t> code, ShaderReflection& reflection);
+
+} // namespace qpl
+
+#endif
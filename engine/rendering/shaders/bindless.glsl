@@ -0,0 +1,29 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+// The bindless heap, set 0 of every pipeline. Must match BindlessType in bindless-heap.hpp. Resources are picked by
+// the BindlessIndex they were registered under; indices that may differ within a draw or workgroup have to be wrapped
+// in nonuniformEXT() where the array is indexed.
+
+#extension GL_EXT_nonuniform_qualifier : require
+
+#define BINDLESS_SAMPLED_IMAGES 0
+#define BINDLESS_STORAGE_BUFFERS 1
+#define BINDLESS_SAMPLERS 2
+
+layout(set = 0, binding = BINDLESS_SAMPLED_IMAGES) uniform texture2D bindlessTextures[];
+layout(set = 0, binding = BINDLESS_SAMPLERS) uniform sampler bindlessSamplers[];
+
+// Storage buffers of every type share one array; each type declares its own view of it:
+//
+//   BINDLESS_BUFFER(readonly, Particles, { Particle particles[]; });
+//   ... Particles[index].particles[i] ...
+#define BINDLESS_BUFFER(Qualifiers, Name, Members) \
+  layout(std430, set = 0, binding = BINDLESS_STORAGE_BUFFERS) Qualifiers buffer Name##Block Members Name[]
+
+vec4 SampleBindless(uint textureIndex, uint samplerIndex, vec2 uv) {
+  return texture(
+    sampler2D(bindlessTextures[nonuniformEXT(textureIndex)], bindlessSamplers[nonuniformEXT(samplerIndex)]), uv
+  );
+}
@@ -0,0 +1,17 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#version 460
+
+layout(location = 0) in vec3 inNormal;
+layout(location = 1) in vec4 inColor;
+
+layout(location = 0) out vec4 outColor;
+
+const vec3 LightDirection = normalize(vec3(0.4, 1.0, 0.3));
+
+void main() {
+  float diffuse = max(dot(normalize(inNormal), LightDirection), 0.0);
+  outColor = vec4(inColor.rgb * (0.2 + 0.8 * diffuse), inColor.a);
+}
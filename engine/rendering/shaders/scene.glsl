@@ -0,0 +1,59 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+// Scene data shared by the culling and drawing shaders. Must match the structs in gpu-scene.hpp.
+
+#include "bindless.glsl"
+
+struct SceneObject {
+  mat4 transform;
+  // World space bounding sphere: center in xyz, radius in w.
+  vec4 bounds;
+  vec4 color;
+  uint mesh;
+  uint batch;
+  uint pad0;
+  uint pad1;
+};
+
+struct SceneMesh {
+  uint indexCount;
+  uint firstIndex;
+  int vertexOffset;
+  uint pad0;
+};
+
+struct SceneVertex {
+  float px, py, pz;
+  float nx, ny, nz;
+};
+
+struct DrawCommand {
+  uint indexCount;
+  uint instanceCount;
+  uint firstIndex;
+  int vertexOffset;
+  uint firstInstance;
+};
+
+// Marks a free object slot.
+const uint InvalidMesh = 0xFFFFFFFFu;
+
+// Bindless indices of the scene's buffers. Passed in push constants.
+struct SceneBuffers {
+  uint objects;
+  uint meshes;
+  uint vertices;
+  uint batches;
+  uint draws;
+  uint drawCounts;
+};
+
+BINDLESS_BUFFER(readonly, SceneObjects, { SceneObject objects[]; });
+BINDLESS_BUFFER(readonly, SceneMeshes, { SceneMesh meshes[]; });
+BINDLESS_BUFFER(readonly, SceneVertices, { SceneVertex vertices[]; });
+// First draw command slot of every batch.
+BINDLESS_BUFFER(readonly, SceneBatches, { uint drawOffsets[]; });
+BINDLESS_BUFFER(SCENE_DRAWS_QUALIFIER, SceneDraws, { DrawCommand draws[]; });
+BINDLESS_BUFFER(SCENE_DRAWS_QUALIFIER, SceneDrawCounts, { uint drawCounts[]; });
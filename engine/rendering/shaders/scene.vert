@@ -0,0 +1,26 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#version 460
+#extension GL_GOOGLE_include_directive : require
+
+#define SCENE_DRAWS_QUALIFIER readonly
+#include "scene.glsl"
+
+layout(push_constant) uniform Camera {
+  mat4 viewProjection;
+  SceneBuffers buffers;
+} camera;
+
+layout(location = 0) out vec3 outNormal;
+layout(location = 1) out vec4 outColor;
+
+void main() {
+  SceneObject object = SceneObjects[camera.buffers.objects].objects[gl_InstanceIndex];
+  SceneVertex vertex = SceneVertices[camera.buffers.vertices].vertices[gl_VertexIndex];
+
+  gl_Position = camera.viewProjection * object.transform * vec4(vertex.px, vertex.py, vertex.pz, 1.0);
+  outNormal = mat3(object.transform) * vec3(vertex.nx, vertex.ny, vertex.nz);
+  outColor = object.color;
+}
@@ -0,0 +1,722 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#include "texture-streamer.hpp"
+
+#include <bit>
+#include <cmath>
+#include <format>
+#include <limits>
+#include <cstring>
+#include <algorithm>
+
+namespace qpl {
+
+QPL_INLINE static VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment) {
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+QPL_INLINE static uint32_t GetMipExtent(uint32_t extent, uint32_t level) {
+  return std::max(extent >> level, 1u);
+}
+
+std::string GetTextureMipName(std::string_view name, uint32_t level) {
+  return std::format("{}.mip{}", name, level);
+}
+
+uint64_t GetTextureMipSize(const TextureHeader& header, uint32_t level) {
+  uint64_t blocksX = (GetMipExtent(header.width, level) + header.blockExtent - 1) / header.blockExtent;
+  uint64_t blocksY = (GetMipExtent(header.height, level) + header.blockExtent - 1) / header.blockExtent;
+  return blocksX * blocksY * header.blockSize;
+}
+
+bool WriteTexture(
+  AssetArchiveWriter& writer,
+  std::string_view name,
+  const TextureHeader& header,
+  std::span<const std::span<const std::byte>> mips,
+  AssetCompression compression
+) {
+  if (header.mipCount == 0 || mips.size() != header.mipCount) {
+    LogError("Renderer - Texture {} has {} mips, but its header says {}", name, mips.size(), header.mipCount);
+    return false;
+  }
+
+  for (uint32_t level = 0; level < header.mipCount; level++) {
+    if (mips[level].size() != GetTextureMipSize(header, level)) {
+      LogError(
+        "Renderer - Mip {} of texture {} is {} bytes, expected {}",
+        level,
+        name,
+        mips[level].size(),
+        GetTextureMipSize(header, level)
+      );
+      return false;
+    }
+
+    if (!writer.Add(GetTextureMipName(name, level), mips[level], compression)) {
+      return false;
+    }
+  }
+
+  // Headers are read on their own and are too small to be worth compressing.
+  return writer.Add(name, std::as_bytes(std::span(&header, 1)), AssetCompression::None);
+}
+
+float GetProjectedSize(float worldSize, float distance, float verticalFov, uint32_t viewportHeight) {
+  float viewHeight = 2.0f * std::max(distance, 1e-4f) * std::tan(verticalFov * 0.5f);
+  return worldSize / viewHeight * static_cast<float>(viewportHeight);
+}
+
+void TextureStreamer::Init(
+  VkDevice device,
+  VkPhysicalDevice physicalDevice,
+  GpuAllocator& allocator,
+  UploadRing& uploadRing,
+  AssetStreamer& assetStreamer,
+  BindlessHeap& bindlessHeap,
+  GpuTimeline& graphicsTimeline,
+  bool memoryBudget,
+  const TextureStreamerConfig& config
+) {
+  mDevice = device;
+  mPhysicalDevice = physicalDevice;
+  mAllocator = &allocator;
+  mUploadRing = &uploadRing;
+  mAssetStreamer = &assetStreamer;
+  mBindlessHeap = &bindlessHeap;
+  mGraphicsTimeline = &graphicsTimeline;
+  mMemoryBudget = memoryBudget;
+  mConfig = config;
+  mConfig.requestLifetime = std::max(mConfig.requestLifetime, 1u);
+  mConfig.maxTransitions = std::max(mConfig.maxTransitions, 1u);
+
+  // Textures go wherever device-local images do; with several device-local heaps, that is the largest one.
+  const VkPhysicalDeviceMemoryProperties& properties = mAllocator->GetMemoryProperties();
+
+  for (uint32_t i = 0; i < properties.memoryHeapCount; i++) {
+    bool deviceLocal = (properties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+
+    if (deviceLocal && properties.memoryHeaps[i].size > properties.memoryHeaps[mHeapIndex].size) {
+      mHeapIndex = i;
+    }
+  }
+
+  mBudget = QueryBudget();
+
+  LogInfo(
+    "Renderer - Creating TextureStreamer (budget {} MiB, {})",
+    mBudget >> 20,
+    mMemoryBudget ? "tracking VK_EXT_memory_budget" : "fixed"
+  );
+
+  CreateFallback();
+}
+
+void TextureStreamer::Destroy() {
+  if (mAllocator == nullptr) {
+    return;
+  }
+
+  for (Texture& texture : mTextures) {
+    if (!texture.live) {
+      continue;
+    }
+
+    if (texture.headerStream != InvalidStreamHandle) {
+      mAssetStreamer->Release(texture.headerStream);
+    }
+
+    if (texture.transition != nullptr) {
+      for (StreamHandle stream : texture.transition->streams) {
+        mAssetStreamer->Release(stream);
+      }
+
+      DestroyImage(texture.transition->image, VK_NULL_HANDLE);
+    }
+
+    DestroyImage(texture.image, texture.view);
+  }
+
+  for (Transition& transition : mAbandoned) {
+    DestroyImage(transition.image, VK_NULL_HANDLE);
+  }
+
+  for (RetiredImage& retired : mRetired) {
+    DestroyImage(retired.image, retired.view);
+  }
+
+  DestroyImage(mFallbackImage, mFallbackView);
+
+  mTextures.clear();
+  mFreeHandles.clear();
+  mAbandoned.clear();
+  mRetired.clear();
+  mAllocator = nullptr;
+}
+
+TextureHandle TextureStreamer::Load(std::string_view name) {
+  StreamRequest request;
+  request.name = name;
+  // Tiny, and nothing can be decided about a texture before it is in.
+  request.priority = std::numeric_limits<float>::max();
+
+  StreamHandle stream = mAssetStreamer->Request(request);
+
+  if (stream == InvalidStreamHandle) {
+    return InvalidTextureHandle;
+  }
+
+  TextureHandle handle;
+
+  if (!mFreeHandles.empty()) {
+    handle = mFreeHandles.back();
+    mFreeHandles.pop_back();
+  }
+  else {
+    handle = static_cast<TextureHandle>(mTextures.size());
+    mTextures.emplace_back();
+  }
+
+  Texture& texture = mTextures[handle];
+  texture.name = name;
+  texture.live = true;
+  texture.headerStream = stream;
+  return handle;
+}
+
+void TextureStreamer::Release(TextureHandle handle) {
+  QPL_CORE_ASSERT(handle < mTextures.size() && mTextures[handle].live && "invalid texture handle");
+
+  Texture& texture = mTextures[handle];
+
+  if (texture.headerStream != InvalidStreamHandle) {
+    mAssetStreamer->Release(texture.headerStream);
+  }
+
+  if (texture.transition != nullptr) {
+    AbandonTransition(texture);
+  }
+
+  RetireResidency(texture);
+
+  texture = {};
+  mFreeHandles.push_back(handle);
+}
+
+void TextureStreamer::RequestMip(TextureHandle handle, uint32_t mip, float priority) {
+  QPL_CORE_ASSERT(handle < mTextures.size() && mTextures[handle].live && "invalid texture handle");
+
+  Texture& texture = mTextures[handle];
+
+  // The finest level wins until its request expires, so a coarser request in between does not evict it.
+  if (mip <= texture.requestedMip || mFrame - texture.requestedFrame >= mConfig.requestLifetime) {
+    texture.requestedMip = mip;
+    texture.requestedFrame = mFrame;
+  }
+
+  texture.priority = texture.lastRequestFrame == mFrame ? std::max(texture.priority, priority) : priority;
+  texture.lastRequestFrame = mFrame;
+}
+
+void TextureStreamer::RequestScreenSize(TextureHandle handle, float screenSize, float priority) {
+  QPL_CORE_ASSERT(handle < mTextures.size() && mTextures[handle].live && "invalid texture handle");
+
+  const TextureHeader& header = mTextures[handle].header;
+
+  // The texture's size is unknown until its header is in, and until then only its tail can be loaded anyway.
+  if (header.mipCount == 0) {
+    return;
+  }
+
+  float texels = static_cast<float>(std::max(header.width, header.height));
+  float mip = screenSize > 0.0f ? std::floor(std::log2(texels / screenSize)) : static_cast<float>(header.mipCount);
+
+  RequestMip(handle, static_cast<uint32_t>(std::clamp(mip, 0.0f, static_cast<float>(header.mipCount))), priority);
+}
+
+void TextureStreamer::Update() {
+  ReleaseRetired();
+
+  mBudget = QueryBudget();
+
+  for (Texture& texture : mTextures) {
+    if (texture.live && texture.headerStream != InvalidStreamHandle) {
+      PollHeader(texture);
+    }
+  }
+
+  ApplyBudget();
+
+  for (Texture& texture : mTextures) {
+    if (texture.live && texture.transition != nullptr) {
+      ProgressTransition(texture);
+    }
+  }
+
+  StartTransitions();
+
+  // Requests made from here on count towards the next frame.
+  mFrame++;
+}
+
+BindlessIndex TextureStreamer::GetBindlessIndex(TextureHandle handle) const {
+  QPL_CORE_ASSERT(handle < mTextures.size() && mTextures[handle].live && "invalid texture handle");
+
+  BindlessIndex index = mTextures[handle].bindlessIndex;
+  return index != InvalidBindlessIndex ? index : mFallbackIndex;
+}
+
+uint32_t TextureStreamer::GetResidentMip(TextureHandle handle) const {
+  QPL_CORE_ASSERT(handle < mTextures.size() && mTextures[handle].live && "invalid texture handle");
+  return mTextures[handle].residentMip;
+}
+
+TextureStreamerStats TextureStreamer::GetStats() const {
+  TextureStreamerStats stats{};
+  stats.residentBytes = mResidentBytes;
+  stats.wantedBytes = mWantedBytes;
+  stats.budget = mBudget;
+
+  for (const Texture& texture : mTextures) {
+    stats.textureCount += texture.live ? 1 : 0;
+    stats.transitionCount += texture.transition != nullptr ? 1 : 0;
+  }
+
+  return stats;
+}
+
+void TextureStreamer::CreateFallback() {
+  VkImageCreateInfo imageInfo{};
+  imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+  imageInfo.imageType = VK_IMAGE_TYPE_2D;
+  imageInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+  imageInfo.extent = {1, 1, 1};
+  imageInfo.mipLevels = 1;
+  imageInfo.arrayLayers = 1;
+  imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+  imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+  imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+  imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+  mFallbackImage = mAllocator->CreateImage(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+  // Counted like any other image, as Destroy() frees it through DestroyImage().
+  mResidentBytes += mFallbackImage.allocation.size;
+
+  VkBufferImageCopy region{};
+  region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+  region.imageExtent = {1, 1, 1};
+
+  // The first frame waits on the transfer that carries it, so the fallback is valid from the start.
+  const std::byte white[4] = {std::byte{0xff}, std::byte{0xff}, std::byte{0xff}, std::byte{0xff}};
+  mUploadRing->UploadImage(mFallbackImage.image, std::span(&region, 1), white);
+
+  VkImageViewCreateInfo viewInfo{};
+  viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+  viewInfo.image = mFallbackImage.image;
+  viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+  viewInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+  viewInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+
+  if (vkCreateImageView(mDevice, &viewInfo, nullptr, &mFallbackView) != VK_SUCCESS) {
+    QPL_CORE_ASSERT(false && "failed to create fallback texture view!");
+  }
+
+  mFallbackIndex = mBindlessHeap->AddSampledImage(mFallbackView);
+}
+
+void TextureStreamer::PollHeader(Texture& texture) {
+  StreamState state = mAssetStreamer->GetState(texture.headerStream);
+
+  if (state != StreamState::Complete && state != StreamState::Failed) {
+    return;
+  }
+
+  std::span<const std::byte> data = mAssetStreamer->GetData(texture.headerStream);
+  TextureHeader header;
+
+  bool valid = data.size() == sizeof(header);
+
+  if (valid) {
+    std::memcpy(&header, data.data(), sizeof(header));
+
+    uint32_t maxMipCount = std::bit_width(std::max(header.width, header.height));
+
+    valid = header.magic == TextureMagic && header.version == TextureVersion && header.format != VK_FORMAT_UNDEFINED
+      && header.mipCount != 0 && header.mipCount <= maxMipCount && header.blockExtent != 0
+      && std::has_single_bit(header.blockSize) && header.blockSize <= UploadRing::CopyAlignment;
+  }
+
+  mAssetStreamer->Release(texture.headerStream);
+  texture.headerStream = InvalidStreamHandle;
+
+  if (!valid) {
+    LogError("Renderer - {} is not a valid texture", texture.name);
+    texture.failed = true;
+    return;
+  }
+
+  texture.header = header;
+  texture.residentMip = header.mipCount;
+  texture.tailMip = header.mipCount - 1;
+
+  while (texture.tailMip > 0
+         && std::max(GetMipExtent(header.width, texture.tailMip - 1), GetMipExtent(header.height, texture.tailMip - 1))
+           <= mConfig.tailSize) {
+    texture.tailMip--;
+  }
+
+  // Image uploads are staged whole, so a chain larger than the upload ring can never be made resident. Every level
+  // may be padded to the ring's alignment.
+  texture.finestMip = 0;
+
+  while (texture.finestMip < texture.tailMip
+         && GetChainSize(header, texture.finestMip) + header.mipCount * UploadRing::CopyAlignment
+           > mUploadRing->GetCapacity()) {
+    texture.finestMip++;
+  }
+
+  if (texture.finestMip > 0) {
+    LogWarning(
+      "Renderer - Texture {} streams from mip {} on, finer mips do not fit into the upload ring",
+      texture.name,
+      texture.finestMip
+    );
+  }
+}
+
+void TextureStreamer::ApplyBudget() {
+  std::vector<Texture*> evictable;
+  uint64_t wantedBytes = 0;
+
+  for (Texture& texture : mTextures) {
+    if (!texture.live || texture.header.mipCount == 0 || texture.failed) {
+      continue;
+    }
+
+    bool requested = mFrame - texture.requestedFrame < mConfig.requestLifetime;
+    uint32_t mip = requested ? std::min(texture.requestedMip, texture.tailMip) : texture.tailMip;
+
+    texture.targetMip = std::max(mip, texture.finestMip);
+    wantedBytes += GetChainSize(texture.header, texture.targetMip);
+
+    if (texture.targetMip < texture.tailMip) {
+      evictable.push_back(&texture);
+    }
+  }
+
+  mWantedBytes = wantedBytes;
+
+  if (wantedBytes <= mBudget) {
+    return;
+  }
+
+  std::sort(evictable.begin(), evictable.end(), [](const Texture* a, const Texture* b) {
+    return a->priority != b->priority ? a->priority < b->priority : a->lastRequestFrame < b->lastRequestFrame;
+  });
+
+  // The least important texture gives up all of its detail above the tail before the next one loses any.
+  for (Texture* texture : evictable) {
+    while (wantedBytes > mBudget && texture->targetMip < texture->tailMip) {
+      wantedBytes -= GetTextureMipSize(texture->header, texture->targetMip);
+      texture->targetMip++;
+    }
+
+    if (wantedBytes <= mBudget) {
+      break;
+    }
+  }
+}
+
+void TextureStreamer::StartTransitions() {
+  std::vector<Texture*> candidates;
+  uint32_t inFlight = 0;
+
+  for (Texture& texture : mTextures) {
+    if (!texture.live) {
+      continue;
+    }
+
+    if (texture.transition != nullptr) {
+      inFlight++;
+    }
+    else if (texture.header.mipCount != 0 && !texture.failed && texture.targetMip != texture.residentMip) {
+      candidates.push_back(&texture);
+    }
+  }
+
+  // Textures without anything resident go first, since they cannot be drawn at all, and evictions next, since they
+  // make room for the rest. Whatever remains is refined in priority order.
+  auto rank = [](const Texture* texture) {
+    return texture->image.image == VK_NULL_HANDLE ? 0 : texture->targetMip > texture->residentMip ? 1 : 2;
+  };
+
+  std::sort(candidates.begin(), candidates.end(), [&](const Texture* a, const Texture* b) {
+    return rank(a) != rank(b) ? rank(a) < rank(b) : a->priority > b->priority;
+  });
+
+  for (Texture* texture : candidates) {
+    if (inFlight >= mConfig.maxTransitions) {
+      break;
+    }
+
+    BeginTransition(*texture);
+    inFlight += texture->transition != nullptr ? 1 : 0;
+  }
+}
+
+void TextureStreamer::BeginTransition(Texture& texture) {
+  auto transition = std::make_unique<Transition>();
+  transition->firstMip = texture.targetMip;
+
+  for (uint32_t mip = transition->firstMip; mip < texture.header.mipCount; mip++) {
+    StreamRequest request;
+    std::string name = GetTextureMipName(texture.name, mip);
+    request.name = name;
+    request.priority = texture.priority;
+
+    StreamHandle stream = mAssetStreamer->Request(request);
+
+    if (stream == InvalidStreamHandle) {
+      for (StreamHandle started : transition->streams) {
+        mAssetStreamer->Release(started);
+      }
+
+      texture.failed = true;
+      return;
+    }
+
+    transition->streams.push_back(stream);
+  }
+
+  texture.transition = std::move(transition);
+}
+
+void TextureStreamer::ProgressTransition(Texture& texture) {
+  Transition& transition = *texture.transition;
+
+  if (transition.ticket != 0) {
+    if (mUploadRing->IsComplete(transition.ticket)) {
+      CompleteTransition(texture);
+    }
+
+    return;
+  }
+
+  // Nothing is allocated before the upload, so a transition that is no longer wanted is simply dropped.
+  if (transition.firstMip != texture.targetMip) {
+    AbandonTransition(texture);
+    return;
+  }
+
+  bool complete = true;
+
+  for (StreamHandle stream : transition.streams) {
+    StreamState state = mAssetStreamer->GetState(stream);
+
+    if (state == StreamState::Failed) {
+      LogError("Renderer - Failed to stream texture {}", texture.name);
+      AbandonTransition(texture);
+      texture.failed = true;
+      return;
+    }
+
+    complete = complete && state == StreamState::Complete;
+  }
+
+  if (complete) {
+    UploadTransition(texture);
+  }
+}
+
+void TextureStreamer::UploadTransition(Texture& texture) {
+  Transition& transition = *texture.transition;
+  const TextureHeader& header = texture.header;
+  uint32_t levelCount = header.mipCount - transition.firstMip;
+
+  std::vector<VkBufferImageCopy> regions(levelCount);
+  std::vector<std::byte> data;
+  data.reserve(GetChainSize(header, transition.firstMip) + levelCount * UploadRing::CopyAlignment);
+
+  for (uint32_t i = 0; i < levelCount; i++) {
+    uint32_t mip = transition.firstMip + i;
+    std::span<const std::byte> level = mAssetStreamer->GetData(transition.streams[i]);
+
+    if (level.size() != GetTextureMipSize(header, mip)) {
+      LogError("Renderer - Mip {} of texture {} has the wrong size", mip, texture.name);
+      AbandonTransition(texture);
+      texture.failed = true;
+      return;
+    }
+
+    VkDeviceSize offset = AlignUp(data.size(), UploadRing::CopyAlignment);
+    data.resize(offset + level.size());
+    std::memcpy(data.data() + offset, level.data(), level.size());
+
+    VkBufferImageCopy& region = regions[i];
+    region.bufferOffset = offset;
+    region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, i, 0, 1};
+    region.imageExtent = {GetMipExtent(header.width, mip), GetMipExtent(header.height, mip), 1};
+  }
+
+  for (StreamHandle stream : transition.streams) {
+    mAssetStreamer->Release(stream);
+  }
+
+  transition.streams.clear();
+
+  VkImageCreateInfo imageInfo{};
+  imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+  imageInfo.imageType = VK_IMAGE_TYPE_2D;
+  imageInfo.format = static_cast<VkFormat>(header.format);
+  imageInfo.extent = regions[0].imageExtent;
+  imageInfo.mipLevels = levelCount;
+  imageInfo.arrayLayers = 1;
+  imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+  imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+  imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+  imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+  transition.image = mAllocator->CreateImage(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+  mResidentBytes += transition.image.allocation.size;
+
+  transition.ticket = mUploadRing->UploadImage(transition.image.image, regions, data);
+}
+
+void TextureStreamer::CompleteTransition(Texture& texture) {
+  Transition& transition = *texture.transition;
+
+  VkImageViewCreateInfo viewInfo{};
+  viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+  viewInfo.image = transition.image.image;
+  viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+  viewInfo.format = static_cast<VkFormat>(texture.header.format);
+  viewInfo.subresourceRange = {
+    VK_IMAGE_ASPECT_COLOR_BIT, 0, texture.header.mipCount - transition.firstMip, 0, 1
+  };
+
+  VkImageView view;
+
+  if (vkCreateImageView(mDevice, &viewInfo, nullptr, &view) != VK_SUCCESS) {
+    QPL_CORE_ASSERT(false && "failed to create texture view!");
+  }
+
+  // A new slot rather than an update of the old one: frames still in flight sample the old one.
+  BindlessIndex index = mBindlessHeap->AddSampledImage(view);
+
+  RetireResidency(texture);
+
+  texture.image = transition.image;
+  texture.view = view;
+  texture.bindlessIndex = index;
+  texture.residentMip = transition.firstMip;
+  texture.transition.reset();
+}
+
+void TextureStreamer::AbandonTransition(Texture& texture) {
+  Transition& transition = *texture.transition;
+
+  for (StreamHandle stream : transition.streams) {
+    mAssetStreamer->Release(stream);
+  }
+
+  transition.streams.clear();
+
+  // The upload ring may still be writing the image.
+  if (transition.image.image != VK_NULL_HANDLE) {
+    mAbandoned.push_back(std::move(transition));
+  }
+
+  texture.transition.reset();
+}
+
+void TextureStreamer::RetireResidency(Texture& texture) {
+  if (texture.image.image == VK_NULL_HANDLE) {
+    return;
+  }
+
+  // The frame being recorded may still sample the image, and it signals the value after the last submitted one.
+  mBindlessHeap->Free(BindlessType::SampledImage, texture.bindlessIndex);
+  mRetired.push_back({texture.image, texture.view, mGraphicsTimeline->GetLastSubmitted() + 1});
+
+  texture.image = {};
+  texture.view = VK_NULL_HANDLE;
+  texture.bindlessIndex = InvalidBindlessIndex;
+  texture.residentMip = texture.header.mipCount;
+}
+
+void TextureStreamer::ReleaseRetired() {
+  // Once its upload is done, an abandoned image is only referenced by the acquire barrier of a submitted frame.
+  std::erase_if(mAbandoned, [this](Transition& transition) {
+    if (!mUploadRing->IsComplete(transition.ticket)) {
+      return false;
+    }
+
+    mRetired.push_back({transition.image, VK_NULL_HANDLE, mGraphicsTimeline->GetLastSubmitted() + 1});
+    return true;
+  });
+
+  std::erase_if(mRetired, [this](RetiredImage& retired) {
+    if (!mGraphicsTimeline->IsComplete(retired.lastUsedValue)) {
+      return false;
+    }
+
+    DestroyImage(retired.image, retired.view);
+    return true;
+  });
+}
+
+void TextureStreamer::DestroyImage(GpuImage& image, VkImageView view) {
+  if (view != VK_NULL_HANDLE) {
+    vkDestroyImageView(mDevice, view, nullptr);
+  }
+
+  if (image.image == VK_NULL_HANDLE) {
+    return;
+  }
+
+  mResidentBytes -= image.allocation.size;
+  mAllocator->DestroyImage(image);
+}
+
+uint64_t TextureStreamer::QueryBudget() const {
+  const VkPhysicalDeviceMemoryProperties& properties = mAllocator->GetMemoryProperties();
+  uint64_t budget = mConfig.budget != 0 ? mConfig.budget : properties.memoryHeaps[mHeapIndex].size / 2;
+
+  if (!mMemoryBudget) {
+    return budget;
+  }
+
+  VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties{};
+  budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+  VkPhysicalDeviceMemoryProperties2 properties2{};
+  properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+  properties2.pNext = &budgetProperties;
+
+  vkGetPhysicalDeviceMemoryProperties2(mPhysicalDevice, &properties2);
+
+  // The heap's usage includes the textures themselves; what everything else takes, in this process or any other, is
+  // not theirs to have. A tenth of the heap's budget stays free for allocations that cannot wait for an eviction.
+  uint64_t heapBudget = budgetProperties.heapBudget[mHeapIndex];
+  uint64_t heapUsage = budgetProperties.heapUsage[mHeapIndex];
+  uint64_t otherUsage = heapUsage - std::min(heapUsage, mResidentBytes) + heapBudget / 10;
+  uint64_t available = heapBudget - std::min(heapBudget, otherUsage);
+
+  return mConfig.budget != 0 ? std::min(budget, available) : available;
+}
+
+uint64_t TextureStreamer::GetChainSize(const TextureHeader& header, uint32_t firstMip) {
+  uint64_t size = 0;
+
+  for (uint32_t level = firstMip; level < header.mipCount; level++) {
+    size += GetTextureMipSize(header, level);
+  }
+
+  return size;
+}
+
+} // namespace qpl
@@ -0,0 +1,251 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#ifndef QPL_TEXTURE_STREAMER_HPP
+#define QPL_TEXTURE_STREAMER_HPP
+
+#include <span>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <string_view>
+
+#include <vulkan/vulkan.h>
+#include <core/core.hpp>
+#include <assets/asset-archive.hpp>
+#include <assets/asset-streamer.hpp>
+#include "gpu-allocator.hpp"
+#include "gpu-timeline.hpp"
+#include "upload-ring.hpp"
+#include "bindless-heap.hpp"
+
+namespace qpl {
+
+// Index of a texture inside a TextureStreamer. Reused once the texture is released.
+using TextureHandle = uint32_t;
+
+QPL_INLINE_CONSTEXPR TextureHandle InvalidTextureHandle = UINT32_MAX;
+
+QPL_INLINE_CONSTEXPR uint32_t TextureMagic = 0x58455451; // "QTEX"
+QPL_INLINE_CONSTEXPR uint32_t TextureVersion = 1;
+
+// Describes a streamable texture. Stored as an archive entry under the texture's name, with every mip level in an
+// entry of its own next to it (see GetTextureMipName()), so levels can be read independently.
+struct TextureHeader {
+  uint32_t magic = TextureMagic;
+  uint32_t version = TextureVersion;
+  // A VkFormat.
+  uint32_t format = VK_FORMAT_UNDEFINED;
+  uint32_t width = 0;
+  uint32_t height = 0;
+  uint32_t mipCount = 0;
+  // Bytes per texel block, and the width and height of a block in texels: 1 for uncompressed formats, 4 for BCn.
+  // Blocks must be a power of two up to 16 bytes, so every level stays aligned inside the upload ring.
+  uint32_t blockSize = 0;
+  uint32_t blockExtent = 1;
+};
+
+static_assert(sizeof(TextureHeader) == 32);
+
+// Name of the archive entry holding mip `level` of texture `name`.
+std::string GetTextureMipName(std::string_view name, uint32_t level);
+
+// Bytes of mip `level`, tightly packed.
+uint64_t GetTextureMipSize(const TextureHeader& header, uint32_t level);
+
+// Adds texture `name` to an archive being written. `mips` holds every level of the chain, finest first.
+bool WriteTexture(
+  AssetArchiveWriter& writer,
+  std::string_view name,
+  const TextureHeader& header,
+  std::span<const std::span<const std::byte>> mips,
+  AssetCompression compression
+);
+
+// Pixels spanned by something `worldSize` across at `distance` from a camera with a vertical field of view of
+// `verticalFov` radians, drawing into a viewport `viewportHeight` pixels tall.
+float GetProjectedSize(float worldSize, float distance, float verticalFov, uint32_t viewportHeight);
+
+struct TextureStreamerConfig {
+  // Device memory textures may take, in bytes. 0 takes what VK_EXT_memory_budget reports as left over by everything
+  // else, or half of the device-local heap without the extension. With it, a set budget is capped the same way.
+  uint64_t budget = 0;
+  // Levels up to this many texels along their longer edge are the tail of a chain, which stays resident for as long as
+  // the texture is loaded.
+  uint32_t tailSize = 64;
+  // Frames a request keeps its mip wanted after it was last made. Textures that keep dropping in and out of view, or
+  // hover at a mip boundary, then do not stream their finer levels in and out over and over.
+  uint32_t requestLifetime = 30;
+  // Residency changes in flight at once. Each holds both the old and the new image of its texture until it is done.
+  uint32_t maxTransitions = 8;
+};
+
+struct TextureStreamerStats {
+  uint32_t textureCount = 0;
+  uint32_t transitionCount = 0;
+  // Device memory of every image the streamer holds, including those being replaced.
+  uint64_t residentBytes = 0;
+  // What every requested level would take. Whatever exceeds the budget was evicted.
+  uint64_t wantedBytes = 0;
+  uint64_t budget = 0;
+};
+
+//
+// ---- Texture Streamer ---------------------------------
+//
+// Keeps the mip chain of each texture resident only down to the finest level anything on screen needs. Callers
+// report what they need every frame they draw a texture - a mip level, or the size on screen to derive one from - and
+// a texture nobody asked for within `requestLifetime` frames falls back to its tail. Texture data comes from the
+// archives mounted into the AssetStreamer and reaches the GPU through the upload ring.
+//
+// When the requested levels of all textures do not fit into the budget, the least important textures - lowest
+// priority first, then least recently requested - are coarsened a level at a time until they do, but never past
+// their tail. Memory therefore follows what is visible, and a short budget costs detail rather than failing.
+//
+// A residency change allocates an image holding exactly the new chain, reads its levels from the archive - the
+// coarse ones again, instead of copying them over from the old image - uploads them in one piece and then moves the
+// texture to a new bindless slot. The old image and slot are retired once the frames that may sample them have
+// finished. A texture's bindless index thus changes over time and is fetched with GetBindlessIndex() each frame; until
+// the tail is in, it is that of a 1x1 white fallback.
+//
+// Meant for the render thread, between frames; GetBindlessIndex() may also be called while recording.
+//
+class TextureStreamer final {
+public:
+  // `memoryBudget` tells whether VK_EXT_memory_budget is enabled on `device`.
+  void Init(
+    VkDevice device,
+    VkPhysicalDevice physicalDevice,
+    GpuAllocator& allocator,
+    UploadRing& uploadRing,
+    AssetStreamer& assetStreamer,
+    BindlessHeap& bindlessHeap,
+    GpuTimeline& graphicsTimeline,
+    bool memoryBudget,
+    const TextureStreamerConfig& config
+  );
+
+  // Callers idle the device first.
+  void Destroy();
+
+  // Starts loading texture `name`; only its tail is made resident until finer levels are requested. Returns
+  // InvalidTextureHandle if no mounted archive has it.
+  TextureHandle Load(std::string_view name);
+  void Release(TextureHandle handle);
+
+  // Asks for `mip` and every coarser level to be resident. `priority` ranks the texture against the others when the
+  // budget runs short; higher keeps its detail longer.
+  void RequestMip(TextureHandle handle, uint32_t mip, float priority = 0.0f);
+
+  // Same, picking the level at which a texel covers about a pixel of something `screenSize` pixels across.
+  void RequestScreenSize(TextureHandle handle, float screenSize, float priority = 0.0f);
+
+  // Applies the requests, finishes residency changes and starts new ones. Called once per frame, before the upload
+  // ring submits.
+  void Update();
+
+  BindlessIndex GetBindlessIndex(TextureHandle handle) const;
+
+  // Finest resident level, or the mip count while nothing is resident.
+  uint32_t GetResidentMip(TextureHandle handle) const;
+
+  TextureStreamerStats GetStats() const;
+
+private:
+  // Replaces a texture's image with one holding the levels from `firstMip` on.
+  struct Transition {
+    uint32_t firstMip = 0;
+    // A read per level, finest first. Released once their data went to the upload ring.
+    std::vector<StreamHandle> streams;
+    GpuImage image;
+    UploadTicket ticket = 0;
+  };
+
+  struct Texture {
+    std::string name;
+    bool live = false;
+    bool failed = false;
+
+    // Read before anything else; the header's mip count stays 0 until it is in.
+    StreamHandle headerStream = InvalidStreamHandle;
+    TextureHeader header;
+    uint32_t tailMip = 0;
+    // Finest level whose chain fits into the upload ring.
+    uint32_t finestMip = 0;
+
+    GpuImage image;
+    VkImageView view = VK_NULL_HANDLE;
+    BindlessIndex bindlessIndex = InvalidBindlessIndex;
+    uint32_t residentMip = 0;
+
+    // Finest level asked for within the request lifetime, and when it was asked for.
+    uint32_t requestedMip = UINT32_MAX;
+    uint64_t requestedFrame = 0;
+    // Highest priority of the frame the texture was last requested in.
+    float priority = 0.0f;
+    uint64_t lastRequestFrame = 0;
+    // Level the texture streams towards, once the budget is applied.
+    uint32_t targetMip = 0;
+
+    std::unique_ptr<Transition> transition;
+  };
+
+  struct RetiredImage {
+    GpuImage image;
+    VkImageView view = VK_NULL_HANDLE;
+    uint64_t lastUsedValue = 0;
+  };
+
+  void CreateFallback();
+  void PollHeader(Texture& texture);
+  void ApplyBudget();
+  void StartTransitions();
+  void BeginTransition(Texture& texture);
+  void ProgressTransition(Texture& texture);
+  void UploadTransition(Texture& texture);
+  void CompleteTransition(Texture& texture);
+  void AbandonTransition(Texture& texture);
+  void RetireResidency(Texture& texture);
+  void ReleaseRetired();
+  void DestroyImage(GpuImage& image, VkImageView view);
+  uint64_t QueryBudget() const;
+
+  // Bytes of the levels from `firstMip` to the end of the chain.
+  static uint64_t GetChainSize(const TextureHeader& header, uint32_t firstMip);
+
+private:
+  VkDevice mDevice = VK_NULL_HANDLE;
+  VkPhysicalDevice mPhysicalDevice = VK_NULL_HANDLE;
+  GpuAllocator* mAllocator = nullptr;
+  UploadRing* mUploadRing = nullptr;
+  AssetStreamer* mAssetStreamer = nullptr;
+  BindlessHeap* mBindlessHeap = nullptr;
+  GpuTimeline* mGraphicsTimeline = nullptr;
+  bool mMemoryBudget = false;
+  TextureStreamerConfig mConfig;
+
+  // The device-local heap textures are allocated from.
+  uint32_t mHeapIndex = 0;
+
+  std::vector<Texture> mTextures;
+  std::vector<TextureHandle> mFreeHandles;
+
+  GpuImage mFallbackImage;
+  VkImageView mFallbackView = VK_NULL_HANDLE;
+  BindlessIndex mFallbackIndex = InvalidBindlessIndex;
+
+  // Transitions whose texture went away while the upload ring was still writing their image.
+  std::vector<Transition> mAbandoned;
+  std::vector<RetiredImage> mRetired;
+
+  uint64_t mFrame = 0;
+  uint64_t mBudget = 0;
+  uint64_t mResidentBytes = 0;
+  uint64_t mWantedBytes = 0;
+};
+
+} // namespace qpl
+
+#endif
@@ -0,0 +1,587 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#include "upload-ring.hpp"
+
+#include <cstring>
+#include <algorithm>
+
+namespace qpl {
+
+QPL_INLINE static VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment) {
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+void UploadRing::Init(
+  VkDevice device,
+  GpuAllocator& allocator,
+  GpuTimeline& graphicsTimeline,
+  uint32_t transferFamily,
+  uint32_t graphicsFamily,
+  VkDeviceSize capacity
+) {
+  LogInfo(
+    "Renderer - Creating UploadRing ({} bytes, transfer family {}, graphics family {})",
+    capacity,
+    transferFamily,
+    graphicsFamily
+  );
+
+  mDevice = device;
+  mAllocator = &allocator;
+  mGraphicsTimeline = &graphicsTimeline;
+  mTransferFamily = transferFamily;
+  mGraphicsFamily = graphicsFamily;
+  mCapacity = AlignUp(capacity, CopyAlignment);
+
+  VkBufferCreateInfo bufferInfo{};
+  bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+  bufferInfo.size = mCapacity;
+  bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+  bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+  mBuffer = mAllocator->CreateBuffer(
+    bufferInfo, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+  );
+  mMapped = static_cast<std::byte*>(mBuffer.allocation.mapped);
+
+  QPL_CORE_ASSERT(mMapped != nullptr && "upload ring memory is not host visible!");
+
+  mTimeline.Init(mDevice, "transfer");
+}
+
+void UploadRing::Destroy() {
+  // Callers idle the device first; this only releases what is left.
+  for (const Submission& submission : mInFlight) {
+    vkDestroyCommandPool(mDevice, submission.commandPool, nullptr);
+  }
+
+  for (const Submission& submission : mFreeSubmissions) {
+    vkDestroyCommandPool(mDevice, submission.commandPool, nullptr);
+  }
+
+  mInFlight.clear();
+  mFreeSubmissions.clear();
+  mPending.clear();
+  mCopies.clear();
+  mImageCopies.clear();
+  mGraphicsCopies.clear();
+  mGraphicsOwned.clear();
+
+  mTimeline.Destroy();
+  mAllocator->DestroyBuffer(mBuffer);
+  mMapped = nullptr;
+}
+
+UploadTicket UploadRing::UploadBuffer(VkBuffer dst, VkDeviceSize dstOffset, std::span<const std::byte> data) {
+  std::lock_guard lock(mMutex);
+
+  // Nothing to copy, so nothing to wait for. A fresh ticket would only complete once some later upload is submitted.
+  if (data.empty()) {
+    return mCompletedTicket;
+  }
+
+  UploadTicket ticket = mNextTicket++;
+
+  // Keep uploads ordered: nothing new goes straight into the ring while older data is still waiting for room.
+  if (mPending.empty()) {
+    VkDeviceSize staged = Stage(dst, dstOffset, data.data(), data.size());
+
+    if (staged < data.size()) {
+      // The ring may only look full because nobody has polled the transfer timeline for a while.
+      Reclaim();
+      staged += Stage(dst, dstOffset + staged, data.data() + staged, data.size() - staged);
+    }
+
+    if (staged == data.size()) {
+      mLastStagedTicket = ticket;
+      return ticket;
+    }
+
+    data = data.subspan(staged);
+    dstOffset += staged;
+  }
+
+  PendingUpload& pending = mPending.emplace_back();
+  pending.dst = dst;
+  pending.dstOffset = dstOffset;
+  pending.data.assign(data.begin(), data.end());
+  pending.ticket = ticket;
+  return ticket;
+}
+
+UploadTicket UploadRing::UploadImage(
+  VkImage dst, std::span<const VkBufferImageCopy> regions, std::span<const std::byte> data
+) {
+  QPL_CORE_ASSERT(!data.empty() && data.size() <= mCapacity && "image upload does not fit into the upload ring!");
+
+  std::lock_guard lock(mMutex);
+
+  UploadTicket ticket = mNextTicket++;
+
+  if (mPending.empty()) {
+    bool staged = StageImage(dst, regions, data);
+
+    if (!staged) {
+      Reclaim();
+      staged = StageImage(dst, regions, data);
+    }
+
+    if (staged) {
+      mLastStagedTicket = ticket;
+      return ticket;
+    }
+  }
+
+  PendingUpload& pending = mPending.emplace_back();
+  pending.image = dst;
+  pending.regions.assign(regions.begin(), regions.end());
+  pending.data.assign(data.begin(), data.end());
+  pending.ticket = ticket;
+  return ticket;
+}
+
+bool UploadRing::IsComplete(UploadTicket ticket) {
+  std::lock_guard lock(mMutex);
+
+  if (ticket > mCompletedTicket) {
+    Reclaim();
+  }
+
+  return ticket <= mCompletedTicket;
+}
+
+uint64_t UploadRing::Submit(VkQueue transferQueue) {
+  std::lock_guard lock(mMutex);
+
+  mAcquireBarriers.clear();
+  mImageAcquireBarriers.clear();
+  mGraphicsCopies.clear();
+  Reclaim();
+  DrainPending();
+
+  if (mCopies.empty() && mImageCopies.empty()) {
+    return 0;
+  }
+
+  Submission submission = AcquireSubmission();
+
+  VkCommandBufferBeginInfo beginInfo{};
+  beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+  if (vkBeginCommandBuffer(submission.commandBuffer, &beginInfo) != VK_SUCCESS) {
+    QPL_CORE_ASSERT(false && "failed to begin recording upload command buffer!");
+  }
+
+  // Group the copies by destination so each buffer gets a single vkCmdCopyBuffer. Stable, so overlapping writes to
+  // the same range still land in the order they were issued.
+  std::stable_sort(mCopies.begin(), mCopies.end(), [](const CopyCommand& a, const CopyCommand& b) {
+    return a.dst < b.dst;
+  });
+
+  std::vector<VkBufferCopy> regions;
+  std::vector<VkBufferMemoryBarrier> releaseBarriers;
+
+  for (size_t begin = 0; begin < mCopies.size();) {
+    VkBuffer dst = mCopies[begin].dst;
+
+    regions.clear();
+    size_t end = begin;
+    while (end < mCopies.size() && mCopies[end].dst == dst) {
+      regions.push_back(mCopies[end].region);
+      end++;
+    }
+
+    // Already handed to the graphics queue by an earlier upload; copied there instead of taking it back.
+    if (UsesOwnershipTransfer() && mGraphicsOwned.contains(dst)) {
+      mGraphicsCopies.insert(mGraphicsCopies.end(), mCopies.begin() + begin, mCopies.begin() + end);
+      begin = end;
+      continue;
+    }
+
+    vkCmdCopyBuffer(
+      submission.commandBuffer, mBuffer.buffer, dst, static_cast<uint32_t>(regions.size()), regions.data()
+    );
+
+    if (UsesOwnershipTransfer()) {
+      VkBufferMemoryBarrier barrier{};
+      barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+      barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+      barrier.dstAccessMask = 0;
+      barrier.srcQueueFamilyIndex = mTransferFamily;
+      barrier.dstQueueFamilyIndex = mGraphicsFamily;
+      barrier.buffer = dst;
+      barrier.offset = 0;
+      barrier.size = VK_WHOLE_SIZE;
+      releaseBarriers.push_back(barrier);
+
+      // The acquire must match the release exactly, apart from the access masks.
+      barrier.srcAccessMask = 0;
+      barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+      mAcquireBarriers.push_back(barrier);
+      mGraphicsOwned.insert(dst);
+    }
+
+    begin = end;
+  }
+
+  // Images are written whole, so they start out UNDEFINED and skip preserving whatever they held.
+  std::vector<VkImageMemoryBarrier> imageBarriers;
+
+  for (const ImageCopyCommand& copy : mImageCopies) {
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = copy.dst;
+    barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS};
+    imageBarriers.push_back(barrier);
+  }
+
+  if (!imageBarriers.empty()) {
+    vkCmdPipelineBarrier(
+      submission.commandBuffer,
+      VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      0,
+      0,
+      nullptr,
+      0,
+      nullptr,
+      static_cast<uint32_t>(imageBarriers.size()),
+      imageBarriers.data()
+    );
+  }
+
+  for (size_t i = 0; i < mImageCopies.size(); i++) {
+    const ImageCopyCommand& copy = mImageCopies[i];
+    VkImageMemoryBarrier& barrier = imageBarriers[i];
+
+    vkCmdCopyBufferToImage(
+      submission.commandBuffer,
+      mBuffer.buffer,
+      copy.dst,
+      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+      static_cast<uint32_t>(copy.regions.size()),
+      copy.regions.data()
+    );
+
+    // Reused for the transition into the layout shaders sample from. The graphics submission waits on the transfer
+    // timeline, so with a single queue family the barrier has nothing to make visible beyond the layout change.
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = 0;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    if (UsesOwnershipTransfer()) {
+      barrier.srcQueueFamilyIndex = mTransferFamily;
+      barrier.dstQueueFamilyIndex = mGraphicsFamily;
+
+      VkImageMemoryBarrier acquire = barrier;
+      acquire.srcAccessMask = 0;
+      acquire.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+      mImageAcquireBarriers.push_back(acquire);
+    }
+  }
+
+  if (!releaseBarriers.empty() || !imageBarriers.empty()) {
+    vkCmdPipelineBarrier(
+      submission.commandBuffer,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+      0,
+      0,
+      nullptr,
+      static_cast<uint32_t>(releaseBarriers.size()),
+      releaseBarriers.data(),
+      static_cast<uint32_t>(imageBarriers.size()),
+      imageBarriers.data()
+    );
+  }
+
+  if (vkEndCommandBuffer(submission.commandBuffer) != VK_SUCCESS) {
+    QPL_CORE_ASSERT(false && "failed to record upload command buffer!");
+  }
+
+  submission.timelineValue = mTimeline.NextValue();
+  // The graphics submission that follows reads the ring for these copies.
+  submission.graphicsValue = mGraphicsCopies.empty() ? 0 : mGraphicsTimeline->GetLastSubmitted() + 1;
+  submission.stagedBytes = mUnsubmittedBytes;
+  submission.lastTicket = mLastStagedTicket;
+
+  VkTimelineSemaphoreSubmitInfo timelineInfo{};
+  timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+  timelineInfo.signalSemaphoreValueCount = 1;
+  timelineInfo.pSignalSemaphoreValues = &submission.timelineValue;
+
+  VkSemaphore timelineSemaphore = mTimeline.GetHandle();
+
+  VkSubmitInfo submitInfo{};
+  submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  submitInfo.pNext = &timelineInfo;
+  submitInfo.commandBufferCount = 1;
+  submitInfo.pCommandBuffers = &submission.commandBuffer;
+  submitInfo.signalSemaphoreCount = 1;
+  submitInfo.pSignalSemaphores = &timelineSemaphore;
+
+  if (vkQueueSubmit(transferQueue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+    QPL_CORE_ASSERT(false && "failed to submit upload command buffer!");
+  }
+
+  mInFlight.push_back(submission);
+  mUnsubmittedBytes = 0;
+  mCopies.clear();
+  mImageCopies.clear();
+
+  return submission.timelineValue;
+}
+
+void UploadRing::RecordGraphicsCommands(VkCommandBuffer commandBuffer) {
+  if (!mAcquireBarriers.empty() || !mImageAcquireBarriers.empty()) {
+    vkCmdPipelineBarrier(
+      commandBuffer,
+      ConsumerStages,
+      ConsumerStages,
+      0,
+      0,
+      nullptr,
+      static_cast<uint32_t>(mAcquireBarriers.size()),
+      mAcquireBarriers.data(),
+      static_cast<uint32_t>(mImageAcquireBarriers.size()),
+      mImageAcquireBarriers.data()
+    );
+  }
+
+  if (mGraphicsCopies.empty()) {
+    return;
+  }
+
+  // Copies are still grouped by destination from Submit(). Each buffer gets a barrier before its copy, against the
+  // earlier frames still using it, and one after, for the work of this frame.
+  std::vector<VkBufferCopy> regions;
+  std::vector<VkBufferMemoryBarrier> beforeBarriers;
+  std::vector<VkBufferMemoryBarrier> afterBarriers;
+
+  for (size_t begin = 0; begin < mGraphicsCopies.size();) {
+    VkBufferMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = mGraphicsCopies[begin].dst;
+    barrier.offset = 0;
+    barrier.size = VK_WHOLE_SIZE;
+    beforeBarriers.push_back(barrier);
+
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+    afterBarriers.push_back(barrier);
+
+    while (begin < mGraphicsCopies.size() && mGraphicsCopies[begin].dst == barrier.buffer) {
+      begin++;
+    }
+  }
+
+  vkCmdPipelineBarrier(
+    commandBuffer,
+    ConsumerStages,
+    VK_PIPELINE_STAGE_TRANSFER_BIT,
+    0,
+    0,
+    nullptr,
+    static_cast<uint32_t>(beforeBarriers.size()),
+    beforeBarriers.data(),
+    0,
+    nullptr
+  );
+
+  for (size_t begin = 0; begin < mGraphicsCopies.size();) {
+    VkBuffer dst = mGraphicsCopies[begin].dst;
+
+    regions.clear();
+    while (begin < mGraphicsCopies.size() && mGraphicsCopies[begin].dst == dst) {
+      regions.push_back(mGraphicsCopies[begin].region);
+      begin++;
+    }
+
+    vkCmdCopyBuffer(commandBuffer, mBuffer.buffer, dst, static_cast<uint32_t>(regions.size()), regions.data());
+  }
+
+  vkCmdPipelineBarrier(
+    commandBuffer,
+    VK_PIPELINE_STAGE_TRANSFER_BIT,
+    ConsumerStages,
+    0,
+    0,
+    nullptr,
+    static_cast<uint32_t>(afterBarriers.size()),
+    afterBarriers.data(),
+    0,
+    nullptr
+  );
+}
+
+std::optional<VkDeviceSize> UploadRing::AllocateRange(VkDeviceSize& size, bool allowPartial) {
+  // An empty ring starts over at the front, so a range that must not be split fits once everything has drained.
+  if (mUsedBytes == 0) {
+    mHead = 0;
+  }
+
+  VkDeviceSize offset = AlignUp(mHead, CopyAlignment);
+  VkDeviceSize padding = offset - mHead;
+
+  // Wrap around when the range does not fit before the end of the buffer, wasting the remainder.
+  if (offset >= mCapacity || (!allowPartial && offset + size > mCapacity)) {
+    offset = 0;
+    padding = mCapacity - mHead;
+  }
+
+  // Live ranges are contiguous (modulo wrap-around) starting at the oldest in-flight frame, so fitting the padding
+  // and the range into the free byte count is enough to guarantee no overlap.
+  VkDeviceSize freeBytes = mCapacity - mUsedBytes;
+  if (padding >= freeBytes) {
+    return std::nullopt;
+  }
+
+  VkDeviceSize available = std::min(freeBytes - padding, mCapacity - offset);
+  if (available < size) {
+    if (!allowPartial || available < std::min(size, MinChunkSize)) {
+      return std::nullopt;
+    }
+
+    size = available & ~(CopyAlignment - 1);
+  }
+
+  mHead = offset + size;
+  mUsedBytes += padding + size;
+  mUnsubmittedBytes += padding + size;
+  return offset;
+}
+
+VkDeviceSize UploadRing::Stage(VkBuffer dst, VkDeviceSize dstOffset, const std::byte* data, VkDeviceSize size) {
+  VkDeviceSize chunkSize = size;
+
+  std::optional<VkDeviceSize> offset = AllocateRange(chunkSize, /*allowPartial=*/true);
+  if (!offset.has_value()) {
+    return 0;
+  }
+
+  std::memcpy(mMapped + *offset, data, chunkSize);
+
+  CopyCommand& copy = mCopies.emplace_back();
+  copy.dst = dst;
+  copy.region.srcOffset = *offset;
+  copy.region.dstOffset = dstOffset;
+  copy.region.size = chunkSize;
+  return chunkSize;
+}
+
+bool UploadRing::StageImage(VkImage dst, std::span<const VkBufferImageCopy> regions, std::span<const std::byte> data) {
+  VkDeviceSize size = data.size();
+
+  std::optional<VkDeviceSize> offset = AllocateRange(size, /*allowPartial=*/false);
+  if (!offset.has_value()) {
+    return false;
+  }
+
+  std::memcpy(mMapped + *offset, data.data(), size);
+
+  ImageCopyCommand& copy = mImageCopies.emplace_back();
+  copy.dst = dst;
+  copy.regions.assign(regions.begin(), regions.end());
+
+  for (VkBufferImageCopy& region : copy.regions) {
+    region.bufferOffset += *offset;
+  }
+
+  return true;
+}
+
+void UploadRing::DrainPending() {
+  while (!mPending.empty()) {
+    PendingUpload& pending = mPending.front();
+
+    if (pending.image != VK_NULL_HANDLE) {
+      if (!StageImage(pending.image, pending.regions, pending.data)) {
+        // Not enough contiguous room; wait for the ring to drain further.
+        break;
+      }
+
+      mLastStagedTicket = pending.ticket;
+      mPending.pop_front();
+      continue;
+    }
+
+    VkDeviceSize remaining = pending.data.size() - pending.progress;
+    VkDeviceSize staged = remaining > 0
+      ? Stage(pending.dst, pending.dstOffset + pending.progress, pending.data.data() + pending.progress, remaining)
+      : 0;
+
+    pending.progress += staged;
+
+    if (pending.progress < pending.data.size()) {
+      // Ring is full; continue next frame.
+      break;
+    }
+
+    mLastStagedTicket = pending.ticket;
+    mPending.pop_front();
+  }
+}
+
+void UploadRing::Reclaim() {
+  while (!mInFlight.empty()) {
+    Submission& submission = mInFlight.front();
+
+    if (!mTimeline.IsComplete(submission.timelineValue) || !mGraphicsTimeline->IsComplete(submission.graphicsValue)) {
+      break;
+    }
+
+    mUsedBytes -= submission.stagedBytes;
+    mCompletedTicket = std::max(mCompletedTicket, submission.lastTicket);
+
+    vkResetCommandPool(mDevice, submission.commandPool, 0);
+    mFreeSubmissions.push_back(submission);
+    mInFlight.pop_front();
+  }
+}
+
+UploadRing::Submission UploadRing::AcquireSubmission() {
+  if (!mFreeSubmissions.empty()) {
+    Submission submission = mFreeSubmissions.back();
+    mFreeSubmissions.pop_back();
+    return submission;
+  }
+
+  Submission submission{};
+
+  VkCommandPoolCreateInfo poolInfo{};
+  poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+  poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+  poolInfo.queueFamilyIndex = mTransferFamily;
+
+  if (vkCreateCommandPool(mDevice, &poolInfo, nullptr, &submission.commandPool) != VK_SUCCESS) {
+    QPL_CORE_ASSERT(false && "failed to create upload command pool!");
+  }
+
+  VkCommandBufferAllocateInfo allocInfo{};
+  allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+  allocInfo.commandPool = submission.commandPool;
+  allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+  allocInfo.commandBufferCount = 1;
+
+  if (vkAllocateCommandBuffers(mDevice, &allocInfo, &submission.commandBuffer) != VK_SUCCESS) {
+    QPL_CORE_ASSERT(false && "failed to allocate upload command buffer!");
+  }
+
+  return submission;
+}
+
+} // namespace qpl
@@ -0,0 +1,189 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#ifndef QPL_UPLOAD_RING_HPP
+#define QPL_UPLOAD_RING_HPP
+
+#include <span>
+#include <deque>
+#include <mutex>
+#include <vector>
+#include <cstddef>
+#include <optional>
+#include <unordered_set>
+
+#include <vulkan/vulkan.h>
+#include <core/core.hpp>
+#include "gpu-allocator.hpp"
+#include "gpu-timeline.hpp"
+
+namespace qpl {
+
+// Identifies an upload issued through UploadRing::UploadBuffer() or UploadImage(). Increases monotonically; 0 is
+// never issued for a copy and always counts as complete.
+using UploadTicket = uint64_t;
+
+//
+// ---- Upload Ring ---------------------------------
+//
+// A persistently mapped staging buffer that is sub-allocated linearly. All copies staged during a frame are recorded
+// into a single command buffer and submitted once on the transfer queue, signalling the next value of the transfer
+// timeline. The graphics submission waits on that value, and the staged bytes are reclaimed as soon as the transfer
+// timeline passes it - typically well before the frame that consumes the data has finished.
+//
+// If the transfer queue belongs to a different family than the graphics queue, destination buffers and images must be
+// VK_SHARING_MODE_EXCLUSIVE: the ring releases them on the transfer queue, and RecordGraphicsCommands() acquires them
+// on the graphics queue. A buffer stays with the graphics queue from then on, so later copies into it are recorded
+// by RecordGraphicsCommands() too, and their staged bytes are held until the graphics timeline has passed them.
+//
+// Uploads never block the caller. Data that does not fit into the ring is copied aside and streamed through it in
+// chunks over the following frames; image uploads wait for room to be staged whole instead. UploadBuffer(),
+// UploadImage() and IsComplete() may be called from any thread.
+//
+class UploadRing final {
+public:
+  // Offset alignment of every staged range. Covers optimalBufferCopyOffsetAlignment on common hardware and the
+  // texel-size requirement of buffer-to-image copies.
+  static constexpr VkDeviceSize CopyAlignment = 16;
+
+  // Ranges smaller than this are not worth splitting an upload for; wait for the ring to drain instead.
+  static constexpr VkDeviceSize MinChunkSize = 64 * 1024;
+
+  // Stages that consume uploaded data, and therefore wait on the transfer timeline.
+  static constexpr VkPipelineStageFlags ConsumerStages = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT
+    | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT
+    | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+  void Init(
+    VkDevice device,
+    GpuAllocator& allocator,
+    GpuTimeline& graphicsTimeline,
+    uint32_t transferFamily,
+    uint32_t graphicsFamily,
+    VkDeviceSize capacity
+  );
+  void Destroy();
+
+  // Copies `data` into `dst` at `dstOffset` with the next transfer submission that has room for it. The returned
+  // ticket can be passed to IsComplete(); for empty `data` it is already complete.
+  UploadTicket UploadBuffer(VkBuffer dst, VkDeviceSize dstOffset, std::span<const std::byte> data);
+
+  // Copies `data` into the color image `dst`, as laid out by `regions`, whose buffer offsets are relative to `data`
+  // and must be multiples of CopyAlignment. Every mip level and layer of `dst` is transitioned from
+  // VK_IMAGE_LAYOUT_UNDEFINED, discarding what it held, and left in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL. `data`
+  // must fit into the ring, since it is staged in one piece.
+  UploadTicket UploadImage(VkImage dst, std::span<const VkBufferImageCopy> regions, std::span<const std::byte> data);
+
+  // True once the copy behind `ticket` has finished executing on the GPU.
+  bool IsComplete(UploadTicket ticket);
+
+  // Records every copy staged since the last call into one command buffer and submits it to `transferQueue`, except
+  // those left to RecordGraphicsCommands(). Returns the transfer timeline value the graphics submission must wait
+  // on, or 0 if nothing was uploaded.
+  uint64_t Submit(VkQueue transferQueue);
+
+  // Records the graphics queue's share of the last Submit() into the command buffer of the graphics submission that
+  // follows it: the acquire half of the queue family ownership transfers, and the copies into buffers the graphics
+  // queue already owns. Does nothing when transfer and graphics share a queue family.
+  void RecordGraphicsCommands(VkCommandBuffer commandBuffer);
+
+  QPL_INLINE VkDeviceSize GetCapacity() const {
+    return mCapacity;
+  }
+
+  QPL_INLINE GpuTimeline& GetTimeline() {
+    return mTimeline;
+  }
+
+  QPL_INLINE bool HasPendingUploads() const {
+    std::lock_guard lock(mMutex);
+    return !mPending.empty();
+  }
+
+private:
+  struct Submission {
+    VkCommandPool commandPool = VK_NULL_HANDLE;
+    VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+    // Transfer timeline value signalled when this submission has executed.
+    uint64_t timelineValue = 0;
+    // Graphics timeline value of the submission that records this one's graphics-side copies, 0 if it has none.
+    uint64_t graphicsValue = 0;
+    // Ring bytes (including alignment padding) staged by this submission.
+    VkDeviceSize stagedBytes = 0;
+    // Newest upload whose last byte went out with this submission.
+    UploadTicket lastTicket = 0;
+  };
+
+  struct CopyCommand {
+    VkBuffer dst;
+    VkBufferCopy region;
+  };
+
+  struct ImageCopyCommand {
+    VkImage dst;
+    std::vector<VkBufferImageCopy> regions;
+  };
+
+  struct PendingUpload {
+    VkBuffer dst = VK_NULL_HANDLE;
+    VkDeviceSize dstOffset = 0;
+    // Set instead of `dst` for image uploads, which are never split.
+    VkImage image = VK_NULL_HANDLE;
+    std::vector<VkBufferImageCopy> regions;
+    std::vector<std::byte> data;
+    // Bytes of `data` already staged.
+    VkDeviceSize progress = 0;
+    UploadTicket ticket = 0;
+  };
+
+  std::optional<VkDeviceSize> AllocateRange(VkDeviceSize& size, bool allowPartial);
+  VkDeviceSize Stage(VkBuffer dst, VkDeviceSize dstOffset, const std::byte* data, VkDeviceSize size);
+  bool StageImage(VkImage dst, std::span<const VkBufferImageCopy> regions, std::span<const std::byte> data);
+  void DrainPending();
+  void Reclaim();
+  Submission AcquireSubmission();
+
+  QPL_INLINE bool UsesOwnershipTransfer() const {
+    return mTransferFamily != mGraphicsFamily;
+  }
+
+private:
+  VkDevice mDevice = VK_NULL_HANDLE;
+  GpuAllocator* mAllocator = nullptr;
+  GpuTimeline* mGraphicsTimeline = nullptr;
+  uint32_t mTransferFamily = 0;
+  uint32_t mGraphicsFamily = 0;
+
+  GpuBuffer mBuffer;
+  std::byte* mMapped = nullptr;
+  VkDeviceSize mCapacity = 0;
+
+  mutable std::mutex mMutex;
+  VkDeviceSize mHead = 0;
+  VkDeviceSize mUsedBytes = 0;
+  VkDeviceSize mUnsubmittedBytes = 0;
+  std::vector<CopyCommand> mCopies;
+  std::vector<ImageCopyCommand> mImageCopies;
+  std::deque<PendingUpload> mPending;
+
+  // Uploads complete in the order they were issued, so a single watermark per stage is enough to track them.
+  UploadTicket mNextTicket = 1;
+  UploadTicket mLastStagedTicket = 0;
+  UploadTicket mCompletedTicket = 0;
+
+  GpuTimeline mTimeline;
+  std::deque<Submission> mInFlight;
+  std::vector<Submission> mFreeSubmissions;
+  std::vector<VkBufferMemoryBarrier> mAcquireBarriers;
+  std::vector<VkImageMemoryBarrier> mImageAcquireBarriers;
+
+  // Buffers released to the graphics queue, and the copies of the last Submit() that target them. Writing those
+  // from the transfer queue would first need the graphics queue to hand them back.
+  std::unordered_set<VkBuffer> mGraphicsOwned;
+  std::vector<CopyCommand> mGraphicsCopies;
+};
+
+} // namespace qpl
+
+#endif
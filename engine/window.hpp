@@ -23,6 +23,10 @@ struct WindowConfig {
   int width, height;
   const char* title;
   bool fullscreen;
+
+  // No window at all: the renderer draws into offscreen images of width x height instead of a swap chain, which
+  // works on machines without a display server.
+  bool headless = false;
 };
 
 //
@@ -32,6 +36,11 @@ class WindowContext final {
 public:
   QPL_INLINE WindowContext(const WindowConfig& windowConfig)
     : config(windowConfig) {
+    if (windowConfig.headless) {
+      window = nullptr;
+      return;
+    }
+
     uint64_t SDLFlags = 0;
 
     // Fullscreen flag
@@ -49,11 +58,19 @@ public:
   }
 
   QPL_INLINE ~WindowContext() {
+    if (IsHeadless()) {
+      return;
+    }
+
     SDL_DestroyWindow(window);
     SDL_Quit();
   }
 
-  // Returns a pointer to the SDL window instance.
+  QPL_INLINE bool IsHeadless() const {
+    return config.headless;
+  }
+
+  // Returns a pointer to the SDL window instance, or nullptr when headless.
   QPL_INLINE SDL_Window* GetSDLWindow() const {
     return window;
   }
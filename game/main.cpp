@@ -1,10 +1,130 @@
 #include <engine.hpp>
+#include <string_view>
+#include <charconv>
 
 using namespace qpl;
 
-int main(int, char**) {
+// Strips `prefix` off `arg`, returning false if `arg` does not start with it.
+static bool ConsumePrefix(std::string_view& arg, std::string_view prefix) {
+  if (!arg.starts_with(prefix)) {
+    return false;
+  }
+
+  arg.remove_prefix(prefix.size());
+  return true;
+}
+
+template <typename T>
+static void ParseNumber(std::string_view arg, T& value) {
+  std::from_chars(arg.data(), arg.data() + arg.size(), value);
+}
+
+int main(int argc, char** argv) {
   WindowConfig cfg{800, 600, "Hello, World!", false};
-  Engine engine(cfg);
-  engine.Start();
+  RendererConfig rendererCfg;
+  EngineConfig engineCfg;
+  std::filesystem::path cpuTracePath;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+
+    if (ConsumePrefix(arg, "--frames-in-flight=")) {
+      ParseNumber(arg, rendererCfg.framesInFlight);
+    }
+    else if (arg == "--headless") {
+      cfg.headless = true;
+    }
+    else if (ConsumePrefix(arg, "--frames=")) {
+      ParseNumber(arg, rendererCfg.frameLimit);
+    }
+    else if (ConsumePrefix(arg, "--readback-interval=")) {
+      ParseNumber(arg, rendererCfg.readbackInterval);
+    }
+    else if (ConsumePrefix(arg, "--scene-objects=")) {
+      ParseNumber(arg, rendererCfg.demoSceneObjects);
+    }
+    else if (ConsumePrefix(arg, "--readback-dir=")) {
+      rendererCfg.readbackDirectory = arg;
+    }
+    else if (ConsumePrefix(arg, "--gpu-profile=")) {
+      rendererCfg.gpuProfileOutput = arg;
+    }
+    else if (ConsumePrefix(arg, "--cpu-trace=")) {
+      cpuTracePath = arg;
+    }
+    else if (ConsumePrefix(arg, "--log-file=")) {
+      LogToFile(arg);
+    }
+    else if (ConsumePrefix(arg, "--job-threads=")) {
+      ParseNumber(arg, engineCfg.jobThreads);
+    }
+    else if (ConsumePrefix(arg, "--tick-rate=")) {
+      double tickRate = 0.0;
+      ParseNumber(arg, tickRate);
+
+      if (tickRate > 0.0) {
+        engineCfg.fixedTimestep = 1.0 / tickRate;
+      }
+    }
+    else if (arg == "--threaded-rendering") {
+      engineCfg.threadedRendering = true;
+    }
+    else if (ConsumePrefix(arg, "--pacing=")) {
+      if (arg == "uncapped") {
+        rendererCfg.framePacing = FramePacing::Uncapped;
+      }
+      else if (arg == "target-fps") {
+        rendererCfg.framePacing = FramePacing::TargetFps;
+      }
+      else if (arg == "low-latency") {
+        rendererCfg.framePacing = FramePacing::LowLatency;
+      }
+    }
+    else if (ConsumePrefix(arg, "--target-fps=")) {
+      ParseNumber(arg, rendererCfg.targetFps);
+    }
+    else if (ConsumePrefix(arg, "--shader-dir=")) {
+      rendererCfg.shaderDirectory = arg;
+    }
+    else if (arg == "--hot-reload-shaders") {
+      rendererCfg.shaderHotReload = true;
+    }
+    else if (arg == "--vsync") {
+      rendererCfg.presentMode = VK_PRESENT_MODE_FIFO_KHR;
+    }
+    else if (ConsumePrefix(arg, "--archive=")) {
+      rendererCfg.assetArchives.emplace_back(arg);
+    }
+    else if (arg == "--no-io-uring") {
+      rendererCfg.streaming.useIoUring = false;
+    }
+    else if (ConsumePrefix(arg, "--texture-budget-mb=")) {
+      uint64_t megabytes = 0;
+      ParseNumber(arg, megabytes);
+      rendererCfg.textureStreaming.budget = megabytes * 1024 * 1024;
+    }
+  }
+
+  // Captures the whole run, startup included. Anything but a .json path gets the compact binary format.
+  if (!cpuTracePath.empty()) {
+    CpuProfiler::BeginCapture();
+  }
+
+  {
+    Engine engine(cfg, rendererCfg, engineCfg);
+    engine.Start();
+  }
+
+  if (!cpuTracePath.empty()) {
+    CpuProfiler::EndCapture();
+
+    if (cpuTracePath.extension() == ".json") {
+      CpuProfiler::WriteChromeTrace(cpuTracePath);
+    }
+    else {
+      CpuProfiler::WriteBinaryCapture(cpuTracePath);
+    }
+  }
+
   return 0;
 }
@@ -0,0 +1,164 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#include "bench.hpp"
+
+#include <assets/asset-archive.hpp>
+
+#include <format>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+
+namespace qpl {
+
+static constexpr uint32_t BenchFiles = 512;
+static constexpr uint32_t BenchRepeats = 3;
+
+// Sizes cycle through 4 KiB to 256 KiB, roughly the spread of a small game's textures, meshes and shaders.
+static constexpr size_t BenchMinSize = 4 * 1024;
+static constexpr size_t BenchMaxSize = 256 * 1024;
+
+// Stand-in for asset data: 32-byte records, most of them a recent record with one word changed, like vertices of a
+// mesh or rows of a texture. Compresses to about half under LZ4.
+static std::vector<std::byte> GenerateAsset(uint32_t seed, size_t size) {
+  static constexpr size_t RecordWords = 8;
+  static constexpr size_t RecentRecords = 64;
+
+  std::vector<uint32_t> words(size / sizeof(uint32_t) + RecordWords);
+  uint32_t x = seed * 0x9E3779B9u + 1;
+
+  for (size_t record = 0; record < words.size() / RecordWords; record++) {
+    uint32_t* dst = &words[record * RecordWords];
+
+    for (size_t i = 0; i < RecordWords; i++) {
+      x ^= x << 13;
+      x ^= x >> 17;
+      x ^= x << 5;
+      dst[i] = x;
+    }
+
+    if (record >= RecentRecords && (x & 3) != 0) {
+      const uint32_t* src = dst - (1 + x % RecentRecords) * RecordWords;
+      uint32_t changed = x >> 29;
+
+      for (size_t i = 0; i < RecordWords; i++) {
+        dst[i] = i == changed ? dst[i] : src[i];
+      }
+    }
+  }
+
+  std::vector<std::byte> data(size);
+  std::memcpy(data.data(), words.data(), size);
+  return data;
+}
+
+// Best of BenchRepeats runs, in milliseconds.
+template <typename Fn>
+static double MeasureMs(Fn&& body) {
+  return MeasureBestNs(BenchRepeats, body) / 1e6;
+}
+
+static uint64_t LoadLoose(const std::filesystem::path& directory, const std::vector<std::string>& names, bool hash) {
+  std::vector<std::byte> buffer;
+  uint64_t checksum = 0;
+
+  for (const std::string& name : names) {
+    std::ifstream file(directory / name, std::ios::binary | std::ios::ate);
+    buffer.resize((size_t)file.tellg());
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+
+    checksum += hash ? HashBytes(buffer.data(), buffer.size()) : (uint64_t)buffer.back();
+  }
+
+  return checksum;
+}
+
+static uint64_t LoadArchive(const std::filesystem::path& path, const std::vector<std::string>& names, bool hash) {
+  AssetArchive archive;
+  archive.Open(path);
+
+  std::vector<std::byte> buffer;
+  uint64_t checksum = 0;
+
+  for (const std::string& name : names) {
+    const ArchiveEntry* entry = archive.Find(name);
+    buffer.resize(entry->size);
+    archive.Read(*entry, buffer);
+
+    checksum += hash ? HashBytes(buffer.data(), buffer.size()) : (uint64_t)buffer.back();
+  }
+
+  return checksum;
+}
+
+void RunAssetArchiveBenchmark() {
+  std::filesystem::path directory = std::filesystem::temp_directory_path() / "qplane-archive-bench";
+  std::filesystem::path looseDirectory = directory / "loose";
+  std::filesystem::path rawPath = directory / "raw.qpak";
+  std::filesystem::path lz4Path = directory / "lz4.qpak";
+
+  std::error_code ec;
+  std::filesystem::remove_all(directory, ec);
+  std::filesystem::create_directories(looseDirectory, ec);
+
+  AssetArchiveWriter rawWriter;
+  AssetArchiveWriter lz4Writer;
+  rawWriter.Open(rawPath);
+  lz4Writer.Open(lz4Path);
+
+  std::vector<std::string> names;
+  uint64_t totalSize = 0;
+
+  for (uint32_t i = 0; i < BenchFiles; i++) {
+    size_t size = BenchMinSize << (i % 7);
+    std::vector<std::byte> data = GenerateAsset(i, std::min(size, BenchMaxSize));
+
+    names.push_back(std::format("asset-{:04}.bin", i));
+    totalSize += data.size();
+
+    std::ofstream file(looseDirectory / names.back(), std::ios::binary);
+    file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+
+    rawWriter.Add(names.back(), data, AssetCompression::None);
+    lz4Writer.Add(names.back(), data, AssetCompression::Lz4);
+  }
+
+  uint64_t lz4Size = lz4Writer.GetSize();
+
+  if (!rawWriter.Finish() || !lz4Writer.Finish()) {
+    LogError("AssetArchive benchmark - Failed to write the archives to {}", directory.string());
+    return;
+  }
+
+  uint64_t looseChecksum = LoadLoose(looseDirectory, names, true);
+  uint64_t rawChecksum = LoadArchive(rawPath, names, true);
+  uint64_t lz4Checksum = LoadArchive(lz4Path, names, true);
+
+  QPL_CORE_ASSERT(rawChecksum == looseChecksum && lz4Checksum == looseChecksum && "archive returned different data");
+
+  // Every file was just written, so this measures loading from the OS file cache: the cost of opening and reading
+  // files one by one, not of the disk. Hashing would dwarf both, so the timed runs only touch the data.
+  double looseMs = MeasureMs([&] { LoadLoose(looseDirectory, names, false); });
+  double rawMs = MeasureMs([&] { LoadArchive(rawPath, names, false); });
+  double lz4Ms = MeasureMs([&] { LoadArchive(lz4Path, names, false); });
+
+  LogInfo(
+    "AssetArchive benchmark - {} files, {:.1f} MiB: loose {:.2f} ms, archive {:.2f} ms ({:.2f}x), "
+    "lz4 archive {:.2f} ms ({:.2f}x, {:.0f}% of the size)",
+    BenchFiles,
+    (double)totalSize / (1024.0 * 1024.0),
+    looseMs,
+    rawMs,
+    looseMs / rawMs,
+    lz4Ms,
+    looseMs / lz4Ms,
+    100.0 * (double)lz4Size / (double)totalSize
+  );
+
+  std::filesystem::remove_all(directory, ec);
+}
+
+} // namespace qpl
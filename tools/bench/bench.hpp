@@ -0,0 +1,60 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#ifndef QPL_BENCH_HPP
+#define QPL_BENCH_HPP
+
+#include <algorithm>
+
+#include <vulkan/vulkan.h>
+#include <core/core.hpp>
+
+namespace qpl {
+
+// Runs `body` `repeats` times and returns the fastest run in nanoseconds. The best run is the one least disturbed by
+// the rest of the system, which makes it the most repeatable number to compare.
+template <typename Fn>
+double MeasureBestNs(uint32_t repeats, Fn&& body) {
+  double best = 0.0;
+
+  for (uint32_t i = 0; i < repeats; i++) {
+    int64_t start = CpuProfiler::Now();
+    body();
+    double ns = (double)(CpuProfiler::Now() - start);
+
+    best = i == 0 ? ns : std::min(best, ns);
+  }
+
+  return best;
+}
+
+class GpuAllocator;
+class GpuTimeline;
+
+// Measures the cost of a zone with and without a capture running and logs the results.
+void RunCpuProfilerBenchmark();
+
+// Times a fine-grained and a coarse workload on 1 to N threads and logs the speedup of each.
+void RunJobSystemBenchmark();
+
+// Dispatches a few million events through EventDispatcher and through the previous std::function based design,
+// and logs the cost per event.
+void RunEventDispatcherBenchmark();
+
+// Iterates a million entities with two to four components through serial and parallel chunk queries, against the
+// same work over an array of game objects, and logs the results.
+void RunWorldBenchmark(JobSystem& jobSystem);
+
+// Packs a few hundred generated files into archives with and without compression, and logs how long loading all of
+// them takes from the archives and from loose files.
+void RunAssetArchiveBenchmark();
+
+// Compiles a representative deferred frame through the render graph and logs its barrier count and peak transient
+// memory next to those of the same frame written by hand with one barrier per transition and one allocation per
+// target. Only compiles; nothing is submitted.
+void RunRenderGraphBenchmark(VkDevice device, GpuAllocator& allocator, GpuTimeline& timeline);
+
+} // namespace qpl
+
+#endif
@@ -0,0 +1,115 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#include "bench.hpp"
+
+#include <events/event-dispatcher.hpp>
+
+#include <array>
+#include <functional>
+#include <unordered_map>
+
+namespace qpl {
+
+static constexpr uint32_t BenchEvents = 1u << 23;
+
+//
+// ---- Legacy Event Dispatcher ---------------------------------
+//
+// The dispatcher as it was before the flat table: a hash map of std::function lists, looked up with operator[].
+//
+class LegacyEventDispatcher final {
+public:
+  using EventCallback = std::function<void(void*)>;
+
+  QPL_INLINE void Subscribe(Event event, EventCallback&& callback) {
+    mSubscribers[event].push_back(std::move(callback));
+  }
+
+  QPL_INLINE void Dispatch(const Event& event, void* pEvent) {
+    for (const EventCallback& callback : mSubscribers[event]) {
+      callback(pEvent);
+    }
+  }
+
+private:
+  std::unordered_map<Event, std::vector<EventCallback>> mSubscribers;
+};
+
+struct BenchCounters {
+  uint64_t quit = 0;
+  uint64_t resize = 0;
+  uint64_t resizeWidth = 0;
+};
+
+// A mix shaped like a real event queue: mostly events nobody listens to, some with a handler or two.
+static constexpr std::array<Event, 8> BenchEventMix = {
+  Event::SDL_WindowResize,
+  static_cast<Event>(SDL_EVENT_MOUSE_MOTION),
+  static_cast<Event>(SDL_EVENT_MOUSE_MOTION),
+  Event::SDL_Quit,
+  static_cast<Event>(SDL_EVENT_KEY_DOWN),
+  static_cast<Event>(SDL_EVENT_MOUSE_MOTION),
+  Event::SDL_WindowResize,
+  static_cast<Event>(SDL_EVENT_KEY_UP),
+};
+
+template <typename Fn>
+static double MeasureNsPerEvent(Fn&& dispatch) {
+  SDL_Event event{};
+  event.window.data1 = 1;
+
+  int64_t start = CpuProfiler::Now();
+
+  for (uint32_t i = 0; i < BenchEvents; i++) {
+    Event type = BenchEventMix[i % BenchEventMix.size()];
+    event.type = static_cast<uint32_t>(type);
+    dispatch(type, &event);
+  }
+
+  return (double)(CpuProfiler::Now() - start) / BenchEvents;
+}
+
+void RunEventDispatcherBenchmark() {
+  BenchCounters legacyCounters;
+  LegacyEventDispatcher legacy;
+
+  legacy.Subscribe(Event::SDL_Quit, [&](void*) { legacyCounters.quit++; });
+  legacy.Subscribe(Event::SDL_WindowResize, [&](void*) { legacyCounters.resize++; });
+  legacy.Subscribe(Event::SDL_WindowResize, [&](void* event) {
+    legacyCounters.resizeWidth += static_cast<SDL_Event*>(event)->window.data1;
+  });
+
+  double legacyNs = MeasureNsPerEvent([&](Event type, SDL_Event* event) { legacy.Dispatch(type, event); });
+
+  BenchCounters counters;
+  EventDispatcher dispatcher;
+
+  dispatcher.Subscribe<Event::SDL_Quit>(&counters, [](BenchCounters* counters, const SDL_QuitEvent&) {
+    counters->quit++;
+  });
+  dispatcher.Subscribe<Event::SDL_WindowResize>(&counters, [](BenchCounters* counters, const SDL_WindowEvent&) {
+    counters->resize++;
+  });
+  dispatcher.Subscribe<Event::SDL_WindowResize>(&counters, [](BenchCounters* counters, const SDL_WindowEvent& event) {
+    counters->resizeWidth += event.data1;
+  });
+
+  double flatNs = MeasureNsPerEvent([&](Event type, SDL_Event* event) { dispatcher.Dispatch(type, event); });
+
+  QPL_CORE_ASSERT(
+    counters.quit == legacyCounters.quit && counters.resize == legacyCounters.resize
+    && counters.resizeWidth == legacyCounters.resizeWidth && "dispatchers disagree"
+  );
+
+  LogInfo(
+    "EventDispatcher benchmark - {} events: std::function map {:.2f} ns/event, flat table {:.2f} ns/event ({:.1f}x)",
+    BenchEvents,
+    legacyNs,
+    flatNs,
+    legacyNs / flatNs
+  );
+}
+
+} // namespace qpl
@@ -0,0 +1,123 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#include "bench.hpp"
+
+#include <core/core.hpp>
+
+namespace qpl {
+
+static constexpr uint32_t BenchItems = 1u << 18;
+static constexpr uint32_t BenchRounds = 64;
+static constexpr uint32_t BenchRepeats = 3;
+
+// Items per leaf of the fork-join tree: roughly ten microseconds of work, so scheduling overhead shows.
+static constexpr uint32_t BenchLeafItems = 64;
+
+// Stand-in for real per-item work: a couple hundred dependent integer operations.
+static uint32_t BenchWork(uint32_t seed) {
+  uint32_t x = seed * 0x9E3779B9u + 1;
+
+  for (uint32_t i = 0; i < BenchRounds; i++) {
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+  }
+
+  return x;
+}
+
+struct SplitTask {
+  JobSystem* jobSystem;
+  uint32_t* output;
+  uint32_t begin;
+  uint32_t end;
+};
+
+// Splits its range in two child jobs and waits for them, down to leaves of BenchLeafItems.
+static void SplitJob(void* data) {
+  SplitTask& task = *static_cast<SplitTask*>(data);
+
+  if (task.end - task.begin <= BenchLeafItems) {
+    for (uint32_t i = task.begin; i < task.end; i++) {
+      task.output[i] = BenchWork(i);
+    }
+    return;
+  }
+
+  uint32_t middle = task.begin + (task.end - task.begin) / 2;
+
+  SplitTask halves[2] = {
+    {task.jobSystem, task.output, task.begin, middle},
+    {task.jobSystem, task.output, middle, task.end},
+  };
+
+  Job children[2] = {{SplitJob, &halves[0]}, {SplitJob, &halves[1]}};
+
+  JobCounter counter;
+  task.jobSystem->Run(children, counter);
+  task.jobSystem->Wait(counter);
+}
+
+static uint64_t Checksum(const std::vector<uint32_t>& output) {
+  uint64_t sum = 0;
+
+  for (uint32_t value : output) {
+    sum += value;
+  }
+
+  return sum;
+}
+
+// Best of BenchRepeats runs, in milliseconds.
+template <typename Fn>
+static double MeasureMs(Fn&& body) {
+  return MeasureBestNs(BenchRepeats, body) / 1e6;
+}
+
+void RunJobSystemBenchmark() {
+  uint32_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<uint32_t> output(BenchItems);
+
+  uint64_t expected = 0;
+  double parallelForBaseMs = 0.0;
+  double forkJoinBaseMs = 0.0;
+
+  for (uint32_t threads = 1; threads <= maxThreads; threads++) {
+    JobSystem jobSystem(threads - 1);
+
+    double parallelForMs = MeasureMs([&] {
+      jobSystem.ParallelFor(BenchItems, BenchLeafItems, [&](uint32_t i) { output[i] = BenchWork(i); });
+    });
+
+    uint64_t parallelForSum = Checksum(output);
+    std::fill(output.begin(), output.end(), 0);
+
+    double forkJoinMs = MeasureMs([&] {
+      SplitTask root{&jobSystem, output.data(), 0, BenchItems};
+      SplitJob(&root);
+    });
+
+    uint64_t forkJoinSum = Checksum(output);
+
+    if (threads == 1) {
+      expected = parallelForSum;
+      parallelForBaseMs = parallelForMs;
+      forkJoinBaseMs = forkJoinMs;
+    }
+
+    QPL_CORE_ASSERT(parallelForSum == expected && forkJoinSum == expected && "job system lost or repeated work");
+
+    LogInfo(
+      "JobSystem benchmark - {} thread(s): parallel-for {:.2f} ms ({:.2f}x), fork-join {:.2f} ms ({:.2f}x)",
+      threads,
+      parallelForMs,
+      parallelForBaseMs / parallelForMs,
+      forkJoinMs,
+      forkJoinBaseMs / forkJoinMs
+    );
+  }
+}
+
+} // namespace qpl
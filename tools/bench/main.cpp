@@ -0,0 +1,90 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#include "bench.hpp"
+
+#include <rendering/renderer.hpp>
+#include <string_view>
+#include <algorithm>
+#include <charconv>
+#include <vector>
+
+using namespace qpl;
+
+static constexpr std::string_view BenchmarkNames[] = {"profiler", "jobs", "events", "ecs", "archive", "render-graph"};
+
+static void PrintUsage() {
+  LogInfo("usage: qplane_bench [--job-threads=N] [benchmark...]   run the given benchmarks, or all of them");
+  LogInfo("       benchmarks: profiler jobs events ecs archive render-graph");
+}
+
+// Strips `prefix` off `arg`, returning false if `arg` does not start with it.
+static bool ConsumePrefix(std::string_view& arg, std::string_view prefix) {
+  if (!arg.starts_with(prefix)) {
+    return false;
+  }
+
+  arg.remove_prefix(prefix.size());
+  return true;
+}
+
+static void RunBenchmark(std::string_view name, uint32_t jobThreads) {
+  if (name == "profiler") {
+    RunCpuProfilerBenchmark();
+  }
+  else if (name == "jobs") {
+    RunJobSystemBenchmark();
+  }
+  else if (name == "events") {
+    RunEventDispatcherBenchmark();
+  }
+  else if (name == "ecs") {
+    JobSystem jobSystem(jobThreads);
+    RunWorldBenchmark(jobSystem);
+  }
+  else if (name == "archive") {
+    RunAssetArchiveBenchmark();
+  }
+  else if (name == "render-graph") {
+    // Only needs a device; a headless renderer brings one up without a window.
+    WindowConfig windowConfig{800, 600, "qplane_bench", false, true};
+    WindowContext windowContext(windowConfig);
+    JobSystem jobSystem(jobThreads);
+    Renderer renderer(windowContext, jobSystem);
+
+    RunRenderGraphBenchmark(renderer.GetDevice(), renderer.GetGpuAllocator(), renderer.GetGraphicsTimeline());
+  }
+}
+
+int main(int argc, char** argv) {
+  uint32_t jobThreads = std::max(1u, std::thread::hardware_concurrency()) - 1;
+  std::vector<std::string_view> benchmarks;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+
+    if (ConsumePrefix(arg, "--job-threads=")) {
+      std::from_chars(arg.data(), arg.data() + arg.size(), jobThreads);
+    }
+    else if (std::find(std::begin(BenchmarkNames), std::end(BenchmarkNames), arg) != std::end(BenchmarkNames)) {
+      benchmarks.push_back(arg);
+    }
+    else {
+      PrintUsage();
+      return 1;
+    }
+  }
+
+  if (benchmarks.empty()) {
+    benchmarks.assign(std::begin(BenchmarkNames), std::end(BenchmarkNames));
+  }
+
+  // Arguments are all parsed first, so every benchmark sees the same configuration regardless of their order.
+  for (std::string_view name : benchmarks) {
+    RunBenchmark(name, jobThreads);
+  }
+
+  LogFlush();
+  return 0;
+}
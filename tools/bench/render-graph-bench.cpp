@@ -0,0 +1,183 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#include "bench.hpp"
+
+#include <rendering/render-graph.hpp>
+
+#include <chrono>
+
+namespace qpl {
+
+// Benchmark frame: a deferred renderer at 1080p. The debug view is declared but never consumed, so the graph culls it.
+static constexpr VkExtent2D BenchExtent = {1920, 1080};
+static constexpr VkExtent2D BenchHalfExtent = {BenchExtent.width / 2, BenchExtent.height / 2};
+static constexpr VkExtent2D BenchQuarterExtent = {BenchExtent.width / 4, BenchExtent.height / 4};
+static constexpr uint32_t BenchIterations = 1000;
+
+static void DeclareBenchFrame(RenderGraph& graph) {
+  auto albedo = graph.CreateTexture("albedo", {VK_FORMAT_R8G8B8A8_UNORM, BenchExtent});
+  auto normal = graph.CreateTexture("normal", {VK_FORMAT_R16G16B16A16_SFLOAT, BenchExtent});
+  auto depth = graph.CreateTexture("depth", {VK_FORMAT_D32_SFLOAT, BenchExtent});
+  auto occlusion = graph.CreateTexture("occlusion", {VK_FORMAT_R8_UNORM, BenchExtent});
+  auto hdr = graph.CreateTexture("hdr", {VK_FORMAT_R16G16B16A16_SFLOAT, BenchExtent});
+  auto bloomHalf = graph.CreateTexture("bloom-half", {VK_FORMAT_R16G16B16A16_SFLOAT, BenchHalfExtent});
+  auto bloomQuarter = graph.CreateTexture("bloom-quarter", {VK_FORMAT_R16G16B16A16_SFLOAT, BenchQuarterExtent});
+  auto debugView = graph.CreateTexture("debug-view", {VK_FORMAT_R8G8B8A8_UNORM, BenchExtent});
+
+  // Nothing is executed, so the backbuffer only needs a format and a size.
+  auto backbuffer = graph.ImportTexture(
+    "backbuffer",
+    VK_NULL_HANDLE,
+    VK_NULL_HANDLE,
+    {VK_FORMAT_B8G8R8A8_SRGB, BenchExtent},
+    VK_IMAGE_LAYOUT_UNDEFINED,
+    VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
+  );
+
+  graph.AddPass("gbuffer").ColorAttachment(albedo).ColorAttachment(normal).DepthAttachment(depth);
+
+  graph.AddPass("ssao")
+    .Read(depth, RenderAccess::SampledFragment)
+    .Read(normal, RenderAccess::SampledFragment)
+    .ColorAttachment(occlusion);
+
+  graph.AddPass("lighting")
+    .Read(albedo, RenderAccess::SampledFragment)
+    .Read(normal, RenderAccess::SampledFragment)
+    .Read(depth, RenderAccess::SampledFragment)
+    .Read(occlusion, RenderAccess::SampledFragment)
+    .ColorAttachment(hdr);
+
+  graph.AddPass("debug-view").Read(depth, RenderAccess::SampledFragment).ColorAttachment(debugView);
+
+  graph.AddPass("bloom-down-half").Read(hdr, RenderAccess::SampledFragment).ColorAttachment(bloomHalf);
+  graph.AddPass("bloom-down-quarter").Read(bloomHalf, RenderAccess::SampledFragment).ColorAttachment(bloomQuarter);
+
+  graph.AddPass("tonemap")
+    .Read(hdr, RenderAccess::SampledFragment)
+    .Read(bloomQuarter, RenderAccess::SampledFragment)
+    .ColorAttachment(backbuffer);
+}
+
+//
+// ---- Hand-Written Frame ---------------------------------
+//
+// The same frame the way it would be written without a graph: a vkCmdPipelineBarrier per transition, placed right
+// before the pass that needs it, and a dedicated allocation per render target.
+//
+struct HandWrittenFrame {
+  uint32_t barrierCalls = 0;
+  uint32_t imageBarriers = 0;
+  VkDeviceSize targetBytes = 0;
+
+  // One vkCmdPipelineBarrier with a single image barrier per transition.
+  QPL_INLINE void Transitions(uint32_t count) {
+    barrierCalls += count;
+    imageBarriers += count;
+  }
+};
+
+static HandWrittenFrame MeasureHandWrittenFrame(VkDevice device) {
+  HandWrittenFrame frame;
+
+  auto addTarget = [&](VkFormat format, VkExtent2D extent, VkImageUsageFlags usage) {
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = format;
+    imageInfo.extent = {extent.width, extent.height, 1};
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = usage;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    VkDeviceImageMemoryRequirements requirementsInfo{};
+    requirementsInfo.sType = VK_STRUCTURE_TYPE_DEVICE_IMAGE_MEMORY_REQUIREMENTS;
+    requirementsInfo.pCreateInfo = &imageInfo;
+
+    VkMemoryRequirements2 requirements{};
+    requirements.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+    vkGetDeviceImageMemoryRequirements(device, &requirementsInfo, &requirements);
+
+    frame.targetBytes += requirements.memoryRequirements.size;
+  };
+
+  constexpr VkImageUsageFlags colorTarget = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+  constexpr VkImageUsageFlags depthTarget = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+
+  addTarget(VK_FORMAT_R8G8B8A8_UNORM, BenchExtent, colorTarget);
+  addTarget(VK_FORMAT_R16G16B16A16_SFLOAT, BenchExtent, colorTarget);
+  addTarget(VK_FORMAT_D32_SFLOAT, BenchExtent, depthTarget);
+  addTarget(VK_FORMAT_R8_UNORM, BenchExtent, colorTarget);
+  addTarget(VK_FORMAT_R16G16B16A16_SFLOAT, BenchExtent, colorTarget);
+  addTarget(VK_FORMAT_R16G16B16A16_SFLOAT, BenchHalfExtent, colorTarget);
+  addTarget(VK_FORMAT_R16G16B16A16_SFLOAT, BenchQuarterExtent, colorTarget);
+  addTarget(VK_FORMAT_R8G8B8A8_UNORM, BenchExtent, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT);
+
+  // gbuffer: albedo, normal and depth become attachments.
+  frame.Transitions(3);
+  // ssao: depth and normal become shader inputs, occlusion an attachment.
+  frame.Transitions(3);
+  // lighting: albedo and occlusion become shader inputs, hdr an attachment.
+  frame.Transitions(3);
+  // debug view: its target becomes an attachment. Skipping the pass would need a manual toggle.
+  frame.Transitions(1);
+  // bloom: hdr becomes an input and the half level an attachment, then the half level an input and the quarter one
+  // an attachment.
+  frame.Transitions(4);
+  // tonemap: the quarter level becomes an input and the backbuffer an attachment, then presentable.
+  frame.Transitions(3);
+
+  return frame;
+}
+
+void RunRenderGraphBenchmark(VkDevice device, GpuAllocator& allocator, GpuTimeline& timeline) {
+  RenderGraph graph;
+  graph.Init(device, allocator, timeline);
+
+  // The first compile fills the memory requirement cache; every frame after that looks like the steady state.
+  DeclareBenchFrame(graph);
+  graph.Compile();
+
+  auto startTime = std::chrono::steady_clock::now();
+
+  for (uint32_t i = 0; i < BenchIterations; i++) {
+    graph.Reset();
+    DeclareBenchFrame(graph);
+    graph.Compile();
+  }
+
+  double compileTimeUs =
+    std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - startTime).count() / BenchIterations;
+
+  RenderGraphStats stats = graph.GetStats();
+  HandWrittenFrame handWritten = MeasureHandWrittenFrame(device);
+
+  LogInfo(
+    "RenderGraph benchmark - {} passes ({} culled), compile {:.2f} us/frame",
+    stats.passCount,
+    stats.culledPassCount,
+    compileTimeUs
+  );
+  LogInfo(
+    "RenderGraph benchmark - graph:        {} barrier calls, {} image barriers, {} bytes transient memory",
+    stats.barrierBatchCount,
+    stats.imageBarrierCount,
+    stats.transientHeapBytes
+  );
+  LogInfo(
+    "RenderGraph benchmark - hand-written: {} barrier calls, {} image barriers, {} bytes transient memory",
+    handWritten.barrierCalls,
+    handWritten.imageBarriers,
+    handWritten.targetBytes
+  );
+
+  graph.Destroy();
+}
+
+} // namespace qpl
@@ -0,0 +1,199 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#include "bench.hpp"
+
+#include <ecs/world.hpp>
+
+namespace qpl {
+
+static constexpr uint32_t BenchEntities = 1u << 20;
+static constexpr uint32_t BenchRepeats = 5;
+static constexpr float BenchStep = 1.0f / 60.0f;
+
+struct BenchPosition {
+  float x, y, z;
+};
+
+struct BenchVelocity {
+  float x, y, z;
+};
+
+struct BenchAcceleration {
+  float x, y, z;
+};
+
+struct BenchInverseMass {
+  float value;
+};
+
+//
+// ---- Legacy Game Object ---------------------------------
+//
+// The array-of-structures layout a game object class ends up with: the fields a system touches interleaved with
+// everything it does not, here a transform, a name and some flags.
+//
+struct LegacyGameObject {
+  BenchPosition position;
+  BenchVelocity velocity;
+  BenchAcceleration acceleration;
+  BenchInverseMass inverseMass;
+  float rotation[4];
+  float scale[3];
+  char name[32];
+  uint32_t flags;
+};
+
+// Best of BenchRepeats runs, in nanoseconds per entity.
+template <typename Fn>
+static double MeasureNsPerEntity(Fn&& body) {
+  return MeasureBestNs(BenchRepeats, body) / BenchEntities;
+}
+
+static void Integrate2(uint32_t count, BenchPosition* position, const BenchVelocity* velocity) {
+  for (uint32_t i = 0; i < count; i++) {
+    position[i].x += velocity[i].x * BenchStep;
+    position[i].y += velocity[i].y * BenchStep;
+    position[i].z += velocity[i].z * BenchStep;
+  }
+}
+
+static void Integrate3(
+  uint32_t count, BenchPosition* position, BenchVelocity* velocity, const BenchAcceleration* acceleration
+) {
+  for (uint32_t i = 0; i < count; i++) {
+    velocity[i].x += acceleration[i].x * BenchStep;
+    velocity[i].y += acceleration[i].y * BenchStep;
+    velocity[i].z += acceleration[i].z * BenchStep;
+    position[i].x += velocity[i].x * BenchStep;
+    position[i].y += velocity[i].y * BenchStep;
+    position[i].z += velocity[i].z * BenchStep;
+  }
+}
+
+static void Integrate4(
+  uint32_t count,
+  BenchPosition* position,
+  BenchVelocity* velocity,
+  const BenchAcceleration* acceleration,
+  const BenchInverseMass* inverseMass
+) {
+  for (uint32_t i = 0; i < count; i++) {
+    float scale = inverseMass[i].value * BenchStep;
+    velocity[i].x += acceleration[i].x * scale;
+    velocity[i].y += acceleration[i].y * scale;
+    velocity[i].z += acceleration[i].z * scale;
+    position[i].x += velocity[i].x * BenchStep;
+    position[i].y += velocity[i].y * BenchStep;
+    position[i].z += velocity[i].z * BenchStep;
+  }
+}
+
+void RunWorldBenchmark(JobSystem& jobSystem) {
+  std::vector<LegacyGameObject> legacy(BenchEntities);
+  World world;
+
+  for (uint32_t i = 0; i < BenchEntities; i++) {
+    float f = (float)(i % 1024);
+
+    LegacyGameObject& object = legacy[i];
+    object.position = {f, f, f};
+    object.velocity = {1.0f, 2.0f, 3.0f};
+    object.acceleration = {0.0f, -9.8f, 0.0f};
+    object.inverseMass = {1.0f / (1.0f + f)};
+
+    world.Create(object.position, object.velocity, object.acceleration, object.inverseMass);
+  }
+
+  // Legacy rows go through the same kernels one object at a time, as a method on the object would.
+  double legacy2 = MeasureNsPerEntity([&] {
+    for (LegacyGameObject& object : legacy) {
+      Integrate2(1, &object.position, &object.velocity);
+    }
+  });
+
+  double legacy3 = MeasureNsPerEntity([&] {
+    for (LegacyGameObject& object : legacy) {
+      Integrate3(1, &object.position, &object.velocity, &object.acceleration);
+    }
+  });
+
+  double legacy4 = MeasureNsPerEntity([&] {
+    for (LegacyGameObject& object : legacy) {
+      Integrate4(1, &object.position, &object.velocity, &object.acceleration, &object.inverseMass);
+    }
+  });
+
+  double serial2 = MeasureNsPerEntity([&] {
+    world.EachChunk<BenchPosition, const BenchVelocity>(
+      [](uint32_t count, const Entity*, BenchPosition* position, const BenchVelocity* velocity) {
+        Integrate2(count, position, velocity);
+      }
+    );
+  });
+
+  double serial3 = MeasureNsPerEntity([&] {
+    world.EachChunk<BenchPosition, BenchVelocity, const BenchAcceleration>(
+      [](uint32_t count, const Entity*, auto* position, auto* velocity, auto* acceleration) {
+        Integrate3(count, position, velocity, acceleration);
+      }
+    );
+  });
+
+  double serial4 = MeasureNsPerEntity([&] {
+    world.EachChunk<BenchPosition, BenchVelocity, const BenchAcceleration, const BenchInverseMass>(
+      [](uint32_t count, const Entity*, auto* position, auto* velocity, auto* acceleration, auto* inverseMass) {
+        Integrate4(count, position, velocity, acceleration, inverseMass);
+      }
+    );
+  });
+
+  double parallel2 = MeasureNsPerEntity([&] {
+    world.ParallelEachChunk<BenchPosition, const BenchVelocity>(
+      jobSystem,
+      [](uint32_t count, const Entity*, BenchPosition* position, const BenchVelocity* velocity) {
+        Integrate2(count, position, velocity);
+      }
+    );
+  });
+
+  double parallel3 = MeasureNsPerEntity([&] {
+    world.ParallelEachChunk<BenchPosition, BenchVelocity, const BenchAcceleration>(
+      jobSystem,
+      [](uint32_t count, const Entity*, auto* position, auto* velocity, auto* acceleration) {
+        Integrate3(count, position, velocity, acceleration);
+      }
+    );
+  });
+
+  double parallel4 = MeasureNsPerEntity([&] {
+    world.ParallelEachChunk<BenchPosition, BenchVelocity, const BenchAcceleration, const BenchInverseMass>(
+      jobSystem,
+      [](uint32_t count, const Entity*, auto* position, auto* velocity, auto* acceleration, auto* inverseMass) {
+        Integrate4(count, position, velocity, acceleration, inverseMass);
+      }
+    );
+  });
+
+  auto report = [&](uint32_t components, double legacyNs, double serialNs, double parallelNs) {
+    LogInfo(
+      "World benchmark - {} entities, {} components: game objects {:.3f} ns/entity, chunks {:.3f} ns/entity ({:.1f}x), "
+      "parallel chunks on {} threads {:.3f} ns/entity ({:.1f}x)",
+      BenchEntities,
+      components,
+      legacyNs,
+      serialNs,
+      legacyNs / serialNs,
+      jobSystem.GetWorkerCount(),
+      parallelNs,
+      legacyNs / parallelNs
+    );
+  };
+
+  report(2, legacy2, serial2, parallel2);
+  report(3, legacy3, serial3, parallel3);
+  report(4, legacy4, serial4, parallel4);
+}
+
+} // namespace qpl
@@ -0,0 +1,158 @@
+// This file is a part of the QPlane project
+// Copyright (C) 2025 XnLogicaL
+// Licensed under the GNU General Public License v3.0
+
+#include <assets/asset-archive.hpp>
+#include <string_view>
+#include <algorithm>
+#include <charconv>
+
+using namespace qpl;
+
+static void PrintUsage() {
+  LogInfo("usage: qpack [--lz4] [--align=N] <archive> <directory>   pack every file under <directory>");
+  LogInfo("       qpack --list <archive>                              list the entries of <archive>");
+  LogInfo("       qpack --verify <archive>                            check every entry against its content hash");
+}
+
+// Strips `prefix` off `arg`, returning false if `arg` does not start with it.
+static bool ConsumePrefix(std::string_view& arg, std::string_view prefix) {
+  if (!arg.starts_with(prefix)) {
+    return false;
+  }
+
+  arg.remove_prefix(prefix.size());
+  return true;
+}
+
+static bool Pack(
+  const std::filesystem::path& archivePath,
+  const std::filesystem::path& directory,
+  AssetCompression compression,
+  uint32_t alignment
+) {
+  std::error_code ec;
+  std::vector<std::filesystem::path> files;
+
+  for (const auto& item : std::filesystem::recursive_directory_iterator(directory, ec)) {
+    if (item.is_regular_file()) {
+      files.push_back(item.path());
+    }
+  }
+
+  if (ec) {
+    LogError("qpack - Failed to list {}: {}", directory.string(), ec.message());
+    return false;
+  }
+
+  // Sorted so the same directory always packs into the same bytes.
+  std::sort(files.begin(), files.end());
+
+  AssetArchiveWriter writer;
+  if (!writer.Open(archivePath, alignment)) {
+    return false;
+  }
+
+  uint64_t totalSize = 0;
+
+  for (const std::filesystem::path& path : files) {
+    MappedFile file;
+    if (!file.Open(path)) {
+      LogError("qpack - Failed to read {}", path.string());
+      return false;
+    }
+
+    if (!writer.Add(path.lexically_relative(directory).generic_string(), file.GetData(), compression)) {
+      return false;
+    }
+
+    totalSize += file.GetSize();
+  }
+
+  if (!writer.Finish()) {
+    return false;
+  }
+
+  LogInfo(
+    "qpack - Packed {} files, {} bytes into {} bytes",
+    files.size(),
+    totalSize,
+    std::filesystem::file_size(archivePath, ec)
+  );
+  return true;
+}
+
+static bool List(const std::filesystem::path& archivePath, bool verify) {
+  AssetArchive archive;
+  if (!archive.Open(archivePath)) {
+    return false;
+  }
+
+  std::vector<std::byte> buffer;
+  bool valid = true;
+
+  for (const ArchiveEntry& entry : archive.GetEntries()) {
+    if (verify) {
+      buffer.resize(entry.size);
+      valid = archive.Read(entry, buffer, /*verify=*/true) && valid;
+      continue;
+    }
+
+    LogInfo(
+      "{:>12} {:>12} {:016x} {}",
+      entry.size,
+      entry.storedSize,
+      entry.contentHash,
+      archive.GetName(entry)
+    );
+  }
+
+  if (verify && valid) {
+    LogInfo("qpack - All {} entries are intact", archive.GetEntries().size());
+  }
+
+  return valid;
+}
+
+int main(int argc, char** argv) {
+  AssetCompression compression = AssetCompression::None;
+  uint32_t alignment = ArchiveDefaultAlignment;
+  std::vector<std::string_view> positional;
+  bool list = false;
+  bool verify = false;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+
+    if (arg == "--lz4") {
+      compression = AssetCompression::Lz4;
+    }
+    else if (arg == "--list") {
+      list = true;
+    }
+    else if (arg == "--verify") {
+      verify = true;
+    }
+    else if (ConsumePrefix(arg, "--align=")) {
+      std::from_chars(arg.data(), arg.data() + arg.size(), alignment);
+    }
+    else {
+      positional.push_back(arg);
+    }
+  }
+
+  bool success = false;
+
+  if ((list || verify) && positional.size() == 1) {
+    success = List(positional[0], verify);
+  }
+  else if (!list && !verify && positional.size() == 2 && alignment != 0 && (alignment & (alignment - 1)) == 0) {
+    success = Pack(positional[0], positional[1], compression, alignment);
+  }
+  else {
+    PrintUsage();
+  }
+
+  LogFlush();
+  return success ? 0 : 1;
+}